@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../bin/cclox"
+  "../bin/cclox.pdb"
+  "CMakeFiles/cclox.dir/shell.cpp.o"
+  "CMakeFiles/cclox.dir/shell.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/cclox.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,65 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/src/ast_printer.cpp" "src/CMakeFiles/lox.dir/ast_printer.cpp.o" "gcc" "src/CMakeFiles/lox.dir/ast_printer.cpp.o.d"
+  "/root/repo/src/background_compiler.cpp" "src/CMakeFiles/lox.dir/background_compiler.cpp.o" "gcc" "src/CMakeFiles/lox.dir/background_compiler.cpp.o.d"
+  "/root/repo/src/bytecode.cpp" "src/CMakeFiles/lox.dir/bytecode.cpp.o" "gcc" "src/CMakeFiles/lox.dir/bytecode.cpp.o.d"
+  "/root/repo/src/bytecode_compiler.cpp" "src/CMakeFiles/lox.dir/bytecode_compiler.cpp.o" "gcc" "src/CMakeFiles/lox.dir/bytecode_compiler.cpp.o.d"
+  "/root/repo/src/cpp_emitter.cpp" "src/CMakeFiles/lox.dir/cpp_emitter.cpp.o" "gcc" "src/CMakeFiles/lox.dir/cpp_emitter.cpp.o.d"
+  "/root/repo/src/environment.cpp" "src/CMakeFiles/lox.dir/environment.cpp.o" "gcc" "src/CMakeFiles/lox.dir/environment.cpp.o.d"
+  "/root/repo/src/event_loop.cpp" "src/CMakeFiles/lox.dir/event_loop.cpp.o" "gcc" "src/CMakeFiles/lox.dir/event_loop.cpp.o.d"
+  "/root/repo/src/heap_meter.cpp" "src/CMakeFiles/lox.dir/heap_meter.cpp.o" "gcc" "src/CMakeFiles/lox.dir/heap_meter.cpp.o.d"
+  "/root/repo/src/heap_snapshot.cpp" "src/CMakeFiles/lox.dir/heap_snapshot.cpp.o" "gcc" "src/CMakeFiles/lox.dir/heap_snapshot.cpp.o.d"
+  "/root/repo/src/interpreter.cpp" "src/CMakeFiles/lox.dir/interpreter.cpp.o" "gcc" "src/CMakeFiles/lox.dir/interpreter.cpp.o.d"
+  "/root/repo/src/ir.cpp" "src/CMakeFiles/lox.dir/ir.cpp.o" "gcc" "src/CMakeFiles/lox.dir/ir.cpp.o.d"
+  "/root/repo/src/ir_builder.cpp" "src/CMakeFiles/lox.dir/ir_builder.cpp.o" "gcc" "src/CMakeFiles/lox.dir/ir_builder.cpp.o.d"
+  "/root/repo/src/ir_passes.cpp" "src/CMakeFiles/lox.dir/ir_passes.cpp.o" "gcc" "src/CMakeFiles/lox.dir/ir_passes.cpp.o.d"
+  "/root/repo/src/jit.cpp" "src/CMakeFiles/lox.dir/jit.cpp.o" "gcc" "src/CMakeFiles/lox.dir/jit.cpp.o.d"
+  "/root/repo/src/lox.cpp" "src/CMakeFiles/lox.dir/lox.cpp.o" "gcc" "src/CMakeFiles/lox.dir/lox.cpp.o.d"
+  "/root/repo/src/lox_channel.cpp" "src/CMakeFiles/lox.dir/lox_channel.cpp.o" "gcc" "src/CMakeFiles/lox.dir/lox_channel.cpp.o.d"
+  "/root/repo/src/lox_class.cpp" "src/CMakeFiles/lox.dir/lox_class.cpp.o" "gcc" "src/CMakeFiles/lox.dir/lox_class.cpp.o.d"
+  "/root/repo/src/lox_function.cpp" "src/CMakeFiles/lox.dir/lox_function.cpp.o" "gcc" "src/CMakeFiles/lox.dir/lox_function.cpp.o.d"
+  "/root/repo/src/lox_instance.cpp" "src/CMakeFiles/lox.dir/lox_instance.cpp.o" "gcc" "src/CMakeFiles/lox.dir/lox_instance.cpp.o.d"
+  "/root/repo/src/lox_list.cpp" "src/CMakeFiles/lox.dir/lox_list.cpp.o" "gcc" "src/CMakeFiles/lox.dir/lox_list.cpp.o.d"
+  "/root/repo/src/module_cache.cpp" "src/CMakeFiles/lox.dir/module_cache.cpp.o" "gcc" "src/CMakeFiles/lox.dir/module_cache.cpp.o.d"
+  "/root/repo/src/native_async_functions.cpp" "src/CMakeFiles/lox.dir/native_async_functions.cpp.o" "gcc" "src/CMakeFiles/lox.dir/native_async_functions.cpp.o.d"
+  "/root/repo/src/native_channel_functions.cpp" "src/CMakeFiles/lox.dir/native_channel_functions.cpp.o" "gcc" "src/CMakeFiles/lox.dir/native_channel_functions.cpp.o.d"
+  "/root/repo/src/native_freeze_function.cpp" "src/CMakeFiles/lox.dir/native_freeze_function.cpp.o" "gcc" "src/CMakeFiles/lox.dir/native_freeze_function.cpp.o.d"
+  "/root/repo/src/native_import_function.cpp" "src/CMakeFiles/lox.dir/native_import_function.cpp.o" "gcc" "src/CMakeFiles/lox.dir/native_import_function.cpp.o.d"
+  "/root/repo/src/native_list_functions.cpp" "src/CMakeFiles/lox.dir/native_list_functions.cpp.o" "gcc" "src/CMakeFiles/lox.dir/native_list_functions.cpp.o.d"
+  "/root/repo/src/native_task_functions.cpp" "src/CMakeFiles/lox.dir/native_task_functions.cpp.o" "gcc" "src/CMakeFiles/lox.dir/native_task_functions.cpp.o.d"
+  "/root/repo/src/object.cpp" "src/CMakeFiles/lox.dir/object.cpp.o" "gcc" "src/CMakeFiles/lox.dir/object.cpp.o.d"
+  "/root/repo/src/object_copier.cpp" "src/CMakeFiles/lox.dir/object_copier.cpp.o" "gcc" "src/CMakeFiles/lox.dir/object_copier.cpp.o.d"
+  "/root/repo/src/optimizer.cpp" "src/CMakeFiles/lox.dir/optimizer.cpp.o" "gcc" "src/CMakeFiles/lox.dir/optimizer.cpp.o.d"
+  "/root/repo/src/parser.cpp" "src/CMakeFiles/lox.dir/parser.cpp.o" "gcc" "src/CMakeFiles/lox.dir/parser.cpp.o.d"
+  "/root/repo/src/ref_count_arena.cpp" "src/CMakeFiles/lox.dir/ref_count_arena.cpp.o" "gcc" "src/CMakeFiles/lox.dir/ref_count_arena.cpp.o.d"
+  "/root/repo/src/register_code.cpp" "src/CMakeFiles/lox.dir/register_code.cpp.o" "gcc" "src/CMakeFiles/lox.dir/register_code.cpp.o.d"
+  "/root/repo/src/register_compiler.cpp" "src/CMakeFiles/lox.dir/register_compiler.cpp.o" "gcc" "src/CMakeFiles/lox.dir/register_compiler.cpp.o.d"
+  "/root/repo/src/register_vm.cpp" "src/CMakeFiles/lox.dir/register_vm.cpp.o" "gcc" "src/CMakeFiles/lox.dir/register_vm.cpp.o.d"
+  "/root/repo/src/resolver.cpp" "src/CMakeFiles/lox.dir/resolver.cpp.o" "gcc" "src/CMakeFiles/lox.dir/resolver.cpp.o.d"
+  "/root/repo/src/scanner.cpp" "src/CMakeFiles/lox.dir/scanner.cpp.o" "gcc" "src/CMakeFiles/lox.dir/scanner.cpp.o.d"
+  "/root/repo/src/server.cpp" "src/CMakeFiles/lox.dir/server.cpp.o" "gcc" "src/CMakeFiles/lox.dir/server.cpp.o.d"
+  "/root/repo/src/task_scheduler.cpp" "src/CMakeFiles/lox.dir/task_scheduler.cpp.o" "gcc" "src/CMakeFiles/lox.dir/task_scheduler.cpp.o.d"
+  "/root/repo/src/token.cpp" "src/CMakeFiles/lox.dir/token.cpp.o" "gcc" "src/CMakeFiles/lox.dir/token.cpp.o.d"
+  "/root/repo/src/trace_jit.cpp" "src/CMakeFiles/lox.dir/trace_jit.cpp.o" "gcc" "src/CMakeFiles/lox.dir/trace_jit.cpp.o.d"
+  "/root/repo/src/vm.cpp" "src/CMakeFiles/lox.dir/vm.cpp.o" "gcc" "src/CMakeFiles/lox.dir/vm.cpp.o.d"
+  "/root/repo/src/x64_assembler.cpp" "src/CMakeFiles/lox.dir/x64_assembler.cpp.o" "gcc" "src/CMakeFiles/lox.dir/x64_assembler.cpp.o.d"
+  )
+
+# Targets to which this target links which contain Fortran sources.
+set(CMAKE_Fortran_TARGET_LINKED_INFO_FILES
+  )
+
+# Targets to which this target links which contain Fortran sources.
+set(CMAKE_Fortran_TARGET_FORWARD_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
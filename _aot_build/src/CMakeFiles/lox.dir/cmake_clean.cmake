@@ -0,0 +1,95 @@
+file(REMOVE_RECURSE
+  "../lib/liblox.a"
+  "../lib/liblox.pdb"
+  "CMakeFiles/lox.dir/ast_printer.cpp.o"
+  "CMakeFiles/lox.dir/ast_printer.cpp.o.d"
+  "CMakeFiles/lox.dir/background_compiler.cpp.o"
+  "CMakeFiles/lox.dir/background_compiler.cpp.o.d"
+  "CMakeFiles/lox.dir/bytecode.cpp.o"
+  "CMakeFiles/lox.dir/bytecode.cpp.o.d"
+  "CMakeFiles/lox.dir/bytecode_compiler.cpp.o"
+  "CMakeFiles/lox.dir/bytecode_compiler.cpp.o.d"
+  "CMakeFiles/lox.dir/cpp_emitter.cpp.o"
+  "CMakeFiles/lox.dir/cpp_emitter.cpp.o.d"
+  "CMakeFiles/lox.dir/environment.cpp.o"
+  "CMakeFiles/lox.dir/environment.cpp.o.d"
+  "CMakeFiles/lox.dir/event_loop.cpp.o"
+  "CMakeFiles/lox.dir/event_loop.cpp.o.d"
+  "CMakeFiles/lox.dir/heap_meter.cpp.o"
+  "CMakeFiles/lox.dir/heap_meter.cpp.o.d"
+  "CMakeFiles/lox.dir/heap_snapshot.cpp.o"
+  "CMakeFiles/lox.dir/heap_snapshot.cpp.o.d"
+  "CMakeFiles/lox.dir/interpreter.cpp.o"
+  "CMakeFiles/lox.dir/interpreter.cpp.o.d"
+  "CMakeFiles/lox.dir/ir.cpp.o"
+  "CMakeFiles/lox.dir/ir.cpp.o.d"
+  "CMakeFiles/lox.dir/ir_builder.cpp.o"
+  "CMakeFiles/lox.dir/ir_builder.cpp.o.d"
+  "CMakeFiles/lox.dir/ir_passes.cpp.o"
+  "CMakeFiles/lox.dir/ir_passes.cpp.o.d"
+  "CMakeFiles/lox.dir/jit.cpp.o"
+  "CMakeFiles/lox.dir/jit.cpp.o.d"
+  "CMakeFiles/lox.dir/lox.cpp.o"
+  "CMakeFiles/lox.dir/lox.cpp.o.d"
+  "CMakeFiles/lox.dir/lox_channel.cpp.o"
+  "CMakeFiles/lox.dir/lox_channel.cpp.o.d"
+  "CMakeFiles/lox.dir/lox_class.cpp.o"
+  "CMakeFiles/lox.dir/lox_class.cpp.o.d"
+  "CMakeFiles/lox.dir/lox_function.cpp.o"
+  "CMakeFiles/lox.dir/lox_function.cpp.o.d"
+  "CMakeFiles/lox.dir/lox_instance.cpp.o"
+  "CMakeFiles/lox.dir/lox_instance.cpp.o.d"
+  "CMakeFiles/lox.dir/lox_list.cpp.o"
+  "CMakeFiles/lox.dir/lox_list.cpp.o.d"
+  "CMakeFiles/lox.dir/module_cache.cpp.o"
+  "CMakeFiles/lox.dir/module_cache.cpp.o.d"
+  "CMakeFiles/lox.dir/native_async_functions.cpp.o"
+  "CMakeFiles/lox.dir/native_async_functions.cpp.o.d"
+  "CMakeFiles/lox.dir/native_channel_functions.cpp.o"
+  "CMakeFiles/lox.dir/native_channel_functions.cpp.o.d"
+  "CMakeFiles/lox.dir/native_freeze_function.cpp.o"
+  "CMakeFiles/lox.dir/native_freeze_function.cpp.o.d"
+  "CMakeFiles/lox.dir/native_import_function.cpp.o"
+  "CMakeFiles/lox.dir/native_import_function.cpp.o.d"
+  "CMakeFiles/lox.dir/native_list_functions.cpp.o"
+  "CMakeFiles/lox.dir/native_list_functions.cpp.o.d"
+  "CMakeFiles/lox.dir/native_task_functions.cpp.o"
+  "CMakeFiles/lox.dir/native_task_functions.cpp.o.d"
+  "CMakeFiles/lox.dir/object.cpp.o"
+  "CMakeFiles/lox.dir/object.cpp.o.d"
+  "CMakeFiles/lox.dir/object_copier.cpp.o"
+  "CMakeFiles/lox.dir/object_copier.cpp.o.d"
+  "CMakeFiles/lox.dir/optimizer.cpp.o"
+  "CMakeFiles/lox.dir/optimizer.cpp.o.d"
+  "CMakeFiles/lox.dir/parser.cpp.o"
+  "CMakeFiles/lox.dir/parser.cpp.o.d"
+  "CMakeFiles/lox.dir/ref_count_arena.cpp.o"
+  "CMakeFiles/lox.dir/ref_count_arena.cpp.o.d"
+  "CMakeFiles/lox.dir/register_code.cpp.o"
+  "CMakeFiles/lox.dir/register_code.cpp.o.d"
+  "CMakeFiles/lox.dir/register_compiler.cpp.o"
+  "CMakeFiles/lox.dir/register_compiler.cpp.o.d"
+  "CMakeFiles/lox.dir/register_vm.cpp.o"
+  "CMakeFiles/lox.dir/register_vm.cpp.o.d"
+  "CMakeFiles/lox.dir/resolver.cpp.o"
+  "CMakeFiles/lox.dir/resolver.cpp.o.d"
+  "CMakeFiles/lox.dir/scanner.cpp.o"
+  "CMakeFiles/lox.dir/scanner.cpp.o.d"
+  "CMakeFiles/lox.dir/server.cpp.o"
+  "CMakeFiles/lox.dir/server.cpp.o.d"
+  "CMakeFiles/lox.dir/task_scheduler.cpp.o"
+  "CMakeFiles/lox.dir/task_scheduler.cpp.o.d"
+  "CMakeFiles/lox.dir/token.cpp.o"
+  "CMakeFiles/lox.dir/token.cpp.o.d"
+  "CMakeFiles/lox.dir/trace_jit.cpp.o"
+  "CMakeFiles/lox.dir/trace_jit.cpp.o.d"
+  "CMakeFiles/lox.dir/vm.cpp.o"
+  "CMakeFiles/lox.dir/vm.cpp.o.d"
+  "CMakeFiles/lox.dir/x64_assembler.cpp.o"
+  "CMakeFiles/lox.dir/x64_assembler.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lox.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
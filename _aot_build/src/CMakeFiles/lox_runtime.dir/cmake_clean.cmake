@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "../lib/liblox_runtime.a"
+  "../lib/liblox_runtime.pdb"
+  "CMakeFiles/lox_runtime.dir/lox_runtime.cpp.o"
+  "CMakeFiles/lox_runtime.dir/lox_runtime.cpp.o.d"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/lox_runtime.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,12 @@
+file(REMOVE_RECURSE
+  "../bin/expression_test"
+  "../bin/expression_test.pdb"
+  "CMakeFiles/expression_test.dir/expression_test.cpp.o"
+  "CMakeFiles/expression_test.dir/expression_test.cpp.o.d"
+  "expression_test_e3b0c442_tests.cmake"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/expression_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
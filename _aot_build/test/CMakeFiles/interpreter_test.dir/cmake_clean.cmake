@@ -0,0 +1,12 @@
+file(REMOVE_RECURSE
+  "../bin/interpreter_test"
+  "../bin/interpreter_test.pdb"
+  "CMakeFiles/interpreter_test.dir/interpreter_test.cpp.o"
+  "CMakeFiles/interpreter_test.dir/interpreter_test.cpp.o.d"
+  "interpreter_test_e3b0c442_tests.cmake"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/interpreter_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
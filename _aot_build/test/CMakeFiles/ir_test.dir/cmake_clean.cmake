@@ -0,0 +1,12 @@
+file(REMOVE_RECURSE
+  "../bin/ir_test"
+  "../bin/ir_test.pdb"
+  "CMakeFiles/ir_test.dir/ir_test.cpp.o"
+  "CMakeFiles/ir_test.dir/ir_test.cpp.o.d"
+  "ir_test_e3b0c442_tests.cmake"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ir_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,12 @@
+file(REMOVE_RECURSE
+  "../bin/ref_count_arena_test"
+  "../bin/ref_count_arena_test.pdb"
+  "CMakeFiles/ref_count_arena_test.dir/ref_count_arena_test.cpp.o"
+  "CMakeFiles/ref_count_arena_test.dir/ref_count_arena_test.cpp.o.d"
+  "ref_count_arena_test_e3b0c442_tests.cmake"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ref_count_arena_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
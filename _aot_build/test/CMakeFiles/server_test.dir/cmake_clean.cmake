@@ -0,0 +1,12 @@
+file(REMOVE_RECURSE
+  "../bin/server_test"
+  "../bin/server_test.pdb"
+  "CMakeFiles/server_test.dir/server_test.cpp.o"
+  "CMakeFiles/server_test.dir/server_test.cpp.o.d"
+  "server_test_e3b0c442_tests.cmake"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/server_test.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
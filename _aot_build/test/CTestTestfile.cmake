@@ -0,0 +1,11 @@
+# CMake generated Testfile for 
+# Source directory: /root/repo/test
+# Build directory: /root/repo/_aot_build/test
+# 
+# This file includes the relevant testing commands required for 
+# testing this directory and lists subdirectories to be tested as well.
+include("/root/repo/_aot_build/test/interpreter_test_e3b0c442_include.cmake")
+include("/root/repo/_aot_build/test/expression_test_e3b0c442_include.cmake")
+include("/root/repo/_aot_build/test/ir_test_e3b0c442_include.cmake")
+include("/root/repo/_aot_build/test/ref_count_arena_test_e3b0c442_include.cmake")
+include("/root/repo/_aot_build/test/server_test_e3b0c442_include.cmake")
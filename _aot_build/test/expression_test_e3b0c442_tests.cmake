@@ -0,0 +1,37 @@
+add_test([=[ExpressionTest.BasicLiteralsTest]=]  /root/repo/_aot_build/bin/expression_test [==[--gtest_filter=ExpressionTest.BasicLiteralsTest]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ExpressionTest.BasicLiteralsTest]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/expression_test.cpp:15]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[ExpressionTest.ArithmeticOperationsTest]=]  /root/repo/_aot_build/bin/expression_test [==[--gtest_filter=ExpressionTest.ArithmeticOperationsTest]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ExpressionTest.ArithmeticOperationsTest]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/expression_test.cpp:80]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[ExpressionTest.ComparisonOperationsTest]=]  /root/repo/_aot_build/bin/expression_test [==[--gtest_filter=ExpressionTest.ComparisonOperationsTest]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ExpressionTest.ComparisonOperationsTest]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/expression_test.cpp:213]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[ExpressionTest.ComplexExpressionsTest]=]  /root/repo/_aot_build/bin/expression_test [==[--gtest_filter=ExpressionTest.ComplexExpressionsTest]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ExpressionTest.ComplexExpressionsTest]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/expression_test.cpp:273]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+set(expression_test_TESTS [==[ExpressionTest.BasicLiteralsTest]==] [==[ExpressionTest.ArithmeticOperationsTest]==] [==[ExpressionTest.ComparisonOperationsTest]==] [==[ExpressionTest.ComplexExpressionsTest]==])
@@ -0,0 +1,5 @@
+if(EXISTS "/root/repo/_aot_build/test/interpreter_test_e3b0c442_tests.cmake")
+  include("/root/repo/_aot_build/test/interpreter_test_e3b0c442_tests.cmake")
+else()
+  add_test(interpreter_test_NOT_BUILT interpreter_test_NOT_BUILT)
+endif()
@@ -0,0 +1,100 @@
+add_test([=[IrTest.BuildsValidSsaForControlFlow]=]  /root/repo/_aot_build/bin/ir_test [==[--gtest_filter=IrTest.BuildsValidSsaForControlFlow]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IrTest.BuildsValidSsaForControlFlow]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ir_test.cpp:76]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[IrTest.RejectsNestedFunctions]=]  /root/repo/_aot_build/bin/ir_test [==[--gtest_filter=IrTest.RejectsNestedFunctions]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IrTest.RejectsNestedFunctions]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ir_test.cpp:91]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[IrTest.FoldsConstantsAndBranches]=]  /root/repo/_aot_build/bin/ir_test [==[--gtest_filter=IrTest.FoldsConstantsAndBranches]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IrTest.FoldsConstantsAndBranches]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ir_test.cpp:95]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[IrTest.KeepsInstructionsThatCanThrow]=]  /root/repo/_aot_build/bin/ir_test [==[--gtest_filter=IrTest.KeepsInstructionsThatCanThrow]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IrTest.KeepsInstructionsThatCanThrow]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ir_test.cpp:113]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[IrTest.EliminatesCommonSubexpressions]=]  /root/repo/_aot_build/bin/ir_test [==[--gtest_filter=IrTest.EliminatesCommonSubexpressions]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IrTest.EliminatesCommonSubexpressions]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ir_test.cpp:128]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[IrTest.HoistsLoopInvariants]=]  /root/repo/_aot_build/bin/ir_test [==[--gtest_filter=IrTest.HoistsLoopInvariants]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IrTest.HoistsLoopInvariants]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ir_test.cpp:136]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[IrTest.InlinesSmallFunctionsBehindAGuard]=]  /root/repo/_aot_build/bin/ir_test [==[--gtest_filter=IrTest.InlinesSmallFunctionsBehindAGuard]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IrTest.InlinesSmallFunctionsBehindAGuard]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ir_test.cpp:158]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[IrTest.DoesNotInlineRecursiveFunctions]=]  /root/repo/_aot_build/bin/ir_test [==[--gtest_filter=IrTest.DoesNotInlineRecursiveFunctions]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IrTest.DoesNotInlineRecursiveFunctions]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ir_test.cpp:190]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[IrTest.InfersTypesThroughLoops]=]  /root/repo/_aot_build/bin/ir_test [==[--gtest_filter=IrTest.InfersTypesThroughLoops]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IrTest.InfersTypesThroughLoops]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ir_test.cpp:210]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[IrTest.PromotesLoopVariablesWithoutCalls]=]  /root/repo/_aot_build/bin/ir_test [==[--gtest_filter=IrTest.PromotesLoopVariablesWithoutCalls]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IrTest.PromotesLoopVariablesWithoutCalls]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ir_test.cpp:235]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[IrTest.GuardsSpeculatedLoopVariables]=]  /root/repo/_aot_build/bin/ir_test [==[--gtest_filter=IrTest.GuardsSpeculatedLoopVariables]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[IrTest.GuardsSpeculatedLoopVariables]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ir_test.cpp:264]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+set(ir_test_TESTS [==[IrTest.BuildsValidSsaForControlFlow]==] [==[IrTest.RejectsNestedFunctions]==] [==[IrTest.FoldsConstantsAndBranches]==] [==[IrTest.KeepsInstructionsThatCanThrow]==] [==[IrTest.EliminatesCommonSubexpressions]==] [==[IrTest.HoistsLoopInvariants]==] [==[IrTest.InlinesSmallFunctionsBehindAGuard]==] [==[IrTest.DoesNotInlineRecursiveFunctions]==] [==[IrTest.InfersTypesThroughLoops]==] [==[IrTest.PromotesLoopVariablesWithoutCalls]==] [==[IrTest.GuardsSpeculatedLoopVariables]==])
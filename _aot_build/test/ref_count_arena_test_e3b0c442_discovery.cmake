@@ -0,0 +1,20 @@
+include("/root/.pyenv/versions/3.11.7/lib/python3.11/site-packages/cmake/data/share/cmake-4.4/Modules/GoogleTestAddTests.cmake")
+gtest_discover_tests_impl(
+  TEST_TARGET [==[ref_count_arena_test]==]
+  TEST_EXECUTABLE [==[/root/repo/_aot_build/bin/ref_count_arena_test]==]
+  TEST_EXECUTOR [==[]==]
+  TEST_WORKING_DIR [==[/root/repo/_aot_build/test]==]
+  TEST_EXTRA_ARGS [==[]==]
+  TEST_PROPERTIES [==[]==]
+  TEST_PREFIX [==[]==]
+  TEST_SUFFIX [==[]==]
+  TEST_FILTER [==[]==]
+  NO_PRETTY_TYPES [==[FALSE]==]
+  NO_PRETTY_VALUES [==[FALSE]==]
+  TEST_LIST [==[ref_count_arena_test_TESTS]==]
+  CTEST_FILE [==[/root/repo/_aot_build/test/ref_count_arena_test_e3b0c442_tests.cmake]==]
+  TEST_DISCOVERY_TIMEOUT [==[5]==]
+  TEST_DISCOVERY_EXTRA_ARGS [==[]==]
+  TEST_XML_OUTPUT_DIR [==[]==]
+  TEST_JSON_OUTPUT_DIR [==[/root/repo/_aot_build/test]==]
+)
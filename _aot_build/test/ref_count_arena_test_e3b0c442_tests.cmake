@@ -0,0 +1,37 @@
+add_test([=[RefCountArenaTest.HandsOutAlignedSeparateBlocks]=]  /root/repo/_aot_build/bin/ref_count_arena_test [==[--gtest_filter=RefCountArenaTest.HandsOutAlignedSeparateBlocks]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[RefCountArenaTest.HandsOutAlignedSeparateBlocks]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ref_count_arena_test.cpp:14]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[RefCountArenaTest.ReusesFreedBlocksOfTheSameSize]=]  /root/repo/_aot_build/bin/ref_count_arena_test [==[--gtest_filter=RefCountArenaTest.ReusesFreedBlocksOfTheSameSize]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[RefCountArenaTest.ReusesFreedBlocksOfTheSameSize]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ref_count_arena_test.cpp:32]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[RefCountArenaTest.AllocatesLargeBlocksFromTheHeap]=]  /root/repo/_aot_build/bin/ref_count_arena_test [==[--gtest_filter=RefCountArenaTest.AllocatesLargeBlocksFromTheHeap]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[RefCountArenaTest.AllocatesLargeBlocksFromTheHeap]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ref_count_arena_test.cpp:47]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[RefCountArenaTest.HoldsControlBlocksOfSharedPointers]=]  /root/repo/_aot_build/bin/ref_count_arena_test [==[--gtest_filter=RefCountArenaTest.HoldsControlBlocksOfSharedPointers]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[RefCountArenaTest.HoldsControlBlocksOfSharedPointers]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/ref_count_arena_test.cpp:55]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+set(ref_count_arena_test_TESTS [==[RefCountArenaTest.HandsOutAlignedSeparateBlocks]==] [==[RefCountArenaTest.ReusesFreedBlocksOfTheSameSize]==] [==[RefCountArenaTest.AllocatesLargeBlocksFromTheHeap]==] [==[RefCountArenaTest.HoldsControlBlocksOfSharedPointers]==])
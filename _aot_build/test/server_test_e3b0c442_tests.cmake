@@ -0,0 +1,28 @@
+add_test([=[ServerTest.AnswersEachRequestOnOneLine]=]  /root/repo/_aot_build/bin/server_test [==[--gtest_filter=ServerTest.AnswersEachRequestOnOneLine]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerTest.AnswersEachRequestOnOneLine]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/server_test.cpp:110]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[ServerTest.ReplacesWorkerThatDiesServingRequest]=]  /root/repo/_aot_build/bin/server_test [==[--gtest_filter=ServerTest.ReplacesWorkerThatDiesServingRequest]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerTest.ReplacesWorkerThatDiesServingRequest]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/server_test.cpp:120]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+add_test([=[ServerTest.ReplacesWorkerThatDiesBetweenRequests]=]  /root/repo/_aot_build/bin/server_test [==[--gtest_filter=ServerTest.ReplacesWorkerThatDiesBetweenRequests]==] --gtest_also_run_disabled_tests)
+set_tests_properties([=[ServerTest.ReplacesWorkerThatDiesBetweenRequests]=]
+  PROPERTIES
+    
+    DEF_SOURCE_LINE [==[/root/repo/test/server_test.cpp:131]==]
+    WORKING_DIRECTORY [==[/root/repo/_aot_build/test]==]
+    SKIP_REGULAR_EXPRESSION [==[\[  SKIPPED \]]==]
+    
+)
+set(server_test_TESTS [==[ServerTest.AnswersEachRequestOnOneLine]==] [==[ServerTest.ReplacesWorkerThatDiesServingRequest]==] [==[ServerTest.ReplacesWorkerThatDiesBetweenRequests]==])
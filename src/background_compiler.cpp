@@ -0,0 +1,59 @@
+#include "background_compiler.h"
+
+#include <utility>
+
+namespace cclox {
+BackgroundCompiler::~BackgroundCompiler() {
+  Cancel();
+  Stop();
+}
+
+auto BackgroundCompiler::Submit(Job job) -> void {
+  {
+    std::lock_guard lock{mutex_};
+    jobs_.push_back(std::move(job));
+    if (!thread_.joinable()) {
+      thread_ = std::thread{[this] { Run(); }};
+    }
+  }
+  condition_.notify_all();
+}
+
+auto BackgroundCompiler::Cancel() -> void {
+  std::unique_lock lock{mutex_};
+  jobs_.clear();
+  condition_.wait(lock, [this] { return !running_; });
+}
+
+auto BackgroundCompiler::Stop() -> void {
+  {
+    std::lock_guard lock{mutex_};
+    stopping_ = true;
+  }
+  condition_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  stopping_ = false;
+}
+
+auto BackgroundCompiler::Run() -> void {
+  std::unique_lock lock{mutex_};
+  while (true) {
+    condition_.wait(lock, [this] { return stopping_ || !jobs_.empty(); });
+    if (jobs_.empty()) {
+      return;
+    }
+    Job job = std::move(jobs_.front());
+    jobs_.pop_front();
+    running_ = true;
+    lock.unlock();
+    job();
+    // What the job captured dies here, not under the lock.
+    job = nullptr;
+    lock.lock();
+    running_ = false;
+    condition_.notify_all();
+  }
+}
+}  // namespace cclox
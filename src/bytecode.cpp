@@ -0,0 +1,92 @@
+#include "bytecode.h"
+
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <string>
+
+namespace cclox::bytecode {
+auto OpCodeName(OpCode opcode) -> std::string_view {
+  switch (opcode) {
+#define CCLOX_BYTECODE_OP(name) \
+  case OpCode::name:            \
+    return #name;
+    CCLOX_BYTECODE_OPCODES(CCLOX_BYTECODE_OP)
+#undef CCLOX_BYTECODE_OP
+  }
+  return "?";
+}
+
+auto Disassemble(const Chunk& chunk, std::ostream& output) -> void {
+  output << std::format("chunk {}/{} ({} stack slots)\n", chunk.name,
+                        chunk.arity, chunk.max_stack);
+  for (size_t i = 0; i < chunk.code.size(); i++) {
+    const Instruction& instruction = chunk.code[i];
+    std::string name{OpCodeName(instruction.opcode)};
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    std::string text = std::format("{:4}  {}", i, name);
+
+    using enum OpCode;
+    switch (instruction.opcode) {
+      case CONSTANT: {
+        const Object& constant = chunk.constants[instruction.a];
+        text += " " + (constant.IsString()
+                           ? std::format("\"{}\"", constant.ToString())
+                           : constant.ToString());
+        break;
+      }
+      case GET_LOCAL:
+      case SET_LOCAL:
+      case SET_LOCAL_POP:
+        text += std::format(" {}  ; {}", instruction.a,
+                            chunk.tokens[instruction.token].GetLexeme());
+        break;
+      case GET_GLOBAL:
+      case SET_GLOBAL:
+      case GET_PROPERTY:
+      case CHECK_INSTANCE:
+      case SET_PROPERTY:
+        text += " " + chunk.tokens[instruction.token].GetLexeme();
+        break;
+      case GET_FREE:
+      case SET_FREE:
+        text += std::format(" {}@{}",
+                            chunk.tokens[instruction.token].GetLexeme(),
+                            instruction.a);
+        break;
+      case ADD_LOCAL_CONSTANT:
+      case SUBTRACT_LOCAL_CONSTANT:
+        text += std::format(" {}, {}", instruction.a,
+                            chunk.constants[instruction.b].ToString());
+        break;
+      case GET_LOCAL_GET_LOCAL:
+        text += std::format(" {}, {}", instruction.a, instruction.b);
+        break;
+      case INVOKE:
+        text += std::format(" {} ({} arguments)",
+                            chunk.tokens[instruction.token].GetLexeme(),
+                            instruction.a);
+        break;
+      case CALL:
+        text += std::format(" ({} arguments)", instruction.a);
+        break;
+      case JUMP:
+      case JUMP_IF_FALSE:
+      case JUMP_IF_FALSE_OR_POP:
+      case JUMP_IF_TRUE_OR_POP:
+      case LESS_JUMP_IF_FALSE:
+      case LESS_EQUAL_JUMP_IF_FALSE:
+      case GREATER_JUMP_IF_FALSE:
+      case GREATER_EQUAL_JUMP_IF_FALSE:
+      case EQUAL_JUMP_IF_FALSE:
+      case NOT_EQUAL_JUMP_IF_FALSE:
+        text += std::format(" -> {}", instruction.a);
+        break;
+      default:
+        break;
+    }
+    output << text << '\n';
+  }
+}
+}  // namespace cclox::bytecode
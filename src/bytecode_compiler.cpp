@@ -0,0 +1,494 @@
+#include "bytecode_compiler.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+
+#include "interpreter.h"
+#include "token_type.h"
+
+namespace cclox {
+using bytecode::OpCode;
+
+namespace {
+/**
+ * @brief Thrown while compiling when the function uses a construct the
+ * bytecode does not handle. The function then stays in the interpreter.
+ */
+class BytecodeUnsupported : public std::runtime_error {
+ public:
+  explicit BytecodeUnsupported(const std::string& message)
+      : std::runtime_error(message) {}
+};
+
+/**
+ * @brief How many values the instruction pushes minus how many it pops. For
+ * conditional jumps that pop on one path only, the path falling through.
+ */
+auto StackEffect(OpCode opcode, uint32_t a) -> int64_t {
+  using enum OpCode;
+  switch (opcode) {
+    case CONSTANT:
+    case GET_LOCAL:
+    case GET_GLOBAL:
+    case GET_FREE:
+    case ADD_LOCAL_CONSTANT:
+    case SUBTRACT_LOCAL_CONSTANT:
+      return 1;
+    case GET_LOCAL_GET_LOCAL:
+      return 2;
+    case POP:
+    case SET_PROPERTY:
+    case ADD:
+    case SUBTRACT:
+    case MULTIPLY:
+    case DIVIDE:
+    case EQUAL:
+    case NOT_EQUAL:
+    case LESS:
+    case LESS_EQUAL:
+    case GREATER:
+    case GREATER_EQUAL:
+    case JUMP_IF_FALSE:
+    case JUMP_IF_FALSE_OR_POP:
+    case JUMP_IF_TRUE_OR_POP:
+    case PRINT:
+    case RETURN:
+    case SET_LOCAL_POP:
+      return -1;
+    case LESS_JUMP_IF_FALSE:
+    case LESS_EQUAL_JUMP_IF_FALSE:
+    case GREATER_JUMP_IF_FALSE:
+    case GREATER_EQUAL_JUMP_IF_FALSE:
+    case EQUAL_JUMP_IF_FALSE:
+    case NOT_EQUAL_JUMP_IF_FALSE:
+      return -2;
+    case CALL:
+    case INVOKE:
+      return -static_cast<int64_t>(a);
+    default:
+      return 0;
+  }
+}
+
+/**
+ * @brief The superinstruction for a comparison followed by `JUMP_IF_FALSE`.
+ */
+auto FusedCompareJump(OpCode comparison) -> std::optional<OpCode> {
+  using enum OpCode;
+  switch (comparison) {
+    case LESS:
+      return LESS_JUMP_IF_FALSE;
+    case LESS_EQUAL:
+      return LESS_EQUAL_JUMP_IF_FALSE;
+    case GREATER:
+      return GREATER_JUMP_IF_FALSE;
+    case GREATER_EQUAL:
+      return GREATER_EQUAL_JUMP_IF_FALSE;
+    case EQUAL:
+      return EQUAL_JUMP_IF_FALSE;
+    case NOT_EQUAL:
+      return NOT_EQUAL_JUMP_IF_FALSE;
+    default:
+      return std::nullopt;
+  }
+}
+}  // namespace
+
+auto BytecodeCompiler::Compile(const FunctionStmt& function)
+    -> std::optional<bytecode::Chunk> {
+  if (!function.IsBodyParsed()) {
+    return std::nullopt;
+  }
+  chunk_ = bytecode::Chunk{};
+  chunk_.name = function.GetFunctionName().GetLexeme();
+  chunk_.arity = function.GetParams().size();
+  scopes_.clear();
+  token_indices_.clear();
+  // Instructions without a token of their own use the function's name.
+  AddToken(function.GetFunctionName());
+  depth_ = 0;
+  fusion_barrier_ = 0;
+
+  try {
+    // The arguments are in the first slots when the frame starts.
+    scopes_.emplace_back();
+    for (const Token& param : function.GetParams()) {
+      depth_++;
+      Declare(param);
+    }
+    chunk_.max_stack = depth_;
+    for (const auto& statement : function.GetBody()) {
+      CompileStatement(statement);
+    }
+  } catch (const BytecodeUnsupported&) {
+    return std::nullopt;
+  }
+
+  // Falling off the end of a function returns nil.
+  EmitConstant(Object{nullptr}, function.GetFunctionName());
+  Emit(OpCode::RETURN, function.GetFunctionName());
+  return std::move(chunk_);
+}
+
+// ====================Statement Visitors====================
+auto BytecodeCompiler::operator()(const BlockStmtPtr& stmt) -> void {
+  scopes_.emplace_back();
+  for (const auto& statement : stmt->GetStatements()) {
+    CompileStatement(statement);
+  }
+  EndScope();
+}
+
+auto BytecodeCompiler::operator()(const ClassStmtPtr&) -> void {
+  throw BytecodeUnsupported("class declaration");
+}
+
+auto BytecodeCompiler::operator()(const ExprStmtPtr& stmt) -> void {
+  CompileExpression(stmt->GetExpression());
+  Emit(OpCode::POP, chunk_.tokens[0]);
+}
+
+auto BytecodeCompiler::operator()(const FunctionStmtPtr&) -> void {
+  throw BytecodeUnsupported("nested function");
+}
+
+auto BytecodeCompiler::operator()(const IfStmtPtr& stmt) -> void {
+  CompileExpression(stmt->GetCondition());
+  size_t then_jump = Emit(OpCode::JUMP_IF_FALSE, chunk_.tokens[0]);
+  CompileStatement(stmt->GetThenBranch());
+
+  const std::optional<StmtPtr>& else_branch_opt = stmt->GetElseBranch();
+  if (!else_branch_opt) {
+    PatchJump(then_jump);
+    return;
+  }
+  size_t else_jump = Emit(OpCode::JUMP, chunk_.tokens[0]);
+  PatchJump(then_jump);
+  CompileStatement(else_branch_opt.value());
+  PatchJump(else_jump);
+}
+
+auto BytecodeCompiler::operator()(const PrintStmtPtr& stmt) -> void {
+  CompileExpression(stmt->GetExpression());
+  Emit(OpCode::PRINT, chunk_.tokens[0]);
+}
+
+auto BytecodeCompiler::operator()(const ReturnStmtPtr& stmt) -> void {
+  const std::optional<ExprPtr>& value_expr_opt = stmt->GetValue();
+  if (value_expr_opt) {
+    CompileExpression(value_expr_opt.value());
+  } else {
+    EmitConstant(Object{nullptr}, stmt->GetKeyword());
+  }
+  Emit(OpCode::RETURN, stmt->GetKeyword());
+}
+
+auto BytecodeCompiler::operator()(const VarStmtPtr& stmt) -> void {
+  const std::optional<ExprPtr>& initializer_opt = stmt->GetInitializer();
+  if (initializer_opt) {
+    CompileExpression(initializer_opt.value());
+  } else {
+    EmitConstant(Object{nullptr}, stmt->GetVariable());
+  }
+  Declare(stmt->GetVariable());
+}
+
+auto BytecodeCompiler::operator()(const WhileStmtPtr& stmt) -> void {
+  uint32_t start = Label();
+  CompileExpression(stmt->GetCondition());
+  size_t exit_jump = Emit(OpCode::JUMP_IF_FALSE, chunk_.tokens[0]);
+  CompileStatement(stmt->GetBody());
+  Emit(OpCode::JUMP, chunk_.tokens[0], start);
+  PatchJump(exit_jump);
+}
+
+// ====================Expression Visitors====================
+auto BytecodeCompiler::operator()(const AssignExprPtr& expr) -> void {
+  CompileExpression(expr->GetValue());
+  const Token& name = expr->GetVariable();
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(expr);
+  if (!depth) {
+    Emit(OpCode::SET_GLOBAL, name);
+    return;
+  }
+  if (std::optional<uint32_t> slot = FindLocal(name.GetLexeme(), depth.value())) {
+    Emit(OpCode::SET_LOCAL, name, slot.value());
+    return;
+  }
+  Emit(OpCode::SET_FREE, name,
+       static_cast<uint32_t>(depth.value() - scopes_.size()));
+}
+
+auto BytecodeCompiler::operator()(const BinaryExprPtr& expr) -> void {
+  CompileExpression(expr->GetLeftExpression());
+  CompileExpression(expr->GetRightExpression());
+
+  using enum TokenType;
+  const Token& op = expr->GetOperator();
+  OpCode opcode = OpCode::ADD;
+  switch (op.GetType()) {
+    case BANG_EQUAL:
+      opcode = OpCode::NOT_EQUAL;
+      break;
+    case EQUAL_EQUAL:
+      opcode = OpCode::EQUAL;
+      break;
+    case GREATER:
+      opcode = OpCode::GREATER;
+      break;
+    case GREATER_EQUAL:
+      opcode = OpCode::GREATER_EQUAL;
+      break;
+    case LESS:
+      opcode = OpCode::LESS;
+      break;
+    case LESS_EQUAL:
+      opcode = OpCode::LESS_EQUAL;
+      break;
+    case MINUS:
+      opcode = OpCode::SUBTRACT;
+      break;
+    case PLUS:
+      opcode = OpCode::ADD;
+      break;
+    case SLASH:
+      opcode = OpCode::DIVIDE;
+      break;
+    case STAR:
+      opcode = OpCode::MULTIPLY;
+      break;
+    default:
+      throw BytecodeUnsupported("binary operator");
+  }
+  Emit(opcode, op);
+}
+
+auto BytecodeCompiler::operator()(const CallExprPtr& expr) -> void {
+  const std::vector<ExprPtr>& arguments = expr->GetArguments();
+  auto argument_count = static_cast<uint32_t>(arguments.size());
+
+  // A method call looks the method up before evaluating the arguments, so
+  // the lookup can only be delayed into `INVOKE` past simple arguments.
+  const auto* get = std::get_if<GetExprPtr>(&expr->GetCallee());
+  if (superinstructions_ && get != nullptr &&
+      std::all_of(arguments.begin(), arguments.end(),
+                  [&](const ExprPtr& argument) { return IsSimple(argument); })) {
+    CompileExpression((*get)->GetObject());
+    for (const auto& argument : arguments) {
+      CompileExpression(argument);
+    }
+    size_t invoke = Emit(OpCode::INVOKE, (*get)->GetProperty(), argument_count);
+    // Errors from the call itself are reported at the parenthesis.
+    chunk_.code[invoke].b = AddToken(expr->GetParen());
+    return;
+  }
+
+  CompileExpression(expr->GetCallee());
+  for (const auto& argument : arguments) {
+    CompileExpression(argument);
+  }
+  Emit(OpCode::CALL, expr->GetParen(), argument_count);
+}
+
+auto BytecodeCompiler::operator()(const GetExprPtr& expr) -> void {
+  CompileExpression(expr->GetObject());
+  Emit(OpCode::GET_PROPERTY, expr->GetProperty());
+}
+
+auto BytecodeCompiler::operator()(const GroupingExprPtr& expr) -> void {
+  CompileExpression(expr->GetExpression());
+}
+
+auto BytecodeCompiler::operator()(const LiteralExprPtr& expr) -> void {
+  EmitConstant(expr->GetValue(), chunk_.tokens[0]);
+}
+
+auto BytecodeCompiler::operator()(const LogicalExprPtr& expr) -> void {
+  CompileExpression(expr->GetLeftExpression());
+  // The left operand is the result when it short-circuits.
+  size_t jump = Emit(expr->GetOperator().GetType() == TokenType::OR
+                         ? OpCode::JUMP_IF_TRUE_OR_POP
+                         : OpCode::JUMP_IF_FALSE_OR_POP,
+                     expr->GetOperator());
+  CompileExpression(expr->GetRightExpression());
+  PatchJump(jump);
+}
+
+auto BytecodeCompiler::operator()(const SetExprPtr& expr) -> void {
+  CompileExpression(expr->GetObject());
+  Emit(OpCode::CHECK_INSTANCE, expr->GetProperty());
+  CompileExpression(expr->GetValue());
+  Emit(OpCode::SET_PROPERTY, expr->GetProperty());
+}
+
+auto BytecodeCompiler::operator()(const SuperExprPtr&) -> void {
+  throw BytecodeUnsupported("super");
+}
+
+auto BytecodeCompiler::operator()(const ThisExprPtr& expr) -> void {
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(expr);
+  if (!depth) {
+    throw BytecodeUnsupported("unresolved this");
+  }
+  Emit(OpCode::GET_FREE, expr->GetKeyword(),
+       static_cast<uint32_t>(depth.value() - scopes_.size()));
+}
+
+auto BytecodeCompiler::operator()(const UnaryExprPtr& expr) -> void {
+  CompileExpression(expr->GetRightExpression());
+  const Token& op = expr->GetOperator();
+  Emit(op.GetType() == TokenType::BANG ? OpCode::NOT : OpCode::NEGATE, op);
+}
+
+auto BytecodeCompiler::operator()(const VariableExprPtr& expr) -> void {
+  const Token& name = expr->GetVariable();
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(expr);
+  if (!depth) {
+    Emit(OpCode::GET_GLOBAL, name);
+    return;
+  }
+  if (std::optional<uint32_t> slot = FindLocal(name.GetLexeme(), depth.value())) {
+    Emit(OpCode::GET_LOCAL, name, slot.value());
+    return;
+  }
+  Emit(OpCode::GET_FREE, name,
+       static_cast<uint32_t>(depth.value() - scopes_.size()));
+}
+
+// ====================Private Methods====================
+auto BytecodeCompiler::CompileStatement(const StmtPtr& stmt) -> void {
+  std::visit(*this, stmt);
+}
+
+auto BytecodeCompiler::CompileExpression(const ExprPtr& expr) -> void {
+  std::visit(*this, expr);
+}
+
+auto BytecodeCompiler::Emit(OpCode opcode, const Token& token, uint32_t a,
+                            uint32_t b) -> size_t {
+  bytecode::Instruction instruction;
+  instruction.opcode = opcode;
+  instruction.token = AddToken(token);
+  instruction.a = a;
+  instruction.b = b;
+  chunk_.code.push_back(instruction);
+
+  depth_ = static_cast<size_t>(static_cast<int64_t>(depth_) +
+                               StackEffect(opcode, a));
+  chunk_.max_stack = std::max(chunk_.max_stack, depth_);
+  if (superinstructions_) {
+    Fuse();
+  }
+  return chunk_.code.size() - 1;
+}
+
+auto BytecodeCompiler::EmitConstant(const Object& value, const Token& token)
+    -> void {
+  chunk_.constants.push_back(value);
+  Emit(OpCode::CONSTANT, token,
+       static_cast<uint32_t>(chunk_.constants.size() - 1));
+}
+
+auto BytecodeCompiler::PatchJump(size_t jump) -> void {
+  chunk_.code[jump].a = Label();
+}
+
+auto BytecodeCompiler::Label() -> uint32_t {
+  fusion_barrier_ = chunk_.code.size();
+  return static_cast<uint32_t>(chunk_.code.size());
+}
+
+auto BytecodeCompiler::Fuse() -> void {
+  std::vector<bytecode::Instruction>& code = chunk_.code;
+  // The number of instructions that may be fused, ending with the new one.
+  size_t fusible = code.size() - fusion_barrier_;
+  if (fusible < 2) {
+    return;
+  }
+  bytecode::Instruction& last = code.back();
+  bytecode::Instruction& previous = code[code.size() - 2];
+
+  using enum OpCode;
+  // local + constant, local - constant
+  if ((last.opcode == ADD || last.opcode == SUBTRACT) && fusible >= 3 &&
+      previous.opcode == CONSTANT &&
+      code[code.size() - 3].opcode == GET_LOCAL) {
+    bytecode::Instruction& local = code[code.size() - 3];
+    local.opcode =
+        last.opcode == ADD ? ADD_LOCAL_CONSTANT : SUBTRACT_LOCAL_CONSTANT;
+    local.b = previous.a;
+    local.token = last.token;
+    code.resize(code.size() - 2);
+    return;
+  }
+  if (last.opcode == GET_LOCAL && previous.opcode == GET_LOCAL) {
+    previous.opcode = GET_LOCAL_GET_LOCAL;
+    previous.b = last.a;
+    code.pop_back();
+    return;
+  }
+  if (last.opcode == JUMP_IF_FALSE) {
+    if (std::optional<OpCode> fused = FusedCompareJump(previous.opcode)) {
+      previous.opcode = fused.value();
+      previous.a = last.a;
+      code.pop_back();
+    }
+    return;
+  }
+  if (last.opcode == POP && previous.opcode == SET_LOCAL) {
+    previous.opcode = SET_LOCAL_POP;
+    code.pop_back();
+  }
+}
+
+auto BytecodeCompiler::AddToken(const Token& token) -> uint32_t {
+  // Runtime errors and lookups only use the lexeme and the line.
+  auto key = std::pair{token.GetLineNumber(), token.GetLexeme()};
+  auto [it, inserted] = token_indices_.try_emplace(
+      std::move(key), static_cast<uint32_t>(chunk_.tokens.size()));
+  if (inserted) {
+    chunk_.tokens.push_back(token);
+  }
+  return it->second;
+}
+
+auto BytecodeCompiler::Declare(const Token& name) -> void {
+  scopes_.back()[name.GetLexeme()] = static_cast<uint32_t>(depth_ - 1);
+}
+
+auto BytecodeCompiler::EndScope() -> void {
+  for (size_t i = 0; i < scopes_.back().size(); i++) {
+    Emit(OpCode::POP, chunk_.tokens[0]);
+  }
+  scopes_.pop_back();
+}
+
+auto BytecodeCompiler::FindLocal(const std::string& name, uint64_t depth) const
+    -> std::optional<uint32_t> {
+  // Deeper variables belong to enclosing functions.
+  if (depth >= scopes_.size()) {
+    return std::nullopt;
+  }
+  const auto& scope = scopes_[scopes_.size() - 1 - depth];
+  auto it = scope.find(name);
+  if (it == scope.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+auto BytecodeCompiler::IsSimple(const ExprPtr& expr) const -> bool {
+  if (std::holds_alternative<LiteralExprPtr>(expr)) {
+    return true;
+  }
+  const auto* variable = std::get_if<VariableExprPtr>(&expr);
+  if (variable == nullptr) {
+    return false;
+  }
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(*variable);
+  return depth && FindLocal((*variable)->GetVariable().GetLexeme(),
+                            depth.value());
+}
+}  // namespace cclox
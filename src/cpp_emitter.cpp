@@ -0,0 +1,921 @@
+#include "cpp_emitter.h"
+
+#include <format>
+#include <variant>
+
+#include "interpreter.h"
+#include "lox.h"
+#include "token_type.h"
+
+namespace cclox {
+namespace {
+// The natives that run functions as tasks.
+const std::unordered_set<std::string> kTaskNatives{
+    "spawn", "parallelMap", "parallelReduce", "parallelFor"};
+}  // namespace
+
+// ====================LexicalScopes====================
+auto LexicalScopes::Declare(const Token& variable) -> void {
+  scopes_.back().insert_or_assign(variable.GetLexeme(),
+                                  Binding{&variable, function_depth_});
+}
+
+auto LexicalScopes::Find(const std::string& name) const
+    -> std::optional<Binding> {
+  for (auto rit = scopes_.rbegin(); rit != scopes_.rend(); rit++) {
+    auto it = rit->find(name);
+    if (it != rit->end()) {
+      return it->second;
+    }
+  }
+  return std::nullopt;
+}
+
+/**
+ * @brief Collects the `ProgramInfo` of a program in one walk over its AST.
+ */
+class ProgramAnalyzer {
+ public:
+  explicit ProgramAnalyzer(ProgramInfo& info) : info_(info) {}
+
+  auto Analyze(const std::vector<StmtPtr>& statements) -> void;
+
+  // ====================Statement Visitors====================
+  auto operator()(const BlockStmtPtr& stmt) -> void;
+
+  auto operator()(const ClassStmtPtr& stmt) -> void;
+
+  auto operator()(const ExprStmtPtr& stmt) -> void;
+
+  auto operator()(const FunctionStmtPtr& stmt) -> void;
+
+  auto operator()(const IfStmtPtr& stmt) -> void;
+
+  auto operator()(const PrintStmtPtr& stmt) -> void;
+
+  auto operator()(const ReturnStmtPtr& stmt) -> void;
+
+  auto operator()(const VarStmtPtr& stmt) -> void;
+
+  auto operator()(const WhileStmtPtr& stmt) -> void;
+
+  // ====================Expression Visitors====================
+  auto operator()(const AssignExprPtr& expr) -> void;
+
+  auto operator()(const BinaryExprPtr& expr) -> void;
+
+  auto operator()(const CallExprPtr& expr) -> void;
+
+  auto operator()(const GetExprPtr& expr) -> void;
+
+  auto operator()(const GroupingExprPtr& expr) -> void;
+
+  auto operator()(const LiteralExprPtr& expr) -> void;
+
+  auto operator()(const LogicalExprPtr& expr) -> void;
+
+  auto operator()(const SetExprPtr& expr) -> void;
+
+  auto operator()(const SuperExprPtr& expr) -> void;
+
+  auto operator()(const ThisExprPtr& expr) -> void;
+
+  auto operator()(const UnaryExprPtr& expr) -> void;
+
+  auto operator()(const VariableExprPtr& expr) -> void;
+
+ private:
+  auto AnalyzeStatement(const StmtPtr& stmt) -> void;
+
+  auto AnalyzeExpression(const ExprPtr& expr) -> void;
+
+  auto AnalyzeFunction(const FunctionStmt& function) -> void;
+
+  auto Declare(const Token& variable) -> void;
+
+  /**
+   * @brief Records a read of or an assignment to `variable`.
+   * @return `true` if `variable` is a global.
+   */
+  auto Reference(const Token& variable) -> bool;
+
+  ProgramInfo& info_;
+  LexicalScopes scopes_;
+  std::unordered_map<std::string, size_t> global_declarations_;
+  std::unordered_set<std::string> assigned_globals_;
+  std::unordered_map<std::string, const FunctionStmt*> global_functions_;
+};
+
+auto ProgramAnalyzer::Analyze(const std::vector<StmtPtr>& statements) -> void {
+  for (const auto& statement : statements) {
+    AnalyzeStatement(statement);
+  }
+
+  for (const auto& [name, function] : global_functions_) {
+    if (global_declarations_[name] == 1 && !assigned_globals_.contains(name)) {
+      info_.direct_functions.emplace(name, function);
+    }
+  }
+  // A program may declare its own global of the same name.
+  std::erase_if(info_.task_natives, [this](const Token* reference) {
+    return global_declarations_.contains(reference->GetLexeme());
+  });
+}
+
+// ====================Statements====================
+auto ProgramAnalyzer::operator()(const BlockStmtPtr& stmt) -> void {
+  scopes_.Push();
+  for (const auto& statement : stmt->GetStatements()) {
+    AnalyzeStatement(statement);
+  }
+  scopes_.Pop();
+}
+
+auto ProgramAnalyzer::operator()(const ClassStmtPtr& stmt) -> void {
+  if (stmt->GetSuperclass()) {
+    (*this)(stmt->GetSuperclass());
+  }
+  Declare(stmt->GetClassName());
+  for (const auto& method : stmt->GetClassMethods()) {
+    AnalyzeFunction(*std::get<FunctionStmtPtr>(method));
+  }
+}
+
+auto ProgramAnalyzer::operator()(const ExprStmtPtr& stmt) -> void {
+  AnalyzeExpression(stmt->GetExpression());
+}
+
+auto ProgramAnalyzer::operator()(const FunctionStmtPtr& stmt) -> void {
+  if (scopes_.IsGlobalScope()) {
+    global_functions_[stmt->GetFunctionName().GetLexeme()] = stmt.get();
+  }
+  Declare(stmt->GetFunctionName());
+  AnalyzeFunction(*stmt);
+}
+
+auto ProgramAnalyzer::operator()(const IfStmtPtr& stmt) -> void {
+  AnalyzeExpression(stmt->GetCondition());
+  AnalyzeStatement(stmt->GetThenBranch());
+  if (stmt->GetElseBranch()) {
+    AnalyzeStatement(stmt->GetElseBranch().value());
+  }
+}
+
+auto ProgramAnalyzer::operator()(const PrintStmtPtr& stmt) -> void {
+  AnalyzeExpression(stmt->GetExpression());
+}
+
+auto ProgramAnalyzer::operator()(const ReturnStmtPtr& stmt) -> void {
+  if (stmt->GetValue()) {
+    AnalyzeExpression(stmt->GetValue().value());
+  }
+}
+
+auto ProgramAnalyzer::operator()(const VarStmtPtr& stmt) -> void {
+  if (stmt->GetInitializer()) {
+    AnalyzeExpression(stmt->GetInitializer().value());
+  }
+  Declare(stmt->GetVariable());
+}
+
+auto ProgramAnalyzer::operator()(const WhileStmtPtr& stmt) -> void {
+  AnalyzeExpression(stmt->GetCondition());
+  AnalyzeStatement(stmt->GetBody());
+}
+
+// ====================Expressions====================
+auto ProgramAnalyzer::operator()(const AssignExprPtr& expr) -> void {
+  AnalyzeExpression(expr->GetValue());
+  if (Reference(expr->GetVariable())) {
+    assigned_globals_.insert(expr->GetVariable().GetLexeme());
+  }
+}
+
+auto ProgramAnalyzer::operator()(const BinaryExprPtr& expr) -> void {
+  AnalyzeExpression(expr->GetLeftExpression());
+  AnalyzeExpression(expr->GetRightExpression());
+}
+
+auto ProgramAnalyzer::operator()(const CallExprPtr& expr) -> void {
+  AnalyzeExpression(expr->GetCallee());
+  for (const auto& argument : expr->GetArguments()) {
+    AnalyzeExpression(argument);
+  }
+}
+
+auto ProgramAnalyzer::operator()(const GetExprPtr& expr) -> void {
+  AnalyzeExpression(expr->GetObject());
+}
+
+auto ProgramAnalyzer::operator()(const GroupingExprPtr& expr) -> void {
+  AnalyzeExpression(expr->GetExpression());
+}
+
+auto ProgramAnalyzer::operator()(const LiteralExprPtr&) -> void {}
+
+auto ProgramAnalyzer::operator()(const LogicalExprPtr& expr) -> void {
+  AnalyzeExpression(expr->GetLeftExpression());
+  AnalyzeExpression(expr->GetRightExpression());
+}
+
+auto ProgramAnalyzer::operator()(const SetExprPtr& expr) -> void {
+  AnalyzeExpression(expr->GetObject());
+  AnalyzeExpression(expr->GetValue());
+}
+
+auto ProgramAnalyzer::operator()(const SuperExprPtr&) -> void {}
+
+auto ProgramAnalyzer::operator()(const ThisExprPtr&) -> void {}
+
+auto ProgramAnalyzer::operator()(const UnaryExprPtr& expr) -> void {
+  AnalyzeExpression(expr->GetRightExpression());
+}
+
+auto ProgramAnalyzer::operator()(const VariableExprPtr& expr) -> void {
+  Reference(expr->GetVariable());
+}
+
+// ====================Private helpers====================
+auto ProgramAnalyzer::AnalyzeStatement(const StmtPtr& stmt) -> void {
+  std::visit(*this, stmt);
+}
+
+auto ProgramAnalyzer::AnalyzeExpression(const ExprPtr& expr) -> void {
+  std::visit(*this, expr);
+}
+
+auto ProgramAnalyzer::AnalyzeFunction(const FunctionStmt& function) -> void {
+  scopes_.EnterFunction();
+  for (const Token& param : function.GetParams()) {
+    Declare(param);
+  }
+  for (const auto& statement : function.GetBody()) {
+    AnalyzeStatement(statement);
+  }
+  scopes_.LeaveFunction();
+}
+
+auto ProgramAnalyzer::Declare(const Token& variable) -> void {
+  if (scopes_.IsGlobalScope()) {
+    info_.globals.insert(variable.GetLexeme());
+    global_declarations_[variable.GetLexeme()]++;
+  } else {
+    scopes_.Declare(variable);
+  }
+}
+
+auto ProgramAnalyzer::Reference(const Token& variable) -> bool {
+  std::optional<LexicalScopes::Binding> binding =
+      scopes_.Find(variable.GetLexeme());
+  if (!binding) {
+    info_.globals.insert(variable.GetLexeme());
+    if (kTaskNatives.contains(variable.GetLexeme())) {
+      info_.task_natives.push_back(&variable);
+    }
+    return true;
+  }
+  if (binding->function_depth < scopes_.GetFunctionDepth()) {
+    info_.captured.insert(binding->declaration);
+  }
+  return false;
+}
+
+// ====================CppEmitter====================
+namespace {
+auto LocalName(const Token& variable) -> std::string {
+  return "l_" + variable.GetLexeme();
+}
+
+auto GlobalName(const std::string& name) -> std::string {
+  return "g_" + name;
+}
+
+auto DirectName(const std::string& name) -> std::string {
+  return "fn_" + name;
+}
+}  // namespace
+
+auto CppEmitter::Emit(const std::vector<StmtPtr>& statements,
+                      std::ostream& errors) -> bool {
+  ProgramAnalyzer{info_}.Analyze(statements);
+  for (const Token* reference : info_.task_natives) {
+    Lox::Error(errors, *reference, "Compiled programs can't run tasks.");
+  }
+  if (!info_.task_natives.empty()) {
+    return false;
+  }
+
+  // The interpreter's predefined globals are its natives.
+  const Interpreter natives;
+  for (const std::string& global : info_.globals) {
+    if (natives.GetGlobalEnvironment()->Find(global)) {
+      Line(std::format("{}.Define(rt::Native(\"{}\"));", GlobalName(global),
+                       global));
+    }
+  }
+  for (const auto& statement : statements) {
+    EmitStatement(statement);
+  }
+
+  output_ << "// Generated by `cclox --emit-cpp` from " << source_name_
+          << ".\n"
+          << "#include \"lox_runtime.h\"\n\n"
+          << "namespace {\n"
+          << "using cclox::Object;\n"
+          << "namespace rt = cclox::runtime;\n\n";
+  for (const std::string& global : info_.globals) {
+    output_ << std::format("rt::Global {}{{{}}};\n", GlobalName(global),
+                           Quote(global));
+  }
+  output_ << '\n';
+
+  // Direct functions may call each other in any order.
+  for (const auto& statement : statements) {
+    const auto* function = std::get_if<FunctionStmtPtr>(&statement);
+    if (function == nullptr) {
+      continue;
+    }
+    const std::string& name = (*function)->GetFunctionName().GetLexeme();
+    if (info_.direct_functions.contains(name)) {
+      std::string params;
+      for (const Token& param : (*function)->GetParams()) {
+        params += params.empty() ? "Object " : ", Object ";
+        params += (IsCaptured(param) ? "arg_" : "l_") + param.GetLexeme();
+      }
+      output_ << std::format("auto {}({}) -> Object;\n", DirectName(name),
+                             params);
+    }
+  }
+  output_ << '\n'
+          << functions_.str() << "auto Main() -> void {\n"
+          << main_.str() << "}\n"
+          << "}  // namespace\n\n"
+          << "auto main() -> int {\n"
+          << "  return cclox::runtime::Run(Main);\n"
+          << "}\n";
+  return true;
+}
+
+// ====================Statements====================
+auto CppEmitter::operator()(const BlockStmtPtr& stmt) -> void {
+  Line("{");
+  indent_++;
+  scopes_.Push();
+  for (const auto& statement : stmt->GetStatements()) {
+    EmitStatement(statement);
+  }
+  scopes_.Pop();
+  indent_--;
+  Line("}");
+}
+
+auto CppEmitter::operator()(const ClassStmtPtr& stmt) -> void {
+  const Token& name = stmt->GetClassName();
+  std::string superclass;
+  if (stmt->GetSuperclass()) {
+    superclass = std::format("super_{}", next_class_id_++);
+    const VariableExprPtr& superclass_expr = stmt->GetSuperclass();
+    Line(std::format("Object {} = rt::CheckSuperclass({}, {});", superclass,
+                     Box((*this)(superclass_expr)),
+                     superclass_expr->GetVariable().GetLineNumber()));
+  }
+  EmitDeclaration(name, "Object{nullptr}");
+
+  Line("{");
+  indent_++;
+  Line("cclox::LoxClass::MethodMap methods;");
+  superclasses_.push_back(superclass);
+  for (const auto& method_stmt : stmt->GetClassMethods()) {
+    const FunctionStmt& method = *std::get<FunctionStmtPtr>(method_stmt);
+    const std::string& method_name = method.GetFunctionName().GetLexeme();
+    EmitLambda(method, true,
+               std::format("methods.emplace({}, rt::MakeFunction({}, {}, {}, ",
+                           Quote(method_name), Quote(method_name),
+                           method.GetParams().size(),
+                           method_name == "init" ? "true" : "false"),
+               "));");
+  }
+  superclasses_.pop_back();
+  Line(AssignTo(
+           name,
+           std::format("rt::MakeClass({}, {}, std::move(methods))",
+                       Quote(name.GetLexeme()),
+                       superclass.empty() ? "std::nullopt" : superclass)) +
+       ";");
+  indent_--;
+  Line("}");
+}
+
+auto CppEmitter::operator()(const ExprStmtPtr& stmt) -> void {
+  Line(EmitExpression(stmt->GetExpression()).code + ";");
+}
+
+auto CppEmitter::operator()(const FunctionStmtPtr& stmt) -> void {
+  const Token& name = stmt->GetFunctionName();
+  const std::string& lexeme = name.GetLexeme();
+  size_t arity = stmt->GetParams().size();
+
+  if (scopes_.IsGlobalScope() && info_.direct_functions.contains(lexeme)) {
+    EmitDirectFunction(*stmt);
+    std::string arguments;
+    for (size_t i = 0; i < arity; i++) {
+      arguments += std::format("{}arguments[{}]", i == 0 ? "" : ", ", i);
+    }
+    Line(std::format(
+        "{}.Define(Object{{rt::MakeFunction({}, {}, false, [](const "
+        "std::vector<Object>& arguments, const cclox::LoxInstancePtr&) -> "
+        "Object {{ return {}({}); }})}});",
+        GlobalName(lexeme), Quote(lexeme), arity, DirectName(lexeme),
+        arguments));
+    return;
+  }
+
+  std::string function_prefix =
+      std::format("Object{{rt::MakeFunction({}, {}, false, ", Quote(lexeme),
+                  arity);
+  if (scopes_.IsGlobalScope()) {
+    EmitLambda(*stmt, false, GlobalName(lexeme) + ".Define(" + function_prefix,
+               ")});");
+  } else if (IsCaptured(name)) {
+    // Declare the cell first so the function can call itself.
+    Line(std::format("auto {} = std::make_shared<Object>(nullptr);",
+                     LocalName(name)));
+    scopes_.Declare(name);
+    EmitLambda(*stmt, false, "*" + LocalName(name) + " = " + function_prefix,
+               ")};");
+  } else {
+    scopes_.Declare(name);
+    EmitLambda(*stmt, false,
+               std::format("Object {} = {}", LocalName(name), function_prefix),
+               ")};");
+  }
+}
+
+auto CppEmitter::operator()(const IfStmtPtr& stmt) -> void {
+  Line(std::format("if ({})",
+                   Condition(EmitExpression(stmt->GetCondition()))));
+  EmitBranch(stmt->GetThenBranch());
+  if (stmt->GetElseBranch()) {
+    Line("else");
+    EmitBranch(stmt->GetElseBranch().value());
+  }
+}
+
+auto CppEmitter::operator()(const PrintStmtPtr& stmt) -> void {
+  Line(std::format("rt::Print({});",
+                   Box(EmitExpression(stmt->GetExpression()))));
+}
+
+auto CppEmitter::operator()(const ReturnStmtPtr& stmt) -> void {
+  const std::optional<ExprPtr>& value = stmt->GetValue();
+  Line(std::format("return {};", value ? Box(EmitExpression(value.value()))
+                                       : "Object{nullptr}"));
+}
+
+auto CppEmitter::operator()(const VarStmtPtr& stmt) -> void {
+  const std::optional<ExprPtr>& initializer = stmt->GetInitializer();
+  EmitDeclaration(stmt->GetVariable(),
+                  initializer ? Box(EmitExpression(initializer.value()))
+                              : "Object{nullptr}");
+}
+
+auto CppEmitter::operator()(const WhileStmtPtr& stmt) -> void {
+  Line(std::format("while ({})",
+                   Condition(EmitExpression(stmt->GetCondition()))));
+  EmitBranch(stmt->GetBody());
+}
+
+// ====================Expressions====================
+auto CppEmitter::operator()(const AssignExprPtr& expr) -> CppExpr {
+  const Token& variable = expr->GetVariable();
+  std::string value = Box(EmitExpression(expr->GetValue()));
+  if (!scopes_.Find(variable.GetLexeme())) {
+    return CppExpr{std::format("{}.Assign({}, {})",
+                               GlobalName(variable.GetLexeme()), value,
+                               variable.GetLineNumber())};
+  }
+  return CppExpr{"(" + AssignTo(variable, value) + ")"};
+}
+
+auto CppEmitter::operator()(const BinaryExprPtr& expr) -> CppExpr {
+  using enum TokenType;
+  using Type = CppExpr::Type;
+  CppExpr left = EmitExpression(expr->GetLeftExpression());
+  CppExpr right = EmitExpression(expr->GetRightExpression());
+  const Token& op = expr->GetOperator();
+  bool is_constant = left.is_constant && right.is_constant;
+  // Operands can be combined in plain C++ when their types are known and the
+  // evaluation order cannot be observed.
+  bool unboxed = IsNumber(left) && IsNumber(right) &&
+                 (left.is_constant || right.is_constant);
+  std::string operands = std::format("{{{}, {}}}", Box(left), Box(right));
+
+  const char* function = nullptr;
+  const char* cpp_operator = nullptr;
+  switch (op.GetType()) {
+    case BANG_EQUAL:
+    case EQUAL_EQUAL: {
+      std::string code = std::format("rt::Equal({})", operands);
+      if (op.GetType() == BANG_EQUAL) {
+        code = "!" + code;
+      }
+      return CppExpr{code, Type::BOOL, is_constant};
+    }
+    case GREATER:
+      function = "Greater";
+      cpp_operator = ">";
+      break;
+    case GREATER_EQUAL:
+      function = "GreaterEqual";
+      cpp_operator = ">=";
+      break;
+    case LESS:
+      function = "Less";
+      cpp_operator = "<";
+      break;
+    case LESS_EQUAL:
+      function = "LessEqual";
+      cpp_operator = "<=";
+      break;
+    case MINUS:
+      function = "Subtract";
+      cpp_operator = "-";
+      break;
+    case PLUS:
+      function = "Add";
+      cpp_operator = "+";
+      break;
+    case SLASH:
+      function = "Divide";
+      cpp_operator = "/";
+      break;
+    case STAR:
+      function = "Multiply";
+      cpp_operator = "*";
+      break;
+    default:
+      break;
+  }
+
+  bool is_comparison = op.GetType() == GREATER ||
+                       op.GetType() == GREATER_EQUAL ||
+                       op.GetType() == LESS || op.GetType() == LESS_EQUAL;
+  if (unboxed && is_comparison) {
+    return CppExpr{
+        std::format("({} {} {})", left.code, cpp_operator, right.code),
+        Type::BOOL, is_constant};
+  }
+  // Integer arithmetic may overflow into a double, so only doubles are
+  // computed unboxed.
+  if (unboxed && (left.type == Type::DOUBLE || right.type == Type::DOUBLE)) {
+    return CppExpr{
+        std::format("(static_cast<double>({}) {} {})", left.code,
+                    cpp_operator, right.code),
+        Type::DOUBLE, is_constant};
+  }
+
+  std::string code = std::format("rt::{}({}, {})", function, operands,
+                                 op.GetLineNumber());
+  return CppExpr{code, is_comparison ? Type::BOOL : Type::OBJECT,
+                 is_constant};
+}
+
+auto CppEmitter::operator()(const CallExprPtr& expr) -> CppExpr {
+  const std::vector<ExprPtr>& argument_exprs = expr->GetArguments();
+  uint32_t line = expr->GetParen().GetLineNumber();
+
+  // Calls to a known top-level function skip the callable lookup.
+  const auto* callee_variable =
+      std::get_if<VariableExprPtr>(&expr->GetCallee());
+  if (callee_variable != nullptr) {
+    const std::string& name = (*callee_variable)->GetVariable().GetLexeme();
+    auto it = info_.direct_functions.find(name);
+    if (!scopes_.Find(name) && it != info_.direct_functions.end() &&
+        it->second->GetParams().size() == argument_exprs.size()) {
+      std::string arguments;
+      std::string types;
+      size_t side_effects = 0;
+      for (const auto& argument_expr : argument_exprs) {
+        CppExpr argument = EmitExpression(argument_expr);
+        side_effects += argument.is_constant ? 0 : 1;
+        arguments += (arguments.empty() ? "" : ", ") + Box(argument);
+        types += types.empty() ? "Object" : ", Object";
+      }
+      std::string call =
+          side_effects <= 1
+              ? std::format("{}({})", DirectName(name), arguments)
+              // A braced initializer evaluates the arguments in order.
+              : std::format("std::apply({}, std::tuple<{}>{{{}}})",
+                            DirectName(name), types, arguments);
+      return CppExpr{
+          std::format("({}.Check({}), {})", GlobalName(name), line, call)};
+    }
+  }
+
+  std::string callee = Box(EmitExpression(expr->GetCallee()));
+  std::string arguments;
+  for (const auto& argument : argument_exprs) {
+    arguments += arguments.empty() ? "" : ", ";
+    arguments += Box(EmitExpression(argument));
+  }
+  return CppExpr{
+      std::format("rt::Call({{{}, {{{}}}}}, {})", callee, arguments, line)};
+}
+
+auto CppEmitter::operator()(const GetExprPtr& expr) -> CppExpr {
+  const Token& property = expr->GetProperty();
+  return CppExpr{std::format("rt::GetProperty({}, {}, {})",
+                             Box(EmitExpression(expr->GetObject())),
+                             Quote(property.GetLexeme()),
+                             property.GetLineNumber())};
+}
+
+auto CppEmitter::operator()(const GroupingExprPtr& expr) -> CppExpr {
+  CppExpr inner = EmitExpression(expr->GetExpression());
+  inner.code = "(" + inner.code + ")";
+  return inner;
+}
+
+auto CppEmitter::operator()(const LiteralExprPtr& expr) -> CppExpr {
+  using Type = CppExpr::Type;
+  const Object& value = expr->GetValue();
+  if (value.IsBool()) {
+    return CppExpr{value.Get<bool>() ? "true" : "false", Type::BOOL, true};
+  }
+  if (value.IsInteger()) {
+    return CppExpr{std::format("int32_t{{{}}}", value.Get<int32_t>()),
+                   Type::INT, true};
+  }
+  if (value.IsDouble()) {
+    // The shortest representation that round-trips.
+    std::string code = std::format("{}", value.Get<double>());
+    if (code.find_first_of(".e") == std::string::npos) {
+      code += ".0";
+    }
+    return CppExpr{code, Type::DOUBLE, true};
+  }
+  if (value.IsString()) {
+    return CppExpr{
+        std::format("Object{{std::string{{{}}}}}",
+                    Quote(value.Get<std::string>())),
+        Type::OBJECT, true};
+  }
+  return CppExpr{"Object{nullptr}", Type::OBJECT, true};
+}
+
+auto CppEmitter::operator()(const LogicalExprPtr& expr) -> CppExpr {
+  CppExpr left = EmitExpression(expr->GetLeftExpression());
+  CppExpr right = EmitExpression(expr->GetRightExpression());
+  bool is_or = expr->GetOperator().GetType() == TokenType::OR;
+
+  if (left.type == CppExpr::Type::BOOL && right.type == CppExpr::Type::BOOL) {
+    return CppExpr{std::format("({} {} {})", left.code, is_or ? "||" : "&&",
+                               right.code),
+                   CppExpr::Type::BOOL,
+                   left.is_constant && right.is_constant};
+  }
+  // The result is one of the operands, so short-circuit in a lambda.
+  return CppExpr{std::format(
+      "[&]() -> Object {{ Object left = {}; if ({}rt::Truthy(left)) {{ return "
+      "left; }} return {}; }}()",
+      Box(left), is_or ? "" : "!", Box(right))};
+}
+
+auto CppEmitter::operator()(const SetExprPtr& expr) -> CppExpr {
+  const Token& property = expr->GetProperty();
+  std::string object = Box(EmitExpression(expr->GetObject()));
+  std::string value = Box(EmitExpression(expr->GetValue()));
+  // The object is checked before the value is evaluated.
+  return CppExpr{std::format(
+      "[&]() -> Object {{ cclox::LoxInstancePtr instance = "
+      "rt::FieldTarget({}, {}); return rt::SetField(instance, {}, {}, {}); "
+      "}}()",
+      object, property.GetLineNumber(), Quote(property.GetLexeme()), value,
+      property.GetLineNumber())};
+}
+
+auto CppEmitter::operator()(const SuperExprPtr& expr) -> CppExpr {
+  const Token& method = expr->GetMethod();
+  return CppExpr{std::format("rt::GetSuperMethod({}, self, {}, {})",
+                             superclasses_.back(), Quote(method.GetLexeme()),
+                             method.GetLineNumber())};
+}
+
+auto CppEmitter::operator()(const ThisExprPtr&) -> CppExpr {
+  return CppExpr{"Object{self}"};
+}
+
+auto CppEmitter::operator()(const UnaryExprPtr& expr) -> CppExpr {
+  using Type = CppExpr::Type;
+  CppExpr right = EmitExpression(expr->GetRightExpression());
+  const Token& op = expr->GetOperator();
+
+  if (op.GetType() == TokenType::BANG) {
+    return CppExpr{"!" + Condition(right), Type::BOOL, right.is_constant};
+  }
+  if (right.type == Type::DOUBLE) {
+    return CppExpr{"-" + right.code, Type::DOUBLE, right.is_constant};
+  }
+  return CppExpr{std::format("rt::Negate({}, {})", Box(right),
+                             op.GetLineNumber()),
+                 Type::OBJECT, right.is_constant};
+}
+
+auto CppEmitter::operator()(const VariableExprPtr& expr) -> CppExpr {
+  const Token& variable = expr->GetVariable();
+  std::optional<LexicalScopes::Binding> binding =
+      scopes_.Find(variable.GetLexeme());
+  if (!binding) {
+    return CppExpr{std::format("{}.Get({})", GlobalName(variable.GetLexeme()),
+                               variable.GetLineNumber())};
+  }
+  if (IsCaptured(*binding->declaration)) {
+    return CppExpr{"(*" + LocalName(variable) + ")"};
+  }
+  return CppExpr{LocalName(variable)};
+}
+
+// ====================Private helpers====================
+auto CppEmitter::EmitStatement(const StmtPtr& stmt) -> void {
+  std::visit(*this, stmt);
+}
+
+auto CppEmitter::EmitExpression(const ExprPtr& expr) -> CppExpr {
+  return std::visit(*this, expr);
+}
+
+auto CppEmitter::EmitBranch(const StmtPtr& stmt) -> void {
+  if (std::holds_alternative<BlockStmtPtr>(stmt)) {
+    EmitStatement(stmt);
+    return;
+  }
+  Line("{");
+  indent_++;
+  EmitStatement(stmt);
+  indent_--;
+  Line("}");
+}
+
+auto CppEmitter::EmitDirectFunction(const FunctionStmt& function) -> void {
+  std::ostringstream* enclosing_out = out_;
+  size_t enclosing_indent = indent_;
+  out_ = &functions_;
+  indent_ = 0;
+
+  std::string params;
+  for (const Token& param : function.GetParams()) {
+    params += params.empty() ? "Object " : ", Object ";
+    params += (IsCaptured(param) ? "arg_" : "l_") + param.GetLexeme();
+  }
+  Line(std::format("auto {}({}) -> Object {{",
+                   DirectName(function.GetFunctionName().GetLexeme()), params));
+  indent_++;
+  scopes_.EnterFunction();
+  EmitParameters(function, true);
+  for (const auto& statement : function.GetBody()) {
+    EmitStatement(statement);
+  }
+  scopes_.LeaveFunction();
+  Line("return Object{nullptr};");
+  indent_--;
+  Line("}");
+  Line("");
+
+  out_ = enclosing_out;
+  indent_ = enclosing_indent;
+}
+
+auto CppEmitter::EmitLambda(const FunctionStmt& function, bool is_method,
+                            std::string_view prefix, std::string_view suffix)
+    -> void {
+  // Methods name the receiver; other functions see the `self` of the method
+  // they are nested in, if any.
+  Line(std::format("{}[=](const std::vector<Object>& arguments, const "
+                   "cclox::LoxInstancePtr&{}) -> Object {{",
+                   prefix, is_method ? " self" : ""));
+  indent_++;
+  scopes_.EnterFunction();
+  EmitParameters(function, false);
+  for (const auto& statement : function.GetBody()) {
+    EmitStatement(statement);
+  }
+  scopes_.LeaveFunction();
+  Line("return Object{nullptr};");
+  indent_--;
+  Line(std::format("}}{}", suffix));
+}
+
+auto CppEmitter::EmitParameters(const FunctionStmt& function, bool direct)
+    -> void {
+  const std::vector<Token>& params = function.GetParams();
+  for (size_t i = 0; i < params.size(); i++) {
+    const Token& param = params[i];
+    if (direct) {
+      if (IsCaptured(param)) {
+        Line(std::format(
+            "auto {} = std::make_shared<Object>(std::move(arg_{}));",
+            LocalName(param), param.GetLexeme()));
+      }
+      scopes_.Declare(param);
+    } else {
+      EmitDeclaration(param, std::format("arguments[{}]", i));
+    }
+  }
+}
+
+auto CppEmitter::EmitDeclaration(const Token& variable,
+                                 const std::string& value) -> void {
+  if (scopes_.IsGlobalScope()) {
+    Line(std::format("{}.Define({});", GlobalName(variable.GetLexeme()),
+                     value));
+    return;
+  }
+  if (IsCaptured(variable)) {
+    Line(std::format("auto {} = std::make_shared<Object>({});",
+                     LocalName(variable), value));
+  } else {
+    Line(std::format("Object {} = {};", LocalName(variable), value));
+  }
+  scopes_.Declare(variable);
+}
+
+auto CppEmitter::AssignTo(const Token& variable, const std::string& value)
+    -> std::string {
+  std::optional<LexicalScopes::Binding> binding =
+      scopes_.Find(variable.GetLexeme());
+  if (!binding) {
+    return std::format("{}.Define({})", GlobalName(variable.GetLexeme()),
+                       value);
+  }
+  if (IsCaptured(*binding->declaration)) {
+    return std::format("*{} = {}", LocalName(variable), value);
+  }
+  return std::format("{} = {}", LocalName(variable), value);
+}
+
+auto CppEmitter::IsCaptured(const Token& declaration) const -> bool {
+  return info_.captured.contains(&declaration);
+}
+
+auto CppEmitter::Line(std::string_view code) -> void {
+  if (!code.empty()) {
+    *out_ << std::string(2 * indent_, ' ') << code;
+  }
+  *out_ << '\n';
+}
+
+auto CppEmitter::Box(const CppExpr& expr) -> std::string {
+  switch (expr.type) {
+    case CppExpr::Type::OBJECT:
+      return expr.code;
+    case CppExpr::Type::BOOL:
+      return std::format("Object{{static_cast<bool>({})}}", expr.code);
+    case CppExpr::Type::INT:
+      return std::format("Object{{{}}}", expr.code);
+    case CppExpr::Type::DOUBLE:
+      return std::format("Object{{static_cast<double>({})}}", expr.code);
+  }
+  return expr.code;
+}
+
+auto CppEmitter::Condition(const CppExpr& expr) -> std::string {
+  if (expr.type == CppExpr::Type::BOOL) {
+    return expr.code;
+  }
+  return std::format("rt::Truthy({})", Box(expr));
+}
+
+auto CppEmitter::IsNumber(const CppExpr& expr) -> bool {
+  return expr.type == CppExpr::Type::INT || expr.type == CppExpr::Type::DOUBLE;
+}
+
+auto CppEmitter::Quote(std::string_view text) -> std::string {
+  std::string quoted = "\"";
+  for (char c : text) {
+    switch (c) {
+      case '"':
+        quoted += "\\\"";
+        break;
+      case '\\':
+        quoted += "\\\\";
+        break;
+      case '\n':
+        quoted += "\\n";
+        break;
+      case '\r':
+        quoted += "\\r";
+        break;
+      case '\t':
+        quoted += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          quoted += std::format("\\{:03o}", static_cast<unsigned char>(c));
+        } else {
+          quoted += c;
+        }
+    }
+  }
+  return quoted + "\"";
+}
+}  // namespace cclox
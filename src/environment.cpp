@@ -1,7 +1,20 @@
 #include "environment.h"
+
+#include <utility>
+
 #include "interpreter.h"
 
 namespace cclox {
+namespace {
+auto SizeOf(const Environment::VariableMap& values) noexcept -> size_t {
+  size_t bytes = 0;
+  for (const auto& [name, value] : values) {
+    bytes += HeapCharge::SizeOf(name, value);
+  }
+  return bytes;
+}
+}  // namespace
+
 auto Environment::Create() -> std::shared_ptr<Environment> {
   return std::shared_ptr<Environment>(new Environment());
 }
@@ -28,14 +41,44 @@ auto Environment::GetAt(uint64_t distance, const Token& name) -> Object {
   return Ancestor(distance)->Get(name);
 }
 
+auto Environment::Find(const std::string& name) const noexcept
+    -> const Object* {
+  auto it = values_.find(name);
+  return it == values_.end() ? nullptr : &it->second;
+}
+
+auto Environment::FindAt(uint64_t distance, const std::string& name)
+    -> Object* {
+  VariableMap& values = Ancestor(distance)->values_;
+  auto it = values.find(name);
+  return it == values.end() ? nullptr : &it->second;
+}
+
 auto Environment::Define(const std::string& name, const Object& value) -> void {
-  values_[name] = value;
+  auto [it, inserted] = values_.try_emplace(name);
+  charge_.Adjust(inserted ? HeapCharge::SizeOf(name, value)
+                          : HeapCharge::SizeOf(value),
+                 HeapCharge::SizeOf(it->second));
+  it->second = value;
+}
+
+auto Environment::Reset(const VariableMap& values) -> void {
+  // The old values die after the map is replaced, since their destructors
+  // may reach this environment.
+  charge_.Adjust(SizeOf(values), SizeOf(values_));
+  VariableMap old = std::exchange(values_, values);
+}
+
+auto Environment::ChargeTo(std::shared_ptr<HeapMeter> meter) noexcept
+    -> void {
+  charge_.MoveTo(std::move(meter), sizeof(Environment) + SizeOf(values_));
 }
 
 auto Environment::Assign(const Token& variable, const Object& value) -> void {
   const std::string& variable_name = variable.GetLexeme();
-  if (values_.contains(variable_name)) {
-    values_[variable_name] = value;
+  if (auto it = values_.find(variable_name); it != values_.end()) {
+    charge_.Adjust(HeapCharge::SizeOf(value), HeapCharge::SizeOf(it->second));
+    it->second = value;
     return;
   }
 
@@ -0,0 +1,338 @@
+#include "event_loop.h"
+
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <thread>
+#include <utility>
+
+namespace cclox {
+namespace {
+// Fiber stacks are as deep as the main thread's by default, but reserved, not
+// committed, so an async call only uses the memory its stack actually
+// touches. The lowest page is a guard page.
+constexpr size_t kStackSize = size_t{8} << 20;
+constexpr size_t kGuardSize = 4096;
+
+/**
+ * @brief Thrown by `await` in a cancelled async call to unwind its stack.
+ * Deliberately not a `std::runtime_error`, so nothing in the interpreter
+ * catches it on the way.
+ */
+struct Cancelled {};
+
+// The fiber `RunFiber` is about to start on this thread.
+thread_local void* starting_fiber = nullptr;
+}  // namespace
+
+struct EventLoop::Fiber {
+  uint64_t id;
+  ucontext_t context;
+  // The context that resumed the fiber, to switch back to.
+  ucontext_t* caller{nullptr};
+  void* stack;
+  Callback body;
+  Interpreter::ExecutionState state;
+  std::exception_ptr exception;
+  bool done{false};
+  bool cancelled{false};
+};
+
+// ====================LoxPromise====================
+auto LoxPromise::Call(Interpreter& interpreter, const std::vector<Object>&)
+    -> Object {
+  return interpreter.GetEventLoop().Await(shared_from_this());
+}
+
+auto LoxPromise::Resolve(Object result) -> void {
+  result_ = std::move(result);
+  settled_ = true;
+  for (std::function<void()>& callback : std::exchange(callbacks_, {})) {
+    loop_.Post(std::move(callback));
+  }
+}
+
+auto LoxPromise::Reject(std::exception_ptr error) -> void {
+  error_ = std::move(error);
+  settled_ = true;
+  for (std::function<void()>& callback : std::exchange(callbacks_, {})) {
+    loop_.Post(std::move(callback));
+  }
+}
+
+auto LoxPromise::GetResult() -> Object {
+  if (error_) {
+    std::rethrow_exception(error_);
+  }
+  return result_;
+}
+
+auto LoxPromise::OnSettled(std::function<void()> callback) -> void {
+  if (settled_) {
+    loop_.Post(std::move(callback));
+  } else {
+    callbacks_.push_back(std::move(callback));
+  }
+}
+
+// ====================EventLoop====================
+EventLoop::EventLoop(Interpreter& interpreter) : interpreter_(interpreter) {}
+
+EventLoop::~EventLoop() {
+  Cancel();
+  for (void* stack : free_stacks_) {
+    munmap(stack, kStackSize);
+  }
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+  }
+}
+
+auto EventLoop::Start(LoxCallablePtr callee) -> std::shared_ptr<LoxPromise> {
+  auto promise = std::make_shared<LoxPromise>(*this);
+  auto fiber = std::make_unique<Fiber>();
+  fiber->id = ++fiber_count_;
+  fiber->stack = AllocateStack();
+  fiber->state = {interpreter_.GetGlobalEnvironment(), nullptr};
+  fiber->body = [this, callee = std::move(callee), promise] {
+    try {
+      promise->Resolve(callee->Call(interpreter_, {}));
+    } catch (const RuntimeError&) {
+      promise->Reject(std::current_exception());
+      rejected_.push_back(promise);
+    }
+  };
+  getcontext(&fiber->context);
+  fiber->context.uc_stack.ss_sp = fiber->stack;
+  fiber->context.uc_stack.ss_size = kStackSize;
+  fiber->context.uc_link = nullptr;
+  makecontext(&fiber->context, &EventLoop::RunFiber, 0);
+
+  Fiber& started = *fiber;
+  fibers_.emplace(started.id, std::move(fiber));
+  starting_fiber = &started;
+  Resume(started);
+  return promise;
+}
+
+auto EventLoop::Await(const std::shared_ptr<LoxPromise>& promise) -> Object {
+  if (&promise->loop_ != this) {
+    throw NativeError("Can only await promises made by the same task.");
+  }
+  promise->awaited_ = true;
+  if (current_ != nullptr) {
+    if (!promise->IsSettled()) {
+      promise->OnSettled([this, id = current_->id] {
+        if (auto it = fibers_.find(id); it != fibers_.end()) {
+          Resume(*it->second);
+        }
+      });
+      Suspend();
+    }
+  } else {
+    while (!promise->IsSettled()) {
+      if (!RunOnce()) {
+        throw NativeError("Awaited a promise that can never be settled.");
+      }
+    }
+    // The timers that fired with the promise's, which were due no later,
+    // have only posted the async calls they woke; those run first.
+    while (!ready_.empty()) {
+      RunOnce();
+    }
+  }
+  return promise->GetResult();
+}
+
+auto EventLoop::Post(Callback callback) -> void {
+  ready_.push_back(std::move(callback));
+}
+
+auto EventLoop::AddTimer(std::chrono::milliseconds delay, Callback callback)
+    -> void {
+  timers_.push({std::chrono::steady_clock::now() + delay, timer_count_++,
+                std::move(callback)});
+}
+
+auto EventLoop::WatchReadable(int fd, Callback callback) -> bool {
+  if (epoll_fd_ < 0) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+      return false;
+    }
+  }
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = fd;
+  if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+    return false;
+  }
+  watches_[fd] = std::move(callback);
+  return true;
+}
+
+auto EventLoop::Unwatch(int fd) -> void {
+  if (watches_.erase(fd) > 0) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  }
+}
+
+auto EventLoop::Run() -> void {
+  while (RunOnce()) {
+  }
+  // What is left waits for promises nothing can settle anymore.
+  Cancel();
+  std::vector<std::shared_ptr<LoxPromise>> rejected =
+      std::exchange(rejected_, {});
+  for (const auto& promise : rejected) {
+    if (!promise->awaited_) {
+      std::rethrow_exception(promise->error_);
+    }
+  }
+}
+
+auto EventLoop::Cancel() noexcept -> void {
+  ready_.clear();
+  timers_ = {};
+  for (const auto& [fd, callback] : watches_) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+  }
+  watches_.clear();
+
+  std::vector<uint64_t> ids;
+  ids.reserve(fibers_.size());
+  for (const auto& [id, fiber] : fibers_) {
+    ids.push_back(id);
+  }
+  for (uint64_t id : ids) {
+    if (auto it = fibers_.find(id); it != fibers_.end()) {
+      it->second->cancelled = true;
+      try {
+        Resume(*it->second);
+      } catch (...) {
+        // The program already failed; its other errors do not matter.
+      }
+    }
+  }
+  // Unwinding the fibers can post and arm more; none of it will run.
+  ready_.clear();
+  timers_ = {};
+  watches_.clear();
+}
+
+auto EventLoop::RunOnce() -> bool {
+  if (!ready_.empty()) {
+    std::deque<Callback> ready = std::exchange(ready_, {});
+    for (Callback& callback : ready) {
+      callback();
+    }
+    return true;
+  }
+  if (timers_.empty() && watches_.empty()) {
+    return false;
+  }
+
+  // The wait ends at the next timer, or at the running code's deadline if
+  // that comes first.
+  std::optional<std::chrono::steady_clock::time_point> wake;
+  if (!timers_.empty()) {
+    wake = timers_.top().deadline;
+  }
+  std::optional<std::chrono::steady_clock::time_point> deadline =
+      interpreter_.GetExecutionLimits().deadline;
+  if (deadline && (!wake || deadline.value() < wake.value())) {
+    wake = deadline;
+  }
+  int timeout = -1;
+  if (wake) {
+    auto wait = std::chrono::ceil<std::chrono::milliseconds>(
+        wake.value() - std::chrono::steady_clock::now());
+    timeout = static_cast<int>(std::max<int64_t>(wait.count(), 0));
+  }
+  if (!watches_.empty()) {
+    std::array<epoll_event, 64> events{};
+    int count = epoll_wait(epoll_fd_, events.data(),
+                           static_cast<int>(events.size()), timeout);
+    for (int i = 0; i < count; i++) {
+      auto it = watches_.find(events[static_cast<size_t>(i)].data.fd);
+      if (it != watches_.end()) {
+        // The callback may unwatch its descriptor.
+        Callback callback = it->second;
+        callback();
+      }
+    }
+  } else {
+    std::this_thread::sleep_until(wake.value());
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (deadline && now >= deadline.value()) {
+    throw NativeError("Time limit exceeded.");
+  }
+  while (!timers_.empty() && timers_.top().deadline <= now) {
+    Callback callback = timers_.top().callback;
+    timers_.pop();
+    callback();
+  }
+  return true;
+}
+
+auto EventLoop::Resume(Fiber& fiber) -> void {
+  Fiber* previous = std::exchange(current_, &fiber);
+  interpreter_.SwapExecutionState(fiber.state);
+  ucontext_t caller;
+  fiber.caller = &caller;
+  swapcontext(&caller, &fiber.context);
+  interpreter_.SwapExecutionState(fiber.state);
+  current_ = previous;
+
+  if (fiber.done) {
+    std::exception_ptr exception = std::move(fiber.exception);
+    free_stacks_.push_back(fiber.stack);
+    fibers_.erase(fiber.id);
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+}
+
+auto EventLoop::Suspend() -> void {
+  Fiber& fiber = *current_;
+  swapcontext(&fiber.context, fiber.caller);
+  if (fiber.cancelled) {
+    throw Cancelled{};
+  }
+}
+
+auto EventLoop::RunFiber() -> void {
+  auto& fiber = *static_cast<Fiber*>(starting_fiber);
+  try {
+    fiber.body();
+  } catch (const Cancelled&) {
+  } catch (...) {
+    fiber.exception = std::current_exception();
+  }
+  fiber.done = true;
+  setcontext(fiber.caller);
+}
+
+auto EventLoop::AllocateStack() -> void* {
+  if (!free_stacks_.empty()) {
+    void* stack = free_stacks_.back();
+    free_stacks_.pop_back();
+    return stack;
+  }
+  void* stack = mmap(nullptr, kStackSize, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK,
+                     -1, 0);
+  if (stack == MAP_FAILED) {
+    throw NativeError("Out of memory for async calls.");
+  }
+  mprotect(stack, kGuardSize, PROT_NONE);
+  return stack;
+}
+}  // namespace cclox
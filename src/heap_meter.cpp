@@ -0,0 +1,53 @@
+#include "heap_meter.h"
+
+#include <utility>
+
+namespace cclox {
+namespace {
+struct Binding {
+  std::shared_ptr<HeapMeter> meter;
+  int64_t* alarm{nullptr};
+};
+
+thread_local Binding binding;
+
+// A hash map node holds its key and value, the next node and the key's
+// hash, and the map keeps a bucket pointing at it.
+constexpr size_t kEntryOverhead = 3 * sizeof(void*);
+}  // namespace
+
+auto HeapMeter::Bind(std::shared_ptr<HeapMeter> meter, int64_t* alarm) noexcept
+    -> void {
+  binding.meter = std::move(meter);
+  binding.alarm = alarm;
+}
+
+auto HeapMeter::Unbind(const int64_t* alarm) noexcept -> void {
+  if (binding.alarm == alarm) {
+    binding = {};
+  }
+}
+
+auto HeapMeter::Current() noexcept -> const std::shared_ptr<HeapMeter>& {
+  return binding.meter;
+}
+
+auto HeapMeter::Charge(size_t bytes) noexcept -> void {
+  size_t current =
+      current_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  size_t peak = peak_.load(std::memory_order_relaxed);
+  while (current > peak &&
+         !peak_.compare_exchange_weak(peak, current,
+                                      std::memory_order_relaxed)) {
+  }
+  if (limit_ && current > limit_.value() && binding.meter.get() == this) {
+    *binding.alarm = 0;
+  }
+}
+
+auto HeapCharge::SizeOf(const std::string& name, const Object& value) noexcept
+    -> size_t {
+  return sizeof(std::pair<const std::string, Object>) + kEntryOverhead +
+         name.size() + SizeOf(value);
+}
+}  // namespace cclox
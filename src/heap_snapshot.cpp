@@ -0,0 +1,608 @@
+#include "heap_snapshot.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+
+#include "environment.h"
+#include "interpreter.h"
+#include "lox_class.h"
+#include "lox_function.h"
+#include "lox_instance.h"
+#include "lox_list.h"
+
+namespace cclox {
+namespace {
+constexpr std::string_view kMagic{"CCLOXHS1"};
+
+enum class ShellKind : uint8_t {
+  GLOBALS,
+  ENVIRONMENT,
+  FUNCTION,
+  CLASS,
+  INSTANCE,
+  LIST,
+  RANGE,
+  NATIVE,
+};
+
+enum class ValueTag : uint8_t {
+  NIL,
+  BOOL,
+  INTEGER,
+  DOUBLE,
+  STRING,
+  CALLABLE,
+  INSTANCE,
+};
+
+// Bits of a list's flags.
+constexpr uint8_t kFrozen = 1;
+constexpr uint8_t kShareable = 2;
+
+/**
+ * @brief FNV-1a, which unlike `std::hash` is the same in every build.
+ */
+auto HashSource(std::string_view source) -> uint64_t {
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : source) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+/**
+ * @brief Collects the function declarations of a program in source order,
+ * which numbers them the same way in every run of the same script.
+ */
+auto CollectDeclarations(const std::vector<StmtPtr>& statements,
+                         std::vector<const FunctionStmtPtr*>& declarations)
+    -> void;
+
+auto CollectDeclarations(const StmtPtr& statement,
+                         std::vector<const FunctionStmtPtr*>& declarations)
+    -> void {
+  if (const auto* function = std::get_if<FunctionStmtPtr>(&statement)) {
+    declarations.push_back(function);
+    CollectDeclarations((*function)->GetBody(), declarations);
+  } else if (const auto* klass = std::get_if<ClassStmtPtr>(&statement)) {
+    CollectDeclarations((*klass)->GetClassMethods(), declarations);
+  } else if (const auto* block = std::get_if<BlockStmtPtr>(&statement)) {
+    CollectDeclarations((*block)->GetStatements(), declarations);
+  } else if (const auto* if_stmt = std::get_if<IfStmtPtr>(&statement)) {
+    CollectDeclarations((*if_stmt)->GetThenBranch(), declarations);
+    if ((*if_stmt)->GetElseBranch()) {
+      CollectDeclarations((*if_stmt)->GetElseBranch().value(), declarations);
+    }
+  } else if (const auto* while_stmt = std::get_if<WhileStmtPtr>(&statement)) {
+    CollectDeclarations((*while_stmt)->GetBody(), declarations);
+  }
+}
+
+auto CollectDeclarations(const std::vector<StmtPtr>& statements,
+                         std::vector<const FunctionStmtPtr*>& declarations)
+    -> void {
+  for (const auto& statement : statements) {
+    CollectDeclarations(statement, declarations);
+  }
+}
+
+/**
+ * @brief A read-only mapping of a whole file.
+ */
+class MappedFile {
+ public:
+  explicit MappedFile(const std::filesystem::path& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw SnapshotError(
+          std::format("Unable to open snapshot: {}", path.string()));
+    }
+    struct stat status {};
+    if (fstat(fd, &status) == 0 && status.st_size > 0) {
+      size_ = static_cast<size_t>(status.st_size);
+      data_ = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    if (data_ == MAP_FAILED || data_ == nullptr) {
+      data_ = nullptr;
+      throw SnapshotError(
+          std::format("Unable to read snapshot: {}", path.string()));
+    }
+  }
+
+  MappedFile(const MappedFile&) = delete;
+
+  auto operator=(const MappedFile&) -> MappedFile& = delete;
+
+  ~MappedFile() {
+    if (data_ != nullptr) {
+      munmap(data_, size_);
+    }
+  }
+
+  auto Data() const noexcept -> const char* {
+    return static_cast<const char*>(data_);
+  }
+
+  auto Size() const noexcept -> size_t { return size_; }
+
+ private:
+  void* data_{nullptr};
+  size_t size_{0};
+};
+}  // namespace
+
+/**
+ * @brief Numbers the objects reachable from the globals in the order they are
+ * first reached, and writes each one's shell when it is numbered and its
+ * contents once every object before it is written.
+ */
+class HeapSnapshot::Writer {
+ public:
+  Writer(const std::vector<StmtPtr>& statements,
+         const Interpreter& interpreter)
+      : interpreter_(interpreter) {
+    std::vector<const FunctionStmtPtr*> declarations;
+    CollectDeclarations(statements, declarations);
+    for (size_t i = 0; i < declarations.size(); i++) {
+      declarations_.emplace(declarations[i], static_cast<uint32_t>(i));
+    }
+    for (const auto& [name, value] : interpreter.GetNatives()) {
+      if (std::optional<LoxCallablePtr> native = value.AsLoxCallable()) {
+        natives_.emplace(native.value().get(), name);
+      }
+    }
+  }
+
+  auto Write(std::string_view source) -> std::string {
+    const std::shared_ptr<Environment>& globals =
+        interpreter_.GetGlobalEnvironment();
+    Number(globals.get(), ShellKind::GLOBALS);
+    for (size_t i = 0; i < pending_.size(); i++) {
+      WriteContents(pending_[i]);
+    }
+
+    std::string image{kMagic};
+    PutU64(image, HashSource(source));
+    PutU32(image, static_cast<uint32_t>(pending_.size()));
+    image += shells_;
+    image += contents_;
+    return image;
+  }
+
+ private:
+  using Pending =
+      std::variant<const Environment*, const LoxCallable*, const LoxInstance*>;
+
+  static auto PutU8(std::string& out, uint8_t value) -> void {
+    out.push_back(static_cast<char>(value));
+  }
+
+  template<typename T>
+  static auto PutRaw(std::string& out, T value) -> void {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+  }
+
+  static auto PutU32(std::string& out, uint32_t value) -> void {
+    PutRaw(out, value);
+  }
+
+  static auto PutU64(std::string& out, uint64_t value) -> void {
+    PutRaw(out, value);
+  }
+
+  static auto PutString(std::string& out, std::string_view value) -> void {
+    PutU32(out, static_cast<uint32_t>(value.size()));
+    out += value;
+  }
+
+  /**
+   * @brief Returns the index of `object`, numbering it and writing its shell
+   * the first time it is reached.
+   */
+  auto Number(Pending object, ShellKind kind) -> uint32_t {
+    const void* address = std::visit(
+        [](const auto* pointer) -> const void* { return pointer; }, object);
+    if (auto it = indices_.find(address); it != indices_.end()) {
+      return it->second;
+    }
+    auto index = static_cast<uint32_t>(pending_.size());
+    indices_.emplace(address, index);
+    pending_.push_back(object);
+    PutU8(shells_, static_cast<uint8_t>(kind));
+    return index;
+  }
+
+  auto NumberEnvironment(const std::shared_ptr<Environment>& environment)
+      -> uint32_t {
+    if (!environment) {
+      // Every environment of the program encloses the globals.
+      throw SnapshotError("Can't snapshot an environment outside the script.");
+    }
+    if (auto it = indices_.find(environment.get()); it != indices_.end()) {
+      return it->second;
+    }
+    // The enclosing environment comes first, so that loading can create each
+    // environment inside its enclosing one.
+    uint32_t enclosing =
+        NumberEnvironment(environment->GetEnclosingEnvironment());
+    uint32_t index = Number(environment.get(), ShellKind::ENVIRONMENT);
+    PutU32(shells_, enclosing);
+    return index;
+  }
+
+  auto NumberCallable(const LoxCallablePtr& callable) -> uint32_t {
+    if (auto it = indices_.find(callable.get()); it != indices_.end()) {
+      return it->second;
+    }
+    if (auto function = std::dynamic_pointer_cast<LoxFunction>(callable)) {
+      auto declaration = declarations_.find(&function->declaration_);
+      if (declaration == declarations_.end()) {
+        throw SnapshotError(std::format(
+            "Can't snapshot {} declared outside the script.",
+            function->ToString()));
+      }
+      uint32_t index = Number(callable.get(), ShellKind::FUNCTION);
+      PutU32(shells_, declaration->second);
+      PutU8(shells_, function->is_initializer_ ? 1 : 0);
+      return index;
+    }
+    if (auto klass = std::dynamic_pointer_cast<LoxClass>(callable)) {
+      uint32_t index = Number(callable.get(), ShellKind::CLASS);
+      PutString(shells_, klass->name_);
+      return index;
+    }
+    if (std::dynamic_pointer_cast<LoxList>(callable)) {
+      return Number(callable.get(), ShellKind::LIST);
+    }
+    if (auto range = std::dynamic_pointer_cast<LoxRange>(callable)) {
+      uint32_t index = Number(callable.get(), ShellKind::RANGE);
+      int32_t start = range->Length() == 0 ? 0 : range->At(0).Get<int32_t>();
+      PutRaw(shells_, start);
+      PutRaw(shells_, static_cast<int32_t>(start + range->Length()));
+      return index;
+    }
+    if (auto native = natives_.find(callable.get()); native != natives_.end()) {
+      uint32_t index = Number(callable.get(), ShellKind::NATIVE);
+      PutString(shells_, native->second);
+      return index;
+    }
+    throw SnapshotError(
+        std::format("Can't snapshot {}.", callable->ToString()));
+  }
+
+  auto PutValue(std::string& out, const Object& value) -> void {
+    const Object::ValueType& variant = value.Value();
+    if (const auto* boolean = std::get_if<bool>(&variant)) {
+      PutU8(out, static_cast<uint8_t>(ValueTag::BOOL));
+      PutU8(out, *boolean ? 1 : 0);
+    } else if (const auto* integer = std::get_if<int32_t>(&variant)) {
+      PutU8(out, static_cast<uint8_t>(ValueTag::INTEGER));
+      PutRaw(out, *integer);
+    } else if (const auto* number = std::get_if<double>(&variant)) {
+      PutU8(out, static_cast<uint8_t>(ValueTag::DOUBLE));
+      PutRaw(out, *number);
+    } else if (const auto* string = std::get_if<std::string>(&variant)) {
+      PutU8(out, static_cast<uint8_t>(ValueTag::STRING));
+      PutString(out, *string);
+    } else if (const auto* callable = std::get_if<LoxCallablePtr>(&variant)) {
+      PutU8(out, static_cast<uint8_t>(ValueTag::CALLABLE));
+      PutU32(out, NumberCallable(*callable));
+    } else if (const auto* instance = std::get_if<LoxInstancePtr>(&variant)) {
+      PutU8(out, static_cast<uint8_t>(ValueTag::INSTANCE));
+      PutU32(out, Number(instance->get(), ShellKind::INSTANCE));
+    } else {
+      PutU8(out, static_cast<uint8_t>(ValueTag::NIL));
+    }
+  }
+
+  auto PutVariables(const std::unordered_map<std::string, Object>& variables,
+                    const Environment::VariableMap* natives) -> void {
+    std::vector<const std::pair<const std::string, Object>*> saved;
+    for (const auto& variable : variables) {
+      // Natives the program did not replace are there on loading.
+      if (natives != nullptr) {
+        auto native = natives->find(variable.first);
+        if (native != natives->end() &&
+            native->second.AsLoxCallable() == variable.second.AsLoxCallable()) {
+          continue;
+        }
+      }
+      saved.push_back(&variable);
+    }
+    PutU32(contents_, static_cast<uint32_t>(saved.size()));
+    for (const auto* variable : saved) {
+      PutString(contents_, variable->first);
+      PutValue(contents_, variable->second);
+    }
+  }
+
+  auto WriteContents(Pending object) -> void {
+    if (const auto* const* environment =
+            std::get_if<const Environment*>(&object)) {
+      bool globals = *environment == interpreter_.GetGlobalEnvironment().get();
+      PutVariables((*environment)->GetValues(),
+                   globals ? &interpreter_.GetNatives() : nullptr);
+    } else if (const auto* const* instance =
+                   std::get_if<const LoxInstance*>(&object)) {
+      PutU32(contents_,
+             NumberCallable(std::const_pointer_cast<LoxClass>(
+                 (*instance)->klass_)));
+      PutU8(contents_, (*instance)->frozen_ ? 1 : 0);
+      PutVariables((*instance)->fields_, nullptr);
+    } else {
+      WriteCallableContents(*std::get<const LoxCallable*>(object));
+    }
+  }
+
+  auto WriteCallableContents(const LoxCallable& callable) -> void {
+    if (const auto* function = dynamic_cast<const LoxFunction*>(&callable)) {
+      PutU32(contents_, NumberEnvironment(function->closure_));
+    } else if (const auto* klass = dynamic_cast<const LoxClass*>(&callable)) {
+      PutU8(contents_, klass->superclass_ ? 1 : 0);
+      if (klass->superclass_) {
+        PutValue(contents_, klass->superclass_.value());
+      }
+      PutU32(contents_, static_cast<uint32_t>(klass->methods_.size()));
+      for (const auto& [name, method] : klass->methods_) {
+        PutString(contents_, name);
+        PutU32(contents_, NumberCallable(method));
+      }
+    } else if (const auto* list = dynamic_cast<const LoxList*>(&callable)) {
+      uint8_t flags = (list->IsFrozen() ? kFrozen : 0) |
+                      (list->IsShareable() ? kShareable : 0);
+      PutU8(contents_, flags);
+      PutU32(contents_, static_cast<uint32_t>(list->Length()));
+      for (const Object& element : list->GetElements()) {
+        PutValue(contents_, element);
+      }
+    }
+    // Ranges and natives are whole in their shell.
+  }
+
+  const Interpreter& interpreter_;
+  std::unordered_map<const FunctionStmtPtr*, uint32_t> declarations_;
+  std::unordered_map<const LoxCallable*, std::string> natives_;
+  std::unordered_map<const void*, uint32_t> indices_;
+  // The objects numbered so far, in index order.
+  std::vector<Pending> pending_;
+  std::string shells_;
+  std::string contents_;
+};
+
+/**
+ * @brief Creates an object for each shell, which relocates the indices the
+ * contents refer to, then fills the objects in.
+ */
+class HeapSnapshot::Reader {
+ public:
+  Reader(const std::vector<StmtPtr>& statements, Interpreter& interpreter)
+      : interpreter_(interpreter) {
+    CollectDeclarations(statements, declarations_);
+  }
+
+  auto Read(const MappedFile& file, std::string_view source) -> void {
+    next_ = file.Data();
+    end_ = file.Data() + file.Size();
+    if (std::string_view{Take(kMagic.size()), kMagic.size()} != kMagic) {
+      throw SnapshotError("Not a heap snapshot.");
+    }
+    if (GetRaw<uint64_t>() != HashSource(source)) {
+      throw SnapshotError("The snapshot was saved from a different script.");
+    }
+    auto count = GetRaw<uint32_t>();
+    // Each shell takes at least a byte.
+    if (count > static_cast<size_t>(end_ - next_)) {
+      throw SnapshotError("The snapshot is truncated.");
+    }
+    objects_.reserve(count);
+    for (uint32_t i = 0; i < count; i++) {
+      objects_.push_back(ReadShell());
+    }
+    for (Shell& object : objects_) {
+      ReadContents(object);
+    }
+  }
+
+ private:
+  using Shell = std::variant<std::shared_ptr<Environment>, LoxCallablePtr,
+                             LoxInstancePtr>;
+
+  auto Take(size_t size) -> const char* {
+    if (static_cast<size_t>(end_ - next_) < size) {
+      throw SnapshotError("The snapshot is truncated.");
+    }
+    const char* bytes = next_;
+    next_ += size;
+    return bytes;
+  }
+
+  template<typename T>
+  auto GetRaw() -> T {
+    T value;
+    std::memcpy(&value, Take(sizeof(T)), sizeof(T));
+    return value;
+  }
+
+  auto GetString() -> std::string {
+    auto size = GetRaw<uint32_t>();
+    return std::string{Take(size), size};
+  }
+
+  template<typename T>
+  auto GetObject() -> const T& {
+    auto index = GetRaw<uint32_t>();
+    if (index >= objects_.size() ||
+        !std::holds_alternative<T>(objects_[index])) {
+      throw SnapshotError("The snapshot is malformed.");
+    }
+    return std::get<T>(objects_[index]);
+  }
+
+  auto ReadShell() -> Shell {
+    auto kind = static_cast<ShellKind>(GetRaw<uint8_t>());
+    switch (kind) {
+      case ShellKind::GLOBALS:
+        if (!objects_.empty()) {
+          break;
+        }
+        return interpreter_.GetGlobalEnvironment();
+      case ShellKind::ENVIRONMENT:
+        return Environment::Create(GetObject<std::shared_ptr<Environment>>());
+      case ShellKind::FUNCTION: {
+        auto declaration = GetRaw<uint32_t>();
+        bool is_initializer = GetRaw<uint8_t>() != 0;
+        if (declaration >= declarations_.size()) {
+          break;
+        }
+        auto function = std::make_shared<LoxFunction>(
+            *declarations_[declaration], nullptr, is_initializer);
+        if (interpreter_.GetJit().IsEnabled()) {
+          // Methods share theirs with their bound copies.
+          function->GetJitProfile();
+        }
+        return function;
+      }
+      case ShellKind::CLASS:
+        return std::make_shared<LoxClass>(GetString(), std::nullopt,
+                                          LoxClass::MethodMap{});
+      case ShellKind::INSTANCE:
+        return LoxInstance::Create(nullptr);
+      case ShellKind::LIST:
+        return std::make_shared<LoxList>();
+      case ShellKind::RANGE: {
+        auto start = GetRaw<int32_t>();
+        auto end = GetRaw<int32_t>();
+        return std::make_shared<LoxRange>(start, end);
+      }
+      case ShellKind::NATIVE: {
+        std::string name = GetString();
+        auto native = interpreter_.GetNatives().find(name);
+        if (native == interpreter_.GetNatives().end() ||
+            !native->second.IsLoxCallable()) {
+          throw SnapshotError(std::format("Unknown native '{}'.", name));
+        }
+        return native->second.AsLoxCallable().value();
+      }
+    }
+    throw SnapshotError("The snapshot is malformed.");
+  }
+
+  auto GetValue() -> Object {
+    switch (static_cast<ValueTag>(GetRaw<uint8_t>())) {
+      case ValueTag::NIL:
+        return Object{nullptr};
+      case ValueTag::BOOL:
+        return Object{GetRaw<uint8_t>() != 0};
+      case ValueTag::INTEGER:
+        return Object{GetRaw<int32_t>()};
+      case ValueTag::DOUBLE:
+        return Object{GetRaw<double>()};
+      case ValueTag::STRING:
+        return Object{GetString()};
+      case ValueTag::CALLABLE:
+        return Object{GetObject<LoxCallablePtr>()};
+      case ValueTag::INSTANCE:
+        return Object{GetObject<LoxInstancePtr>()};
+    }
+    throw SnapshotError("The snapshot is malformed.");
+  }
+
+  auto ReadContents(Shell& object) -> void {
+    if (auto* environment =
+            std::get_if<std::shared_ptr<Environment>>(&object)) {
+      auto count = GetRaw<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        std::string name = GetString();
+        (*environment)->Define(name, GetValue());
+      }
+    } else if (auto* instance = std::get_if<LoxInstancePtr>(&object)) {
+      auto klass = std::dynamic_pointer_cast<LoxClass>(
+          GetObject<LoxCallablePtr>());
+      if (!klass) {
+        throw SnapshotError("The snapshot is malformed.");
+      }
+      (*instance)->klass_ = std::move(klass);
+      bool frozen = GetRaw<uint8_t>() != 0;
+      auto count = GetRaw<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        std::string name = GetString();
+        (*instance)->PutField(name, GetValue());
+      }
+      (*instance)->frozen_ = frozen;
+    } else {
+      ReadCallableContents(std::get<LoxCallablePtr>(object));
+    }
+  }
+
+  auto ReadCallableContents(const LoxCallablePtr& callable) -> void {
+    if (auto function = std::dynamic_pointer_cast<LoxFunction>(callable)) {
+      function->closure_ = GetObject<std::shared_ptr<Environment>>();
+    } else if (auto klass = std::dynamic_pointer_cast<LoxClass>(callable)) {
+      if (GetRaw<uint8_t>() != 0) {
+        klass->superclass_ = GetValue();
+      }
+      auto count = GetRaw<uint32_t>();
+      for (uint32_t i = 0; i < count; i++) {
+        std::string name = GetString();
+        klass->methods_.insert_or_assign(std::move(name),
+                                         GetObject<LoxCallablePtr>());
+      }
+    } else if (auto list = std::dynamic_pointer_cast<LoxList>(callable)) {
+      auto flags = GetRaw<uint8_t>();
+      auto count = GetRaw<uint32_t>();
+      list->Reserve(count);
+      for (uint32_t i = 0; i < count; i++) {
+        list->Push(GetValue());
+      }
+      if ((flags & kFrozen) != 0) {
+        list->Freeze();
+      }
+      if ((flags & kShareable) != 0) {
+        list->MarkShareable();
+      }
+    }
+  }
+
+  Interpreter& interpreter_;
+  std::vector<const FunctionStmtPtr*> declarations_;
+  // The object created for each shell, by index.
+  std::vector<Shell> objects_;
+  const char* next_{nullptr};
+  const char* end_{nullptr};
+};
+
+auto HeapSnapshot::Write(const std::filesystem::path& path,
+                         std::string_view source,
+                         const std::vector<StmtPtr>& statements,
+                         const Interpreter& interpreter) -> void {
+  std::string image = Writer{statements, interpreter}.Write(source);
+  std::ofstream file{path, std::ios::binary | std::ios::trunc};
+  if (!file.write(image.data(), static_cast<std::streamsize>(image.size()))) {
+    throw SnapshotError(
+        std::format("Unable to write snapshot: {}", path.string()));
+  }
+}
+
+auto HeapSnapshot::Read(const std::filesystem::path& path,
+                        std::string_view source,
+                        const std::vector<StmtPtr>& statements,
+                        Interpreter& interpreter) -> void {
+  MappedFile file{path};
+  Reader{statements, interpreter}.Read(file, source);
+}
+}  // namespace cclox
@@ -0,0 +1,62 @@
+#ifndef BACKGROUND_COMPILER_H_
+#define BACKGROUND_COMPILER_H_
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace cclox {
+/**
+ * @brief A thread that compiles on behalf of an interpreter, so that the
+ * interpreter keeps running its code in the meantime.
+ *
+ * Jobs run one at a time, in the order they were submitted. They must not
+ * touch what the interpreter changes while it runs; they hand their results
+ * back, and the interpreter installs them when it is safe to. The thread is
+ * started by the first job, so interpreters that never compile in the
+ * background do not pay for it.
+ */
+class BackgroundCompiler {
+ public:
+  using Job = std::function<void()>;
+
+  BackgroundCompiler() = default;
+
+  /**
+   * @brief Drops the jobs not started yet and waits for the running one.
+   */
+  ~BackgroundCompiler();
+
+  BackgroundCompiler(const BackgroundCompiler&) = delete;
+
+  auto operator=(const BackgroundCompiler&) -> BackgroundCompiler& = delete;
+
+  auto Submit(Job job) -> void;
+
+  /**
+   * @brief Drops the jobs not started yet and waits for the running one, so
+   * that no job outlives what it compiles.
+   */
+  auto Cancel() -> void;
+
+  /**
+   * @brief Runs the jobs submitted so far, then stops the thread. The next
+   * job starts it again.
+   */
+  auto Stop() -> void;
+
+ private:
+  auto Run() -> void;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::deque<Job> jobs_;
+  bool running_{false};
+  bool stopping_{false};
+  std::thread thread_;
+};
+}  // namespace cclox
+
+#endif  // BACKGROUND_COMPILER_H_
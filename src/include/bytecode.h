@@ -0,0 +1,134 @@
+#ifndef BYTECODE_H_
+#define BYTECODE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "object.h"
+#include "token.h"
+
+/**
+ * @brief A compact stack bytecode for the bodies of Lox functions.
+ *
+ * Locals live in the frame's stack slots, below the temporaries of the
+ * expression being evaluated, so reading a local is an index instead of an
+ * environment lookup. Instructions are fixed-size and carry up to two
+ * immediate operands; jump targets are absolute instruction indices.
+ */
+namespace cclox::bytecode {
+// The list of opcodes, expanded by `CCLOX_BYTECODE_OP` wherever a table
+// indexed by opcode is needed. Operands are named after the comment.
+#define CCLOX_BYTECODE_OPCODES(OP)                                       \
+  /* Pushes constant `a`. */                                             \
+  OP(CONSTANT)                                                           \
+  OP(POP)                                                                \
+  /* Locals, by slot `a`. Stores leave the value on the stack. */        \
+  OP(GET_LOCAL)                                                          \
+  OP(SET_LOCAL)                                                          \
+  /* Globals, named by the instruction's token. */                       \
+  OP(GET_GLOBAL)                                                         \
+  OP(SET_GLOBAL)                                                         \
+  /* Variables of enclosing functions, `a` environments up. */           \
+  OP(GET_FREE)                                                           \
+  OP(SET_FREE)                                                           \
+  OP(GET_PROPERTY)                                                       \
+  /* Throws unless the top of the stack is an instance. */               \
+  OP(CHECK_INSTANCE)                                                     \
+  /* Pops the value and the instance, and pushes the value back. */      \
+  OP(SET_PROPERTY)                                                       \
+  OP(ADD)                                                                \
+  OP(SUBTRACT)                                                           \
+  OP(MULTIPLY)                                                           \
+  OP(DIVIDE)                                                             \
+  OP(NEGATE)                                                             \
+  OP(NOT)                                                                \
+  OP(EQUAL)                                                              \
+  OP(NOT_EQUAL)                                                          \
+  OP(LESS)                                                               \
+  OP(LESS_EQUAL)                                                         \
+  OP(GREATER)                                                            \
+  OP(GREATER_EQUAL)                                                      \
+  /* Jumps to instruction `a`. */                                        \
+  OP(JUMP)                                                               \
+  /* Pops the condition and jumps to `a` if it is falsey. */             \
+  OP(JUMP_IF_FALSE)                                                      \
+  /* Keep the condition and jump to `a` if it is falsey (truthy), or */  \
+  /* pop it and fall through. */                                         \
+  OP(JUMP_IF_FALSE_OR_POP)                                               \
+  OP(JUMP_IF_TRUE_OR_POP)                                                \
+  /* Calls the callee below the `a` arguments. */                        \
+  OP(CALL)                                                               \
+  OP(PRINT)                                                              \
+  OP(RETURN)                                                             \
+  /* Superinstructions, fusing the most frequent sequences: */           \
+  /* local `a` + constant `b`. */                                        \
+  OP(ADD_LOCAL_CONSTANT)                                                 \
+  /* local `a` - constant `b`. */                                        \
+  OP(SUBTRACT_LOCAL_CONSTANT)                                            \
+  /* Pushes locals `a` and `b`. */                                       \
+  OP(GET_LOCAL_GET_LOCAL)                                                \
+  /* A comparison followed by `JUMP_IF_FALSE` to `a`. */                 \
+  OP(LESS_JUMP_IF_FALSE)                                                 \
+  OP(LESS_EQUAL_JUMP_IF_FALSE)                                           \
+  OP(GREATER_JUMP_IF_FALSE)                                              \
+  OP(GREATER_EQUAL_JUMP_IF_FALSE)                                        \
+  OP(EQUAL_JUMP_IF_FALSE)                                                \
+  OP(NOT_EQUAL_JUMP_IF_FALSE)                                            \
+  /* Calls method `token` on the instance below the `a` arguments. */    \
+  OP(INVOKE)                                                             \
+  /* Stores the top of the stack into local `a` and pops it. */          \
+  OP(SET_LOCAL_POP)
+
+enum class OpCode : uint8_t {
+#define CCLOX_BYTECODE_OP(name) name,
+  CCLOX_BYTECODE_OPCODES(CCLOX_BYTECODE_OP)
+#undef CCLOX_BYTECODE_OP
+};
+
+inline constexpr size_t kOpCodeCount = 0
+#define CCLOX_BYTECODE_OP(name) +1
+    CCLOX_BYTECODE_OPCODES(CCLOX_BYTECODE_OP)
+#undef CCLOX_BYTECODE_OP
+    ;
+
+auto OpCodeName(OpCode opcode) -> std::string_view;
+
+struct Instruction {
+  // The address of the instruction's handler in the dispatch loop, filled in
+  // by the VM before the chunk first runs (direct threading).
+  const void* handler{nullptr};
+  OpCode opcode{OpCode::POP};
+  // The token in the chunk's `tokens` naming the variable or property, and
+  // carrying the line reported by runtime errors.
+  uint32_t token{0};
+  uint32_t a{0};
+  uint32_t b{0};
+};
+
+/**
+ * @brief The bytecode of one function.
+ */
+struct Chunk {
+  std::string name;
+  size_t arity{0};
+  std::vector<Instruction> code;
+  std::vector<Object> constants;
+  std::vector<Token> tokens;
+  // Stack slots of a frame: the parameters, the other locals and the deepest
+  // temporaries.
+  size_t max_stack{0};
+  // The handler table `code` was threaded with, or `nullptr`.
+  const void* const* threaded_with{nullptr};
+};
+
+/**
+ * @brief Prints the chunk in a human-readable form.
+ */
+auto Disassemble(const Chunk& chunk, std::ostream& output) -> void;
+}  // namespace cclox::bytecode
+
+#endif  // BYTECODE_H_
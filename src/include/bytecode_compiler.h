@@ -0,0 +1,157 @@
+#ifndef BYTECODE_COMPILER_H_
+#define BYTECODE_COMPILER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "bytecode.h"
+#include "expr.h"
+#include "stmt.h"
+
+namespace cclox {
+class Interpreter;
+
+/**
+ * @brief Compiles the body of a Lox function to stack bytecode.
+ *
+ * Parameters and locals are assigned the stack slots they occupy when they
+ * are declared, and popped when their block ends. Like `IrBuilder`, the
+ * compiler rejects functions that declare nested functions or classes, whose
+ * locals could be captured, and functions that use `super`; variables of
+ * enclosing functions and `this` are accessed through the closure.
+ *
+ * With superinstructions enabled, a peephole step fuses the most frequent
+ * instruction sequences as they are emitted, never across a jump target.
+ */
+class BytecodeCompiler {
+ public:
+  explicit BytecodeCompiler(const Interpreter& interpreter,
+                            bool superinstructions = true)
+      : interpreter_(interpreter), superinstructions_(superinstructions) {}
+
+  /**
+   * @return The function's bytecode, or `std::nullopt` if it uses a construct
+   * the bytecode does not support.
+   */
+  auto Compile(const FunctionStmt& function) -> std::optional<bytecode::Chunk>;
+
+  // ====================Statement Visitors====================
+  auto operator()(const BlockStmtPtr& stmt) -> void;
+
+  auto operator()(const ClassStmtPtr& stmt) -> void;
+
+  auto operator()(const ExprStmtPtr& stmt) -> void;
+
+  auto operator()(const FunctionStmtPtr& stmt) -> void;
+
+  auto operator()(const IfStmtPtr& stmt) -> void;
+
+  auto operator()(const PrintStmtPtr& stmt) -> void;
+
+  auto operator()(const ReturnStmtPtr& stmt) -> void;
+
+  auto operator()(const VarStmtPtr& stmt) -> void;
+
+  auto operator()(const WhileStmtPtr& stmt) -> void;
+
+  // ====================Expression Visitors====================
+  auto operator()(const AssignExprPtr& expr) -> void;
+
+  auto operator()(const BinaryExprPtr& expr) -> void;
+
+  auto operator()(const CallExprPtr& expr) -> void;
+
+  auto operator()(const GetExprPtr& expr) -> void;
+
+  auto operator()(const GroupingExprPtr& expr) -> void;
+
+  auto operator()(const LiteralExprPtr& expr) -> void;
+
+  auto operator()(const LogicalExprPtr& expr) -> void;
+
+  auto operator()(const SetExprPtr& expr) -> void;
+
+  auto operator()(const SuperExprPtr& expr) -> void;
+
+  auto operator()(const ThisExprPtr& expr) -> void;
+
+  auto operator()(const UnaryExprPtr& expr) -> void;
+
+  auto operator()(const VariableExprPtr& expr) -> void;
+
+ private:
+  auto CompileStatement(const StmtPtr& stmt) -> void;
+
+  auto CompileExpression(const ExprPtr& expr) -> void;
+
+  /**
+   * @brief Appends an instruction, tracking the stack depth and fusing it
+   * with the instructions before it where possible.
+   * @return The index of the instruction it ended up in.
+   */
+  auto Emit(bytecode::OpCode opcode, const Token& token, uint32_t a = 0,
+            uint32_t b = 0) -> size_t;
+
+  auto EmitConstant(const Object& value, const Token& token) -> void;
+
+  /**
+   * @brief Points the jump at `jump` to the next instruction, which becomes
+   * a jump target.
+   */
+  auto PatchJump(size_t jump) -> void;
+
+  /**
+   * @brief The index of the next instruction, as a jump target.
+   */
+  auto Label() -> uint32_t;
+
+  /**
+   * @brief Replaces the last instructions with a superinstruction if they
+   * form one of the fused sequences.
+   */
+  auto Fuse() -> void;
+
+  auto AddToken(const Token& token) -> uint32_t;
+
+  /**
+   * @brief Makes the value on top of the stack the local `name`.
+   */
+  auto Declare(const Token& name) -> void;
+
+  auto EndScope() -> void;
+
+  /**
+   * @brief Finds the slot of the local `depth` scopes up that a resolved
+   * variable expression refers to.
+   */
+  auto FindLocal(const std::string& name, uint64_t depth) const
+      -> std::optional<uint32_t>;
+
+  /**
+   * @brief Whether evaluating the expression has no side effects and cannot
+   * throw, so it can be reordered with a property lookup.
+   */
+  auto IsSimple(const ExprPtr& expr) const -> bool;
+
+  const Interpreter& interpreter_;
+  bool superinstructions_;
+  bytecode::Chunk chunk_;
+  // The lexical scopes of the function, mirroring the resolver's, mapping
+  // each local to its slot.
+  std::vector<std::unordered_map<std::string, uint32_t>> scopes_;
+  // The index of each token in the chunk, by line and lexeme.
+  std::map<std::pair<uint32_t, std::string>, uint32_t> token_indices_;
+  // Stack slots in use at the current instruction.
+  size_t depth_{0};
+  // Instructions before this index may not be fused: a jump lands here.
+  size_t fusion_barrier_{0};
+};
+}  // namespace cclox
+
+#endif  // BYTECODE_COMPILER_H_
@@ -0,0 +1,246 @@
+#ifndef CPP_EMITTER_H_
+#define CPP_EMITTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "expr.h"
+#include "stmt.h"
+#include "token.h"
+
+namespace cclox {
+/**
+ * @brief Tracks which local declarations are visible, mirroring the scopes the
+ * resolver builds. Declarations made outside of any scope are globals.
+ */
+class LexicalScopes {
+ public:
+  struct Binding {
+    // The token that declared the variable; unique per declaration.
+    const Token* declaration;
+    // How many functions enclose the declaration.
+    size_t function_depth;
+  };
+
+  auto Push() -> void { scopes_.emplace_back(); }
+
+  auto Pop() -> void { scopes_.pop_back(); }
+
+  auto EnterFunction() -> void {
+    function_depth_++;
+    Push();
+  }
+
+  auto LeaveFunction() -> void {
+    Pop();
+    function_depth_--;
+  }
+
+  auto IsGlobalScope() const noexcept -> bool { return scopes_.empty(); }
+
+  auto GetFunctionDepth() const noexcept -> size_t { return function_depth_; }
+
+  auto Declare(const Token& variable) -> void;
+
+  /**
+   * @brief Finds the innermost local declaration of `name`, or returns
+   * `std::nullopt` if `name` refers to a global.
+   */
+  auto Find(const std::string& name) const -> std::optional<Binding>;
+
+ private:
+  std::vector<std::unordered_map<std::string, Binding>> scopes_;
+  size_t function_depth_{0};
+};
+
+/**
+ * @brief What the emitter needs to know about a program before emitting it.
+ */
+struct ProgramInfo {
+  // Locals referenced from a nested function. They live in a shared cell so
+  // closures see every later assignment.
+  std::unordered_set<const Token*> captured;
+  // Top-level functions whose global is declared once and never assigned.
+  // They become plain C++ functions that are called directly.
+  std::unordered_map<std::string, const FunctionStmt*> direct_functions;
+  // Every global name the program declares or references.
+  std::set<std::string> globals;
+  // References to the natives that spawn tasks, which compiled programs
+  // cannot use.
+  std::vector<const Token*> task_natives;
+};
+
+/**
+ * @brief Translates a resolved Lox program into a C++ program that links
+ * against the runtime library in `lox_runtime.h`.
+ *
+ * Lox locals become C++ locals and functions become lambdas, so C++ scoping
+ * does the work of the environment chain. Values stay boxed in `Object`s,
+ * except for expressions whose type is known statically (comparisons, `!`,
+ * and arithmetic on literals), which are emitted as plain `bool`, `int32_t`
+ * and `double` arithmetic.
+ */
+class CppEmitter {
+ public:
+  /**
+   * @param output Where the generated C++ source is written.
+   * @param source_name The script's name, mentioned in the generated header.
+   */
+  CppEmitter(std::ostream& output, std::string_view source_name)
+      : output_(output), source_name_(source_name) {}
+
+  /**
+   * @brief Emits the C++ program for `statements`, which must have been
+   * resolved without errors.
+   *
+   * Tasks run on copies of the interpreter's globals, which compiled code
+   * does not keep, so programs that use `spawn` or the parallel natives are
+   * rejected with a compile error written to `errors`.
+   * @return Whether a program was emitted.
+   */
+  auto Emit(const std::vector<StmtPtr>& statements, std::ostream& errors)
+      -> bool;
+
+  // ====================Statement Visitors====================
+  auto operator()(const BlockStmtPtr& stmt) -> void;
+
+  auto operator()(const ClassStmtPtr& stmt) -> void;
+
+  auto operator()(const ExprStmtPtr& stmt) -> void;
+
+  auto operator()(const FunctionStmtPtr& stmt) -> void;
+
+  auto operator()(const IfStmtPtr& stmt) -> void;
+
+  auto operator()(const PrintStmtPtr& stmt) -> void;
+
+  auto operator()(const ReturnStmtPtr& stmt) -> void;
+
+  auto operator()(const VarStmtPtr& stmt) -> void;
+
+  auto operator()(const WhileStmtPtr& stmt) -> void;
+
+  // ====================Expression Visitors====================
+  /**
+   * @brief A C++ expression together with its static type.
+   */
+  struct CppExpr {
+    enum class Type {
+      // An `Object`.
+      OBJECT,
+      // A `bool`.
+      BOOL,
+      // An `int32_t`.
+      INT,
+      // A `double`.
+      DOUBLE,
+    };
+
+    std::string code;
+    Type type{Type::OBJECT};
+    // Whether the expression is a literal or only combines literals, so it can
+    // be evaluated in any order.
+    bool is_constant{false};
+  };
+
+  auto operator()(const AssignExprPtr& expr) -> CppExpr;
+
+  auto operator()(const BinaryExprPtr& expr) -> CppExpr;
+
+  auto operator()(const CallExprPtr& expr) -> CppExpr;
+
+  auto operator()(const GetExprPtr& expr) -> CppExpr;
+
+  auto operator()(const GroupingExprPtr& expr) -> CppExpr;
+
+  auto operator()(const LiteralExprPtr& expr) -> CppExpr;
+
+  auto operator()(const LogicalExprPtr& expr) -> CppExpr;
+
+  auto operator()(const SetExprPtr& expr) -> CppExpr;
+
+  auto operator()(const SuperExprPtr& expr) -> CppExpr;
+
+  auto operator()(const ThisExprPtr& expr) -> CppExpr;
+
+  auto operator()(const UnaryExprPtr& expr) -> CppExpr;
+
+  auto operator()(const VariableExprPtr& expr) -> CppExpr;
+
+ private:
+  auto EmitStatement(const StmtPtr& stmt) -> void;
+
+  auto EmitExpression(const ExprPtr& expr) -> CppExpr;
+
+  /**
+   * @brief Emits a statement as a braced block.
+   */
+  auto EmitBranch(const StmtPtr& stmt) -> void;
+
+  /**
+   * @brief Emits a top-level function that is only called directly as a C++
+   * function.
+   */
+  auto EmitDirectFunction(const FunctionStmt& function) -> void;
+
+  /**
+   * @brief Emits the lambda implementing `function`, on the current line
+   * after `prefix` and followed by `suffix`.
+   */
+  auto EmitLambda(const FunctionStmt& function, bool is_method,
+                  std::string_view prefix, std::string_view suffix) -> void;
+
+  auto EmitParameters(const FunctionStmt& function, bool direct) -> void;
+
+  /**
+   * @brief Emits the declaration of a global or local variable initialized to
+   * `value`.
+   */
+  auto EmitDeclaration(const Token& variable, const std::string& value)
+      -> void;
+
+  /**
+   * @brief Returns the code that assigns `value` to `variable`, which must be
+   * visible.
+   */
+  auto AssignTo(const Token& variable, const std::string& value)
+      -> std::string;
+
+  auto IsCaptured(const Token& declaration) const -> bool;
+
+  auto Line(std::string_view code) -> void;
+
+  static auto Box(const CppExpr& expr) -> std::string;
+
+  static auto Condition(const CppExpr& expr) -> std::string;
+
+  static auto IsNumber(const CppExpr& expr) -> bool;
+
+  static auto Quote(std::string_view text) -> std::string;
+
+  std::ostream& output_;
+  std::string source_name_;
+  ProgramInfo info_;
+  LexicalScopes scopes_;
+  // Direct functions are emitted to their own stream, so `out_` changes
+  // while one is being emitted.
+  std::ostringstream functions_;
+  std::ostringstream main_;
+  std::ostringstream* out_{&main_};
+  size_t indent_{1};
+  // The variables holding the superclass of each enclosing class.
+  std::vector<std::string> superclasses_;
+  size_t next_class_id_{0};
+};
+}  // namespace cclox
+
+#endif  // CPP_EMITTER_H_
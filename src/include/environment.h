@@ -6,6 +6,7 @@
 #include <unordered_map>
 #include <utility>
 
+#include "heap_meter.h"
 #include "object.h"
 #include "token.h"
 
@@ -24,6 +25,21 @@ class Environment : public std::enable_shared_from_this<Environment> {
 
   auto GetAt(uint64_t distance, const Token& variable) -> Object;
 
+  /**
+   * @brief Looks up a variable defined directly in this environment without
+   * throwing. The returned pointer stays valid for the environment's lifetime
+   * since variables are never removed.
+   * @return A pointer to the variable's value, or `nullptr` if not defined.
+   */
+  auto Find(const std::string& name) const noexcept -> const Object*;
+
+  /**
+   * @brief Like `Find`, but looks in the ancestor `distance` hops away and
+   * allows the value to be updated in place. Such updates bypass the heap
+   * meter, so they may only replace a number or boolean with another.
+   */
+  auto FindAt(uint64_t distance, const std::string& name) -> Object*;
+
   auto Define(const std::string& name, const Object& value) -> void;
 
   auto Assign(const Token& variable, const Object& value) -> void;
@@ -36,6 +52,23 @@ class Environment : public std::enable_shared_from_this<Environment> {
 
   using VariableMap = std::unordered_map<std::string, Object>;
 
+  /**
+   * @brief The variables defined directly in this environment.
+   */
+  auto GetValues() const noexcept -> const VariableMap& { return values_; }
+
+  /**
+   * @brief Replaces the variables defined directly in this environment with
+   * `values`.
+   */
+  auto Reset(const VariableMap& values) -> void;
+
+  /**
+   * @brief Charges this environment and its variables to `meter` from now on,
+   * for an environment made before the meter was bound.
+   */
+  auto ChargeTo(std::shared_ptr<HeapMeter> meter) noexcept -> void;
+
  private:
   Environment() = default;
 
@@ -46,6 +79,7 @@ class Environment : public std::enable_shared_from_this<Environment> {
 
   VariableMap values_;
   std::shared_ptr<Environment> enclosing_;
+  HeapCharge charge_{sizeof(Environment)};
 };
 }  // namespace cclox
 
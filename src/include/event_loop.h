@@ -0,0 +1,199 @@
+#ifndef EVENT_LOOP_H_
+#define EVENT_LOOP_H_
+
+#include <ucontext.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "interpreter.h"
+#include "lox_callable.h"
+#include "object.h"
+
+namespace cclox {
+class EventLoop;
+
+/**
+ * @brief The result of an async call or of an asynchronous native, such as
+ * `sleep`, which `await` waits for. Calling a promise is the same as
+ * awaiting it.
+ */
+class LoxPromise : public LoxCallable,
+                   public std::enable_shared_from_this<LoxPromise> {
+ public:
+  explicit LoxPromise(EventLoop& loop) : loop_(loop) {}
+
+  auto Arity() const noexcept -> size_t override { return 0; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<promise>"; }
+
+  auto IsSettled() const noexcept -> bool { return settled_; }
+
+  auto Resolve(Object result) -> void;
+
+  /**
+   * @param error A `RuntimeError`, or a `NativeError` to be reported where
+   * the promise is awaited.
+   */
+  auto Reject(std::exception_ptr error) -> void;
+
+  /**
+   * @brief Returns the result, or rethrows the error.
+   * @pre `IsSettled()`.
+   */
+  auto GetResult() -> Object;
+
+  /**
+   * @brief Calls `callback` once the promise is settled.
+   */
+  auto OnSettled(std::function<void()> callback) -> void;
+
+ private:
+  friend class EventLoop;
+
+  EventLoop& loop_;
+  bool settled_{false};
+  // Whether anyone awaited the promise, so that its error is not lost.
+  bool awaited_{false};
+  Object result_;
+  std::exception_ptr error_;
+  std::vector<std::function<void()>> callbacks_;
+};
+
+/**
+ * @brief Runs the async calls of one interpreter on its thread, and the
+ * timers and file reads they wait for.
+ *
+ * Each async call runs on a fiber: a stack of its own that the thread
+ * switches to and away from. An `await` on a pending promise inside an async
+ * call switches back to whoever resumed the call, however deep in the
+ * interpreter it is, and the loop resumes it once the promise is settled; so
+ * every engine runs async calls unchanged, and thousands of them can wait at
+ * once on one thread. Outside async calls, `await` runs the loop until the
+ * promise is settled.
+ *
+ * The loop waits for timers and readable file descriptors with `epoll`.
+ */
+class EventLoop {
+ public:
+  using Callback = std::function<void()>;
+
+  explicit EventLoop(Interpreter& interpreter);
+
+  /**
+   * @brief Cancels the async calls still waiting.
+   */
+  ~EventLoop();
+
+  EventLoop(const EventLoop&) = delete;
+
+  auto operator=(const EventLoop&) -> EventLoop& = delete;
+
+  /**
+   * @brief Calls `callee` with no arguments as an async call, which runs
+   * until it first waits, and returns the promise of its result.
+   */
+  auto Start(LoxCallablePtr callee) -> std::shared_ptr<LoxPromise>;
+
+  /**
+   * @brief Waits for `promise` and returns its result: by suspending the
+   * running async call, or outside of one, by running the loop until the
+   * promise and every callback that became due with it have run.
+   * @throws NativeError If the promise can never be settled.
+   */
+  auto Await(const std::shared_ptr<LoxPromise>& promise) -> Object;
+
+  /**
+   * @brief Calls `callback` on the next turn of the loop.
+   */
+  auto Post(Callback callback) -> void;
+
+  auto AddTimer(std::chrono::milliseconds delay, Callback callback) -> void;
+
+  /**
+   * @brief Calls `callback` whenever `fd` is readable, until `Unwatch(fd)`.
+   * @return Whether `fd` can be waited for. Regular files cannot, as they
+   * are always readable.
+   */
+  auto WatchReadable(int fd, Callback callback) -> bool;
+
+  auto Unwatch(int fd) -> void;
+
+  /**
+   * @brief Runs until nothing is left to do, then cancels the async calls
+   * waiting for what can no longer happen.
+   * @throws RuntimeError The first error of a failed async call that nobody
+   * awaited.
+   * @throws NativeError If the running code's deadline passes while waiting.
+   */
+  auto Run() -> void;
+
+  /**
+   * @brief Cancels all async calls still waiting, unwinding their stacks,
+   * and drops the timers and watches they waited for.
+   */
+  auto Cancel() noexcept -> void;
+
+ private:
+  struct Fiber;
+
+  struct Timer {
+    std::chrono::steady_clock::time_point deadline;
+    // Timers with the same deadline fire in the order they were added.
+    uint64_t sequence;
+    Callback callback;
+
+    auto operator>(const Timer& other) const noexcept -> bool {
+      return deadline != other.deadline ? deadline > other.deadline
+                                        : sequence > other.sequence;
+    }
+  };
+
+  /**
+   * @brief Runs the callbacks that are due, waiting for the first of them
+   * if none is.
+   * @return Whether anything was left to do.
+   * @throws NativeError If the running code's deadline passes while waiting.
+   */
+  auto RunOnce() -> bool;
+
+  auto Resume(Fiber& fiber) -> void;
+
+  /**
+   * @brief Switches from the running fiber back to whoever resumed it.
+   */
+  auto Suspend() -> void;
+
+  static auto RunFiber() -> void;
+
+  auto AllocateStack() -> void*;
+
+  Interpreter& interpreter_;
+  std::deque<Callback> ready_;
+  std::priority_queue<Timer, std::vector<Timer>, std::greater<>> timers_;
+  uint64_t timer_count_{0};
+  int epoll_fd_{-1};
+  std::unordered_map<int, Callback> watches_;
+  // Fibers by id, which callbacks hold instead of pointers, as fibers can be
+  // cancelled before the callbacks run.
+  std::unordered_map<uint64_t, std::unique_ptr<Fiber>> fibers_;
+  uint64_t fiber_count_{0};
+  Fiber* current_{nullptr};
+  std::vector<void*> free_stacks_;
+  std::vector<std::shared_ptr<LoxPromise>> rejected_;
+};
+}  // namespace cclox
+
+#endif  // EVENT_LOOP_H_
@@ -0,0 +1,150 @@
+#ifndef HEAP_METER_H_
+#define HEAP_METER_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include "object.h"
+
+namespace cclox {
+/**
+ * @brief The bytes a program's objects hold now, and the most they held.
+ */
+struct HeapUsage {
+  size_t current{0};
+  size_t peak{0};
+};
+
+/**
+ * @brief Counts the memory held by a program's environments, functions,
+ * instances and lists, with the strings stored in them, against an optional
+ * limit.
+ *
+ * The interpreter running on a thread binds its meter there, and objects
+ * created on the thread charge it until they die. An interpreter and its task
+ * contexts share one meter, so the counts are atomic. Sizes are estimates of
+ * what the objects allocate.
+ *
+ * Going over the limit only raises an alarm, which makes the bound
+ * interpreter's next loop iteration or call fail, where it has a token to
+ * report the error at.
+ */
+class HeapMeter {
+ public:
+  explicit HeapMeter(std::optional<size_t> limit) noexcept : limit_(limit) {}
+
+  /**
+   * @brief Makes objects created on this thread charge `meter`, if any, and
+   * zero `*alarm` whenever a charge leaves it over its limit.
+   */
+  static auto Bind(std::shared_ptr<HeapMeter> meter, int64_t* alarm) noexcept
+      -> void;
+
+  /**
+   * @brief Undoes `Bind` if this thread's alarm is still `alarm`.
+   */
+  static auto Unbind(const int64_t* alarm) noexcept -> void;
+
+  /**
+   * @brief Returns the meter bound to this thread, or `nullptr`.
+   */
+  static auto Current() noexcept -> const std::shared_ptr<HeapMeter>&;
+
+  auto Charge(size_t bytes) noexcept -> void;
+
+  auto Release(size_t bytes) noexcept -> void {
+    current_.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  auto IsOverLimit() const noexcept -> bool {
+    return limit_ && current_.load(std::memory_order_relaxed) > limit_.value();
+  }
+
+  auto GetUsage() const noexcept -> HeapUsage {
+    return {current_.load(std::memory_order_relaxed),
+            peak_.load(std::memory_order_relaxed)};
+  }
+
+  auto GetLimit() const noexcept -> std::optional<size_t> { return limit_; }
+
+ private:
+  std::atomic<size_t> current_{0};
+  std::atomic<size_t> peak_{0};
+  const std::optional<size_t> limit_;
+};
+
+/**
+ * @brief The bytes an object charged to the meter bound when it was created,
+ * released when it dies. Objects made while no meter is bound charge nothing.
+ */
+class HeapCharge {
+ public:
+  explicit HeapCharge(size_t bytes) noexcept : meter_(HeapMeter::Current()) {
+    if (meter_) {
+      meter_->Charge(bytes);
+      bytes_ = bytes;
+    }
+  }
+
+  HeapCharge(const HeapCharge&) = delete;
+  auto operator=(const HeapCharge&) -> HeapCharge& = delete;
+
+  ~HeapCharge() {
+    if (meter_) {
+      meter_->Release(bytes_);
+    }
+  }
+
+  /**
+   * @brief Charges `added` more bytes and releases `removed`, for an object
+   * that grew or shrank.
+   * @pre `removed` bytes were charged by this object, which holds when every
+   * write to its fields, elements or variables goes through `Adjust`.
+   */
+  auto Adjust(size_t added, size_t removed) noexcept -> void {
+    if (meter_) {
+      meter_->Charge(added);
+      meter_->Release(removed);
+      bytes_ = bytes_ + added - removed;
+    }
+  }
+
+  /**
+   * @brief Releases what was charged, and charges `bytes` to `meter` instead.
+   */
+  auto MoveTo(std::shared_ptr<HeapMeter> meter, size_t bytes) noexcept
+      -> void {
+    if (meter_) {
+      meter_->Release(bytes_);
+    }
+    meter_ = std::move(meter);
+    bytes_ = 0;
+    Adjust(bytes, 0);
+  }
+
+  /**
+   * @brief Returns the bytes `value` holds outside of an `Object`.
+   */
+  static auto SizeOf(const Object& value) noexcept -> size_t {
+    return value.IsString() ? value.Get<std::string>().size() : 0;
+  }
+
+  /**
+   * @brief Returns the bytes a variable or field named `name` holding `value`
+   * takes in a hash map.
+   */
+  static auto SizeOf(const std::string& name, const Object& value) noexcept
+      -> size_t;
+
+ private:
+  std::shared_ptr<HeapMeter> meter_;
+  size_t bytes_{0};
+};
+}  // namespace cclox
+
+#endif  // HEAP_METER_H_
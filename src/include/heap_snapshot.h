@@ -0,0 +1,62 @@
+#ifndef HEAP_SNAPSHOT_H_
+#define HEAP_SNAPSHOT_H_
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "stmt.h"
+
+namespace cclox {
+class Interpreter;
+
+class SnapshotError : public std::runtime_error {
+ public:
+  explicit SnapshotError(const std::string& message)
+      : std::runtime_error(message) {}
+};
+
+/**
+ * @brief Saves the globals a script's top level defined, with everything they
+ * reach, to a file that a later run of the same script loads instead of
+ * running its top level again.
+ *
+ * The file is a table of object shells, then the contents of each object,
+ * which refers to others by their index in the table. Loading maps the file,
+ * creates every shell, then fills in the contents, so it costs time in
+ * proportion to the size of the heap. Functions refer to their declaration
+ * by its position in the script, which must be unchanged: the file records a
+ * hash of the source. Natives are saved by name; tasks, futures, channels and
+ * the functions of imported modules can't be saved.
+ */
+class HeapSnapshot {
+ public:
+  /**
+   * @brief Saves the globals of `interpreter`, which ran the top level of
+   * `statements`, parsed from `source`, to `path`.
+   * @throws SnapshotError If the globals reach something that can't be
+   * saved, or the file can't be written.
+   */
+  static auto Write(const std::filesystem::path& path, std::string_view source,
+                    const std::vector<StmtPtr>& statements,
+                    const Interpreter& interpreter) -> void;
+
+  /**
+   * @brief Defines the globals saved at `path` in `interpreter`, whose
+   * program is `statements`, parsed from `source`.
+   * @throws SnapshotError If the file can't be read, is malformed or was
+   * saved from a different script.
+   */
+  static auto Read(const std::filesystem::path& path, std::string_view source,
+                   const std::vector<StmtPtr>& statements,
+                   Interpreter& interpreter) -> void;
+
+ private:
+  class Writer;
+  class Reader;
+};
+}  // namespace cclox
+
+#endif  // HEAP_SNAPSHOT_H_
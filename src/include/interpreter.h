@@ -1,20 +1,44 @@
 #ifndef INTERPRETER_H_
 #define INTERPRETER_H_
 
+#include <chrono>
+#include <cstdint>
 #include <format>
+#include <limits>
 #include <memory>
+#include <optional>
 #include <ostream>
 #include <stdexcept>
+#include <string>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "background_compiler.h"
 #include "environment.h"
 #include "expr.h"
+#include "heap_meter.h"
+#include "jit.h"
+#include "module_cache.h"
 #include "object.h"
+#include "optimizer.h"
+#include "register_vm.h"
 #include "stmt.h"
+#include "trace_jit.h"
+#include "vm.h"
 
 namespace cclox {
+/**
+ * @brief Bounds on how long a run may execute.
+ */
+struct ExecutionLimits {
+  // Loop iterations and calls the run may make, or `std::nullopt` for no
+  // bound.
+  std::optional<uint64_t> fuel;
+  // When the run must have ended, or `std::nullopt` for no bound.
+  std::optional<std::chrono::steady_clock::time_point> deadline;
+};
+
 /**
  * @brief Exception class for runtime errors during interpretation.
  */
@@ -33,6 +57,20 @@ class RuntimeError : public std::runtime_error {
   Token token_;
 };
 
+/**
+ * @brief Exception class for errors in native functions, which do not know
+ * where they are called from. `Interpreter::Call` reports them as runtime
+ * errors at the call.
+ */
+class NativeError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+class EventLoop;
+class LoxFuture;
+class TaskScheduler;
+
 /**
  * @brief Interpreter class that evaluates and executes expressions.
  */
@@ -42,16 +80,280 @@ class Interpreter {
 
   explicit Interpreter(std::ostream& output);
 
+  /**
+   * @brief Constructs a context for running tasks spawned by the programs of
+   * `root`, on another thread. It shares `root`'s resolution of variables and
+   * its execution settings, but none of its state.
+   */
+  Interpreter(std::ostream& output, Interpreter& root);
+
+  ~Interpreter();
+
   /**
    * @brief Evaluates an expression and prints its result.
    * @param expr The expression to interpret.
    */
   auto Interpret(const std::vector<StmtPtr>& statements) -> void;
 
+  /**
+   * @brief Runs the next top-level statement of a program that is still
+   * being read. A runtime error ends the program and is reported.
+   * @return Whether the statement ran without errors.
+   */
+  auto ExecuteTopLevel(const StmtPtr& statement) -> bool;
+
+  /**
+   * @brief Ends a program run with `ExecuteTopLevel`: waits for its async
+   * calls and tasks and drops the code compiled for it, unless it is kept.
+   */
+  auto EndProgram() -> void;
+
+  /**
+   * @brief Sets whether ending a program keeps the code compiled for it, for
+   * sessions whose statements outlive each program run in them. Their runner
+   * then forgets the code of the statements it drops.
+   */
+  auto SetKeepsCompiledCode(bool keeps) noexcept -> void {
+    keeps_compiled_code_ = keeps;
+  }
+
   auto ResolveVariable(const ExprPtr& expr, uint64_t depth) -> void;
 
+  /**
+   * @brief Forgets how the given expressions were resolved, once the code
+   * they are part of can no longer run.
+   */
+  auto ForgetVariables(const std::vector<ExprPtr>& exprs) -> void;
+
+  /**
+   * @brief Returns the scope distance the resolver computed for a variable
+   * expression, or `std::nullopt` if the variable is global.
+   */
+  auto GetResolvedDepth(const ExprPtr& expr) const -> std::optional<uint64_t>;
+
+  auto GetGlobalEnvironment() const noexcept
+      -> const std::shared_ptr<Environment>&;
+
+  /**
+   * @brief Returns the globals every program starts with: the natives.
+   */
+  auto GetNatives() const noexcept -> const Environment::VariableMap& {
+    return natives_;
+  }
+
   auto GetOutputStream() const -> std::ostream&;
 
+  auto GetJit() noexcept -> Jit&;
+
+  auto GetTraceJit() noexcept -> TraceJit&;
+
+  auto GetOptimizer() noexcept -> Optimizer&;
+
+  auto GetVm() noexcept -> Vm&;
+
+  auto GetRegisterVm() noexcept -> RegisterVm&;
+
+  auto GetBackgroundCompiler() noexcept -> BackgroundCompiler&;
+
+  /**
+   * @brief Sets the number of threads running spawned tasks; 0, the default,
+   * uses one per hardware thread. Takes effect when the first task is
+   * spawned.
+   */
+  auto SetWorkerCount(size_t count) noexcept -> void;
+
+  /**
+   * @brief Bounds each run, a program or a call from the host, to `fuel`
+   * loop iterations and calls and to `time_limit` of wall-clock time; either
+   * may be `std::nullopt`. A run that exceeds a bound fails with a runtime
+   * error, which the host can catch from `CallFromHost`. While a run is
+   * bounded, functions and loops run on the tree-walker, which counts fuel.
+   */
+  auto SetExecutionBudget(std::optional<uint64_t> fuel,
+                          std::optional<std::chrono::milliseconds> time_limit)
+      -> void;
+
+  /**
+   * @brief Starts the bounds set by `SetExecutionBudget` for a new run.
+   */
+  auto StartExecutionBudget() -> void;
+
+  /**
+   * @brief Returns what is left of the bounds of the running code. Tasks run
+   * with what their spawner had left.
+   */
+  auto GetExecutionLimits() const noexcept -> ExecutionLimits;
+
+  /**
+   * @brief Replaces the bounds of the running code.
+   */
+  auto SetExecutionLimits(const ExecutionLimits& limits) noexcept -> void;
+
+  /**
+   * @brief Counts the memory programs hold from now on, and bounds it to
+   * `limit` bytes if set. Once over the bound, the next loop iteration or
+   * call of the running code fails with an "Out of memory." runtime error;
+   * while memory is bounded, functions and loops run on the tree-walker.
+   * Tasks share the bound of the program that spawned them.
+   */
+  auto SetHeapLimit(std::optional<size_t> limit) -> void;
+
+  /**
+   * @brief Returns the memory counted since `SetHeapLimit`, or nothing if it
+   * was never called.
+   */
+  auto GetHeapUsage() const noexcept -> HeapUsage;
+
+  /**
+   * @brief Tells whether the running code has bounds, which compiled code
+   * would not count.
+   */
+  auto IsMetered() const noexcept -> bool { return metered_; }
+
+  /**
+   * @brief Charges a loop iteration or call to the running code's fuel.
+   * Without bounds, this is a decrement that never reaches zero.
+   * @throws RuntimeError At `token`, once a bound is exceeded.
+   */
+  auto ChargeFuel(const Token& token) -> void {
+    if (--fuel_ < 0) [[unlikely]] {
+      Refuel(token);
+    }
+  }
+
+  /**
+   * @brief Returns the pool running spawned tasks, shared by the root
+   * interpreter and its task contexts and started on first use.
+   */
+  auto GetTaskScheduler() -> TaskScheduler&;
+
+  /**
+   * @brief Records a task spawned by the running program or task, which
+   * joins it when it ends.
+   */
+  auto AddSpawnedTask(std::shared_ptr<LoxFuture> future) -> void;
+
+  /**
+   * @brief Awaits, in spawn order, the spawned tasks nobody awaited.
+   * @throws RuntimeError The first error of a failed task, once all of them
+   * have finished, or the deadline passing.
+   */
+  auto AwaitSpawnedTasks() -> void;
+
+  /**
+   * @brief Waits for the spawned tasks nobody awaited and drops their output
+   * and results, after the program failed. On the root, the tasks' waits for
+   * channels are cancelled first, so that they fail instead of waiting
+   * forever.
+   */
+  auto DiscardSpawnedTasks() noexcept -> void;
+
+  /**
+   * @brief Records a function of the program whose body is parsed on its
+   * first call.
+   */
+  auto AddLazyFunction(FunctionStmt& function) -> void;
+
+  /**
+   * @brief Parses and resolves the body of a function that was only
+   * pre-parsed.
+   * @throws RuntimeError If the body has syntax or resolution errors, which
+   * are reported first.
+   */
+  auto CompileLazyBody(FunctionStmt& function) -> void;
+
+  /**
+   * @brief Compiles the body of every function of the program that was only
+   * pre-parsed. Tasks read bodies and resolutions without a lock, so this
+   * runs before the first task starts.
+   * @throws RuntimeError If a body has errors.
+   */
+  auto CompileLazyBodies() -> void;
+
+  /**
+   * @brief Returns the namespace of the module at `path`: a frozen instance
+   * with a field for each variable, function and class the module's top
+   * level defines. The module is resolved and run the first time the program
+   * imports it.
+   * @throws NativeError If the module cannot be read or compiled, imports
+   * itself, or is imported by a task or while tasks run.
+   */
+  auto ImportModule(const std::string& path) -> Object;
+
+  /**
+   * @brief Returns the loop running this interpreter's async calls, started
+   * on first use.
+   */
+  auto GetEventLoop() -> EventLoop&;
+
+  /**
+   * @brief Runs the event loop until no async call can make progress, then
+   * cancels those left waiting.
+   * @throws RuntimeError The first error of a failed async call that nobody
+   * awaited, or the deadline passing.
+   */
+  auto RunEventLoop() -> void;
+
+  /**
+   * @brief Cancels the async calls still waiting, after the program failed.
+   */
+  auto CancelAsyncCalls() noexcept -> void;
+
+  /**
+   * @brief Calls `callee` on behalf of the host program, like a call
+   * statement at the top level of a script: the result of an async callee is
+   * awaited, and so are the async calls and tasks the call started.
+   * @throws RuntimeError If the call fails, once what it started is
+   * cancelled.
+   */
+  auto CallFromHost(const Object& callee, const std::vector<Object>& arguments)
+      -> Object;
+
+  /**
+   * @brief Forgets the programs run so far, their globals and everything
+   * compiled for them, so that the next program runs as in a new
+   * interpreter. The native functions, the settings and the threads are
+   * kept.
+   */
+  auto Reset() -> void;
+
+  /**
+   * @brief Takes the execution settings of `other`, for running programs
+   * like it on another thread.
+   */
+  auto CopySettings(const Interpreter& other) noexcept -> void;
+
+  /**
+   * @brief Stops the threads running tasks and background compilation, which
+   * start again when next needed. Only the calling thread lives on in a
+   * process made by `fork()`, so this must come first.
+   */
+  auto StopThreads() -> void;
+
+  /**
+   * @brief What the interpreter is in the middle of running. Each async call
+   * has its own, swapped in while it runs.
+   */
+  struct ExecutionState {
+    std::shared_ptr<Environment> environment;
+    JitProfile* active_profile;
+  };
+
+  auto SwapExecutionState(ExecutionState& state) noexcept -> void;
+
+  /**
+   * @brief Drops traces, optimized functions and bytecode. They are keyed by
+   * statements, so they must not outlive the program they were compiled
+   * from.
+   */
+  auto ClearCompiledCode() noexcept -> void;
+
+  /**
+   * @brief Drops what was compiled for the loops in `stmt`, a top-level
+   * statement that defines no functions and is about to be destroyed.
+   */
+  auto ForgetLoops(const StmtPtr& stmt) noexcept -> void;
+
   // ====================Methods to handle statement====================
   auto ExecuteStatement(const StmtPtr& stmt) -> void;
 
@@ -128,10 +430,16 @@ class Interpreter {
 
   auto operator()(const VariableExprPtr& expr) -> Object;
 
-  using ResolvedVariableMap = std::unordered_map<ExprPtr, size_t>;
+  /**
+   * @brief Calls `callee` after checking that it is callable with the given
+   * number of arguments.
+   * @param paren The call's closing parenthesis, for error reporting.
+   */
+  auto Call(const Object& callee, const std::vector<Object>& arguments,
+            const Token& paren) -> Object;
 
- private:
-  auto DefineNativeFunctions() -> void;
+  // ====================Operators====================
+  // The operators' semantics are shared with the ahead-of-time runtime.
 
   /**
    * @brief Tests equality between two Objects.
@@ -139,7 +447,7 @@ class Interpreter {
    * @param right Right operand of the equality comparison.
    * @return true if objects are equal, false otherwise.
    */
-  auto Equal(const Object& left, const Object& right) const -> bool;
+  static auto Equal(const Object& left, const Object& right) -> bool;
 
   /**
    * @brief Tests if left operand is greater than right operand.
@@ -148,7 +456,7 @@ class Interpreter {
    * @param right Right operand.
    * @return true if left > right, false otherwise.
    */
-  auto Greater(const Object& left, const Token& op, const Object& right) const
+  static auto Greater(const Object& left, const Token& op, const Object& right)
       -> bool;
 
   /**
@@ -158,7 +466,7 @@ class Interpreter {
    * @param right Right operand.
    * @return true if left < right, false otherwise.
    */
-  auto Less(const Object& left, const Token& op, const Object& right) const
+  static auto Less(const Object& left, const Token& op, const Object& right)
       -> bool;
 
   /**
@@ -168,7 +476,7 @@ class Interpreter {
    * @param right Right operand.
    * @return Result of subtraction.
    */
-  auto Subtract(const Object& left, const Token& op, const Object& right) const
+  static auto Subtract(const Object& left, const Token& op, const Object& right)
       -> Object;
 
   /**
@@ -178,7 +486,7 @@ class Interpreter {
    * @param right Right operand.
    * @return Result of addition.
    */
-  auto Add(const Object& left, const Token& op, const Object& right) const
+  static auto Add(const Object& left, const Token& op, const Object& right)
       -> Object;
 
   /**
@@ -188,7 +496,7 @@ class Interpreter {
    * @param right Right operand.
    * @return Result of division.
    */
-  auto Divide(const Object& left, const Token& op, const Object& right) const
+  static auto Divide(const Object& left, const Token& op, const Object& right)
       -> Object;
 
   /**
@@ -198,7 +506,7 @@ class Interpreter {
    * @param right Right operand.
    * @return Result of multiplication.
    */
-  auto Multiply(const Object& left, const Token& op, const Object& right) const
+  static auto Multiply(const Object& left, const Token& op, const Object& right)
       -> Object;
 
   /**
@@ -208,17 +516,77 @@ class Interpreter {
    * @param right Right operand.
    * @return Pair of doubles representing the numeric values.
    */
-  auto GetNumberOperands(const Object& left, const Token& op,
-                         const Object& right) const
+  static auto GetNumberOperands(const Object& left, const Token& op,
+                                const Object& right)
       -> std::pair<double, double>;
 
+  using ResolvedVariableMap = std::unordered_map<ExprPtr, size_t>;
+
+ private:
+  /**
+   * @brief Ends the program after a runtime error, cancelling what it still
+   * runs.
+   */
+  auto AbortProgram(const RuntimeError& error) -> void;
+
+  auto ReleaseProgram() noexcept -> void;
+
+  /**
+   * @brief Hands the next slice of fuel to `fuel_`, after checking the
+   * deadline and the heap; called once per slice, so that the clock is read
+   * rarely, and when the heap meter raises its alarm.
+   */
+  auto Refuel(const Token& token) -> void;
+
+  auto DefineNativeFunctions() -> void;
+
   auto LookUpVariable(const Token& variable, const ExprPtr& expr) -> Object;
 
   // The environment that stores variables' values.
   const std::shared_ptr<Environment> globals_{Environment::Create()};
   std::shared_ptr<Environment> environment_{globals_};
-  ResolvedVariableMap locals_;
+  // The globals a new program starts with, restored by `Reset`.
+  Environment::VariableMap natives_;
+  // Functions of the program that may still need their body parsed.
+  std::vector<FunctionStmt*> lazy_functions_;
+  // The namespaces of the modules the program imported, by canonical path;
+  // `std::nullopt` while the module runs.
+  std::unordered_map<std::string, std::optional<Object>> modules_;
+  // Functions and classes of imported modules refer to their statements.
+  std::vector<std::shared_ptr<const Module>> imported_;
+  // Shared with task contexts, which run the same programs.
+  std::shared_ptr<ResolvedVariableMap> locals_{
+      std::make_shared<ResolvedVariableMap>()};
   std::ostream& output_{std::cout};
+  // The interpreter running the programs; `this` unless this is a task
+  // context.
+  Interpreter* root_{this};
+  Jit jit_{*this};
+  TraceJit trace_jit_{*this};
+  Optimizer optimizer_{*this};
+  Vm vm_{*this};
+  RegisterVm register_vm_{*this};
+  // Declared after the state its jobs use, so that they stop first.
+  BackgroundCompiler background_compiler_;
+  size_t worker_count_{0};
+  // Set by `SetExecutionBudget`, and started for each run.
+  std::optional<uint64_t> fuel_budget_;
+  std::optional<std::chrono::milliseconds> time_limit_;
+  // Fuel left in the current slice; effectively endless when unmetered.
+  int64_t fuel_{std::numeric_limits<int64_t>::max()};
+  // Fuel not yet handed out in slices, or `std::nullopt` without a budget.
+  std::optional<uint64_t> fuel_reserve_;
+  std::optional<std::chrono::steady_clock::time_point> deadline_;
+  bool metered_{false};
+  bool keeps_compiled_code_{false};
+  // Set by `SetHeapLimit`; task contexts use their root's.
+  std::shared_ptr<HeapMeter> heap_;
+  // Tasks spawned by the running program or task that are not awaited yet.
+  std::vector<std::shared_ptr<LoxFuture>> spawned_;
+  // Declared after the state its async calls use while they are cancelled.
+  std::unique_ptr<EventLoop> event_loop_;
+  // Declared last so that worker threads stop before anything they use dies.
+  std::unique_ptr<TaskScheduler> scheduler_;
 };
 }  // namespace cclox
 
@@ -0,0 +1,332 @@
+#ifndef IR_H_
+#define IR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "object.h"
+#include "token.h"
+#include "token_type.h"
+
+/**
+ * @brief A mid-level SSA intermediate representation for Lox functions.
+ *
+ * A function is a control flow graph of basic blocks. Every value is defined
+ * exactly once, and values flowing in from several predecessors are merged by
+ * phi instructions at the top of a block. Values are boxed `Object`s: the IR
+ * makes data flow and control flow explicit but leaves the types dynamic, so
+ * every operation keeps the interpreter's semantics and runtime errors.
+ */
+namespace cclox::ir {
+using ValueId = uint32_t;
+using BlockId = uint32_t;
+
+inline constexpr ValueId kNoValue = std::numeric_limits<ValueId>::max();
+
+// The `index` of a call that must not be inlined.
+inline constexpr uint64_t kNoInline = 1;
+
+enum class Opcode : uint8_t {
+  // The constant `constant`.
+  CONST,
+  // The parameter at position `index`.
+  PARAM,
+  // Merges one operand per predecessor, in the order of `predecessors`.
+  PHI,
+  // The value of its operand. `token` names the variable it defines.
+  COPY,
+  // Arithmetic and comparisons, with the interpreter's semantics.
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  NEG,
+  NOT,
+  EQ,
+  NE,
+  LT,
+  LE,
+  GT,
+  GE,
+  // Globals, named by `token`.
+  LOAD_GLOBAL,
+  STORE_GLOBAL,
+  // Variables of enclosing functions, `index` environments up from the
+  // closure.
+  LOAD_FREE,
+  STORE_FREE,
+  // Properties of instances, named by `token`.
+  GET_PROPERTY,
+  // Throws unless its operand is an instance, before the assigned value of a
+  // `SetExpr` is evaluated.
+  CHECK_INSTANCE,
+  SET_PROPERTY,
+  // Calls the first operand with the others as arguments.
+  CALL,
+  // Whether its operand is the function `constant`, compared by identity.
+  // Guards code inlined from that function.
+  IS_CALLEE,
+  // Whether its operand has the type `index`.
+  IS_TYPE,
+  // Its operand, which a preceding `IS_TYPE` proved to have the type `index`.
+  ASSUME_TYPE,
+  PRINT,
+  // Terminators.
+  JUMP,
+  BRANCH,
+  RETURN,
+  // Leaves the optimized code for the interpreter, which resumes where the
+  // code was entered. `token` and `index` name the variable and the type
+  // whose speculation failed.
+  DEOPT,
+};
+
+/**
+ * @brief What is statically known about the values an SSA value can hold at
+ * run time. `NONE` means no value has been seen yet, `NUMBER` is an integer or
+ * a double (integer arithmetic overflows into doubles), and `ANY` is unknown.
+ */
+enum class Type : uint8_t {
+  NONE,
+  INT,
+  DOUBLE,
+  NUMBER,
+  BOOL,
+  STRING,
+  NIL,
+  ANY,
+};
+
+/**
+ * @brief The least type that includes both types.
+ */
+auto Join(Type left, Type right) noexcept -> Type;
+
+/**
+ * @brief Whether every value of the type is a number.
+ */
+auto IsNumeric(Type type) noexcept -> bool;
+
+auto TypeName(Type type) -> std::string_view;
+
+/**
+ * @brief The most precise type of a run-time value.
+ */
+auto TypeOf(const Object& value) -> Type;
+
+auto HasType(const Object& value, Type type) -> bool;
+
+struct Instruction {
+  Opcode opcode{Opcode::CONST};
+  // The value the instruction defines, or `kNoValue`.
+  ValueId result{kNoValue};
+  std::vector<ValueId> operands;
+  // Names the variable or property the instruction accesses, and carries the
+  // line reported by runtime errors.
+  Token token{TokenType::NIL, ""};
+  Object constant{nullptr};
+  // `PARAM`: the parameter's position. `LOAD_FREE` and `STORE_FREE`: the
+  // distance to the variable's environment. `CALL`: `kNoInline` or 0.
+  // `IS_TYPE`, `ASSUME_TYPE` and `DEOPT`: the `Type`.
+  uint64_t index{0};
+  // `JUMP`: the target. `BRANCH`: the targets when the operand is truthy and
+  // falsey.
+  std::vector<BlockId> targets;
+};
+
+struct Block {
+  std::vector<Instruction> phis;
+  // The block's code, ending with exactly one terminator.
+  std::vector<Instruction> instructions;
+  std::vector<BlockId> predecessors;
+};
+
+/**
+ * @brief A function in SSA form. Block 0 is the entry block.
+ */
+struct Function {
+  std::string name;
+  size_t arity{0};
+  std::vector<Block> blocks;
+  // Values are numbered densely from 0 to `value_count - 1`.
+  ValueId value_count{0};
+  // The type of each value, as inferred by `TypeInference`, or empty. Passes
+  // that change the function leave it stale, so type inference runs last.
+  std::vector<Type> types;
+
+  auto NewValue() -> ValueId { return value_count++; }
+
+  auto NewBlock() -> BlockId;
+
+  /**
+   * @brief Adds a control flow edge by recording `from` as a predecessor of
+   * `to`. The caller emits the terminator and any phi operands.
+   */
+  auto AddEdge(BlockId from, BlockId to) -> void;
+};
+
+/**
+ * @brief A variable of the interpreter that holds an SSA value.
+ */
+struct FrameSlot {
+  Token name;
+  // Distance from the closure, or `std::nullopt` for a global.
+  std::optional<uint64_t> distance;
+  ValueId value;
+};
+
+/**
+ * @brief The variables to write back to the interpreter's environments when
+ * the optimized code deoptimizes, so that the interpreter can resume.
+ */
+using FrameState = std::vector<FrameSlot>;
+
+/**
+ * @brief The instruction defining each value, or `nullptr` for values that
+ * are not defined (anymore). The pointers are invalidated by any change to
+ * the function.
+ */
+using Definitions = std::vector<const Instruction*>;
+
+auto ComputeDefinitions(const Function& function) -> Definitions;
+
+auto IsTerminator(Opcode opcode) noexcept -> bool;
+
+/**
+ * @brief Whether the instruction only computes its result from its operands,
+ * without reading or writing memory. Pure instructions may still throw a
+ * runtime error, but they always do so for the same operands.
+ */
+auto IsPure(Opcode opcode) noexcept -> bool;
+
+/**
+ * @brief Whether executing the instruction can throw a runtime error. Uses the
+ * definitions of the operands: arithmetic on values that are known to be
+ * numbers never throws.
+ */
+auto CanThrow(const Definitions& definitions, const Instruction& instruction)
+    -> bool;
+
+/**
+ * @brief Whether executing the instruction can throw a runtime error, given
+ * the inferred `types` of its operands.
+ */
+auto CanThrow(const std::vector<Type>& types, const Instruction& instruction)
+    -> bool;
+
+/**
+ * @brief Whether the instruction can be deleted when its result is unused.
+ */
+auto IsRemovable(const Definitions& definitions,
+                 const Instruction& instruction) -> bool;
+
+/**
+ * @brief Whether the value is always a number.
+ */
+auto IsNumber(const Definitions& definitions, ValueId value) -> bool;
+
+/**
+ * @brief Computes a pure operation on constant operands with the
+ * interpreter's semantics. Unary operations only use `left`.
+ * @throws RuntimeError If the interpreter would throw.
+ */
+auto Evaluate(Opcode opcode, const Object& left, const Object& right,
+              const Token& token) -> Object;
+
+/**
+ * @brief Returns the blocks reachable from the entry, in reverse post-order.
+ */
+auto ComputeReversePostOrder(const Function& function) -> std::vector<BlockId>;
+
+/**
+ * @brief The dominator tree of a function's reachable blocks.
+ */
+class DominatorTree {
+ public:
+  explicit DominatorTree(const Function& function);
+
+  auto Dominates(BlockId dominator, BlockId block) const -> bool;
+
+  auto IsReachable(BlockId block) const -> bool {
+    return idom_[block] != kUnreachable;
+  }
+
+  auto GetChildren(BlockId block) const -> const std::vector<BlockId>& {
+    return children_[block];
+  }
+
+  auto GetReversePostOrder() const -> const std::vector<BlockId>& {
+    return rpo_;
+  }
+
+ private:
+  static constexpr BlockId kUnreachable = std::numeric_limits<BlockId>::max();
+
+  std::vector<BlockId> rpo_;
+  std::vector<BlockId> idom_;
+  std::vector<std::vector<BlockId>> children_;
+};
+
+/**
+ * @brief Rewrites every use of a value in `replacements` to the value it maps
+ * to, following chains of replacements.
+ */
+auto ReplaceUses(Function& function, std::vector<ValueId> replacements)
+    -> void;
+
+/**
+ * @brief Deletes blocks that cannot be reached from the entry, dropping the
+ * phi operands that flowed in from them, and renumbers the rest.
+ * @return Whether any block was deleted.
+ */
+auto RemoveUnreachableBlocks(Function& function) -> bool;
+
+/**
+ * @brief Merges each block that ends in a jump into the jump's target when it
+ * is the target's only predecessor.
+ * @return Whether any blocks were merged.
+ */
+auto MergeBlocks(Function& function) -> bool;
+
+/**
+ * @brief Removes `from` from the predecessors of `to`, along with the operands
+ * of `to`'s phis for that edge.
+ */
+auto RemoveEdge(Function& function, BlockId from, BlockId to) -> void;
+
+/**
+ * @brief Speculates that `value` has the type `type` from instruction
+ * `position` of `block` on.
+ *
+ * The block is split there: it ends by checking the type, and deoptimizes
+ * through a new block that writes `state` back if the check fails. Otherwise
+ * it continues in a new block starting with an `ASSUME_TYPE` of the value,
+ * which replaces the value in every use the new block dominates.
+ * @param name The variable the value belongs to, which the `DEOPT` reports.
+ * @return The block that continues after the guard.
+ */
+auto InsertTypeGuard(Function& function, BlockId block, size_t position,
+                     ValueId value, Type type, const Token& name,
+                     const FrameState& state) -> BlockId;
+
+/**
+ * @brief Checks the SSA invariants: blocks end in one terminator, edges and
+ * predecessor lists agree, phis have one operand per predecessor, and every
+ * value is defined once, in a block dominating its uses.
+ * @return A description of the first violation, or `std::nullopt`.
+ */
+auto Verify(const Function& function) -> std::optional<std::string>;
+
+/**
+ * @brief Prints the function in a human-readable form.
+ */
+auto Dump(const Function& function, std::ostream& output) -> void;
+}  // namespace cclox::ir
+
+#endif  // IR_H_
@@ -0,0 +1,243 @@
+#ifndef IR_BUILDER_H_
+#define IR_BUILDER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "expr.h"
+#include "ir.h"
+#include "stmt.h"
+
+namespace cclox {
+class Interpreter;
+
+/**
+ * @brief Translates the body of a Lox function into SSA form.
+ *
+ * SSA is constructed directly from the AST with the algorithm of Braun et
+ * al., "Simple and Efficient Construction of Static Single Assignment Form":
+ * the current value of each local is tracked per block, and phis are created
+ * on demand when a variable is read in a block with several predecessors.
+ * Every definition of a local becomes a `COPY` named after the variable,
+ * which keeps the unoptimized IR readable; copy propagation removes them.
+ *
+ * Functions that declare nested functions or classes, or use `super`, are
+ * not translated: their locals can be captured by closures, which SSA values
+ * cannot express. Variables of enclosing functions and `this` are accessed
+ * through the closure's environments.
+ */
+class IrBuilder {
+ public:
+  explicit IrBuilder(const Interpreter& interpreter)
+      : interpreter_(interpreter) {}
+
+  /**
+   * @return The function in SSA form, or `std::nullopt` if it uses a
+   * construct the IR does not support.
+   */
+  auto Build(const FunctionStmt& function) -> std::optional<ir::Function>;
+
+  /**
+   * @brief The type to speculate that a promoted variable keeps, from its
+   * name and its distance from the closure (none for globals), or
+   * `ir::Type::ANY` not to speculate.
+   */
+  using Speculation =
+      std::function<ir::Type(const Token&, std::optional<uint64_t>)>;
+
+  /**
+   * @brief Translates a loop for on-stack replacement: the function starts at
+   * the loop's condition and returns nil once the loop is done. Its closure
+   * is the environment the loop runs in.
+   *
+   * Unless the loop makes calls, which could reach the same variables
+   * through closures, the variables it uses from outside are promoted: each
+   * is read once on entry and then kept in SSA values. With `write_through`,
+   * assignments to them also store to the environment right away, so the
+   * interpreter sees exact state even if the loop throws. Otherwise they are
+   * stored back only when the loop is left.
+   *
+   * Promoted variables get a type guard for their `speculation`: once on
+   * entry, or at the top of every iteration if the loop assigns them. A
+   * failing guard writes the assigned variables back (its frame state) and
+   * deoptimizes; the interpreter resumes at the loop's condition.
+   * @return The loop in SSA form, or `std::nullopt` if it uses a construct
+   * the IR does not support or contains a `return`.
+   */
+  auto BuildLoop(const WhileStmt& loop, bool write_through,
+                 const Speculation& speculation = nullptr)
+      -> std::optional<ir::Function>;
+
+  // ====================Statement Visitors====================
+  auto operator()(const BlockStmtPtr& stmt) -> void;
+
+  auto operator()(const ClassStmtPtr& stmt) -> void;
+
+  auto operator()(const ExprStmtPtr& stmt) -> void;
+
+  auto operator()(const FunctionStmtPtr& stmt) -> void;
+
+  auto operator()(const IfStmtPtr& stmt) -> void;
+
+  auto operator()(const PrintStmtPtr& stmt) -> void;
+
+  auto operator()(const ReturnStmtPtr& stmt) -> void;
+
+  auto operator()(const VarStmtPtr& stmt) -> void;
+
+  auto operator()(const WhileStmtPtr& stmt) -> void;
+
+  // ====================Expression Visitors====================
+  auto operator()(const AssignExprPtr& expr) -> ir::ValueId;
+
+  auto operator()(const BinaryExprPtr& expr) -> ir::ValueId;
+
+  auto operator()(const CallExprPtr& expr) -> ir::ValueId;
+
+  auto operator()(const GetExprPtr& expr) -> ir::ValueId;
+
+  auto operator()(const GroupingExprPtr& expr) -> ir::ValueId;
+
+  auto operator()(const LiteralExprPtr& expr) -> ir::ValueId;
+
+  auto operator()(const LogicalExprPtr& expr) -> ir::ValueId;
+
+  auto operator()(const SetExprPtr& expr) -> ir::ValueId;
+
+  auto operator()(const SuperExprPtr& expr) -> ir::ValueId;
+
+  auto operator()(const ThisExprPtr& expr) -> ir::ValueId;
+
+  auto operator()(const UnaryExprPtr& expr) -> ir::ValueId;
+
+  auto operator()(const VariableExprPtr& expr) -> ir::ValueId;
+
+ private:
+  // Identifies one declaration of a local variable.
+  using VariableId = size_t;
+
+  /**
+   * @brief Starts building a new function with an empty, sealed entry block.
+   */
+  auto Reset(std::string name, size_t arity) -> void;
+
+  auto BuildLoopBody(const WhileStmt& loop) -> void;
+
+  /**
+   * @brief Ends a loop built for on-stack replacement: stores the promoted
+   * variables back unless they were written through, returns, and inserts
+   * the speculation guards.
+   */
+  auto FinishLoop(const Speculation& speculation) -> void;
+
+  auto BuildStatement(const StmtPtr& stmt) -> void;
+
+  auto BuildExpression(const ExprPtr& expr) -> ir::ValueId;
+
+  /**
+   * @brief Appends an instruction to the current block.
+   * @return The value it defines, if `defines_value` is set.
+   */
+  auto Emit(ir::Instruction instruction, bool defines_value = true)
+      -> ir::ValueId;
+
+  auto EmitConstant(Object value) -> ir::ValueId;
+
+  auto EmitJump(ir::BlockId target) -> void;
+
+  auto EmitBranch(ir::ValueId condition, ir::BlockId if_true,
+                  ir::BlockId if_false) -> void;
+
+  /**
+   * @brief Whether the current block already ends with a terminator, i.e.
+   * the code being built is unreachable.
+   */
+  auto IsTerminated() const -> bool;
+
+  /**
+   * @brief Continues building in a fresh block without predecessors, after a
+   * `return`.
+   */
+  auto StartUnreachableBlock() -> void;
+
+  auto NewBlock() -> ir::BlockId;
+
+  // ====================SSA construction====================
+  auto Declare(const Token& name, ir::ValueId value) -> void;
+
+  /**
+   * @brief Finds the local `depth` scopes up that a resolved variable
+   * expression refers to.
+   */
+  auto FindLocal(const std::string& name, uint64_t depth) const
+      -> std::optional<VariableId>;
+
+  auto WriteVariable(VariableId variable, ir::BlockId block,
+                     ir::ValueId value) -> void;
+
+  auto ReadVariable(VariableId variable, ir::BlockId block) -> ir::ValueId;
+
+  auto ReadVariableRecursive(VariableId variable, ir::BlockId block)
+      -> ir::ValueId;
+
+  auto NewPhi(VariableId variable, ir::BlockId block) -> ir::ValueId;
+
+  auto AddPhiOperands(VariableId variable, ir::BlockId block,
+                      ir::ValueId phi) -> void;
+
+  /**
+   * @brief Marks a block whose predecessors are all known, completing the
+   * phis created while some were missing.
+   */
+  auto SealBlock(ir::BlockId block) -> void;
+
+  /**
+   * @brief Reads a variable that is not a local of this function: a global
+   * or a variable of an enclosing function.
+   */
+  auto LoadNonLocal(const Token& name, const ExprPtr& expr) -> ir::ValueId;
+
+  auto StoreNonLocal(const Token& name, const ExprPtr& expr, ir::ValueId value)
+      -> void;
+
+  /**
+   * @brief Returns the SSA variable tracking a promoted variable from outside
+   * the loop, creating it with a load in the entry block on first use.
+   * @return The variable, or `std::nullopt` if it is not promoted.
+   */
+  auto FindPromoted(const Token& name, const ExprPtr& expr)
+      -> std::optional<VariableId>;
+
+  const Interpreter& interpreter_;
+  ir::Function function_;
+  ir::BlockId current_{0};
+  // The lexical scopes of the function, mirroring the resolver's.
+  std::vector<std::unordered_map<std::string, VariableId>> scopes_;
+  std::vector<Token> variables_;
+  // Per block: the current value of each variable, whether all of its
+  // predecessors are known, and the phis awaiting their operands.
+  std::vector<std::unordered_map<VariableId, ir::ValueId>> definitions_;
+  std::vector<bool> sealed_;
+  std::vector<std::unordered_map<VariableId, ir::ValueId>> incomplete_phis_;
+  // Whether a loop is being built, whether it promotes outside variables,
+  // and whether it stores them on every assignment.
+  bool building_loop_{false};
+  bool promote_{false};
+  bool write_through_{true};
+  // Promoted variables, by distance from the closure (none for globals) and
+  // name, and those the loop assigns.
+  std::map<std::pair<std::optional<uint64_t>, std::string>, VariableId>
+      promoted_;
+  std::set<VariableId> assigned_;
+};
+}  // namespace cclox
+
+#endif  // IR_BUILDER_H_
@@ -0,0 +1,218 @@
+#ifndef IR_PASSES_H_
+#define IR_PASSES_H_
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "ir.h"
+#include "object.h"
+
+namespace cclox::ir {
+/**
+ * @brief A transformation of a function in SSA form. Passes must leave the
+ * function valid according to `Verify`.
+ */
+class Pass {
+ public:
+  virtual ~Pass() = default;
+
+  virtual auto Name() const -> std::string_view = 0;
+
+  /**
+   * @return Whether the pass changed the function.
+   */
+  virtual auto Run(Function& function) -> bool = 0;
+};
+
+/**
+ * @brief Folds operations whose operands are all constants, and branches on
+ * constants. Folding is skipped when the operation would throw, so the error
+ * is still reported at run time. Blocks that become unreachable are deleted.
+ */
+class ConstantPropagation : public Pass {
+ public:
+  auto Name() const -> std::string_view override {
+    return "constant-propagation";
+  }
+
+  auto Run(Function& function) -> bool override;
+};
+
+/**
+ * @brief Replaces the uses of copies, and of phis whose operands are all the
+ * same value, with the original value.
+ */
+class CopyPropagation : public Pass {
+ public:
+  auto Name() const -> std::string_view override { return "copy-propagation"; }
+
+  auto Run(Function& function) -> bool override;
+};
+
+/**
+ * @brief Deletes instructions whose results are unused and that can neither
+ * throw nor have side effects, and blocks that cannot be reached. Chains of
+ * blocks joined by unconditional jumps are merged into one block.
+ */
+class DeadCodeElimination : public Pass {
+ public:
+  auto Name() const -> std::string_view override {
+    return "dead-code-elimination";
+  }
+
+  auto Run(Function& function) -> bool override;
+};
+
+/**
+ * @brief Dominator-based global value numbering: a pure operation computed
+ * again on the same operands reuses the earlier result. If the first one
+ * throws, the second is never reached, so this is safe for operations that
+ * can throw too.
+ */
+class CommonSubexpressionElimination : public Pass {
+ public:
+  auto Name() const -> std::string_view override {
+    return "common-subexpression-elimination";
+  }
+
+  auto Run(Function& function) -> bool override;
+};
+
+/**
+ * @brief Moves computations that yield the same value on every iteration of
+ * a loop to the loop's preheader.
+ *
+ * An instruction that can throw is only hoisted from the top of the loop
+ * header, before anything observable happens in the loop: the header runs at
+ * least once whenever the loop is entered, so the error is still reported at
+ * the same point. Reads of enclosing functions' variables are invariant in
+ * loops that neither store to them nor make calls.
+ */
+class LoopInvariantCodeMotion : public Pass {
+ public:
+  auto Name() const -> std::string_view override {
+    return "loop-invariant-code-motion";
+  }
+
+  auto Run(Function& function) -> bool override;
+};
+
+/**
+ * @brief Infers the type of every value into `Function::types`, without
+ * changing the code.
+ *
+ * Types flow forwards from constants through operations whose result type
+ * depends only on their operands' types, and are joined at phis until they
+ * reach a fixed point. Values read from variables of enclosing functions,
+ * globals, properties, parameters and calls are `ANY`. An operation that
+ * throws unless its operands are numbers yields a number whatever its
+ * operands, since nothing after it runs otherwise.
+ */
+class TypeInference : public Pass {
+ public:
+  auto Name() const -> std::string_view override { return "type-inference"; }
+
+  /**
+   * @return `false`: the code does not change.
+   */
+  auto Run(Function& function) -> bool override;
+};
+
+/**
+ * @brief A function whose body calls may be inlined from.
+ */
+struct InlineCandidate {
+  // The function object itself, which guards the inlined code.
+  Object callee;
+  // Its body in SSA form, already optimized.
+  const Function* body;
+};
+
+/**
+ * @brief Substitutes the bodies of small functions for calls to them.
+ *
+ * Only calls to globals are considered, and the body is looked up by the
+ * global's name. The inlined code runs behind an `IS_CALLEE` guard that falls
+ * back to the original call whenever the global no longer holds the same
+ * function object. Recursive functions, functions that use variables of
+ * enclosing functions or `this`, and bodies larger than `kMaxCalleeSize` are
+ * not inlined, and a function stops growing once it reaches `kMaxSize`.
+ */
+class Inlining : public Pass {
+ public:
+  // Sizes count instructions, including phis.
+  static constexpr size_t kMaxCalleeSize = 32;
+  static constexpr size_t kMaxSize = 512;
+
+  using Lookup =
+      std::function<std::optional<InlineCandidate>(const std::string& name)>;
+
+  explicit Inlining(Lookup lookup) : lookup_(std::move(lookup)) {}
+
+  auto Name() const -> std::string_view override { return "inlining"; }
+
+  /**
+   * @brief Reports every call that was inlined, or why it was not, to
+   * `report`. `nullptr` disables reporting.
+   */
+  auto SetReportStream(std::ostream* report) noexcept -> void {
+    report_ = report;
+  }
+
+  auto Run(Function& function) -> bool override;
+
+ private:
+  /**
+   * @return Why the call of `candidate` cannot be inlined into `function`, or
+   * `std::nullopt` if it can.
+   */
+  auto Reject(const Function& function, const Instruction& call,
+              const InlineCandidate& candidate) const
+      -> std::optional<std::string>;
+
+  Lookup lookup_;
+  std::ostream* report_{nullptr};
+};
+
+/**
+ * @brief Runs a pipeline of passes over a function, repeating it until it
+ * stops changing the function (or for at most `kMaxRounds` rounds).
+ */
+class PassManager {
+ public:
+  static constexpr size_t kMaxRounds = 4;
+
+  /**
+   * @brief Returns the default optimization pipeline.
+   */
+  static auto CreateDefault() -> PassManager;
+
+  /**
+   * @brief Appends the passes of the default pipeline.
+   */
+  auto AddDefaultPasses() -> PassManager&;
+
+  auto Add(std::unique_ptr<Pass> pass) -> PassManager&;
+
+  /**
+   * @brief Verifies the function after every pass, throwing
+   * `std::logic_error` when a pass breaks it.
+   */
+  auto SetVerify(bool verify) noexcept -> void { verify_ = verify; }
+
+  auto Run(Function& function) const -> void;
+
+ private:
+  std::vector<std::unique_ptr<Pass>> passes_;
+  bool verify_{false};
+};
+}  // namespace cclox::ir
+
+#endif  // IR_PASSES_H_
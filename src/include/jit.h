@@ -0,0 +1,182 @@
+#ifndef JIT_H_
+#define JIT_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "object.h"
+#include "x64_assembler.h"
+
+namespace cclox {
+class Interpreter;
+class Jit;
+class LoxFunction;
+
+/**
+ * @brief Controls when functions are compiled to native code.
+ *
+ * - `OFF`: never compile, every call runs in the tree-walking interpreter.
+ * - `ON`: compile a function once its calls plus loop back-edges cross
+ *   `Jit::kHotThreshold`.
+ * - `FORCE`: compile every eligible function on its first call. Used to run
+ *   the test suite through the JIT.
+ */
+enum class JitMode { OFF, ON, FORCE };
+
+/**
+ * @brief Signature of the native code emitted for a function. Arguments are
+ * passed as sign-extended 32-bit integers; the result is written to `out` and
+ * the return value is one of the `Jit::Status` codes.
+ */
+using NativeEntry = int64_t (*)(Jit* jit, const int64_t* args, int64_t* out);
+
+/**
+ * @brief Per-function profiling counters and compiled code. A profile is
+ * shared between a method and every bound copy of it, so `this.method()`
+ * calls warm up the same profile.
+ */
+struct JitProfile {
+  enum class State { COLD, COMPILING, COMPILED, FAILED };
+
+  // Number of calls observed while the function was still interpreted.
+  uint64_t calls{0};
+  // Number of loop back-edges taken inside the function's body.
+  uint64_t back_edges{0};
+  // Number of times the native code gave up and fell back to the interpreter.
+  uint32_t bailouts{0};
+  State state{State::COLD};
+  std::unique_ptr<ExecutableMemory> code;
+  NativeEntry entry{nullptr};
+};
+
+/**
+ * @brief A baseline method JIT for x86-64.
+ *
+ * The JIT compiles functions whose bodies only manipulate integer and boolean
+ * locals: arithmetic, comparisons, logical operators, `if`/`while`/`return`,
+ * and calls to other global functions that are themselves compilable. Such
+ * functions have no observable side effects, which keeps deoptimization
+ * trivial: whenever a guard fails (a non-integer argument, an integer
+ * overflow, a division by zero, or a callee that was redefined), the native
+ * code returns `BAILOUT` and the whole call is simply re-run by the
+ * tree-walking interpreter.
+ */
+class Jit {
+ public:
+  /**
+   * @brief Result codes returned by native code.
+   */
+  enum Status : int32_t { INT = 0, BOOL = 1, NIL = 2, BAILOUT = 3 };
+
+  // Calls plus loop back-edges after which a function is compiled in `ON`
+  // mode.
+  static constexpr uint64_t kHotThreshold = 1000;
+
+  // Bailouts after which compiled code is discarded for good.
+  static constexpr uint32_t kMaxBailouts = 8;
+
+  explicit Jit(Interpreter& interpreter) : interpreter_(interpreter) {}
+
+  auto SetMode(JitMode mode) noexcept -> void { mode_ = mode; }
+
+  auto GetMode() const noexcept -> JitMode { return mode_; }
+
+  auto IsEnabled() const noexcept -> bool { return mode_ != JitMode::OFF; }
+
+  /**
+   * @brief Runs `function` natively if it is (or just became) compiled and
+   * the arguments pass the entry guards.
+   * @return The call's result, or `std::nullopt` if the caller must run the
+   * function in the interpreter.
+   */
+  auto TryCall(const LoxFunction& function, JitProfile& profile,
+               const std::vector<Object>& arguments) -> std::optional<Object>;
+
+  /**
+   * @brief Counts a loop back-edge against the function being interpreted.
+   */
+  auto RecordBackEdge() noexcept -> void {
+    if (active_profile_ != nullptr) {
+      active_profile_->back_edges++;
+    }
+  }
+
+  /**
+   * @brief Replaces the function being interpreted, for switching between
+   * async calls, and returns the one it replaced.
+   */
+  auto SwapActiveProfile(JitProfile* profile) noexcept -> JitProfile* {
+    return std::exchange(active_profile_, profile);
+  }
+
+  /**
+   * @brief Drops the call sites of compiled code, which keep the functions
+   * they call alive. Only once no compiled code can run again.
+   */
+  auto Clear() noexcept -> void { call_sites_.clear(); }
+
+  /**
+   * @brief Marks `profile` as the function being interpreted for the lifetime
+   * of the scope, so back-edges are attributed to it.
+   */
+  class ActiveProfileScope {
+   public:
+    ActiveProfileScope(Jit& jit, JitProfile* profile)
+        : jit_(jit), previous_(jit.active_profile_) {
+      jit_.active_profile_ = profile;
+    }
+
+    ActiveProfileScope(const ActiveProfileScope&) = delete;
+
+    auto operator=(const ActiveProfileScope&)
+        -> ActiveProfileScope& = delete;
+
+    ~ActiveProfileScope() { jit_.active_profile_ = previous_; }
+
+   private:
+    Jit& jit_;
+    JitProfile* previous_;
+  };
+
+ private:
+  friend class FunctionCompiler;
+
+  /**
+   * @brief A call from native code to a global function. The site remembers
+   * which function object the global held at compile time; native code only
+   * calls straight into the target while the global still holds it.
+   */
+  struct CallSite {
+    const Object* global;
+    LoxCallablePtr expected;
+    JitProfile* target;
+  };
+
+  /**
+   * @brief Compiles `function` into `profile`. On failure the profile is
+   * marked `FAILED` and the function stays in the interpreter.
+   * @return `true` if the function is (or is being) compiled.
+   */
+  auto Compile(const LoxFunction& function, JitProfile& profile) -> bool;
+
+  /**
+   * @brief Called by native code for every Lox call.
+   */
+  static auto CallHelper(Jit* jit, uint64_t site, const int64_t* args,
+                         int64_t* out) -> int64_t;
+
+  auto RecordBailout(JitProfile& profile) noexcept -> void;
+
+  auto IsHot(const JitProfile& profile) const noexcept -> bool;
+
+  Interpreter& interpreter_;
+  JitMode mode_{JitMode::OFF};
+  JitProfile* active_profile_{nullptr};
+  std::vector<CallSite> call_sites_;
+};
+}  // namespace cclox
+
+#endif  // JIT_H_
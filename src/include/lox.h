@@ -1,9 +1,18 @@
 #ifndef LOX_H_
 #define LOX_H_
 
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <istream>
+#include <optional>
+#include <ostream>
 #include <string>
+#include <vector>
 
 #include "interpreter.h"
+#include "stmt.h"
 #include "token.h"
 
 namespace cclox {
@@ -25,11 +34,207 @@ class Lox {
    */
   auto RunFile(std::string_view path) -> void;
 
+  /**
+   * @brief Runs a program read from `input` as it arrives, each top-level
+   * declaration as soon as it has been parsed. Once there is a syntax error,
+   * nothing more runs, but the rest is still checked for errors. Imports are
+   * relative to the working directory.
+   */
+  auto RunStream(std::istream& input) -> void;
+
+  /**
+   * @brief Runs each script in turn, each as in a new interpreter, but in
+   * this process and with this interpreter's settings. A script that cannot
+   * be read is reported and skipped.
+   * @param thread_count The number of threads running scripts at once, each
+   * with an interpreter of its own. The output of each script is written
+   * whole, in the order of `paths`.
+   * @return Whether every script ran without errors.
+   */
+  auto RunBatch(const std::vector<std::string>& paths, size_t thread_count)
+      -> bool;
+
+  /**
+   * @brief Runs a script and keeps it loaded, so that its functions can be
+   * called afterwards with `Call`.
+   * @return Whether the script ran without errors.
+   */
+  auto Load(std::string_view path) -> bool;
+
+  /**
+   * @brief Runs the top level of a script, then saves its globals and
+   * everything they reach to `snapshot`; see `HeapSnapshot`.
+   * @return Whether the script ran and was saved without errors.
+   */
+  auto SnapshotFile(std::string_view path,
+                    const std::filesystem::path& snapshot) -> bool;
+
+  /**
+   * @brief Loads a script with the globals saved in `snapshot` instead of
+   * running its top level, then calls its global function `entry` with no
+   * arguments.
+   * @return Whether the snapshot loaded and the call ran without errors.
+   */
+  auto RunFromSnapshot(std::string_view path,
+                       const std::filesystem::path& snapshot,
+                       const std::string& entry) -> bool;
+
+  /**
+   * @brief Returns the value of a global variable of the loaded script.
+   */
+  auto GetGlobal(const std::string& name) const -> std::optional<Object>;
+
+  /**
+   * @brief Calls a function of the loaded script; see
+   * `Interpreter::CallFromHost`.
+   * @throws RuntimeError If the call fails.
+   */
+  auto Call(const Object& callee, const std::vector<Object>& arguments)
+      -> Object;
+
+  /**
+   * @brief Stops the interpreter's threads before the process forks; see
+   * `Interpreter::StopThreads`.
+   */
+  auto PrepareFork() -> void;
+
+  /**
+   * @brief Translates the specified source file into a C++ program that links
+   * against the runtime library in `lox_runtime.h`. Compile errors are
+   * reported to the output stream, and nothing is written to `cpp`.
+   * @param path The path to the Lox script file to be translated.
+   * @param cpp The stream receiving the generated C++ source.
+   * @return Whether the script compiled without errors.
+   */
+  auto EmitCpp(std::string_view path, std::ostream& cpp) -> bool;
+
   /**
    * @brief Starts an interactive prompt (REPL) for the Lox interpreter.
    */
   auto RunPrompt() -> void;
 
+  /**
+   * @brief Runs one line of an interactive session, which can use what the
+   * lines before it defined. Only the statements that may define functions
+   * or classes are kept once they have run, and the code compiled for them
+   * is kept until a line redefines a function.
+   */
+  auto RunLine(std::string line) -> void;
+
+  /**
+   * @brief Makes scripts only pre-parse function bodies, which are parsed
+   * and resolved on each function's first call. Syntax errors in a body are
+   * then reported, as a runtime error, when the function is first called or
+   * when the script first starts a task, which needs every body parsed.
+   * Scripts run by `Load`, imported modules and `--emit-cpp` are always
+   * parsed whole.
+   */
+  auto SetLazyParsingEnabled(bool enabled) noexcept -> void;
+
+  /**
+   * @brief Selects when Lox functions are compiled to native code.
+   * @param mode The JIT mode; `JitMode::OFF` by default.
+   */
+  auto SetJitMode(JitMode mode) noexcept -> void;
+
+  /**
+   * @brief Selects when hot loops are recorded and compiled to native traces.
+   * @param mode The trace JIT mode; `JitMode::OFF` by default.
+   */
+  auto SetTraceJitMode(JitMode mode) noexcept -> void;
+
+  /**
+   * @brief Enables running functions on their optimized SSA form.
+   */
+  auto SetOptimizerEnabled(bool enabled) noexcept -> void;
+
+  /**
+   * @brief Compiles functions for the optimizer on a background thread while
+   * they keep running in the interpreter.
+   */
+  auto SetBackgroundCompileEnabled(bool enabled) noexcept -> void;
+
+  /**
+   * @brief Prints the optimized IR of each function to `dump` when it is
+   * compiled, or stops doing so if `dump` is `nullptr`.
+   */
+  auto SetIrDumpStream(std::ostream* dump) noexcept -> void;
+
+  /**
+   * @brief Reports which calls the optimizer inlined, and why it did not
+   * inline others, to `report`, or stops doing so if `report` is `nullptr`.
+   */
+  auto SetInlineReportStream(std::ostream* report) noexcept -> void;
+
+  /**
+   * @brief Prints how often optimized code deoptimized or was invalidated,
+   * by reason, one line per reason.
+   */
+  auto PrintDeoptStats(std::ostream& output) -> void;
+
+  /**
+   * @brief Enables running functions on the bytecode VM.
+   */
+  auto SetVmEnabled(bool enabled) noexcept -> void;
+
+  /**
+   * @brief Counts the pairs of opcodes the VM executes, on bytecode without
+   * superinstructions.
+   */
+  auto SetVmProfileEnabled(bool enabled) noexcept -> void;
+
+  /**
+   * @brief Prints the bytecode of each function to `dump` when it is
+   * compiled, or stops doing so if `dump` is `nullptr`.
+   */
+  auto SetBytecodeDumpStream(std::ostream* dump) noexcept -> void;
+
+  /**
+   * @brief Prints the most frequent pairs of opcodes the VM executed while
+   * profiling.
+   */
+  auto PrintVmProfile(std::ostream& output) -> void;
+
+  /**
+   * @brief Enables running functions on the register VM.
+   */
+  auto SetRegisterVmEnabled(bool enabled) noexcept -> void;
+
+  /**
+   * @brief Prints the register code of each function to `dump` when it is
+   * compiled, or stops doing so if `dump` is `nullptr`.
+   */
+  auto SetRegisterCodeDumpStream(std::ostream* dump) noexcept -> void;
+
+  /**
+   * @brief Sets the number of threads running spawned tasks; 0, the default,
+   * uses one per hardware thread.
+   */
+  auto SetWorkerCount(size_t count) noexcept -> void;
+
+  /**
+   * @brief Bounds each run of a script, and each `Call`, to `fuel` loop
+   * iterations and calls and to `time_limit` of wall-clock time. A run that
+   * exceeds a bound fails with a runtime error; `Call` throws it. Bounded
+   * runs execute on the tree-walker only.
+   */
+  auto SetExecutionBudget(std::optional<uint64_t> fuel,
+                          std::optional<std::chrono::milliseconds> time_limit)
+      -> void;
+
+  /**
+   * @brief Counts the memory scripts hold, and bounds it to `limit` bytes if
+   * set. A run that exceeds the bound fails with an "Out of memory." runtime
+   * error; `Call` throws it. Bounded runs execute on the tree-walker only.
+   */
+  auto SetHeapLimit(std::optional<size_t> limit) -> void;
+
+  /**
+   * @brief Returns the memory scripts hold and the most they held, counted
+   * since `SetHeapLimit`.
+   */
+  auto GetHeapUsage() const noexcept -> HeapUsage;
+
   /**
    * @brief Reports an error with a message at a specific line number.
    * @param output The output stream.
@@ -59,12 +264,79 @@ class Lox {
   static auto ReportRuntimeError(std::ostream& output,
                                  const RuntimeError& error) -> void;
 
+  /**
+   * @brief Reads, scans and parses the module at `path`. Errors are reported
+   * to `output`.
+   * @return The module's statements, or `std::nullopt` if there was an error.
+   */
+  static auto ParseModule(const std::filesystem::path& path,
+                          std::ostream& output)
+      -> std::optional<std::vector<StmtPtr>>;
+
+  /**
+   * @brief Resolves a module's statements for `interpreter`; see
+   * `Resolver::ResolveModule`.
+   * @return Whether there was no error.
+   */
+  static auto ResolveModule(Interpreter& interpreter,
+                            const std::vector<StmtPtr>& statements) -> bool;
+
+  /**
+   * @brief Parses and resolves the body of a function that was only
+   * pre-parsed, and replaces its pre-parsed body with it. Errors are reported
+   * to the interpreter's output stream.
+   * @return Whether there was no error.
+   */
+  static auto CompileLazyBody(Interpreter& interpreter, FunctionStmt& function)
+      -> bool;
+
  private:
   /**
    * @brief Executes the given Lox source code.
    * @param source The Lox source code to be executed.
+   * @param directory The directory imports are relative to.
+   */
+  auto Run(std::string source, const std::filesystem::path& directory = {})
+      -> void;
+
+  /**
+   * @brief Scans, parses, and resolves the given Lox source code.
+   * @param source The Lox source code.
+   * @param directory The directory imports are relative to.
+   * @param lazy Whether function bodies are only pre-parsed.
+   * @return The resolved statements, or `std::nullopt` if there was an error.
+   */
+  auto Compile(std::string source, const std::filesystem::path& directory = {},
+               bool lazy = false) -> std::optional<std::vector<StmtPtr>>;
+
+  /**
+   * @brief Runs one script of a batch, then resets the interpreter.
+   * @return Whether the script ran without errors.
+   */
+  auto RunBatchScript(const std::string& path) -> bool;
+
+  /**
+   * @return The name the statement declares where it runs, or
+   * `std::nullopt` if it declares none.
+   */
+  static auto DeclaredName(const StmtPtr& stmt) -> std::optional<std::string>;
+
+  /**
+   * @brief Tells whether running the statement may define a function or a
+   * class, which would refer to it.
+   */
+  static auto DefinesCallables(const StmtPtr& stmt) -> bool;
+
+  /**
+   * @brief Reads the whole source file, exiting if it cannot be read.
+   */
+  static auto ReadFile(std::string_view path) -> std::string;
+
+  /**
+   * @brief Reads the whole source file, reporting to standard error if it
+   * cannot be read.
    */
-  auto Run(std::string source) -> void;
+  static auto TryReadFile(std::string_view path) -> std::optional<std::string>;
 
   auto ResetLoxInterpreterState() noexcept -> void;
 
@@ -81,9 +353,16 @@ class Lox {
 
   std::ostream& output_{std::cout};
   Interpreter interpreter_;
-  // A flag indicating whether an error has occurred.
-  static bool had_error;
-  static bool had_runtime_error;
+  // The script run by `Load`, which its functions refer to.
+  std::vector<StmtPtr> loaded_;
+  // The statements of the lines run by `RunLine` that functions and classes
+  // may refer to. A deque, since functions refer to their statements' place.
+  std::deque<StmtPtr> session_;
+  bool lazy_parsing_{false};
+  // A flag indicating whether an error has occurred. Batches run scripts on
+  // several threads, each with a `Lox` of its own.
+  static thread_local bool had_error;
+  static thread_local bool had_runtime_error;
 };
 }  // namespace cclox
 
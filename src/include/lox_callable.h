@@ -14,10 +14,24 @@ class LoxCallable {
 
   virtual auto Arity() const noexcept -> size_t = 0;
 
+  /**
+   * @brief Whether the callable takes `Arity()` or more arguments rather than
+   * exactly `Arity()`.
+   */
+  virtual auto IsVariadic() const noexcept -> bool { return false; }
+
   virtual auto Call(Interpreter& interpreter,
                     const std::vector<Object>& arguments) -> Object = 0;
 
   virtual auto ToString() const -> std::string = 0;
+
+  /**
+   * @brief Returns a copy of this method with `this` bound to `instance`.
+   * Only callables stored in a class's method table are ever bound.
+   */
+  virtual auto Bind(const LoxInstancePtr&) const -> LoxCallablePtr {
+    return nullptr;
+  }
 };
 }  // namespace cclox
 
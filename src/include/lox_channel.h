@@ -0,0 +1,103 @@
+#ifndef LOX_CHANNEL_H_
+#define LOX_CHANNEL_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "lox_callable.h"
+#include "object.h"
+
+namespace cclox {
+/**
+ * @brief A bounded queue of values that tasks on different threads send to
+ * and receive from, made by the `channel` native.
+ *
+ * The queue is a ring of `capacity` cells, each stamped with the position it
+ * is next free or full at, as in Vyukov's bounded queue, so any number of
+ * senders and receivers claim cells with one compare-and-swap and never take
+ * a lock. Blocking is left to the natives, which wait for `WaitForChange`
+ * when a channel is full or empty.
+ *
+ * Channels are shared, not copied, between tasks. Like sequences they are
+ * stored as callables, and calling one is an error.
+ */
+class LoxChannel : public LoxCallable {
+ public:
+  enum class SendResult { SENT, FULL, CLOSED };
+
+  explicit LoxChannel(size_t capacity);
+
+  auto Arity() const noexcept -> size_t override { return 0; }
+
+  // Any number of arguments reaches `Call`, which reports the error.
+  auto IsVariadic() const noexcept -> bool override { return true; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<channel>"; }
+
+  /**
+   * @brief Appends `value` unless the channel is full or closed.
+   */
+  auto TrySend(const Object& value) -> SendResult;
+
+  /**
+   * @brief Removes the oldest value, if any.
+   */
+  auto TryRecv() -> std::optional<Object>;
+
+  /**
+   * @brief Makes later sends fail. Values already sent can still be
+   * received.
+   */
+  auto Close() -> void;
+
+  /**
+   * @brief Whether the channel is closed and no value is left or on its way.
+   * Once true, it stays true.
+   */
+  auto IsDrained() -> bool;
+
+  /**
+   * @brief Blocks until a value is sent to or received from any channel, or a
+   * channel is closed, unless `ready()` already holds; or until `timeout`
+   * passes. No change after `ready` is checked goes unnoticed.
+   */
+  static auto WaitForChange(const std::function<bool()>& ready,
+                            std::chrono::microseconds timeout) -> void;
+
+  /**
+   * @brief Wakes every `WaitForChange`, as if a channel had changed.
+   */
+  static auto NotifyChange() -> void;
+
+ private:
+  struct Cell {
+    // `2 * position` when the cell is free for the send at `position`, and
+    // `2 * position + 1` when it holds the value for the receive at
+    // `position`. Doubling keeps the two apart when the capacity is 1.
+    std::atomic<size_t> sequence;
+    Object value;
+  };
+
+  size_t capacity_;
+  std::unique_ptr<Cell[]> cells_;
+  // Senders and receivers on different cores contend on different lines.
+  alignas(64) std::atomic<size_t> send_position_{0};
+  alignas(64) std::atomic<size_t> recv_position_{0};
+  std::atomic<bool> closed_{false};
+  // Sends that may not see `closed_` yet; see `IsDrained`.
+  std::atomic<size_t> sending_{0};
+};
+
+using LoxChannelPtr = std::shared_ptr<LoxChannel>;
+}  // namespace cclox
+
+#endif  // LOX_CHANNEL_H_
@@ -11,7 +11,8 @@
 #include "object.h"
 
 namespace cclox {
-class LoxClass : public LoxCallable {
+class LoxClass : public LoxCallable,
+                 public std::enable_shared_from_this<LoxClass> {
  public:
   using MethodMap = std::unordered_map<std::string, LoxCallablePtr>;
 
@@ -31,6 +32,10 @@ class LoxClass : public LoxCallable {
   auto ToString() const -> std::string override;
 
  private:
+  friend class HeapSnapshot;
+  friend class ObjectCopier;
+
+
   std::string name_;
   std::optional<Object> superclass_;
   MethodMap methods_;
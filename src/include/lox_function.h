@@ -7,6 +7,8 @@
 #include <vector>
 
 #include "environment.h"
+#include "heap_meter.h"
+#include "jit.h"
 #include "lox_callable.h"
 #include "object.h"
 #include "stmt.h"
@@ -27,12 +29,32 @@ class LoxFunction : public LoxCallable {
 
   auto ToString() const -> std::string override;
 
-  auto Bind(const LoxInstancePtr& instance) const -> LoxCallablePtr;
+  auto Bind(const LoxInstancePtr& instance) const -> LoxCallablePtr override;
+
+  auto GetDeclaration() const noexcept -> const FunctionStmtPtr& {
+    return declaration_;
+  }
+
+  auto IsInitializer() const noexcept -> bool { return is_initializer_; }
+
+  /**
+   * @brief Returns the JIT profile of this function, creating it on first use.
+   * Methods must have theirs before they are bound, for their bound copies
+   * to share it.
+   */
+  auto GetJitProfile() const -> JitProfile&;
 
  private:
+  friend class HeapSnapshot;
+  friend class ObjectCopier;
+
   const FunctionStmtPtr& declaration_;
   std::shared_ptr<Environment> closure_;
   bool is_initializer_{false};
+  // Created lazily so functions never touched by the JIT pay nothing, and
+  // binding a method without one costs nothing either.
+  mutable std::shared_ptr<JitProfile> jit_profile_;
+  HeapCharge charge_{sizeof(LoxFunction)};
 };
 
 using LoxFunctionPtr = std::shared_ptr<LoxFunction>;
@@ -4,7 +4,10 @@
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "heap_meter.h"
 #include "lox_class.h"
 
 namespace cclox {
@@ -13,21 +16,53 @@ class LoxInstance : public std::enable_shared_from_this<LoxInstance> {
   // Ensure that client code cannot directly call the constructor and can only
   // create instances of LoxInstance as std::shared_ptr to support the usage of
   // shared_from_this.
-  static auto Create(const LoxClass& klass) -> LoxInstancePtr;
+  static auto Create(std::shared_ptr<const LoxClass> klass) -> LoxInstancePtr;
+
+  /**
+   * @brief Destroys the instances only this one refers to one after another
+   * rather than nested, so a long chain of them cannot overflow the stack.
+   */
+  ~LoxInstance();
 
   auto GetField(const Token& field) -> Object;
 
+  /**
+   * @throws RuntimeError If the instance is frozen.
+   */
   auto SetField(const Token& field, const Object& value) -> void;
 
   auto ToString() const -> std::string;
 
   using FieldMap = std::unordered_map<std::string, Object>;
 
+  auto GetFields() const noexcept -> const FieldMap& { return fields_; }
+
+  auto IsFrozen() const noexcept -> bool { return frozen_; }
+
+  /**
+   * @brief Makes `SetField` fail from now on. The fields' values are left as
+   * they are.
+   */
+  auto Freeze() noexcept -> void { frozen_ = true; }
+
  private:
-  explicit LoxInstance(const LoxClass& klass) : klass_(klass) {}
+  friend class HeapSnapshot;
+  friend class ObjectCopier;
+
+  explicit LoxInstance(std::shared_ptr<const LoxClass> klass)
+      : klass_(std::move(klass)) {}
+
+  /**
+   * @brief Sets the field `name` to `value`, charging the difference to the
+   * heap meter, whether the instance is frozen or not.
+   */
+  auto PutField(const std::string& name, const Object& value) -> void;
 
-  const LoxClass& klass_;
+  // Owned, so instances outlive a class that goes out of scope.
+  std::shared_ptr<const LoxClass> klass_;
   FieldMap fields_;
+  bool frozen_{false};
+  HeapCharge charge_{sizeof(LoxInstance)};
 };
 }  // namespace cclox
 
@@ -0,0 +1,154 @@
+#ifndef LOX_LIST_H_
+#define LOX_LIST_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "heap_meter.h"
+#include "lox_callable.h"
+#include "object.h"
+
+namespace cclox {
+/**
+ * @brief A sequence of values with random access, read by the `length` and
+ * `get` natives.
+ *
+ * Sequences are stored as callables, as Lox has no other reference type that
+ * is not an instance; calling one is an error.
+ */
+class LoxSequence : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 0; }
+
+  // Any number of arguments reaches `Call`, which reports the error.
+  auto IsVariadic() const noexcept -> bool override { return true; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  virtual auto Length() const noexcept -> size_t = 0;
+
+  /**
+   * @pre `index < Length()`.
+   */
+  virtual auto At(size_t index) const -> Object = 0;
+
+  /**
+   * @brief Returns the elements from `begin` up to `end` as a new sequence.
+   * @pre `begin <= end && end <= Length()`.
+   */
+  virtual auto Slice(size_t begin, size_t end) const
+      -> std::shared_ptr<LoxSequence> = 0;
+};
+
+/**
+ * @brief A growable list of values, made by the `list` native.
+ *
+ * `freeze` makes a list immutable. A frozen list that reaches only values any
+ * thread may read is shareable: tasks get lists of their own that share its
+ * elements rather than copies, each with its own reference count.
+ */
+class LoxList : public LoxSequence {
+ public:
+  LoxList() : elements_(std::make_shared<std::vector<Object>>()) {}
+
+  explicit LoxList(std::vector<Object> elements);
+
+  // A copy shares the elements, which stay charged to the original.
+  LoxList(const LoxList& other)
+      : LoxSequence(other),
+        elements_(other.elements_),
+        frozen_(other.frozen_),
+        shareable_(other.shareable_) {}
+
+  auto ToString() const -> std::string override;
+
+  auto Length() const noexcept -> size_t override { return elements_->size(); }
+
+  auto At(size_t index) const -> Object override { return (*elements_)[index]; }
+
+  auto Slice(size_t begin, size_t end) const
+      -> std::shared_ptr<LoxSequence> override;
+
+  auto GetElements() const noexcept -> const std::vector<Object>& {
+    return *elements_;
+  }
+
+  /**
+   * @brief Makes room for `capacity` elements without charging for it, as
+   * each element is charged once pushed.
+   */
+  auto Reserve(size_t capacity) -> void { elements_->reserve(capacity); }
+
+  /**
+   * @brief Appends `value`, charging it to the heap meter.
+   * @pre `!IsFrozen()`.
+   */
+  auto Push(Object value) -> void;
+
+  /**
+   * @brief Replaces the element at `index` with `value`, charging the
+   * difference to the heap meter.
+   * @pre `!IsFrozen() && index < Length()`.
+   */
+  auto Set(size_t index, const Object& value) -> void;
+
+  auto IsFrozen() const noexcept -> bool { return frozen_; }
+
+  auto Freeze() noexcept -> void { frozen_ = true; }
+
+  auto IsShareable() const noexcept -> bool { return shareable_; }
+
+  /**
+   * @pre `IsFrozen()` and every element can be read by any thread.
+   */
+  auto MarkShareable() noexcept -> void { shareable_ = true; }
+
+  /**
+   * @brief Returns a frozen list with the same elements, which it shares
+   * instead of copying.
+   * @pre `IsShareable()`.
+   */
+  auto Share() const -> std::shared_ptr<LoxList>;
+
+ private:
+  std::shared_ptr<std::vector<Object>> elements_;
+  bool frozen_{false};
+  bool shareable_{false};
+  HeapCharge charge_{sizeof(LoxList) + sizeof(std::vector<Object>)};
+};
+
+/**
+ * @brief The integers from `start` up to, but excluding, `end`, made by the
+ * `range` native. Ranges are immutable and store no elements.
+ */
+class LoxRange : public LoxSequence {
+ public:
+  LoxRange(int32_t start, int32_t end) : start_(start), end_(end) {}
+
+  auto ToString() const -> std::string override;
+
+  auto Length() const noexcept -> size_t override {
+    return end_ > start_ ? static_cast<size_t>(int64_t{end_} - start_) : 0;
+  }
+
+  auto At(size_t index) const -> Object override {
+    return Object{static_cast<int32_t>(start_ + static_cast<int32_t>(index))};
+  }
+
+  auto Slice(size_t begin, size_t end) const
+      -> std::shared_ptr<LoxSequence> override;
+
+ private:
+  int32_t start_;
+  int32_t end_;
+};
+
+using LoxSequencePtr = std::shared_ptr<LoxSequence>;
+using LoxListPtr = std::shared_ptr<LoxList>;
+}  // namespace cclox
+
+#endif  // LOX_LIST_H_
@@ -0,0 +1,182 @@
+#ifndef LOX_RUNTIME_H_
+#define LOX_RUNTIME_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "lox_callable.h"
+#include "lox_class.h"
+#include "lox_instance.h"
+#include "object.h"
+
+/**
+ * @brief Support library for programs generated by `cclox --emit-cpp`.
+ *
+ * Generated code keeps Lox values in `Object`s and reuses `LoxClass` and
+ * `LoxInstance` for classes, so it behaves exactly like the interpreter,
+ * including its runtime error messages. Operators take their operands as a
+ * braced aggregate so that, like in the interpreter, the left operand is
+ * always evaluated before the right one.
+ */
+namespace cclox::runtime {
+struct Operands {
+  Object left;
+  Object right;
+};
+
+struct CallOperands {
+  Object callee;
+  std::vector<Object> arguments;
+};
+
+/**
+ * @brief A global variable. Globals can be read before their declaration has
+ * run, which is a runtime error.
+ */
+class Global {
+ public:
+  explicit Global(std::string name) : name_(std::move(name)) {}
+
+  auto Define(Object value) -> void {
+    value_ = std::move(value);
+    defined_ = true;
+  }
+
+  auto Get(uint32_t line) const -> const Object& {
+    Check(line);
+    return value_;
+  }
+
+  auto Assign(Object value, uint32_t line) -> const Object& {
+    Check(line);
+    value_ = std::move(value);
+    return value_;
+  }
+
+  /**
+   * @brief Throws "Undefined variable" unless the global has been declared.
+   */
+  auto Check(uint32_t line) const -> void {
+    if (!defined_) {
+      ThrowUndefined(line);
+    }
+  }
+
+ private:
+  [[noreturn]] auto ThrowUndefined(uint32_t line) const -> void;
+
+  std::string name_;
+  Object value_{nullptr};
+  bool defined_{false};
+};
+
+/**
+ * @brief A Lox function or method compiled to C++.
+ */
+class CompiledFunction : public LoxCallable {
+ public:
+  using Body = std::function<Object(const std::vector<Object>& arguments,
+                                    const LoxInstancePtr& self)>;
+
+  CompiledFunction(std::string name, size_t arity, bool is_initializer,
+                   std::shared_ptr<const Body> body, LoxInstancePtr self)
+      : name_(std::move(name)),
+        arity_(arity),
+        is_initializer_(is_initializer),
+        body_(std::move(body)),
+        self_(std::move(self)) {}
+
+  auto Arity() const noexcept -> size_t override { return arity_; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override;
+
+  auto Bind(const LoxInstancePtr& instance) const -> LoxCallablePtr override;
+
+ private:
+  std::string name_;
+  size_t arity_;
+  bool is_initializer_;
+  std::shared_ptr<const Body> body_;
+  LoxInstancePtr self_;
+};
+
+auto MakeFunction(std::string name, size_t arity, bool is_initializer,
+                  CompiledFunction::Body body) -> LoxCallablePtr;
+
+/**
+ * @brief Evaluates to `superclass`, or throws if it is not a class.
+ */
+auto CheckSuperclass(Object superclass, uint32_t line) -> Object;
+
+auto MakeClass(std::string name, std::optional<Object> superclass,
+               LoxClass::MethodMap methods) -> Object;
+
+/**
+ * @brief Returns the native function the interpreter defines as global
+ * `name`.
+ */
+auto Native(const std::string& name) -> Object;
+
+inline auto Truthy(const Object& value) -> bool {
+  return value.IsTruthy();
+}
+
+// ====================Operators====================
+auto Equal(const Operands& operands) -> bool;
+
+auto Greater(const Operands& operands, uint32_t line) -> bool;
+
+auto GreaterEqual(const Operands& operands, uint32_t line) -> bool;
+
+auto Less(const Operands& operands, uint32_t line) -> bool;
+
+auto LessEqual(const Operands& operands, uint32_t line) -> bool;
+
+auto Add(const Operands& operands, uint32_t line) -> Object;
+
+auto Subtract(const Operands& operands, uint32_t line) -> Object;
+
+auto Multiply(const Operands& operands, uint32_t line) -> Object;
+
+auto Divide(const Operands& operands, uint32_t line) -> Object;
+
+auto Negate(const Object& operand, uint32_t line) -> Object;
+
+// ====================Calls and properties====================
+auto Call(const CallOperands& operands, uint32_t line) -> Object;
+
+auto GetProperty(const Object& object, const std::string& name, uint32_t line)
+    -> Object;
+
+/**
+ * @brief Returns the instance a field is assigned on, or throws if `object`
+ * is not an instance. Checked before the assigned value is evaluated.
+ */
+auto FieldTarget(const Object& object, uint32_t line) -> LoxInstancePtr;
+
+auto SetField(const LoxInstancePtr& instance, const std::string& name,
+              Object value, uint32_t line) -> Object;
+
+auto GetSuperMethod(const Object& superclass, const LoxInstancePtr& self,
+                    const std::string& name, uint32_t line) -> Object;
+
+auto Print(const Object& value) -> void;
+
+/**
+ * @brief Runs a generated program's top-level code, then its pending async
+ * calls, and reports an uncaught runtime error like the interpreter does.
+ * @return The process exit code.
+ */
+auto Run(void (*main)()) -> int;
+}  // namespace cclox::runtime
+
+#endif  // LOX_RUNTIME_H_
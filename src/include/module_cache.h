@@ -0,0 +1,40 @@
+#ifndef MODULE_CACHE_H_
+#define MODULE_CACHE_H_
+
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+#include "stmt.h"
+
+namespace cclox {
+/**
+ * @brief The statements of a module, parsed from its file as it was when it
+ * was last modified at `modified`.
+ */
+struct Module {
+  std::filesystem::file_time_type modified;
+  std::vector<StmtPtr> statements;
+};
+
+/**
+ * @brief The modules imported in this process. Each is scanned and parsed
+ * once and shared by every interpreter, which resolves and runs it for each
+ * program that imports it. A module whose file changed is parsed again;
+ * programs still running the old one keep it alive.
+ */
+class ModuleCache {
+ public:
+  /**
+   * @brief Returns the module at the canonical `path`, parsing it unless its
+   * file is unchanged since it was cached.
+   * @return The module, or `nullptr` if it could not be read or had syntax
+   * errors, which are reported to `output` and are not cached.
+   */
+  static auto Load(const std::filesystem::path& path, std::ostream& output)
+      -> std::shared_ptr<const Module>;
+};
+}  // namespace cclox
+
+#endif  // MODULE_CACHE_H_
@@ -0,0 +1,61 @@
+#ifndef NATIVE_ASYNC_FUNCTIONS_H_
+#define NATIVE_ASYNC_FUNCTIONS_H_
+
+#include <string>
+#include <vector>
+
+#include "lox_callable.h"
+#include "object.h"
+
+namespace cclox {
+/**
+ * @brief `async(fn)` calls `fn` as an async call and returns its promise.
+ *
+ * The parser turns the body of each `async fun` into a function that its
+ * declaration passes to this native. `async` is a keyword, so programs cannot
+ * name the native themselves.
+ */
+class NativeAsyncFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `sleep(milliseconds)` returns a promise settled with nil once
+ * `milliseconds` have passed.
+ */
+class NativeSleepFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `readFile(path)` returns a promise of the contents of a file, pipe
+ * or other stream, read without blocking the thread.
+ *
+ * Pipes are read as the event loop reports them readable. Regular files are
+ * always readable, so they are read a block per turn of the loop instead,
+ * letting other async calls run in between.
+ */
+class NativeReadFileFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+}  // namespace cclox
+
+#endif  // NATIVE_ASYNC_FUNCTIONS_H_
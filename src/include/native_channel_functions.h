@@ -0,0 +1,120 @@
+#ifndef NATIVE_CHANNEL_FUNCTIONS_H_
+#define NATIVE_CHANNEL_FUNCTIONS_H_
+
+#include <string>
+#include <vector>
+
+#include "lox_callable.h"
+#include "object.h"
+
+namespace cclox {
+/**
+ * @brief `channel(capacity)` makes a channel that holds up to `capacity`
+ * values.
+ */
+class NativeChannelFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `send(channel, value)` sends a copy of `value`, waiting while the
+ * channel is full.
+ *
+ * The value is copied like a task's arguments (see `ObjectCopier`), so the
+ * receiver owns what it receives; instances arrive with copies of their
+ * classes. Sending to a closed channel is an error.
+ */
+class NativeSendFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 2; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `recv(channel)` receives the oldest value, waiting while the channel
+ * is empty. Returns nil once the channel is closed and empty.
+ */
+class NativeRecvFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `trySend(channel, value)` sends like `send` if the channel is not
+ * full, and returns whether it did.
+ */
+class NativeTrySendFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 2; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `tryRecv(channel)` receives the oldest value if there is one, and
+ * returns nil otherwise.
+ */
+class NativeTryRecvFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `close(channel)` closes a channel: later sends fail, and receivers
+ * get nil once the values already sent are received.
+ */
+class NativeCloseFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `select(channels...)` receives from whichever channel has a value
+ * first, and returns `list(index, value)` with the channel's position among
+ * the arguments. Returns nil once all the channels are closed and empty.
+ *
+ * When several channels have values, the search starts after the channel
+ * the thread last received from, so no channel is starved.
+ */
+class NativeSelectFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto IsVariadic() const noexcept -> bool override { return true; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+}  // namespace cclox
+
+#endif  // NATIVE_CHANNEL_FUNCTIONS_H_
@@ -0,0 +1,32 @@
+#ifndef NATIVE_FREEZE_FUNCTION_H_
+#define NATIVE_FREEZE_FUNCTION_H_
+
+#include <string>
+#include <vector>
+
+#include "lox_callable.h"
+#include "object.h"
+
+namespace cclox {
+/**
+ * @brief `freeze(value)` makes `value`, and every instance and list it
+ * reaches, immutable for good, and returns it. Setting a field of a frozen
+ * instance, or `set` and `push` on a frozen list, is a runtime error. Other
+ * values, including strings, are immutable already and are returned as they
+ * are.
+ *
+ * Frozen lists of nil, booleans, numbers, strings, ranges and other such
+ * lists are shared with tasks and channels instead of being copied.
+ */
+class NativeFreezeFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+}  // namespace cclox
+
+#endif  // NATIVE_FREEZE_FUNCTION_H_
@@ -0,0 +1,28 @@
+#ifndef NATIVE_IMPORT_FUNCTION_H_
+#define NATIVE_IMPORT_FUNCTION_H_
+
+#include <string>
+#include <vector>
+
+#include "lox_callable.h"
+#include "object.h"
+
+namespace cclox {
+/**
+ * @brief `import(path)` returns the namespace of the module at `path`, running
+ * the module the first time the program imports it. The parser turns
+ * `import "dir/name.lox";` into `var name = import("<directory>/dir/
+ * name.lox");`; as `import` is a keyword, programs cannot call it otherwise.
+ */
+class NativeImportFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+}  // namespace cclox
+
+#endif  // NATIVE_IMPORT_FUNCTION_H_
@@ -0,0 +1,111 @@
+#ifndef NATIVE_LIST_FUNCTIONS_H_
+#define NATIVE_LIST_FUNCTIONS_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "lox_callable.h"
+#include "lox_list.h"
+#include "object.h"
+
+namespace cclox {
+/**
+ * @brief Checks that `value` is a whole number that fits in 32 bits.
+ * @throws NativeError If it is not.
+ */
+auto ToInteger(const Object& value) -> int32_t;
+
+/**
+ * @brief Checks that `value` is a list or a range.
+ * @throws NativeError If it is not.
+ */
+auto ToSequence(const Object& value) -> LoxSequencePtr;
+
+/**
+ * @brief `list(values...)` makes a list of its arguments.
+ */
+class NativeListFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 0; }
+
+  auto IsVariadic() const noexcept -> bool override { return true; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `range(end)` and `range(start, end)` make the range of integers from
+ * `start`, or 0, up to `end`.
+ */
+class NativeRangeFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto IsVariadic() const noexcept -> bool override { return true; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `length(sequence)` returns the number of elements of a list or
+ * range.
+ */
+class NativeLengthFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `get(sequence, index)` returns an element of a list or range.
+ */
+class NativeGetFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 2; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `set(list, index, value)` replaces an element of a list and returns
+ * the value.
+ */
+class NativeSetFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 3; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `push(list, value)` appends a value to a list and returns the list.
+ */
+class NativePushFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 2; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+}  // namespace cclox
+
+#endif  // NATIVE_LIST_FUNCTIONS_H_
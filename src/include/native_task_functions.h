@@ -0,0 +1,109 @@
+#ifndef NATIVE_TASK_FUNCTIONS_H_
+#define NATIVE_TASK_FUNCTIONS_H_
+
+#include <string>
+#include <vector>
+
+#include "lox_callable.h"
+#include "object.h"
+
+namespace cclox {
+/**
+ * @brief `spawn(fn, args...)` calls `fn` with `args` on a worker thread and
+ * returns a future for the result.
+ *
+ * The task runs on deep copies of its callee, its arguments and the globals
+ * at the time of the spawn (see `ObjectCopier`), so it shares no mutable
+ * state with its spawner; its result is copied back the same way. A task
+ * that is not awaited is awaited when the program or task that spawned it
+ * ends.
+ */
+class NativeSpawnFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto IsVariadic() const noexcept -> bool override { return true; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `await(future)` waits for a spawned task and returns its result, or
+ * rethrows the error it failed with. Awaiting a promise waits for it on the
+ * event loop instead (see `EventLoop::Await`).
+ *
+ * `await` is a keyword, and `await value` calls this native.
+ */
+class NativeAwaitFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 1; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `parallelMap(sequence, fn, ordered?)` returns the list of `fn`
+ * applied to each element of a list or range.
+ *
+ * The elements are split into chunks, a few per worker, and each chunk runs
+ * as a task on copies of `fn` and its elements like `spawn`. The results are
+ * always in the order of the elements. With `ordered`, true by default, the
+ * output of the chunks is written in the order of the elements too;
+ * otherwise, in the order the chunks finish.
+ */
+class NativeParallelMapFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 2; }
+
+  auto IsVariadic() const noexcept -> bool override { return true; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `parallelReduce(sequence, fn, init, ordered?)` combines `init` and
+ * the elements of a list or range with `fn`, which must be associative.
+ *
+ * Each chunk is folded by a task, and the spawner folds the chunks' results
+ * into `init`: in the order of the elements if `ordered`, true by default,
+ * or in the order the chunks finish, for a commutative `fn`.
+ */
+class NativeParallelReduceFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 3; }
+
+  auto IsVariadic() const noexcept -> bool override { return true; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+
+/**
+ * @brief `parallelFor(sequence, fn, ordered?)` calls `fn` on each element of
+ * a list or range, chunked like `parallelMap`.
+ */
+class NativeParallelForFunction : public LoxCallable {
+ public:
+  auto Arity() const noexcept -> size_t override { return 2; }
+
+  auto IsVariadic() const noexcept -> bool override { return true; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<native fn>"; }
+};
+}  // namespace cclox
+
+#endif  // NATIVE_TASK_FUNCTIONS_H_
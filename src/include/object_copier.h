@@ -0,0 +1,62 @@
+#ifndef OBJECT_COPIER_H_
+#define OBJECT_COPIER_H_
+
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "environment.h"
+#include "object.h"
+
+namespace cclox {
+/**
+ * @brief Deep-copies Lox values so they can move between interpreter contexts
+ * running on different threads.
+ *
+ * Nil, booleans, numbers and strings are copied by value. Instances, lists,
+ * classes, functions and the environments functions close over are copied
+ * together with everything they reach, so neither side ever touches the
+ * other's objects. Each object is copied once per copier, which preserves
+ * sharing and cycles. Native functions, ranges and futures are immutable, and
+ * channels are meant for tasks to share, so these are shared instead. So are
+ * the elements of shareable frozen lists, which nobody can change.
+ */
+class ObjectCopier {
+ public:
+  auto Copy(const Object& value) -> Object;
+
+  auto CopyEnvironment(const std::shared_ptr<Environment>& environment)
+      -> std::shared_ptr<Environment>;
+
+  /**
+   * @brief Uses `to` wherever the copy reaches `from`, instead of copying it.
+   */
+  auto Map(const LoxCallablePtr& from, LoxCallablePtr to) -> void;
+
+  auto Map(const std::shared_ptr<Environment>& from,
+           std::shared_ptr<Environment> to) -> void;
+
+  /**
+   * @brief The classes copied so far, each paired with its original.
+   */
+  auto GetCopiedClasses() const noexcept
+      -> const std::vector<std::pair<LoxCallablePtr, LoxCallablePtr>>& {
+    return copied_classes_;
+  }
+
+ private:
+  auto CopyCallable(const LoxCallablePtr& callable) -> LoxCallablePtr;
+
+  auto CopyInstance(const LoxInstancePtr& instance) -> LoxInstancePtr;
+
+  // Copies made so far, keyed by the address of their original. Originals
+  // outlive the copier, so addresses are not reused while it runs.
+  std::unordered_map<const void*, LoxCallablePtr> callables_;
+  std::unordered_map<const void*, LoxInstancePtr> instances_;
+  std::unordered_map<const void*, std::shared_ptr<Environment>> environments_;
+  std::vector<std::pair<LoxCallablePtr, LoxCallablePtr>> copied_classes_;
+};
+}  // namespace cclox
+
+#endif  // OBJECT_COPIER_H_
@@ -0,0 +1,292 @@
+#ifndef OPTIMIZER_H_
+#define OPTIMIZER_H_
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ir.h"
+#include "ir_passes.h"
+#include "object.h"
+#include "stmt.h"
+
+namespace cclox {
+class Environment;
+class Interpreter;
+
+/**
+ * @brief Runs Lox functions through the SSA optimizer.
+ *
+ * On its first call, a function is translated to SSA form by `IrBuilder`,
+ * optimized by the default `ir::PassManager` pipeline and cached by
+ * declaration. Calls then execute the optimized IR directly: SSA values live
+ * in a flat array instead of a chain of environments, and only globals,
+ * variables of enclosing functions and `this` are looked up by name. Calls to
+ * small global functions are inlined, using the function the global holds
+ * when the caller is compiled. Arithmetic and comparisons on values inferred
+ * to be numbers, and branches on booleans, skip the interpreter's type
+ * checks.
+ * Functions the builder does not support, and initializers, stay in the
+ * tree-walking interpreter.
+ *
+ * Code whose speculation keeps failing is thrown away: a loop that
+ * deoptimizes is compiled again without speculating on types, and code whose
+ * inlined callee was redefined is compiled again, inlining the new one. Both
+ * events are counted by reason for diagnosis.
+ *
+ * With background compilation, functions are compiled on the interpreter's
+ * `BackgroundCompiler` instead, inlining the functions globals held when the
+ * compilation was requested. Calls keep running in the interpreter until the
+ * code is ready; it is installed at the start of a later call. The functions
+ * and methods of an imported module are queued as it loads. Loops are
+ * still compiled where they run, as their speculation reads the running
+ * environment.
+ */
+class Optimizer {
+ public:
+  // Iterations of a loop in the interpreter before it is compiled.
+  static constexpr uint64_t kHotLoopThreshold = 100;
+  // Failed guards of inlined calls before the code is invalidated.
+  static constexpr uint64_t kMaxGuardFailures = 8;
+  // Times the code of a function or loop is invalidated before it is kept
+  // with its fallbacks.
+  static constexpr uint64_t kMaxInvalidations = 4;
+
+  explicit Optimizer(Interpreter& interpreter);
+
+  auto SetEnabled(bool enabled) noexcept -> void { enabled_ = enabled; }
+
+  auto IsEnabled() const noexcept -> bool { return enabled_; }
+
+  auto SetBackgroundCompileEnabled(bool enabled) noexcept -> void {
+    background_ = enabled;
+  }
+
+  auto IsBackgroundCompileEnabled() const noexcept -> bool {
+    return background_;
+  }
+
+  /**
+   * @brief Prints the optimized IR of every function to `dump` when it is
+   * compiled. `nullptr` disables dumping.
+   */
+  auto SetDumpStream(std::ostream* dump) noexcept -> void { dump_ = dump; }
+
+  /**
+   * @brief Reports the inlining decisions made for every call to `report`.
+   * `nullptr` disables the report.
+   */
+  auto SetInlineReportStream(std::ostream* report) noexcept -> void {
+    report_ = report;
+    pipeline_->inlining->SetReportStream(report);
+  }
+
+  /**
+   * @brief Runs a call of the function declared by `declaration` on its
+   * optimized IR.
+   * @return The call's result, or `std::nullopt` if the function cannot be
+   * optimized and the caller must interpret it.
+   */
+  auto TryCall(const FunctionStmt& declaration,
+               const std::shared_ptr<Environment>& closure,
+               const std::vector<Object>& arguments) -> std::optional<Object>;
+
+  /**
+   * @brief Queues the function declared by `declaration` for compilation
+   * ahead of its first call. Does nothing unless functions are compiled in
+   * the background.
+   */
+  auto Precompile(const FunctionStmt& declaration) -> void;
+
+  /**
+   * @brief Called at a loop's back-edge in the interpreter. Once the loop is
+   * hot, it is compiled from its condition onwards and the rest of the loop
+   * runs on the optimized IR, in the loop's current environment (on-stack
+   * replacement).
+   *
+   * Loop variables that hold numbers, booleans, strings or nil when the loop
+   * is compiled are speculated to keep their type. If one does not, the
+   * optimized loop writes its variables back and deoptimizes at the start of
+   * an iteration, and the interpreter carries on; the loop is then compiled
+   * again without speculation. Unless the loop may throw, its variables are
+   * only stored when it is left.
+   * @return Whether the loop ran to completion in optimized code.
+   */
+  auto OnBackEdge(const WhileStmt& loop,
+                  const std::shared_ptr<Environment>& environment) -> bool;
+
+  /**
+   * @brief How often optimized code deoptimized or was invalidated, by
+   * reason.
+   */
+  auto GetDeoptCounts() const noexcept
+      -> const std::map<std::string, uint64_t>& {
+    return deopts_;
+  }
+
+  /**
+   * @brief Drops every compiled function. They are keyed by AST node, so they
+   * must not outlive the program they were compiled from.
+   */
+  auto Clear() noexcept -> void;
+
+  /**
+   * @brief Drops what was compiled for `loop`, whose statement is about to be
+   * destroyed.
+   */
+  auto ForgetLoop(const WhileStmt& loop) noexcept -> void {
+    loops_.erase(&loop);
+  }
+
+ private:
+  /**
+   * @brief An optimized function or loop. The activations running it share
+   * ownership, so that it can be invalidated while they finish.
+   */
+  struct CompiledCode {
+    ir::Function function;
+    // Fallbacks taken by the guards of inlined calls, and the last guard that
+    // failed.
+    uint64_t guard_failures{0};
+    const ir::Instruction* failed_guard{nullptr};
+    // How often earlier code for the same function or loop was invalidated.
+    uint64_t invalidations{0};
+  };
+  using CompiledCodePtr = std::shared_ptr<CompiledCode>;
+
+  /**
+   * @brief The passes functions are optimized with, and the bodies they
+   * inline. The interpreter's thread and the background compiler each have
+   * their own.
+   */
+  struct Pipeline {
+    ir::PassManager passes;
+    // Owned by `passes`.
+    ir::Inlining* inlining{nullptr};
+    // The bodies inlined into other functions. They are not inlined into
+    // themselves, which bounds the work for recursive functions.
+    std::unordered_map<const FunctionStmt*, std::optional<ir::Function>>
+        inline_bodies;
+    // Finds the value of a global, for inlining.
+    std::function<const Object*(const std::string& name)> find_global;
+  };
+
+  /**
+   * @brief An optimized function compiled in the background, waiting to be
+   * installed.
+   */
+  struct FinishedCompile {
+    const FunctionStmt* declaration;
+    // `nullptr` if the function is not supported.
+    CompiledCodePtr code;
+    std::string dump;
+    std::string report;
+  };
+
+  auto CreatePipeline() -> std::unique_ptr<Pipeline>;
+
+  /**
+   * @return The optimized function, or `nullptr` if it is not supported or
+   * is still being compiled in the background.
+   */
+  auto Compile(const FunctionStmt& declaration) -> CompiledCodePtr;
+
+  /**
+   * @brief Builds and optimizes a function, dumping it to `dump` if not
+   * `nullptr`.
+   * @return The optimized function, or `nullptr` if it is not supported.
+   */
+  auto Build(const FunctionStmt& declaration, Pipeline& pipeline,
+             std::ostream* dump) const -> CompiledCodePtr;
+
+  /**
+   * @brief Submits the compilation of a function to the background compiler.
+   */
+  auto CompileInBackground(const FunctionStmt& declaration,
+                           uint64_t invalidations) -> void;
+
+  /**
+   * @brief Installs the functions compiled in the background so far.
+   */
+  auto InstallFinished() -> void;
+
+  /**
+   * @brief Runs the pipeline and type inference over a function just built.
+   */
+  auto Optimize(const Pipeline& pipeline, ir::Function& function) const
+      -> void;
+
+  static auto Dump(const ir::Function& function, std::ostream* dump) -> void;
+
+  /**
+   * @brief Whether the code's inlined callees were redefined often enough
+   * to compile it again. Counts the invalidation if so.
+   */
+  auto Invalidate(CompiledCode& code) -> bool;
+
+  /**
+   * @brief Finds the function held by the global `name` for inlining.
+   * @return The function and its body optimized without inlining, or
+   * `std::nullopt` if it is not a Lox function the builder supports.
+   */
+  auto FindInlineCandidate(Pipeline& pipeline, const std::string& name) const
+      -> std::optional<ir::InlineCandidate>;
+
+  struct LoopProfile {
+    enum class State { COLD, COMPILED, FAILED };
+    uint64_t iterations{0};
+    State state{State::COLD};
+    bool speculate{true};
+    // The current code, or the last one while the loop is cold again.
+    CompiledCodePtr code;
+  };
+
+  /**
+   * @brief Builds and optimizes a loop for on-stack replacement, guarding the
+   * types of the variables it reads from `environment` if `speculate` is set.
+   * @return The optimized loop, or `nullptr` if it is not supported.
+   */
+  auto CompileLoop(const WhileStmt& loop,
+                   const std::shared_ptr<Environment>& environment,
+                   bool speculate) -> CompiledCodePtr;
+
+  /**
+   * @return The function's result, or `std::nullopt` if it deoptimized and
+   * the interpreter must take over.
+   */
+  auto Execute(CompiledCode& code, const std::shared_ptr<Environment>& closure,
+               const std::vector<Object>& arguments) -> std::optional<Object>;
+
+  Interpreter& interpreter_;
+  bool enabled_{false};
+  bool background_{false};
+  std::ostream* dump_{nullptr};
+  std::ostream* report_{nullptr};
+  std::unique_ptr<Pipeline> pipeline_;
+  // `nullptr` marks functions the builder rejected.
+  std::unordered_map<const FunctionStmt*, CompiledCodePtr> functions_;
+  std::unordered_map<const WhileStmt*, LoopProfile> loops_;
+  std::map<std::string, uint64_t> deopts_;
+
+  // Only used by the background compiler's thread.
+  std::unique_ptr<Pipeline> background_pipeline_;
+  // Functions submitted to the background compiler and not installed yet.
+  std::unordered_set<const FunctionStmt*> pending_;
+  std::mutex finished_mutex_;
+  std::vector<FinishedCompile> finished_;
+  // Whether `finished_` may be non-empty, checked on every call without
+  // taking the lock.
+  std::atomic<bool> has_finished_{false};
+};
+}  // namespace cclox
+
+#endif  // OPTIMIZER_H_
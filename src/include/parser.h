@@ -1,8 +1,13 @@
 #ifndef PARSER_H_
 #define PARSER_H_
 
+#include <cstdint>
+#include <filesystem>
 #include <format>
+#include <functional>
 #include <initializer_list>
+#include <memory>
+#include <optional>
 #include <type_traits>
 #include <utility>
 #include <vector>
@@ -36,6 +41,20 @@ class ParseError : public std::runtime_error {
       : std::runtime_error(std::format("ParseError: {}", message)) {}
 };
 
+/**
+ * @brief A function body that was only pre-parsed: its braces were matched
+ * and its tokens kept, to be parsed on the function's first call.
+ */
+struct LazyBody {
+  // From the first token after `{` to the matching `}`.
+  std::vector<Token> tokens;
+  // The directory imports in the body are relative to.
+  std::filesystem::path directory;
+  // Resolves the parsed body as if where the function is declared; set by the
+  // resolver.
+  std::function<void(const std::vector<StmtPtr>& body)> resolve;
+};
+
 /**
  * @brief The Parser class is responsible for transforming a sequence of tokens
  * into an Abstract Syntax Tree (AST) based on a predefined grammar.
@@ -62,17 +81,75 @@ class Parser {
   explicit Parser(std::vector<Token> tokens, std::ostream& output)
       : tokens_(std::move(tokens)), output_(output) {}
 
+  /**
+   * @brief Returns the next tokens of a program, never none. The last one is
+   * `EoF` at the end of the program.
+   */
+  using TokenSource = std::function<std::vector<Token>()>;
+
+  /**
+   * @brief Constructs a Parser that takes tokens from `source` as it needs
+   * them, for parsing a program a declaration at a time with `ParseNext`.
+   */
+  Parser(TokenSource source, std::ostream& output)
+      : tokens_(source()), source_(std::move(source)), output_(output) {}
+
   auto Parse() -> std::vector<StmtPtr>;
 
+  /**
+   * @brief Parses the next declaration, dropping the tokens of the ones
+   * before it.
+   * @return The declaration, or `std::nullopt` at the end of the program.
+   */
+  auto ParseNext() -> std::optional<StmtPtr>;
+
+  /**
+   * @brief Sets the directory that the paths of imported modules are relative
+   * to; the working directory by default.
+   */
+  auto SetDirectory(std::filesystem::path directory) -> void {
+    directory_ = std::move(directory);
+  }
+
+  /**
+   * @brief Makes the parser only pre-parse function bodies, except those of
+   * async functions; see `LazyBody`.
+   */
+  auto SetLazy(bool lazy) noexcept -> void { lazy_ = lazy; }
+
+  /**
+   * @brief Parses the tokens of a pre-parsed function body, followed by `EoF`.
+   */
+  auto ParseLazyBody() -> std::vector<StmtPtr>;
+
  private:
   auto ParseDeclaration() -> StmtPtr;
 
   auto ParseClassDeclaration() -> StmtPtr;
 
-  auto ParseFunction(std::string_view kind) -> StmtPtr;
+  auto ParseFunction(std::string_view kind, bool is_async = false) -> StmtPtr;
+
+  /**
+   * @brief Skips a function body, after its `{`, checking only that its
+   * braces match.
+   */
+  auto PreParseBody() -> std::shared_ptr<LazyBody>;
+
+  /**
+   * @brief Wraps the body of an async function into a function that runs as
+   * an async call, whose promise the async function returns.
+   */
+  auto MakeAsyncBody(uint32_t line, std::vector<StmtPtr> body)
+      -> std::vector<StmtPtr>;
 
   auto ParseVarDeclaration() -> StmtPtr;
 
+  /**
+   * @brief Parses an import as the declaration of a variable holding the
+   * module, named after its file.
+   */
+  auto ParseImportDeclaration() -> StmtPtr;
+
   auto ParseStatement() -> StmtPtr;
 
   auto ParseForStatement() -> StmtPtr;
@@ -164,7 +241,7 @@ class Parser {
    */
   template<typename T, typename... Ts,
            typename = std::enable_if_t<all_types_are_tokens<T, Ts...>>>
-  auto Match(T type, Ts... types) noexcept -> bool;
+  auto Match(T type, Ts... types) -> bool;
 
   /**
    * @brief Checks if the current token is of the given type and consumes the
@@ -186,7 +263,7 @@ class Parser {
    * @brief Consumes the current token and returns it.
    * @return The most recently consumed token.
    */
-  auto Advance() noexcept -> Token;
+  auto Advance() -> Token;
 
   /**
    * @brief Checks if there are any tokens to parse.
@@ -219,7 +296,7 @@ class Parser {
    * @brief Discards all the tokens of an erroneous statement and advances to
    * the token of the next statement.
    */
-  auto Synchronize() noexcept -> void;
+  auto Synchronize() -> void;
 
   auto FinishCall(ExprPtr callee) -> ExprPtr;
 
@@ -227,6 +304,12 @@ class Parser {
   std::vector<Token> tokens_;
   // Pointer to the next token to be parsed.
   uint32_t current_{0};
+  // Where more tokens come from once `tokens_` are parsed, if anywhere.
+  TokenSource source_;
+  // The directory of the source code, which imports are relative to.
+  std::filesystem::path directory_;
+  // Whether function bodies are only pre-parsed.
+  bool lazy_{false};
 
   // The output stream to log error messages or print values from Lox programs.
   std::ostream& output_{std::cout};
@@ -0,0 +1,71 @@
+#ifndef REF_COUNT_ARENA_H_
+#define REF_COUNT_ARENA_H_
+
+#include <cstddef>
+
+namespace cclox {
+/**
+ * @brief Allocates the control blocks of shared pointers, which hold their
+ * reference counts, in pages of their own.
+ *
+ * Reading a Lox value copies its `shared_ptr`, which writes the object's
+ * reference count. After `fork()`, every such write copies the page it is on.
+ * With the counts packed together, only their pages are copied, and the
+ * pages of the objects they count, which are far larger, stay shared.
+ *
+ * Only the control blocks of `LoxInstance`s come from here; those of lists,
+ * maps and closures stay next to their objects.
+ *
+ * Each chunk holds blocks of one size and counts those in use, and the
+ * threads share the chunks, so a block freed on another thread than the one
+ * that allocated it is reused by either. Chunks whose blocks are all free
+ * stay for later blocks until `ReleaseEmptyChunks` returns them to the heap.
+ */
+class RefCountArena {
+ public:
+  static auto Allocate(size_t size) -> void*;
+
+  static auto Deallocate(void* block, size_t size) noexcept -> void;
+
+  /**
+   * @brief Returns the chunks with no block in use to the heap, such as
+   * those of the instances a server worker's request created.
+   */
+  static auto ReleaseEmptyChunks() noexcept -> void;
+
+  /**
+   * @return The number of chunks held, empty or not.
+   */
+  static auto GetChunkCount() noexcept -> size_t;
+};
+
+/**
+ * @brief An allocator for `std::shared_ptr`'s constructor taking a pointer, a
+ * deleter and an allocator, which it only uses for the control block.
+ */
+template <typename T>
+class RefCountAllocator {
+ public:
+  using value_type = T;
+
+  RefCountAllocator() noexcept = default;
+
+  template <typename U>
+  explicit RefCountAllocator(const RefCountAllocator<U>&) noexcept {}
+
+  auto allocate(size_t count) -> T* {
+    return static_cast<T*>(RefCountArena::Allocate(count * sizeof(T)));
+  }
+
+  auto deallocate(T* block, size_t count) noexcept -> void {
+    RefCountArena::Deallocate(block, count * sizeof(T));
+  }
+
+  template <typename U>
+  auto operator==(const RefCountAllocator<U>&) const noexcept -> bool {
+    return true;
+  }
+};
+}  // namespace cclox
+
+#endif  // REF_COUNT_ARENA_H_
@@ -0,0 +1,134 @@
+#ifndef REGISTER_CODE_H_
+#define REGISTER_CODE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "object.h"
+#include "token.h"
+
+/**
+ * @brief A register bytecode for the bodies of Lox functions.
+ *
+ * Where the stack bytecode moves every operand through the top of the stack,
+ * register instructions name the frame slots (registers) they read and write,
+ * so `i = i + 1` is a single `ADD` from the register of `i` and a constant
+ * into the register of `i`. Source operands can name a constant instead of a
+ * register; see `IsConstant`.
+ */
+namespace cclox::register_code {
+// The list of opcodes, expanded by `CCLOX_REGISTER_OP` wherever a table
+// indexed by opcode is needed. `a` is the destination unless noted.
+#define CCLOX_REGISTER_OPCODES(OP)                                         \
+  /* a = b */                                                              \
+  OP(MOVE)                                                                 \
+  /* Globals and variables of enclosing functions, `b` environments up, */ \
+  /* named by the instruction's token. Stores read `a`. */                 \
+  OP(GET_GLOBAL)                                                           \
+  OP(SET_GLOBAL)                                                           \
+  OP(GET_FREE)                                                             \
+  OP(SET_FREE)                                                             \
+  /* a = b.token */                                                        \
+  OP(GET_PROPERTY)                                                         \
+  /* Throws unless `a` is an instance. */                                  \
+  OP(CHECK_INSTANCE)                                                       \
+  /* a.token = b */                                                        \
+  OP(SET_PROPERTY)                                                         \
+  /* a = b op c */                                                         \
+  OP(ADD)                                                                  \
+  OP(SUBTRACT)                                                             \
+  OP(MULTIPLY)                                                             \
+  OP(DIVIDE)                                                               \
+  OP(EQUAL)                                                                \
+  OP(NOT_EQUAL)                                                            \
+  OP(LESS)                                                                 \
+  OP(LESS_EQUAL)                                                           \
+  OP(GREATER)                                                              \
+  OP(GREATER_EQUAL)                                                        \
+  /* a = op b */                                                           \
+  OP(NEGATE)                                                               \
+  OP(NOT)                                                                  \
+  /* Jumps to instruction `a`. */                                          \
+  OP(JUMP)                                                                 \
+  /* Jumps to `a` if `b` is falsey (truthy). */                            \
+  OP(JUMP_IF_FALSE)                                                        \
+  OP(JUMP_IF_TRUE)                                                         \
+  /* Jumps to `a` unless `b op c` holds. */                                \
+  OP(JUMP_UNLESS_EQUAL)                                                    \
+  OP(JUMP_UNLESS_NOT_EQUAL)                                                \
+  OP(JUMP_UNLESS_LESS)                                                     \
+  OP(JUMP_UNLESS_LESS_EQUAL)                                               \
+  OP(JUMP_UNLESS_GREATER)                                                  \
+  OP(JUMP_UNLESS_GREATER_EQUAL)                                            \
+  /* Calls register `a` with the `b` arguments in the registers after */   \
+  /* it, and stores the result into `a`. */                                \
+  OP(CALL)                                                                 \
+  /* Like `CALL`, on method `token` of the instance in `a`. Errors from */ \
+  /* the call are reported at token `c`. */                                \
+  OP(INVOKE)                                                               \
+  /* Print or return `a`. */                                               \
+  OP(PRINT)                                                                \
+  OP(RETURN)
+
+enum class OpCode : uint8_t {
+#define CCLOX_REGISTER_OP(name) name,
+  CCLOX_REGISTER_OPCODES(CCLOX_REGISTER_OP)
+#undef CCLOX_REGISTER_OP
+};
+
+auto OpCodeName(OpCode opcode) -> std::string_view;
+
+// Set in a source operand that names a constant rather than a register.
+inline constexpr uint32_t kConstantBit = uint32_t{1} << 31;
+
+constexpr auto IsConstant(uint32_t operand) noexcept -> bool {
+  return (operand & kConstantBit) != 0;
+}
+
+constexpr auto ConstantOperand(uint32_t index) noexcept -> uint32_t {
+  return index | kConstantBit;
+}
+
+constexpr auto ConstantIndex(uint32_t operand) noexcept -> uint32_t {
+  return operand & ~kConstantBit;
+}
+
+struct Instruction {
+  // The address of the instruction's handler in the dispatch loop, filled in
+  // by the VM before the code first runs (direct threading).
+  const void* handler{nullptr};
+  OpCode opcode{OpCode::MOVE};
+  // The token in the code's `tokens` naming the variable or property, and
+  // carrying the line reported by runtime errors.
+  uint32_t token{0};
+  uint32_t a{0};
+  uint32_t b{0};
+  uint32_t c{0};
+};
+
+/**
+ * @brief The register bytecode of one function.
+ */
+struct Code {
+  std::string name;
+  size_t arity{0};
+  std::vector<Instruction> code;
+  std::vector<Object> constants;
+  std::vector<Token> tokens;
+  // Registers of a frame: the parameters come first.
+  size_t register_count{0};
+  // The handler table `code` was threaded with, or `nullptr`.
+  const void* const* threaded_with{nullptr};
+};
+
+/**
+ * @brief Prints the code in a human-readable form.
+ */
+auto Disassemble(const Code& code, std::ostream& output) -> void;
+}  // namespace cclox::register_code
+
+#endif  // REGISTER_CODE_H_
@@ -0,0 +1,202 @@
+#ifndef REGISTER_COMPILER_H_
+#define REGISTER_COMPILER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "expr.h"
+#include "register_code.h"
+#include "stmt.h"
+
+namespace cclox {
+class Interpreter;
+
+/**
+ * @brief Compiles the body of a Lox function to register bytecode.
+ *
+ * Registers are allocated by linear scan over the function in program order:
+ * the live range of a local is the rest of its block, and that of a temporary
+ * ends at the instruction consuming it, so each range is known when it ends
+ * and its register goes back to the free pool. A new range takes the lowest
+ * free register. Reads of locals and constants name their register or
+ * constant directly instead of copying them, and an expression assigned to a
+ * local is computed straight into the local's register.
+ *
+ * Like `BytecodeCompiler`, the compiler rejects functions that declare nested
+ * functions or classes, whose locals could be captured, and functions that
+ * use `super`; variables of enclosing functions and `this` are accessed
+ * through the closure.
+ */
+class RegisterCompiler {
+ public:
+  explicit RegisterCompiler(const Interpreter& interpreter)
+      : interpreter_(interpreter) {}
+
+  /**
+   * @return The function's register code, or `std::nullopt` if it uses a
+   * construct the register code does not support.
+   */
+  auto Compile(const FunctionStmt& function)
+      -> std::optional<register_code::Code>;
+
+  /**
+   * @brief Where an expression's value is: a register or a constant, and
+   * whether the register is a temporary to free once the value is used.
+   */
+  struct Operand {
+    uint32_t operand;
+    bool temporary;
+  };
+
+  // ====================Statement Visitors====================
+  auto operator()(const BlockStmtPtr& stmt) -> void;
+
+  auto operator()(const ClassStmtPtr& stmt) -> void;
+
+  auto operator()(const ExprStmtPtr& stmt) -> void;
+
+  auto operator()(const FunctionStmtPtr& stmt) -> void;
+
+  auto operator()(const IfStmtPtr& stmt) -> void;
+
+  auto operator()(const PrintStmtPtr& stmt) -> void;
+
+  auto operator()(const ReturnStmtPtr& stmt) -> void;
+
+  auto operator()(const VarStmtPtr& stmt) -> void;
+
+  auto operator()(const WhileStmtPtr& stmt) -> void;
+
+  // ====================Expression Visitors====================
+  auto operator()(const AssignExprPtr& expr) -> Operand;
+
+  auto operator()(const BinaryExprPtr& expr) -> Operand;
+
+  auto operator()(const CallExprPtr& expr) -> Operand;
+
+  auto operator()(const GetExprPtr& expr) -> Operand;
+
+  auto operator()(const GroupingExprPtr& expr) -> Operand;
+
+  auto operator()(const LiteralExprPtr& expr) -> Operand;
+
+  auto operator()(const LogicalExprPtr& expr) -> Operand;
+
+  auto operator()(const SetExprPtr& expr) -> Operand;
+
+  auto operator()(const SuperExprPtr& expr) -> Operand;
+
+  auto operator()(const ThisExprPtr& expr) -> Operand;
+
+  auto operator()(const UnaryExprPtr& expr) -> Operand;
+
+  auto operator()(const VariableExprPtr& expr) -> Operand;
+
+ private:
+  auto CompileStatement(const StmtPtr& stmt) -> void;
+
+  /**
+   * @brief Compiles an expression, into register `target` if given. Without
+   * a target, locals and constants are not copied.
+   */
+  auto CompileExpression(const ExprPtr& expr,
+                         std::optional<uint32_t> target = std::nullopt)
+      -> Operand;
+
+  /**
+   * @brief Compiles an expression into register `target`.
+   */
+  auto CompileInto(const ExprPtr& expr, uint32_t target) -> void;
+
+  /**
+   * @brief Compiles a condition.
+   * @return The jump taken when the condition is false, to patch.
+   */
+  auto CompileCondition(const ExprPtr& condition) -> size_t;
+
+  /**
+   * @brief The register an expression should write its result to: its
+   * `target`, or a new temporary.
+   */
+  auto Destination(std::optional<uint32_t> target) -> Operand;
+
+  /**
+   * @brief Copies `operand` into `target`, if there is one.
+   * @return Where the value ends up.
+   */
+  auto MoveTo(std::optional<uint32_t> target, const Operand& operand,
+              const Token& token) -> Operand;
+
+  auto Emit(register_code::OpCode opcode, const Token& token, uint32_t a = 0,
+            uint32_t b = 0, uint32_t c = 0) -> size_t;
+
+  auto AddConstant(const Object& value) -> uint32_t;
+
+  auto AddToken(const Token& token) -> uint32_t;
+
+  /**
+   * @brief Points the jump at `jump` to the next instruction.
+   */
+  auto PatchJump(size_t jump) -> void;
+
+  // ====================Register allocation====================
+  auto Allocate() -> uint32_t;
+
+  /**
+   * @brief Allocates `count` consecutive registers, for a call's callee and
+   * arguments.
+   * @return The first of them.
+   */
+  auto AllocateRange(uint32_t count) -> uint32_t;
+
+  auto Free(uint32_t reg) -> void;
+
+  /**
+   * @brief Frees the operand's register if it is a temporary.
+   */
+  auto Release(const Operand& operand) -> void;
+
+  auto Declare(const Token& name, uint32_t reg) -> void;
+
+  auto EndScope() -> void;
+
+  /**
+   * @brief Finds the register of the local `depth` scopes up that a resolved
+   * variable expression refers to.
+   */
+  auto FindLocal(const std::string& name, uint64_t depth) const
+      -> std::optional<uint32_t>;
+
+  /**
+   * @brief Whether evaluating the expression can assign a local, so that a
+   * local read before it must be copied first.
+   */
+  auto AssignsLocal(const ExprPtr& expr) const -> bool;
+
+  /**
+   * @brief Whether evaluating the expression has no side effects and cannot
+   * throw, so it can be reordered with a property lookup.
+   */
+  auto IsSimple(const ExprPtr& expr) const -> bool;
+
+  const Interpreter& interpreter_;
+  register_code::Code code_;
+  // The target of the expression being visited, if any.
+  std::optional<uint32_t> target_;
+  // The lexical scopes of the function, mirroring the resolver's, mapping
+  // each local to its register.
+  std::vector<std::unordered_map<std::string, uint32_t>> scopes_;
+  // Registers below `code_.register_count` that hold no live value.
+  std::set<uint32_t> free_;
+  std::map<std::pair<uint32_t, std::string>, uint32_t> token_indices_;
+};
+}  // namespace cclox
+
+#endif  // REGISTER_COMPILER_H_
@@ -0,0 +1,79 @@
+#ifndef REGISTER_VM_H_
+#define REGISTER_VM_H_
+
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "object.h"
+#include "register_code.h"
+#include "stmt.h"
+
+namespace cclox {
+class Environment;
+class Interpreter;
+
+/**
+ * @brief Runs Lox functions on the register bytecode of `RegisterCompiler`.
+ *
+ * Like `Vm`, it compiles a function on its first call, caches the code by
+ * declaration and dispatches with direct threading where the compiler
+ * supports it. A frame is a flat array of registers; instructions read their
+ * operands from registers or constants and write their result to a register,
+ * so most statements take one or two instructions and values are not pushed
+ * and popped. Functions the compiler does not support, and initializers,
+ * stay in the tree-walking interpreter.
+ */
+class RegisterVm {
+ public:
+  explicit RegisterVm(Interpreter& interpreter) : interpreter_(interpreter) {}
+
+  auto SetEnabled(bool enabled) noexcept -> void { enabled_ = enabled; }
+
+  auto IsEnabled() const noexcept -> bool { return enabled_; }
+
+  /**
+   * @brief Prints the register code of every function to `dump` when it is
+   * compiled. `nullptr` disables dumping.
+   */
+  auto SetDumpStream(std::ostream* dump) noexcept -> void { dump_ = dump; }
+
+  /**
+   * @brief Runs a call of the function declared by `declaration` on its
+   * register code.
+   * @return The call's result, or `std::nullopt` if the function cannot be
+   * compiled and the caller must interpret it.
+   */
+  auto TryCall(const FunctionStmt& declaration,
+               const std::shared_ptr<Environment>& closure,
+               const std::vector<Object>& arguments) -> std::optional<Object>;
+
+  /**
+   * @brief Drops every compiled function. They are keyed by AST node, so they
+   * must not outlive the program they were compiled from.
+   */
+  auto Clear() noexcept -> void { functions_.clear(); }
+
+ private:
+  /**
+   * @return The function's register code, or `nullptr` if it is not
+   * supported.
+   */
+  auto Compile(const FunctionStmt& declaration) -> register_code::Code*;
+
+  auto Run(register_code::Code& code,
+           const std::shared_ptr<Environment>& closure,
+           const std::vector<Object>& arguments) -> Object;
+
+  Interpreter& interpreter_;
+  bool enabled_{false};
+  std::ostream* dump_{nullptr};
+  // `std::nullopt` marks functions the compiler rejected.
+  std::unordered_map<const FunctionStmt*, std::optional<register_code::Code>>
+      functions_;
+};
+}  // namespace cclox
+
+#endif  // REGISTER_VM_H_
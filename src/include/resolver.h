@@ -14,8 +14,26 @@ class Resolver {
  public:
   explicit Resolver(Interpreter& interpreter) : interpreter_(interpreter) {}
 
+  /**
+   * @brief Constructs a Resolver that also appends each expression it
+   * resolves to a local variable to `resolved`, so that the interpreter can
+   * forget them once they are no longer run.
+   */
+  Resolver(Interpreter& interpreter, std::vector<ExprPtr>& resolved)
+      : interpreter_(interpreter), resolved_(&resolved) {}
+
   auto ResolveStatements(const std::vector<StmtPtr>& statements) -> void;
 
+  auto ResolveStatement(const StmtPtr& stmt) -> void;
+
+  /**
+   * @brief Resolves the statements of an imported module, whose top level is
+   * a scope of its own. Like globals, its variables, functions and classes
+   * can be referred to from functions declared before them, and declared
+   * again.
+   */
+  auto ResolveModule(const std::vector<StmtPtr>& statements) -> void;
+
   // ====================Statement Visitors====================
   auto operator()(const BlockStmtPtr& stmt) -> void;
 
@@ -76,8 +94,6 @@ class Resolver {
   };
 
  private:
-  auto ResolveStatement(const StmtPtr& stmt) -> void;
-
   auto ResolveExpression(const ExprPtr& expr) -> void;
 
   auto BeginScope() -> void;
@@ -94,7 +110,11 @@ class Resolver {
       -> void;
 
   Interpreter& interpreter_;
+  // Where the resolved expressions are recorded, if anywhere.
+  std::vector<ExprPtr>* resolved_{nullptr};
   std::vector<SymbolTable> scopes_;
+  // Whether the outermost scope is a module's top level.
+  bool in_module_{false};
   FunctionType current_function_{FunctionType::NONE};
   ClassType current_class_{ClassType::NONE};
 };
@@ -1,8 +1,10 @@
 #ifndef SCANNER_H_
 #define SCANNER_H_
 
+#include <istream>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
@@ -27,12 +29,33 @@ class Scanner {
   Scanner(std::string source, std::ostream& output)
       : source_(std::move(source)), output_(output) {}
 
+  /**
+   * @brief Constructs a Scanner for source code that starts at `line_number`
+   * of a longer program.
+   */
+  Scanner(std::string source, std::ostream& output, uint32_t line_number)
+      : source_(std::move(source)),
+        line_number_(line_number),
+        output_(output) {}
+
   /**
    * @brief Scans the source code and returns a list of tokens.
    * @return A vector containing all the tokens scanned from the source code.
    */
   auto ScanTokens() -> std::vector<Token>;
 
+  /**
+   * @brief Tells whether a string literal is still open at the end of `line`,
+   * given whether one was open at its start.
+   */
+  static auto EndsInString(std::string_view line, bool in_string) noexcept
+      -> bool;
+
+  /**
+   * @brief Tells whether `text` scans as a single identifier.
+   */
+  static auto IsIdentifier(std::string_view text) -> bool;
+
   using TokenTypeMap = std::unordered_map<std::string, TokenType>;
 
  private:
@@ -92,14 +115,14 @@ class Scanner {
    * @param c The character to check.
    * @return true if the character is alphabetic, false otherwise.
    */
-  auto IsAlpha(char c) const noexcept -> bool;
+  static auto IsAlpha(char c) noexcept -> bool;
 
   /**
    * @brief Checks if the given character is a numeric digit (0-9).
    * @param c The character to check.
    * @return true if the character is a digit, false otherwise.
    */
-  auto IsDigit(char c) const noexcept -> bool;
+  static auto IsDigit(char c) noexcept -> bool;
 
   /**
    * @brief Checks if the given character is either an alphabetic character
@@ -107,7 +130,7 @@ class Scanner {
    * @param c The character to check.
    * @return true if the character is alphanumeric, false otherwise.
    */
-  auto IsAlphaNumeric(char c) const noexcept -> bool;
+  static auto IsAlphaNumeric(char c) noexcept -> bool;
 
   /**
    * @brief Returns the current character and then advances
@@ -146,6 +169,29 @@ class Scanner {
   // The output stream to log error messages or print values from Lox programs.
   std::ostream& output_{std::cout};
 };
+
+/**
+ * @brief Scans source code read from a stream as it arrives: a line at a
+ * time, or a few lines at once when a string literal spans them.
+ */
+class StreamScanner {
+ public:
+  StreamScanner(std::istream& input, std::ostream& output)
+      : input_(input), output_(output) {}
+
+  /**
+   * @brief Reads and scans lines until they hold a token.
+   * @return The tokens of those lines, never empty. The last one is `EoF`
+   * once the input has ended.
+   */
+  auto ScanTokens() -> std::vector<Token>;
+
+ private:
+  std::istream& input_;
+  std::ostream& output_;
+  // The number of the next line to be read.
+  uint32_t line_number_{1};
+};
 }  // namespace cclox
 
 #endif  // SCANNER_H_
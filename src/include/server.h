@@ -0,0 +1,117 @@
+#ifndef SERVER_H_
+#define SERVER_H_
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "lox.h"
+#include "object.h"
+
+namespace cclox {
+/**
+ * @brief Serves requests with the `handle(request)` function of a loaded
+ * script, from worker processes forked once the script has run.
+ *
+ * Workers inherit the script's heap copy-on-write, so each request pays
+ * neither for starting the interpreter nor for running the script again, and
+ * the memory the workers only read stays shared between them. A worker that
+ * dies is replaced by a new fork of the server; on a socket, after a delay
+ * that grows while workers keep dying right after they start.
+ *
+ * Each request is a line, which `handle` gets as a string, and each response
+ * is a line with what `handle` returned, or with the runtime error it failed
+ * with. What workers print goes to standard error.
+ */
+class Server {
+ public:
+  /**
+   * @param handler The script's `handle` function.
+   */
+  Server(Lox& lox, Object handler, size_t worker_count);
+
+  /**
+   * @brief Accepts connections on a Unix socket at `path`, each carrying any
+   * number of requests, until the server is interrupted or terminated.
+   * @return The exit code.
+   */
+  auto ServeSocket(const std::string& path) -> int;
+
+  /**
+   * @brief Reads requests from standard input until it ends, and writes the
+   * responses to standard output in the same order.
+   * @return The exit code.
+   */
+  auto ServeStdin() -> int;
+
+ private:
+  /**
+   * @brief Reads the lines a descriptor receives.
+   */
+  class LineReader {
+   public:
+    explicit LineReader(int fd) : fd_(fd) {}
+
+    /**
+     * @return The next line, without its newline, or `std::nullopt` once
+     * the descriptor is closed.
+     */
+    auto Next() -> std::optional<std::string>;
+
+   private:
+    int fd_;
+    std::string buffer_;
+  };
+
+  /**
+   * @brief A worker serving the requests the server reads from standard
+   * input, over its end of a socket pair.
+   */
+  struct StdinWorker {
+    pid_t pid{-1};
+    int fd{-1};
+    LineReader reader{-1};
+  };
+
+  /**
+   * @brief Forks a worker running `serve`, which never returns to the
+   * caller in the worker.
+   * @return The worker's id, or -1 if it could not be forked.
+   */
+  template <typename Serve>
+  auto Fork(const std::vector<int>& inherited, Serve serve) -> pid_t;
+
+  auto StartStdinWorker(StdinWorker& worker) -> bool;
+
+  /**
+   * @brief Waits for the response of `worker`'s oldest request and writes
+   * it to standard output, replacing the worker if it died.
+   */
+  auto WriteResponse(StdinWorker& worker) -> void;
+
+  /**
+   * @brief Reaps `worker`, which died, and starts another in its place.
+   */
+  auto ReplaceStdinWorker(StdinWorker& worker) -> void;
+
+  /**
+   * @brief Answers the requests received on `fd` until it is closed.
+   */
+  auto ServeConnection(int fd) -> void;
+
+  auto Respond(const std::string& request) -> std::string;
+
+  static auto ReportExit(pid_t pid, int status) -> void;
+
+  Lox& lox_;
+  Object handler_;
+  size_t worker_count_;
+  std::vector<StdinWorker> stdin_workers_;
+};
+}  // namespace cclox
+
+#endif  // SERVER_H_
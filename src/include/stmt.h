@@ -19,6 +19,7 @@ class PrintStmt;
 class ReturnStmt;
 class VarStmt;
 class WhileStmt;
+struct LazyBody;
 
 using BlockStmtPtr = std::unique_ptr<BlockStmt>;
 using ClassStmtPtr = std::unique_ptr<ClassStmt>;
@@ -88,6 +89,16 @@ class FunctionStmt {
         params_(std::move(params)),
         body_(std::move(body)) {}
 
+  /**
+   * @brief Constructs a function whose body was only pre-parsed, and is
+   * parsed on the function's first call.
+   */
+  FunctionStmt(Token name, std::vector<Token> params,
+               std::shared_ptr<LazyBody> lazy_body)
+      : name_(std::move(name)),
+        params_(std::move(params)),
+        lazy_body_(std::move(lazy_body)) {}
+
   auto GetFunctionName() const noexcept -> const Token& { return name_; }
 
   auto GetParams() const noexcept -> const std::vector<Token>& {
@@ -96,10 +107,29 @@ class FunctionStmt {
 
   auto GetBody() const noexcept -> const std::vector<StmtPtr>& { return body_; }
 
+  /**
+   * @brief Tells whether the body has been parsed. Until it is, `GetBody` is
+   * empty.
+   */
+  auto IsBodyParsed() const noexcept -> bool { return lazy_body_ == nullptr; }
+
+  auto GetLazyBody() const noexcept -> const std::shared_ptr<LazyBody>& {
+    return lazy_body_;
+  }
+
+  /**
+   * @brief Replaces the pre-parsed body with the parsed one.
+   */
+  auto SetBody(std::vector<StmtPtr> body) -> void {
+    body_ = std::move(body);
+    lazy_body_.reset();
+  }
+
  private:
   Token name_;
   std::vector<Token> params_;
   std::vector<StmtPtr> body_;
+  std::shared_ptr<LazyBody> lazy_body_;
 };
 
 class IfStmt {
@@ -168,14 +198,23 @@ class VarStmt {
 
 class WhileStmt {
  public:
-  WhileStmt(ExprPtr condition, StmtPtr body)
-      : condition_(std::move(condition)), body_(std::move(body)) {}
+  WhileStmt(Token keyword, ExprPtr condition, StmtPtr body)
+      : keyword_(std::move(keyword)),
+        condition_(std::move(condition)),
+        body_(std::move(body)) {}
+
+  /**
+   * @brief Returns the `while` or `for` keyword, where errors raised at the
+   * loop's back-edge are reported.
+   */
+  auto GetKeyword() const noexcept -> const Token& { return keyword_; }
 
   auto GetCondition() const noexcept -> const ExprPtr& { return condition_; }
 
   auto GetBody() const noexcept -> const StmtPtr& { return body_; }
 
  private:
+  Token keyword_;
   ExprPtr condition_;
   StmtPtr body_;
 };
@@ -0,0 +1,218 @@
+#ifndef TASK_SCHEDULER_H_
+#define TASK_SCHEDULER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "interpreter.h"
+#include "lox_callable.h"
+#include "object.h"
+
+namespace cclox {
+/**
+ * @brief The result of a spawned task, which the task's spawner can await.
+ *
+ * Whatever the task prints is held back until the task is first awaited, so
+ * a program's output does not depend on how its tasks are scheduled. Calling
+ * a future is the same as awaiting it.
+ */
+class LoxFuture : public LoxCallable {
+ public:
+  explicit LoxFuture(const Interpreter& spawner) : spawner_(spawner) {}
+
+  auto Arity() const noexcept -> size_t override { return 0; }
+
+  auto Call(Interpreter& interpreter, const std::vector<Object>& arguments)
+      -> Object override;
+
+  auto ToString() const -> std::string override { return "<future>"; }
+
+  /**
+   * @brief Waits for the task, writes its output to `interpreter`'s output
+   * stream if it is the first to await it, and returns its result.
+   * @throws RuntimeError The error the task failed with.
+   * @throws NativeError If the running code's deadline passes first.
+   */
+  auto Await(Interpreter& interpreter) -> Object;
+
+  auto Complete(Object result, std::string output) -> void;
+
+  auto Fail(RuntimeError error, std::string output) -> void;
+
+  auto IsDone() const -> bool;
+
+  /**
+   * @brief Blocks until the task is done, or `timeout` passes.
+   */
+  auto WaitFor(std::chrono::microseconds timeout) const -> void;
+
+ private:
+  const Interpreter& spawner_;
+  mutable std::mutex mutex_;
+  mutable std::condition_variable done_condition_;
+  bool done_{false};
+  // Written by the task before `done_` is set, and read by the spawner after.
+  Object result_;
+  std::optional<RuntimeError> error_;
+  std::string output_;
+};
+
+/**
+ * @brief An interpreter running tasks on a worker thread, with the stream its
+ * tasks print to.
+ */
+struct TaskContext {
+  explicit TaskContext(Interpreter& root) : interpreter(output, root) {}
+
+  std::ostringstream output;
+  Interpreter interpreter;
+  // The program the context last ran a task of; see
+  // `TaskScheduler::EndProgram`.
+  uint64_t program{0};
+};
+
+/**
+ * @brief Runs spawned tasks on a pool of worker threads.
+ *
+ * Each worker has its own deque of jobs. A worker pushes the jobs it spawns
+ * to the back of its deque and pops from the back, running the newest, most
+ * cache-friendly job first; an idle worker steals the oldest job from the
+ * front of another worker's deque. Jobs spawned by other threads are dealt to
+ * the workers in turn. A worker awaiting a task runs other jobs in the
+ * meantime instead of blocking, so tasks awaiting their own subtasks cannot
+ * starve the pool. A worker waiting for a channel cannot do the same, as the
+ * job it would run may wait for the very task it interrupted; instead, a
+ * spare worker is started while the pool is short of running workers.
+ *
+ * Jobs run in an isolated interpreter context of their worker. A job run while
+ * its worker awaits gets a context of its own, so it cannot clobber the
+ * globals or output of the job that is waiting.
+ */
+class TaskScheduler {
+ public:
+  using Job = std::function<void(TaskContext& context)>;
+
+  TaskScheduler(Interpreter& root, size_t worker_count);
+
+  ~TaskScheduler();
+
+  TaskScheduler(const TaskScheduler&) = delete;
+
+  auto operator=(const TaskScheduler&) -> TaskScheduler& = delete;
+
+  /**
+   * @brief The number of workers running at a time, not counting those
+   * waiting for channels.
+   */
+  auto GetWorkerCount() const noexcept -> size_t { return worker_count_; }
+
+  auto Submit(Job job) -> void;
+
+  using Deadline = std::optional<std::chrono::steady_clock::time_point>;
+
+  /**
+   * @brief Waits for the future's task, running other jobs meanwhile if
+   * called on a worker.
+   * @return Whether the task was done before `deadline`, if any.
+   */
+  auto Wait(const LoxFuture& future, const Deadline& deadline = std::nullopt)
+      -> bool;
+
+  /**
+   * @brief Waits until `ready()` holds, running other jobs meanwhile if
+   * called on a worker. Between checks, `sleep(timeout)` blocks until what
+   * `ready` checks may have changed, or `timeout` passes; it never sleeps
+   * past `deadline`.
+   * @return Whether `ready()` held before `deadline`, if any.
+   */
+  auto WaitUntil(const std::function<bool()>& ready,
+                 const std::function<void(std::chrono::microseconds)>& sleep,
+                 const Deadline& deadline = std::nullopt) -> bool;
+
+  /**
+   * @brief Waits like `WaitUntil`, but without running other jobs. On a
+   * worker, a spare worker takes its place meanwhile. Also gives up once the
+   * scheduler is cancelled.
+   */
+  auto BlockUntil(const std::function<bool()>& ready,
+                  const std::function<void(std::chrono::microseconds)>& sleep,
+                  const Deadline& deadline = std::nullopt) -> bool;
+
+  /**
+   * @brief Marks the end of the root's program, once all of its tasks are
+   * done. Contexts drop the code they compiled from it before their next job.
+   */
+  auto EndProgram() noexcept -> void { program_++; }
+
+  /**
+   * @brief Makes every `BlockUntil` return false until `Resume`, so that the
+   * tasks of a program that failed stop waiting for channels nothing will
+   * ever use again, and can be joined. Blocked callers notice within their
+   * next sleep, or at once if their `sleep` is woken.
+   */
+  auto Cancel() noexcept -> void { cancelled_.store(true); }
+
+  auto Resume() noexcept -> void { cancelled_.store(false); }
+
+  auto IsCancelled() const noexcept -> bool { return cancelled_.load(); }
+
+ private:
+  struct Worker {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+    // Indexed by how many jobs the worker is running, nested in awaits.
+    std::vector<std::unique_ptr<TaskContext>> contexts;
+    size_t depth{0};
+    std::thread thread;
+  };
+
+  // The most workers that can wait for channels at once; more block the pool.
+  static constexpr size_t kMaxBlockedWorkers = 256;
+
+  /**
+   * @brief Starts the thread of the next worker. Requires `start_mutex_`
+   * unless the pool is being built.
+   */
+  auto StartWorker() -> void;
+
+  auto RunWorker(size_t index) -> void;
+
+  /**
+   * @brief Takes the newest job of worker `index`, or steals the oldest job
+   * of another worker.
+   */
+  auto Take(size_t index) -> std::optional<Job>;
+
+  auto Run(size_t index, Job& job) -> void;
+
+  Interpreter& root_;
+  size_t worker_count_;
+  // All the workers that can ever start, of which the first `started_` have.
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::atomic<size_t> started_{0};
+  std::atomic<size_t> blocked_{0};
+  std::mutex start_mutex_;
+  std::atomic<size_t> next_worker_{0};
+  // Jobs in the deques, so that idle workers know when to look for one.
+  std::atomic<size_t> queued_{0};
+  std::atomic<uint64_t> program_{0};
+  std::atomic<bool> cancelled_{false};
+  std::mutex idle_mutex_;
+  std::condition_variable idle_condition_;
+  bool stopping_{false};
+};
+}  // namespace cclox
+
+#endif  // TASK_SCHEDULER_H_
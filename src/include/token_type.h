@@ -20,8 +20,8 @@ enum class TokenType {
   IDENTIFIER, STRING, NUMBER,
 
   // Keywords.
-  AND, CLASS, ELSE, FALSE, FUN, FOR, IF, NIL, OR,
-  PRINT, RETURN, SUPER, THIS, TRUE, VAR, WHILE,
+  AND, ASYNC, AWAIT, CLASS, ELSE, FALSE, FUN, FOR, IF, IMPORT, NIL,
+  OR, PRINT, RETURN, SUPER, THIS, TRUE, VAR, WHILE,
 
   // stdio.h already defines EOF, so can't use it anymore.
   EoF,
@@ -40,8 +40,9 @@ constexpr std::array<const char*, static_cast<std::size_t>(TokenType::COUNT)>
     "GREATER", "GREATER_EQUAL",
     "LESS", "LESS_EQUAL",
     "IDENTIFIER", "STRING", "NUMBER",
-    "AND", "CLASS", "ELSE", "FALSE", "FUN", "FOR", "IF", "NIL", "OR",
-    "PRINT", "RETURN", "SUPER", "THIS", "TRUE", "VAR", "WHILE",
+    "AND", "ASYNC", "AWAIT", "CLASS", "ELSE", "FALSE", "FUN", "FOR", "IF",
+    "IMPORT", "NIL", "OR", "PRINT", "RETURN", "SUPER", "THIS", "TRUE", "VAR",
+    "WHILE",
     "EoF"
 };
 
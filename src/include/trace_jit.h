@@ -0,0 +1,179 @@
+#ifndef TRACE_JIT_H_
+#define TRACE_JIT_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "jit.h"
+#include "stmt.h"
+#include "x64_assembler.h"
+
+namespace cclox {
+class Environment;
+class Interpreter;
+
+/**
+ * @brief Operations of the linear trace IR. Every instruction defines the
+ * value whose id is its index in the trace.
+ */
+enum class TraceOp : uint8_t {
+  // Reads an outer variable at the start of the iteration.
+  LOAD,
+  CONST,
+  ADD,
+  SUB,
+  MUL,
+  DIV,
+  NEG,
+  NOT,
+  EQ,
+  NE,
+  LT,
+  LE,
+  GT,
+  GE,
+  // Leaves the trace through a side exit unless the operand is truthy/falsey.
+  GUARD_TRUE,
+  GUARD_FALSE,
+  // The loop condition: leaves the loop normally when the operand is falsey.
+  EXIT_IF_FALSE,
+  // Writes the value `b` back to the outer variable `a` at the end of the
+  // iteration.
+  STORE,
+};
+
+struct TraceInstruction {
+  TraceOp op;
+  int32_t a{-1};
+  int32_t b{-1};
+  int32_t imm{0};
+};
+
+/**
+ * @brief A variable defined outside the loop that the trace reads or writes.
+ */
+struct TraceSlot {
+  // Distance from the loop's environment, or `std::nullopt` for a global.
+  std::optional<uint64_t> distance;
+  std::string name;
+  // Whether the variable holds a bool (otherwise an int32).
+  bool is_bool{false};
+  // Whether the trace stores to the variable.
+  bool written{false};
+};
+
+/**
+ * @brief One recorded and optimized iteration of a loop.
+ */
+struct Trace {
+  std::vector<TraceSlot> slots;
+  std::vector<TraceInstruction> instructions;
+};
+
+/**
+ * @brief A trace-recording JIT for `while` (and `for`) loops.
+ *
+ * Once a loop header gets hot, the recorder walks one iteration of the loop
+ * with the variables' current values and emits the path it takes as a linear
+ * trace: branches become guards, variables defined inside the body become
+ * plain values, and outer variables become slots that are loaded at the top
+ * and stored at the bottom of the iteration. The trace is then optimized
+ * (load forwarding, constant folding, common subexpression elimination) and
+ * compiled to a native loop over unboxed integers.
+ *
+ * Type guards are hoisted out of the loop: slot types are checked once when
+ * the trace is entered and the recorder only accepts traces that keep them
+ * stable. Since stores happen at the end of the iteration, a side exit leaves
+ * every outer variable as it was at the top of the iteration, so it can fall
+ * through to another trace of the same loop or back to the interpreter, which
+ * then simply re-runs that iteration.
+ */
+class TraceJit {
+ public:
+  /**
+   * @brief How a trace left the loop.
+   */
+  enum class Exit {
+    // The trace did not run; keep interpreting.
+    NOT_RUN,
+    // The loop condition became false; the loop is finished.
+    LOOP_DONE,
+    // A guard failed; the interpreter resumes at the top of the iteration.
+    SIDE_EXIT,
+  };
+
+  // Iterations of a loop before it is recorded in `JitMode::ON`.
+  static constexpr uint64_t kHotLoopThreshold = 50;
+
+  // Traces recorded for the different paths through one loop.
+  static constexpr size_t kMaxTracesPerLoop = 4;
+
+  // Side exits back to the interpreter after which a loop's traces are
+  // abandoned.
+  static constexpr uint64_t kMaxSideExits = 64;
+
+  explicit TraceJit(Interpreter& interpreter) : interpreter_(interpreter) {}
+
+  auto SetMode(JitMode mode) noexcept -> void { mode_ = mode; }
+
+  auto GetMode() const noexcept -> JitMode { return mode_; }
+
+  auto IsEnabled() const noexcept -> bool { return mode_ != JitMode::OFF; }
+
+  /**
+   * @brief Called at a loop's back-edge. Records and compiles the loop once
+   * it is hot, then runs its traces from the top of the next iteration. When
+   * every trace side-exits, the path the iteration takes is recorded as one
+   * more trace.
+   * @param loop The loop statement.
+   * @param environment The environment the loop runs in.
+   */
+  auto OnBackEdge(const WhileStmt& loop,
+                  const std::shared_ptr<Environment>& environment) -> Exit;
+
+  /**
+   * @brief Drops every trace. The traces are keyed by AST node, so they must
+   * not outlive the program they were recorded for.
+   */
+  auto Clear() noexcept -> void { loops_.clear(); }
+
+  /**
+   * @brief Drops the traces of `loop`, whose statement is about to be
+   * destroyed.
+   */
+  auto Forget(const WhileStmt& loop) noexcept -> void { loops_.erase(&loop); }
+
+ private:
+  struct LoopProfile {
+    enum class State { COLD, COMPILED, FAILED };
+
+    uint64_t iterations{0};
+    uint64_t side_exits{0};
+    State state{State::COLD};
+    // The union of the traces' slots, in the order the code expects them.
+    std::vector<TraceSlot> slots;
+    std::vector<Trace> traces;
+    std::unique_ptr<ExecutableMemory> code;
+    int64_t (*entry)(int64_t* slots){nullptr};
+  };
+
+  auto Record(const WhileStmt& loop,
+              const std::shared_ptr<Environment>& environment,
+              LoopProfile& profile) -> void;
+
+  auto Run(LoopProfile& profile,
+           const std::shared_ptr<Environment>& environment) -> Exit;
+
+  auto RecordSideExit(LoopProfile& profile) noexcept -> void;
+
+  Interpreter& interpreter_;
+  JitMode mode_{JitMode::OFF};
+  std::unordered_map<const WhileStmt*, LoopProfile> loops_;
+};
+}  // namespace cclox
+
+#endif  // TRACE_JIT_H_
@@ -0,0 +1,108 @@
+#ifndef VM_H_
+#define VM_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#include "bytecode.h"
+#include "object.h"
+#include "stmt.h"
+
+// Dispatches with computed gotos (the "labels as values" extension) where the
+// compiler supports it, and with a `switch` otherwise.
+#ifndef CCLOX_THREADED_DISPATCH
+#if defined(__GNUC__) || defined(__clang__)
+#define CCLOX_THREADED_DISPATCH 1
+#else
+#define CCLOX_THREADED_DISPATCH 0
+#endif
+#endif
+
+namespace cclox {
+class Environment;
+class Interpreter;
+
+/**
+ * @brief Runs Lox functions on the stack bytecode of `BytecodeCompiler`.
+ *
+ * On its first call, a function is compiled to a `bytecode::Chunk` and cached
+ * by declaration. The dispatch loop is direct-threaded: before a chunk first
+ * runs, every instruction is given the address of its handler, and each
+ * handler ends by jumping to the next instruction's handler, so there is no
+ * central `switch` and every handler has its own indirect branch to predict.
+ * Functions the compiler does not support, and initializers, stay in the
+ * tree-walking interpreter.
+ *
+ * With profiling enabled, functions are compiled without superinstructions
+ * and the VM counts how often each opcode follows another. The most frequent
+ * pairs are the candidates for new superinstructions.
+ */
+class Vm {
+ public:
+  explicit Vm(Interpreter& interpreter) : interpreter_(interpreter) {}
+
+  auto SetEnabled(bool enabled) noexcept -> void { enabled_ = enabled; }
+
+  auto IsEnabled() const noexcept -> bool { return enabled_; }
+
+  auto SetProfileEnabled(bool enabled) noexcept -> void { profile_ = enabled; }
+
+  /**
+   * @brief Prints the bytecode of every function to `dump` when it is
+   * compiled. `nullptr` disables dumping.
+   */
+  auto SetDumpStream(std::ostream* dump) noexcept -> void { dump_ = dump; }
+
+  /**
+   * @brief Runs a call of the function declared by `declaration` on its
+   * bytecode.
+   * @return The call's result, or `std::nullopt` if the function cannot be
+   * compiled and the caller must interpret it.
+   */
+  auto TryCall(const FunctionStmt& declaration,
+               const std::shared_ptr<Environment>& closure,
+               const std::vector<Object>& arguments) -> std::optional<Object>;
+
+  /**
+   * @brief Prints the `count` most frequent pairs of consecutive opcodes
+   * executed while profiling, with their share of all pairs.
+   */
+  auto PrintProfile(std::ostream& output, size_t count = 20) const -> void;
+
+  /**
+   * @brief Drops every compiled function. They are keyed by AST node, so they
+   * must not outlive the program they were compiled from.
+   */
+  auto Clear() noexcept -> void { chunks_.clear(); }
+
+ private:
+  /**
+   * @return The function's bytecode, or `nullptr` if it is not supported.
+   */
+  auto Compile(const FunctionStmt& declaration) -> bytecode::Chunk*;
+
+  template <bool kProfile>
+  auto Run(bytecode::Chunk& chunk, const std::shared_ptr<Environment>& closure,
+           const std::vector<Object>& arguments) -> Object;
+
+  using PairCounts = std::array<std::array<uint64_t, bytecode::kOpCodeCount>,
+                                bytecode::kOpCodeCount>;
+
+  Interpreter& interpreter_;
+  bool enabled_{false};
+  bool profile_{false};
+  std::ostream* dump_{nullptr};
+  // `std::nullopt` marks functions the compiler rejected.
+  std::unordered_map<const FunctionStmt*, std::optional<bytecode::Chunk>>
+      chunks_;
+  // How often the second opcode ran right after the first, when profiling.
+  std::unique_ptr<PairCounts> pairs_{std::make_unique<PairCounts>()};
+};
+}  // namespace cclox
+
+#endif  // VM_H_
@@ -0,0 +1,89 @@
+#ifndef VM_OPERATORS_H_
+#define VM_OPERATORS_H_
+
+#include <cstdint>
+#include <variant>
+
+#include "bytecode.h"
+#include "interpreter.h"
+#include "object.h"
+
+// The operators shared by the bytecode VMs, named after the stack bytecode's
+// opcodes. Included by their translation units only.
+namespace cclox {
+/**
+ * @brief Adds, subtracts or multiplies with the interpreter's semantics,
+ * without leaving the VM for two integers that do not overflow.
+ */
+template <bytecode::OpCode kOpCode>
+inline auto Arithmetic(const Object& left, const Token& op, const Object& right)
+    -> Object {
+  const auto* left_int = std::get_if<int32_t>(&left.Value());
+  const auto* right_int = std::get_if<int32_t>(&right.Value());
+  if (left_int != nullptr && right_int != nullptr) {
+    int32_t result = 0;
+    bool overflow = false;
+    if constexpr (kOpCode == bytecode::OpCode::ADD) {
+      overflow = __builtin_add_overflow(*left_int, *right_int, &result);
+    } else if constexpr (kOpCode == bytecode::OpCode::SUBTRACT) {
+      overflow = __builtin_sub_overflow(*left_int, *right_int, &result);
+    } else {
+      overflow = __builtin_mul_overflow(*left_int, *right_int, &result);
+    }
+    if (!overflow) {
+      return Object{result};
+    }
+  }
+  if constexpr (kOpCode == bytecode::OpCode::ADD) {
+    return Interpreter::Add(left, op, right);
+  } else if constexpr (kOpCode == bytecode::OpCode::SUBTRACT) {
+    return Interpreter::Subtract(left, op, right);
+  } else {
+    return Interpreter::Multiply(left, op, right);
+  }
+}
+
+/**
+ * @brief Compares with the interpreter's semantics, without leaving the VM
+ * for two integers.
+ */
+template <bytecode::OpCode kOpCode>
+inline auto Compare(const Object& left, const Token& op, const Object& right)
+    -> bool {
+  using enum bytecode::OpCode;
+  const auto* left_int = std::get_if<int32_t>(&left.Value());
+  const auto* right_int = std::get_if<int32_t>(&right.Value());
+  if (left_int != nullptr && right_int != nullptr) {
+    int32_t a = *left_int;
+    int32_t b = *right_int;
+    if constexpr (kOpCode == EQUAL) {
+      return a == b;
+    } else if constexpr (kOpCode == NOT_EQUAL) {
+      return a != b;
+    } else if constexpr (kOpCode == LESS) {
+      return a < b;
+    } else if constexpr (kOpCode == LESS_EQUAL) {
+      return a <= b;
+    } else if constexpr (kOpCode == GREATER) {
+      return a > b;
+    } else {
+      return a >= b;
+    }
+  }
+  if constexpr (kOpCode == EQUAL) {
+    return Interpreter::Equal(left, right);
+  } else if constexpr (kOpCode == NOT_EQUAL) {
+    return !Interpreter::Equal(left, right);
+  } else if constexpr (kOpCode == LESS) {
+    return Interpreter::Less(left, op, right);
+  } else if constexpr (kOpCode == LESS_EQUAL) {
+    return !Interpreter::Greater(left, op, right);
+  } else if constexpr (kOpCode == GREATER) {
+    return Interpreter::Greater(left, op, right);
+  } else {
+    return !Interpreter::Less(left, op, right);
+  }
+}
+}  // namespace cclox
+
+#endif  // VM_OPERATORS_H_
@@ -0,0 +1,175 @@
+#ifndef X64_ASSEMBLER_H_
+#define X64_ASSEMBLER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace cclox {
+// clang-format off
+/**
+ * @brief General-purpose x86-64 registers, numbered as in their ModRM/REX
+ * encoding.
+ */
+enum class Reg : uint8_t {
+  RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+  R8, R9, R10, R11, R12, R13, R14, R15,
+};
+
+/**
+ * @brief Condition codes used by `Jcc` and `SETcc`.
+ */
+enum class Cond : uint8_t {
+  O = 0x0, NO = 0x1, B = 0x2, AE = 0x3, E = 0x4, NE = 0x5, BE = 0x6, A = 0x7,
+  S = 0x8, NS = 0x9, L = 0xC, GE = 0xD, LE = 0xE, G = 0xF,
+};
+// clang-format on
+
+/**
+ * @brief A position in the code buffer that jumps can target before it is
+ * bound.
+ */
+class Label {
+ public:
+  auto IsBound() const noexcept -> bool { return position_ >= 0; }
+
+ private:
+  friend class X64Assembler;
+
+  // Offset of the label in the code buffer, or -1 if not bound yet.
+  int64_t position_{-1};
+  // Offsets of rel32 fields that must be patched once the label is bound.
+  std::vector<size_t> fixups_;
+};
+
+/**
+ * @brief A minimal x86-64 assembler that emits the handful of instructions the
+ * JIT tiers need. 32-bit arithmetic is used for Lox integers, 64-bit moves for
+ * pointers and spill slots. All memory operands are `[base + disp32]`.
+ */
+class X64Assembler {
+ public:
+  auto Code() const noexcept -> const std::vector<uint8_t>& { return code_; }
+
+  auto Size() const noexcept -> size_t { return code_.size(); }
+
+  auto Bind(Label& label) -> void;
+
+  auto Push(Reg reg) -> void;
+
+  auto Pop(Reg reg) -> void;
+
+  auto Ret() -> void;
+
+  // ====================Data movement====================
+  auto MovRR64(Reg dst, Reg src) -> void;
+
+  auto MovRI32(Reg dst, int32_t imm) -> void;
+
+  auto MovRI64(Reg dst, uint64_t imm) -> void;
+
+  auto Load32(Reg dst, Reg base, int32_t disp) -> void;
+
+  auto Store32(Reg base, int32_t disp, Reg src) -> void;
+
+  auto Load64(Reg dst, Reg base, int32_t disp) -> void;
+
+  auto Store64(Reg base, int32_t disp, Reg src) -> void;
+
+  auto Lea(Reg dst, Reg base, int32_t disp) -> void;
+
+  auto Movsxd(Reg dst, Reg src) -> void;
+
+  /**
+   * @brief Emits `sub rsp, imm32` and returns the offset of the immediate so
+   * the frame size can be patched once it is known.
+   */
+  auto SubRspImm32() -> size_t;
+
+  auto PatchImm32(size_t offset, int32_t value) -> void;
+
+  // ====================32-bit arithmetic====================
+  auto Add32(Reg dst, Reg src) -> void;
+
+  auto Sub32(Reg dst, Reg src) -> void;
+
+  auto Imul32(Reg dst, Reg src) -> void;
+
+  auto Neg32(Reg reg) -> void;
+
+  auto Xor32(Reg dst, Reg src) -> void;
+
+  auto XorImm32(Reg dst, int32_t imm) -> void;
+
+  auto Cmp32(Reg lhs, Reg rhs) -> void;
+
+  auto CmpImm32(Reg lhs, int32_t imm) -> void;
+
+  auto Test32(Reg lhs, Reg rhs) -> void;
+
+  /**
+   * @brief Sign-extends eax into edx (`cdq`), as required before `idiv`.
+   */
+  auto Cdq() -> void;
+
+  auto Idiv32(Reg divisor) -> void;
+
+  /**
+   * @brief Materializes a condition as 0 or 1 in the 32-bit register.
+   */
+  auto SetCC(Cond cond, Reg dst) -> void;
+
+  // ====================Control flow====================
+  auto Jmp(Label& label) -> void;
+
+  auto Jcc(Cond cond, Label& label) -> void;
+
+  auto CallR(Reg target) -> void;
+
+ private:
+  auto Emit8(uint8_t byte) -> void;
+
+  auto Emit32(uint32_t value) -> void;
+
+  auto EmitRex(bool wide, Reg reg, Reg rm) -> void;
+
+  auto EmitModRM(uint8_t mod, uint8_t reg, uint8_t rm) -> void;
+
+  auto EmitMem(Reg reg, Reg base, int32_t disp) -> void;
+
+  auto EmitRR(uint8_t opcode, Reg reg, Reg rm, bool wide) -> void;
+
+  auto EmitRel32(Label& label) -> void;
+
+  std::vector<uint8_t> code_;
+};
+
+/**
+ * @brief A page-aligned block of executable memory obtained with `mmap`. The
+ * code is copied in while the mapping is writable, then the mapping is flipped
+ * to read+execute so no page is ever writable and executable at once.
+ */
+class ExecutableMemory {
+ public:
+  explicit ExecutableMemory(const std::vector<uint8_t>& code);
+
+  ExecutableMemory(const ExecutableMemory&) = delete;
+
+  auto operator=(const ExecutableMemory&) -> ExecutableMemory& = delete;
+
+  ~ExecutableMemory();
+
+  /**
+   * @brief Returns whether the mapping succeeded.
+   */
+  auto IsValid() const noexcept -> bool { return memory_ != nullptr; }
+
+  auto Entry() const noexcept -> const void* { return memory_; }
+
+ private:
+  void* memory_{nullptr};
+  size_t size_{0};
+};
+}  // namespace cclox
+
+#endif  // X64_ASSEMBLER_H_
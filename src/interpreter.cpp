@@ -1,53 +1,480 @@
 #include "interpreter.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <filesystem>
 #include <optional>
 #include <ostream>
 #include <stdexcept>
+#include <thread>
+#include <utility>
 #include <variant>
 
 #include "environment.h"
+#include "event_loop.h"
 #include "expr.h"
 #include "lox.h"
 #include "lox_callable.h"
+#include "lox_channel.h"
 #include "lox_class.h"
 #include "lox_function.h"
 #include "lox_instance.h"
+#include "module_cache.h"
+#include "native_async_functions.h"
+#include "native_channel_functions.h"
 #include "native_clock_function.h"
+#include "native_freeze_function.h"
+#include "native_import_function.h"
+#include "native_list_functions.h"
+#include "native_task_functions.h"
 #include "object.h"
 #include "return.h"
 #include "stmt.h"
+#include "task_scheduler.h"
 #include "token.h"
 #include "token_type.h"
 
 namespace cclox {
+namespace {
+// Where errors in the waits that end a run are reported, as no statement is
+// running then; calls from the host report theirs the same way.
+auto EndOfRun() -> Token {
+  return Token{TokenType::EoF, "", std::nullopt, 0};
+}
+}  // namespace
+
 Interpreter::Interpreter() {
   DefineNativeFunctions();
+  natives_ = globals_->GetValues();
 }
 
 Interpreter::Interpreter(std::ostream& output) : output_(output) {
   DefineNativeFunctions();
+  natives_ = globals_->GetValues();
+}
+
+Interpreter::Interpreter(std::ostream& output, Interpreter& root)
+    : locals_(root.locals_), output_(output), root_(&root) {
+  jit_.SetMode(root.jit_.GetMode());
+  trace_jit_.SetMode(root.trace_jit_.GetMode());
+  optimizer_.SetEnabled(root.optimizer_.IsEnabled());
+  vm_.SetEnabled(root.vm_.IsEnabled());
+  register_vm_.SetEnabled(root.register_vm_.IsEnabled());
+  DefineNativeFunctions();
+}
+
+Interpreter::~Interpreter() {
+  HeapMeter::Unbind(&fuel_);
 }
 
 auto Interpreter::Interpret(const std::vector<StmtPtr>& statements) -> void {
-  try {
-    for (const auto& statement : statements) {
-      ExecuteStatement(statement);
+  StartExecutionBudget();
+  for (const auto& statement : statements) {
+    if (!ExecuteTopLevel(statement)) {
+      return;
     }
+  }
+  EndProgram();
+}
+
+auto Interpreter::ExecuteTopLevel(const StmtPtr& statement) -> bool {
+  try {
+    ExecuteStatement(statement);
+    return true;
   } catch (const RuntimeError& error) {
-    Lox::ReportRuntimeError(output_, error);
+    AbortProgram(error);
+    return false;
   }
 }
 
+auto Interpreter::EndProgram() -> void {
+  try {
+    RunEventLoop();
+    AwaitSpawnedTasks();
+  } catch (const RuntimeError& error) {
+    AbortProgram(error);
+    return;
+  }
+  ReleaseProgram();
+}
+
 auto Interpreter::ResolveVariable(const ExprPtr& expr, uint64_t depth) -> void {
-  locals_[expr] = depth;
+  (*locals_)[expr] = depth;
+}
+
+auto Interpreter::ForgetVariables(const std::vector<ExprPtr>& exprs) -> void {
+  for (const ExprPtr& expr : exprs) {
+    locals_->erase(expr);
+  }
+}
+
+auto Interpreter::GetResolvedDepth(const ExprPtr& expr) const
+    -> std::optional<uint64_t> {
+  auto it = locals_->find(expr);
+  if (it == locals_->end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+auto Interpreter::GetGlobalEnvironment() const noexcept
+    -> const std::shared_ptr<Environment>& {
+  return globals_;
 }
 
 auto Interpreter::GetOutputStream() const -> std::ostream& {
   return output_;
 }
 
+auto Interpreter::GetJit() noexcept -> Jit& {
+  return jit_;
+}
+
+auto Interpreter::GetTraceJit() noexcept -> TraceJit& {
+  return trace_jit_;
+}
+
+auto Interpreter::GetOptimizer() noexcept -> Optimizer& {
+  return optimizer_;
+}
+
+auto Interpreter::GetVm() noexcept -> Vm& {
+  return vm_;
+}
+
+auto Interpreter::GetRegisterVm() noexcept -> RegisterVm& {
+  return register_vm_;
+}
+
+auto Interpreter::GetBackgroundCompiler() noexcept -> BackgroundCompiler& {
+  return background_compiler_;
+}
+
+auto Interpreter::SetWorkerCount(size_t count) noexcept -> void {
+  worker_count_ = count;
+}
+
+auto Interpreter::SetExecutionBudget(
+    std::optional<uint64_t> fuel,
+    std::optional<std::chrono::milliseconds> time_limit) -> void {
+  fuel_budget_ = fuel;
+  time_limit_ = time_limit;
+}
+
+auto Interpreter::SetHeapLimit(std::optional<size_t> limit) -> void {
+  heap_ = std::make_shared<HeapMeter>(limit);
+  // The globals were made before the meter, and hold what programs keep.
+  globals_->ChargeTo(heap_);
+}
+
+auto Interpreter::GetHeapUsage() const noexcept -> HeapUsage {
+  return heap_ ? heap_->GetUsage() : HeapUsage{};
+}
+
+auto Interpreter::StartExecutionBudget() -> void {
+  ExecutionLimits limits{fuel_budget_, std::nullopt};
+  if (time_limit_) {
+    limits.deadline = std::chrono::steady_clock::now() + time_limit_.value();
+  }
+  SetExecutionLimits(limits);
+}
+
+auto Interpreter::GetExecutionLimits() const noexcept -> ExecutionLimits {
+  ExecutionLimits left{fuel_reserve_, deadline_};
+  if (left.fuel) {
+    // What is left of the current slice counts too.
+    left.fuel = left.fuel.value() +
+                static_cast<uint64_t>(std::max<int64_t>(fuel_, 0));
+  }
+  return left;
+}
+
+auto Interpreter::SetExecutionLimits(const ExecutionLimits& limits) noexcept
+    -> void {
+  fuel_reserve_ = limits.fuel;
+  deadline_ = limits.deadline;
+  const std::shared_ptr<HeapMeter>& heap = root_->heap_;
+  // The code that runs next runs on this thread.
+  HeapMeter::Bind(heap, &fuel_);
+  metered_ = limits.fuel || limits.deadline || (heap && heap->GetLimit());
+  // A metered run takes its first slice on its first charge.
+  fuel_ = metered_ ? 0 : std::numeric_limits<int64_t>::max();
+}
+
+auto Interpreter::GetTaskScheduler() -> TaskScheduler& {
+  if (root_ != this) {
+    return root_->GetTaskScheduler();
+  }
+  if (!scheduler_) {
+    size_t count = worker_count_;
+    if (count == 0) {
+      count = std::max(std::thread::hardware_concurrency(), 1U);
+    }
+    scheduler_ = std::make_unique<TaskScheduler>(*this, count);
+  }
+  return *scheduler_;
+}
+
+auto Interpreter::AddSpawnedTask(std::shared_ptr<LoxFuture> future) -> void {
+  spawned_.push_back(std::move(future));
+}
+
+auto Interpreter::AwaitSpawnedTasks() -> void {
+  std::vector<std::shared_ptr<LoxFuture>> spawned = std::exchange(spawned_, {});
+  std::optional<RuntimeError> failure;
+  for (const auto& future : spawned) {
+    try {
+      future->Await(*this);
+    } catch (const RuntimeError& error) {
+      if (!failure) {
+        failure = error;
+      }
+    } catch (const NativeError& error) {
+      // The deadline passed. The task still runs, and is discarded with the
+      // program.
+      spawned_.push_back(future);
+      if (!failure) {
+        failure = RuntimeError(EndOfRun(), error.what());
+      }
+    }
+  }
+  if (failure) {
+    throw failure.value();
+  }
+}
+
+auto Interpreter::DiscardSpawnedTasks() noexcept -> void {
+  std::vector<std::shared_ptr<LoxFuture>> spawned = std::exchange(spawned_, {});
+  if (spawned.empty()) {
+    return;
+  }
+  TaskScheduler& scheduler = GetTaskScheduler();
+  // Once the program fails, nothing sends to, receives from or closes the
+  // channels its tasks wait for, so the waits are cancelled. A task discards
+  // its own tasks when it fails, which finish on their own; the root cancels
+  // them all, as it ends the whole program.
+  if (root_ == this) {
+    scheduler.Cancel();
+    LoxChannel::NotifyChange();
+  }
+  for (const auto& future : spawned) {
+    scheduler.Wait(*future);
+  }
+  if (root_ == this) {
+    scheduler.Resume();
+  }
+}
+
+auto Interpreter::AddLazyFunction(FunctionStmt& function) -> void {
+  lazy_functions_.push_back(&function);
+}
+
+auto Interpreter::CompileLazyBodies() -> void {
+  // Tasks only start once every body is compiled.
+  if (root_ != this) {
+    return;
+  }
+  // Those of functions declared in bodies compiled here are appended as this
+  // goes.
+  for (size_t i = 0; i < lazy_functions_.size(); i++) {
+    if (!lazy_functions_[i]->IsBodyParsed()) {
+      CompileLazyBody(*lazy_functions_[i]);
+    }
+  }
+  lazy_functions_.clear();
+}
+
+auto Interpreter::CompileLazyBody(FunctionStmt& function) -> void {
+  // Background compiles read bodies and resolutions while they run.
+  background_compiler_.Stop();
+  if (!Lox::CompileLazyBody(*this, function)) {
+    const Token& name = function.GetFunctionName();
+    throw RuntimeError(
+        name, std::format("Can't compile function '{}'.", name.GetLexeme()));
+  }
+}
+
+auto Interpreter::ImportModule(const std::string& path) -> Object {
+  if (root_ != this) {
+    throw NativeError("Can't import a module in a task.");
+  }
+  std::error_code error;
+  std::filesystem::path canonical = std::filesystem::canonical(path, error);
+  if (error) {
+    throw NativeError(std::format("Can't open module '{}'.", path));
+  }
+  auto [it, inserted] = modules_.try_emplace(canonical.string());
+  // Unlike `it`, stays valid while the module imports others.
+  std::optional<Object>& namespace_object = it->second;
+  if (!inserted) {
+    if (!namespace_object) {
+      throw NativeError(std::format("Module '{}' imports itself.", path));
+    }
+    return namespace_object.value();
+  }
+
+  try {
+    std::shared_ptr<const Module> module =
+        ModuleCache::Load(canonical, output_);
+    if (!module) {
+      throw NativeError(std::format("Can't compile module '{}'.", path));
+    }
+    // Tasks and background compiles read resolutions while they run.
+    if (std::ranges::any_of(spawned_, [](const auto& future) {
+          return !future->IsDone();
+        })) {
+      throw NativeError("Can't import a module while tasks run.");
+    }
+    background_compiler_.Stop();
+    if (!Lox::ResolveModule(*this, module->statements)) {
+      throw NativeError(std::format("Can't compile module '{}'.", path));
+    }
+    imported_.push_back(module);
+    // Its functions compile while it runs, so that they are ready by their
+    // first calls. Initializers are never compiled.
+    for (const StmtPtr& statement : module->statements) {
+      if (const auto* function = std::get_if<FunctionStmtPtr>(&statement)) {
+        optimizer_.Precompile(**function);
+      } else if (const auto* klass = std::get_if<ClassStmtPtr>(&statement)) {
+        for (const StmtPtr& method : (*klass)->GetClassMethods()) {
+          const FunctionStmt& declaration = *std::get<FunctionStmtPtr>(method);
+          if (declaration.GetFunctionName().GetLexeme() != "init") {
+            optimizer_.Precompile(declaration);
+          }
+        }
+      }
+    }
+
+    std::shared_ptr<Environment> environment = Environment::Create(globals_);
+    ExecuteBlockStatement(module->statements, environment);
+
+    auto klass = std::make_shared<LoxClass>(
+        canonical.stem().string(), std::nullopt, LoxClass::MethodMap{});
+    LoxInstancePtr exports = LoxInstance::Create(std::move(klass));
+    for (const auto& [name, value] : environment->GetValues()) {
+      exports->SetField(Token{TokenType::IDENTIFIER, name, std::nullopt, 0},
+                        value);
+    }
+    exports->Freeze();
+    namespace_object = Object{std::move(exports)};
+    return namespace_object.value();
+  } catch (...) {
+    // A later import tries again.
+    modules_.erase(canonical.string());
+    throw;
+  }
+}
+
+auto Interpreter::GetEventLoop() -> EventLoop& {
+  if (!event_loop_) {
+    event_loop_ = std::make_unique<EventLoop>(*this);
+  }
+  return *event_loop_;
+}
+
+auto Interpreter::RunEventLoop() -> void {
+  if (event_loop_) {
+    try {
+      event_loop_->Run();
+    } catch (const NativeError& error) {
+      throw RuntimeError(EndOfRun(), error.what());
+    }
+  }
+}
+
+auto Interpreter::CancelAsyncCalls() noexcept -> void {
+  if (event_loop_) {
+    event_loop_->Cancel();
+  }
+}
+
+auto Interpreter::CallFromHost(const Object& callee,
+                               const std::vector<Object>& arguments)
+    -> Object {
+  const Token paren{TokenType::RIGHT_PAREN, ")", std::nullopt, 0};
+  StartExecutionBudget();
+  try {
+    Object result = Call(callee, arguments, paren);
+    LoxCallablePtr callable = result.AsLoxCallable().value_or(nullptr);
+    if (std::dynamic_pointer_cast<LoxPromise>(callable)) {
+      // Calling a promise awaits it.
+      result = Call(result, {}, paren);
+    }
+    RunEventLoop();
+    AwaitSpawnedTasks();
+    SetExecutionLimits({});
+    return result;
+  } catch (const RuntimeError&) {
+    CancelAsyncCalls();
+    DiscardSpawnedTasks();
+    SetExecutionLimits({});
+    throw;
+  }
+}
+
+auto Interpreter::Reset() -> void {
+  ClearCompiledCode();
+  jit_.Clear();
+  environment_ = globals_;
+  globals_->Reset(natives_);
+  locals_->clear();
+  lazy_functions_.clear();
+  modules_.clear();
+  imported_.clear();
+}
+
+auto Interpreter::CopySettings(const Interpreter& other) noexcept -> void {
+  jit_.SetMode(other.jit_.GetMode());
+  trace_jit_.SetMode(other.trace_jit_.GetMode());
+  optimizer_.SetEnabled(other.optimizer_.IsEnabled());
+  optimizer_.SetBackgroundCompileEnabled(
+      other.optimizer_.IsBackgroundCompileEnabled());
+  vm_.SetEnabled(other.vm_.IsEnabled());
+  register_vm_.SetEnabled(other.register_vm_.IsEnabled());
+  worker_count_ = other.worker_count_;
+  fuel_budget_ = other.fuel_budget_;
+  time_limit_ = other.time_limit_;
+  if (other.heap_) {
+    SetHeapLimit(other.heap_->GetLimit());
+  }
+}
+
+auto Interpreter::StopThreads() -> void {
+  scheduler_.reset();
+  background_compiler_.Stop();
+}
+
+auto Interpreter::SwapExecutionState(ExecutionState& state) noexcept -> void {
+  std::swap(environment_, state.environment);
+  state.active_profile = jit_.SwapActiveProfile(state.active_profile);
+}
+
+auto Interpreter::ClearCompiledCode() noexcept -> void {
+  trace_jit_.Clear();
+  optimizer_.Clear();
+  vm_.Clear();
+  register_vm_.Clear();
+}
+
+auto Interpreter::ForgetLoops(const StmtPtr& stmt) noexcept -> void {
+  if (const auto* block = std::get_if<BlockStmtPtr>(&stmt)) {
+    for (const StmtPtr& statement : (*block)->GetStatements()) {
+      ForgetLoops(statement);
+    }
+  } else if (const auto* if_stmt = std::get_if<IfStmtPtr>(&stmt)) {
+    ForgetLoops((*if_stmt)->GetThenBranch());
+    if (const std::optional<StmtPtr>& else_branch =
+            (*if_stmt)->GetElseBranch()) {
+      ForgetLoops(else_branch.value());
+    }
+  } else if (const auto* while_stmt = std::get_if<WhileStmtPtr>(&stmt)) {
+    trace_jit_.Forget(**while_stmt);
+    optimizer_.ForgetLoop(**while_stmt);
+    ForgetLoops((*while_stmt)->GetBody());
+  }
+}
+
 // ====================Methods to handle statement====================
 auto Interpreter::ExecuteStatement(const StmtPtr& stmt) -> void {
   std::visit(*this, stmt);
@@ -90,6 +517,10 @@ auto Interpreter::operator()(const ClassStmtPtr& stmt) -> void {
     const bool is_initializer = method_name == "init";
     auto function =
         std::make_shared<LoxFunction>(method, environment_, is_initializer);
+    if (jit_.IsEnabled()) {
+      // Shared by the method's bound copies.
+      function->GetJitProfile();
+    }
     methods.emplace(std::move(method_name), std::move(function));
   }
 
@@ -154,6 +585,20 @@ auto Interpreter::operator()(const VarStmtPtr& stmt) -> void {
 auto Interpreter::operator()(const WhileStmtPtr& stmt) -> void {
   while (EvaluateExpression(stmt->GetCondition()).IsTruthy()) {
     ExecuteStatement(stmt->GetBody());
+    ChargeFuel(stmt->GetKeyword());
+    if (metered_) {
+      // Compiled loops would not count fuel.
+      continue;
+    }
+    jit_.RecordBackEdge();
+    if (trace_jit_.IsEnabled() &&
+        trace_jit_.OnBackEdge(*stmt, environment_) ==
+            TraceJit::Exit::LOOP_DONE) {
+      return;
+    }
+    if (optimizer_.IsEnabled() && optimizer_.OnBackEdge(*stmt, environment_)) {
+      return;
+    }
   }
 }
 
@@ -189,8 +634,8 @@ auto Interpreter::operator()(const AssignExprPtr& expr) -> Object {
   assert(expr);
   Object value = EvaluateExpression(expr->GetValue());
 
-  if (locals_.contains(expr)) {
-    environment_->AssignAt(locals_.at(expr), expr->GetVariable(), value);
+  if (locals_->contains(expr)) {
+    environment_->AssignAt(locals_->at(expr), expr->GetVariable(), value);
   } else {
     globals_->Assign(expr->GetVariable(), value);
   }
@@ -244,20 +689,7 @@ auto Interpreter::operator()(const CallExprPtr& expr) -> Object {
     arguments.emplace_back(EvaluateExpression(argument));
   }
 
-  std::optional<LoxCallablePtr> function_opt = callee.AsLoxCallable();
-  if (!function_opt) {
-    throw RuntimeError(expr->GetParen(),
-                       "Can only call functions and classes.");
-  }
-
-  const LoxCallablePtr& function = function_opt.value();
-  if (arguments.size() != function->Arity()) {
-    throw RuntimeError(expr->GetParen(),
-                       std::format("Expected {} arguments but got {}.",
-                                   function->Arity(), arguments.size()));
-  }
-
-  return function->Call(*this, arguments);
+  return Call(callee, arguments, expr->GetParen());
 }
 
 auto Interpreter::operator()(const GetExprPtr& expr) -> Object {
@@ -311,7 +743,7 @@ auto Interpreter::operator()(const SetExprPtr& expr) -> Object {
 }
 
 auto Interpreter::operator()(const SuperExprPtr& expr) -> Object {
-  size_t distance = locals_.at(expr);
+  size_t distance = locals_->at(expr);
   Object superclass =
       environment_->GetAt(distance, Token{TokenType::SUPER, "super"});
   assert(distance > 0);
@@ -332,8 +764,7 @@ auto Interpreter::operator()(const SuperExprPtr& expr) -> Object {
   }
 
   // The generic Object `object` should contain a LoxInstance in normal cases.
-  return Object{static_pointer_cast<LoxFunction>(method)->Bind(
-      object.AsLoxInstance().value())};
+  return Object{method->Bind(object.AsLoxInstance().value())};
 }
 
 auto Interpreter::operator()(const ThisExprPtr& expr) -> Object {
@@ -365,13 +796,136 @@ auto Interpreter::operator()(const VariableExprPtr& expr) -> Object {
   return LookUpVariable(expr->GetVariable(), expr);
 }
 
+auto Interpreter::Call(const Object& callee,
+                       const std::vector<Object>& arguments, const Token& paren)
+    -> Object {
+  std::optional<LoxCallablePtr> function_opt = callee.AsLoxCallable();
+  if (!function_opt) {
+    throw RuntimeError(paren, "Can only call functions and classes.");
+  }
+
+  const LoxCallablePtr& function = function_opt.value();
+  if (function->IsVariadic()) {
+    if (arguments.size() < function->Arity()) {
+      throw RuntimeError(
+          paren, std::format("Expected at least {} arguments but got {}.",
+                             function->Arity(), arguments.size()));
+    }
+  } else if (arguments.size() != function->Arity()) {
+    throw RuntimeError(paren,
+                       std::format("Expected {} arguments but got {}.",
+                                   function->Arity(), arguments.size()));
+  }
+
+  ChargeFuel(paren);
+  try {
+    return function->Call(*this, arguments);
+  } catch (const NativeError& error) {
+    throw RuntimeError(paren, error.what());
+  }
+}
+
 // ====================Private method implementations====================
+auto Interpreter::AbortProgram(const RuntimeError& error) -> void {
+  // Reported first, as the tasks may take a while to stop.
+  Lox::ReportRuntimeError(output_, error);
+  // Async calls and tasks still running use the program too.
+  CancelAsyncCalls();
+  DiscardSpawnedTasks();
+  ReleaseProgram();
+}
+
+auto Interpreter::Refuel(const Token& token) -> void {
+  // Reading the clock once per slice keeps it out of the hot path.
+  constexpr uint64_t kDeadlineSlice = 1 << 14;
+
+  if (!metered_) {
+    fuel_ = std::numeric_limits<int64_t>::max();
+    return;
+  }
+  // Memory is only ever counted, never reclaimed on demand: it is freed as
+  // soon as nothing refers to it.
+  if (root_->heap_ && root_->heap_->IsOverLimit()) {
+    fuel_ = 0;
+    throw RuntimeError(token, "Out of memory.");
+  }
+  if (deadline_ && std::chrono::steady_clock::now() >= deadline_.value()) {
+    fuel_ = 0;
+    throw RuntimeError(token, "Time limit exceeded.");
+  }
+  uint64_t slice = deadline_ ? kDeadlineSlice
+                             : std::numeric_limits<int64_t>::max();
+  if (fuel_reserve_) {
+    if (fuel_reserve_.value() == 0) {
+      fuel_ = 0;
+      throw RuntimeError(token, "Fuel budget exhausted.");
+    }
+    slice = std::min(slice, fuel_reserve_.value());
+    fuel_reserve_ = fuel_reserve_.value() - slice;
+  }
+  // This charge takes the first unit of the slice.
+  fuel_ = static_cast<int64_t>(slice) - 1;
+}
+
+auto Interpreter::ReleaseProgram() noexcept -> void {
+  // The program's statements die after it.
+  lazy_functions_.clear();
+  SetExecutionLimits({});
+  if (!keeps_compiled_code_) {
+    ClearCompiledCode();
+  }
+  if (scheduler_) {
+    scheduler_->EndProgram();
+  }
+}
+
 auto Interpreter::DefineNativeFunctions() -> void {
   environment_->Define("clock",
                        Object{std::make_shared<NativeClockFunction>()});
+  environment_->Define("spawn",
+                       Object{std::make_shared<NativeSpawnFunction>()});
+  environment_->Define("await",
+                       Object{std::make_shared<NativeAwaitFunction>()});
+  environment_->Define("list", Object{std::make_shared<NativeListFunction>()});
+  environment_->Define("range",
+                       Object{std::make_shared<NativeRangeFunction>()});
+  environment_->Define("length",
+                       Object{std::make_shared<NativeLengthFunction>()});
+  environment_->Define("get", Object{std::make_shared<NativeGetFunction>()});
+  environment_->Define("set", Object{std::make_shared<NativeSetFunction>()});
+  environment_->Define("push", Object{std::make_shared<NativePushFunction>()});
+  environment_->Define("freeze",
+                       Object{std::make_shared<NativeFreezeFunction>()});
+  environment_->Define("parallelMap",
+                       Object{std::make_shared<NativeParallelMapFunction>()});
+  environment_->Define(
+      "parallelReduce",
+      Object{std::make_shared<NativeParallelReduceFunction>()});
+  environment_->Define("parallelFor",
+                       Object{std::make_shared<NativeParallelForFunction>()});
+  environment_->Define("channel",
+                       Object{std::make_shared<NativeChannelFunction>()});
+  environment_->Define("send", Object{std::make_shared<NativeSendFunction>()});
+  environment_->Define("recv", Object{std::make_shared<NativeRecvFunction>()});
+  environment_->Define("trySend",
+                       Object{std::make_shared<NativeTrySendFunction>()});
+  environment_->Define("tryRecv",
+                       Object{std::make_shared<NativeTryRecvFunction>()});
+  environment_->Define("close",
+                       Object{std::make_shared<NativeCloseFunction>()});
+  environment_->Define("select",
+                       Object{std::make_shared<NativeSelectFunction>()});
+  environment_->Define("async",
+                       Object{std::make_shared<NativeAsyncFunction>()});
+  environment_->Define("sleep",
+                       Object{std::make_shared<NativeSleepFunction>()});
+  environment_->Define("readFile",
+                       Object{std::make_shared<NativeReadFileFunction>()});
+  environment_->Define("import",
+                       Object{std::make_shared<NativeImportFunction>()});
 }
 
-auto Interpreter::Equal(const Object& left, const Object& right) const -> bool {
+auto Interpreter::Equal(const Object& left, const Object& right) -> bool {
   std::optional<double> left_num = left.AsDouble();
   std::optional<double> right_num = right.AsDouble();
   // Arithmetic types need special treatment since we consider 0 == 0.0.
@@ -384,19 +938,19 @@ auto Interpreter::Equal(const Object& left, const Object& right) const -> bool {
 }
 
 auto Interpreter::Greater(const Object& left, const Token& op,
-                          const Object& right) const -> bool {
+                          const Object& right) -> bool {
   auto [left_num, right_num] = GetNumberOperands(left, op, right);
   return left_num > right_num;
 }
 
 auto Interpreter::Less(const Object& left, const Token& op,
-                       const Object& right) const -> bool {
+                       const Object& right) -> bool {
   auto [left_num, right_num] = GetNumberOperands(left, op, right);
   return left_num < right_num;
 }
 
 auto Interpreter::Add(const Object& left, const Token& op,
-                      const Object& right) const -> Object {
+                      const Object& right) -> Object {
   if (left.IsString() && right.IsString()) {
     return Object(left.Get<std::string>() + right.Get<std::string>());
   }
@@ -420,7 +974,7 @@ auto Interpreter::Add(const Object& left, const Token& op,
 }
 
 auto Interpreter::Subtract(const Object& left, const Token& op,
-                           const Object& right) const -> Object {
+                           const Object& right) -> Object {
   auto [left_num, right_num] = GetNumberOperands(left, op, right);
 
   if (left.IsInteger() && right.IsInteger()) {
@@ -435,7 +989,7 @@ auto Interpreter::Subtract(const Object& left, const Token& op,
 }
 
 auto Interpreter::Divide(const Object& left, const Token& op,
-                         const Object& right) const -> Object {
+                         const Object& right) -> Object {
   auto [left_num, right_num] = GetNumberOperands(left, op, right);
 
   if (left.IsInteger() && right.IsInteger()) {
@@ -448,7 +1002,7 @@ auto Interpreter::Divide(const Object& left, const Token& op,
 }
 
 auto Interpreter::Multiply(const Object& left, const Token& op,
-                           const Object& right) const -> Object {
+                           const Object& right) -> Object {
   auto [left_num, right_num] = GetNumberOperands(left, op, right);
 
   if (left.IsInteger() && right.IsInteger()) {
@@ -462,7 +1016,7 @@ auto Interpreter::Multiply(const Object& left, const Token& op,
 }
 
 auto Interpreter::GetNumberOperands(const Object& left, const Token& op,
-                                    const Object& right) const
+                                    const Object& right)
     -> std::pair<double, double> {
   std::optional<double> left_num = left.AsDouble();
   std::optional<double> right_num = right.AsDouble();
@@ -476,8 +1030,8 @@ auto Interpreter::GetNumberOperands(const Object& left, const Token& op,
 
 auto Interpreter::LookUpVariable(const Token& variable, const ExprPtr& expr)
     -> Object {
-  if (locals_.contains(expr)) {
-    return environment_->GetAt(locals_.at(expr), variable);
+  if (locals_->contains(expr)) {
+    return environment_->GetAt(locals_->at(expr), variable);
   } else {
     return globals_->Get(variable);
   }
@@ -0,0 +1,872 @@
+#include "ir.h"
+
+#include <algorithm>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "interpreter.h"
+
+namespace cclox::ir {
+namespace {
+auto Successors(const Block& block) -> const std::vector<BlockId>& {
+  return block.instructions.back().targets;
+}
+
+auto OpcodeName(Opcode opcode) -> std::string_view {
+  using enum Opcode;
+  switch (opcode) {
+    case CONST:
+      return "const";
+    case PARAM:
+      return "param";
+    case PHI:
+      return "phi";
+    case COPY:
+      return "copy";
+    case ADD:
+      return "add";
+    case SUB:
+      return "sub";
+    case MUL:
+      return "mul";
+    case DIV:
+      return "div";
+    case NEG:
+      return "neg";
+    case NOT:
+      return "not";
+    case EQ:
+      return "eq";
+    case NE:
+      return "ne";
+    case LT:
+      return "lt";
+    case LE:
+      return "le";
+    case GT:
+      return "gt";
+    case GE:
+      return "ge";
+    case LOAD_GLOBAL:
+      return "load_global";
+    case STORE_GLOBAL:
+      return "store_global";
+    case LOAD_FREE:
+      return "load_free";
+    case STORE_FREE:
+      return "store_free";
+    case GET_PROPERTY:
+      return "get_property";
+    case CHECK_INSTANCE:
+      return "check_instance";
+    case SET_PROPERTY:
+      return "set_property";
+    case CALL:
+      return "call";
+    case IS_CALLEE:
+      return "is_callee";
+    case IS_TYPE:
+      return "is_type";
+    case ASSUME_TYPE:
+      return "assume_type";
+    case PRINT:
+      return "print";
+    case JUMP:
+      return "jump";
+    case BRANCH:
+      return "branch";
+    case RETURN:
+      return "return";
+    case DEOPT:
+      return "deopt";
+  }
+  return "?";
+}
+
+auto ValueName(ValueId value) -> std::string {
+  return std::format("v{}", value);
+}
+
+auto BlockName(BlockId block) -> std::string {
+  return std::format("b{}", block);
+}
+
+auto Describe(const Function& function, const Instruction& instruction)
+    -> std::string {
+  using enum Opcode;
+  std::string text;
+  if (instruction.result != kNoValue) {
+    text = ValueName(instruction.result);
+    if (instruction.result < function.types.size()) {
+      text += std::format(":{}", TypeName(function.types[instruction.result]));
+    }
+    text += " = ";
+  }
+  text += OpcodeName(instruction.opcode);
+
+  std::vector<std::string> arguments;
+  switch (instruction.opcode) {
+    case CONST:
+      arguments.push_back(instruction.constant.IsString()
+                              ? std::format("\"{}\"",
+                                            instruction.constant.ToString())
+                              : instruction.constant.ToString());
+      break;
+    case PARAM:
+      arguments.push_back(std::to_string(instruction.index));
+      break;
+    case LOAD_GLOBAL:
+    case STORE_GLOBAL:
+    case GET_PROPERTY:
+    case SET_PROPERTY:
+      arguments.push_back(instruction.token.GetLexeme());
+      break;
+    case LOAD_FREE:
+    case STORE_FREE:
+      arguments.push_back(std::format("{}@{}", instruction.token.GetLexeme(),
+                                      instruction.index));
+      break;
+    case IS_CALLEE:
+      arguments.push_back(instruction.constant.ToString());
+      break;
+    case IS_TYPE:
+    case ASSUME_TYPE:
+      arguments.emplace_back(TypeName(static_cast<Type>(instruction.index)));
+      break;
+    case DEOPT:
+      arguments.push_back(
+          std::format("{}:{}", instruction.token.GetLexeme(),
+                      TypeName(static_cast<Type>(instruction.index))));
+      break;
+    default:
+      break;
+  }
+  for (ValueId operand : instruction.operands) {
+    arguments.push_back(ValueName(operand));
+  }
+  for (BlockId target : instruction.targets) {
+    arguments.push_back(BlockName(target));
+  }
+
+  for (size_t i = 0; i < arguments.size(); i++) {
+    text += (i == 0 ? " " : ", ") + arguments[i];
+  }
+  if (instruction.opcode == PARAM || instruction.opcode == COPY ||
+      instruction.opcode == PHI) {
+    if (!instruction.token.GetLexeme().empty()) {
+      text += "  ; " + instruction.token.GetLexeme();
+    }
+  }
+  return text;
+}
+}  // namespace
+
+auto Join(Type left, Type right) noexcept -> Type {
+  if (left == right || right == Type::NONE) {
+    return left;
+  }
+  if (left == Type::NONE) {
+    return right;
+  }
+  if (IsNumeric(left) && IsNumeric(right)) {
+    return Type::NUMBER;
+  }
+  return Type::ANY;
+}
+
+auto IsNumeric(Type type) noexcept -> bool {
+  return type == Type::INT || type == Type::DOUBLE || type == Type::NUMBER;
+}
+
+auto TypeName(Type type) -> std::string_view {
+  using enum Type;
+  switch (type) {
+    case NONE:
+      return "none";
+    case INT:
+      return "int";
+    case DOUBLE:
+      return "double";
+    case NUMBER:
+      return "number";
+    case BOOL:
+      return "bool";
+    case STRING:
+      return "string";
+    case NIL:
+      return "nil";
+    case ANY:
+      return "any";
+  }
+  return "?";
+}
+
+auto TypeOf(const Object& value) -> Type {
+  if (value.IsInteger()) {
+    return Type::INT;
+  }
+  if (value.IsDouble()) {
+    return Type::DOUBLE;
+  }
+  if (value.IsBool()) {
+    return Type::BOOL;
+  }
+  if (value.IsString()) {
+    return Type::STRING;
+  }
+  return value.IsNil() ? Type::NIL : Type::ANY;
+}
+
+auto HasType(const Object& value, Type type) -> bool {
+  return Join(type, TypeOf(value)) == type;
+}
+
+auto Function::NewBlock() -> BlockId {
+  blocks.emplace_back();
+  return static_cast<BlockId>(blocks.size() - 1);
+}
+
+auto Function::AddEdge(BlockId from, BlockId to) -> void {
+  blocks[to].predecessors.push_back(from);
+}
+
+auto ComputeDefinitions(const Function& function) -> Definitions {
+  Definitions definitions(function.value_count, nullptr);
+  for (const Block& block : function.blocks) {
+    for (const Instruction& phi : block.phis) {
+      definitions[phi.result] = &phi;
+    }
+    for (const Instruction& instruction : block.instructions) {
+      if (instruction.result != kNoValue) {
+        definitions[instruction.result] = &instruction;
+      }
+    }
+  }
+  return definitions;
+}
+
+auto IsTerminator(Opcode opcode) noexcept -> bool {
+  return opcode == Opcode::JUMP || opcode == Opcode::BRANCH ||
+         opcode == Opcode::RETURN || opcode == Opcode::DEOPT;
+}
+
+auto IsPure(Opcode opcode) noexcept -> bool {
+  using enum Opcode;
+  switch (opcode) {
+    case CONST:
+    case PARAM:
+    case PHI:
+    case COPY:
+    case ADD:
+    case SUB:
+    case MUL:
+    case DIV:
+    case NEG:
+    case NOT:
+    case EQ:
+    case NE:
+    case LT:
+    case LE:
+    case GT:
+    case GE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+auto IsNumber(const Definitions& definitions, ValueId value) -> bool {
+  const Instruction* definition = definitions[value];
+  if (definition == nullptr) {
+    return false;
+  }
+
+  using enum Opcode;
+  switch (definition->opcode) {
+    case CONST:
+      return definition->constant.IsInteger() ||
+             definition->constant.IsDouble();
+    // These only ever produce numbers; otherwise they throw.
+    case SUB:
+    case MUL:
+    case DIV:
+    case NEG:
+      return true;
+    case ADD:
+      return IsNumber(definitions, definition->operands[0]) ||
+             IsNumber(definitions, definition->operands[1]);
+    default:
+      return false;
+  }
+}
+
+auto CanThrow(const Definitions& definitions, const Instruction& instruction)
+    -> bool {
+  using enum Opcode;
+  switch (instruction.opcode) {
+    case ADD:
+    case SUB:
+    case MUL:
+    case DIV:
+    case LT:
+    case LE:
+    case GT:
+    case GE:
+      return !IsNumber(definitions, instruction.operands[0]) ||
+             !IsNumber(definitions, instruction.operands[1]);
+    case NEG:
+      return !IsNumber(definitions, instruction.operands[0]);
+    case LOAD_GLOBAL:
+    case STORE_GLOBAL:
+    case GET_PROPERTY:
+    case CHECK_INSTANCE:
+    case CALL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+auto CanThrow(const std::vector<Type>& types, const Instruction& instruction)
+    -> bool {
+  auto numeric = [&](size_t operand) {
+    return IsNumeric(types[instruction.operands[operand]]);
+  };
+  using enum Opcode;
+  switch (instruction.opcode) {
+    case ADD:
+      return !(numeric(0) && numeric(1)) &&
+             !(types[instruction.operands[0]] == Type::STRING &&
+               types[instruction.operands[1]] == Type::STRING);
+    case SUB:
+    case MUL:
+    case DIV:
+    case LT:
+    case LE:
+    case GT:
+    case GE:
+      return !numeric(0) || !numeric(1);
+    case NEG:
+      return !numeric(0);
+    case LOAD_GLOBAL:
+    case STORE_GLOBAL:
+    case GET_PROPERTY:
+    case CHECK_INSTANCE:
+    case CALL:
+      return true;
+    default:
+      return false;
+  }
+}
+
+auto IsRemovable(const Definitions& definitions,
+                 const Instruction& instruction) -> bool {
+  return (IsPure(instruction.opcode) ||
+          instruction.opcode == Opcode::LOAD_FREE) &&
+         !CanThrow(definitions, instruction);
+}
+
+auto Evaluate(Opcode opcode, const Object& left, const Object& right,
+              const Token& token) -> Object {
+  using enum Opcode;
+  switch (opcode) {
+    case COPY:
+      return left;
+    case ADD:
+      return Interpreter::Add(left, token, right);
+    case SUB:
+      return Interpreter::Subtract(left, token, right);
+    case MUL:
+      return Interpreter::Multiply(left, token, right);
+    case DIV:
+      return Interpreter::Divide(left, token, right);
+    case NEG:
+      return Interpreter::Subtract(Object{static_cast<int32_t>(0)}, token,
+                                   left);
+    case NOT:
+      return Object{!left.IsTruthy()};
+    case EQ:
+      return Object{Interpreter::Equal(left, right)};
+    case NE:
+      return Object{!Interpreter::Equal(left, right)};
+    case LT:
+      return Object{Interpreter::Less(left, token, right)};
+    case LE:
+      return Object{!Interpreter::Greater(left, token, right)};
+    case GT:
+      return Object{Interpreter::Greater(left, token, right)};
+    case GE:
+      return Object{!Interpreter::Less(left, token, right)};
+    default:
+      break;
+  }
+  throw std::logic_error("not a pure operation");
+}
+
+auto ComputeReversePostOrder(const Function& function)
+    -> std::vector<BlockId> {
+  std::vector<BlockId> post_order;
+  std::vector<bool> visited(function.blocks.size(), false);
+  // An explicit stack of (block, next successor to visit).
+  std::vector<std::pair<BlockId, size_t>> stack{{0, 0}};
+  visited[0] = true;
+  while (!stack.empty()) {
+    auto& [block, next] = stack.back();
+    const std::vector<BlockId>& successors =
+        Successors(function.blocks[block]);
+    if (next < successors.size()) {
+      BlockId successor = successors[next++];
+      if (!visited[successor]) {
+        visited[successor] = true;
+        stack.emplace_back(successor, 0);
+      }
+    } else {
+      post_order.push_back(block);
+      stack.pop_back();
+    }
+  }
+  std::reverse(post_order.begin(), post_order.end());
+  return post_order;
+}
+
+// ====================DominatorTree====================
+// Cooper, Harvey and Kennedy, "A Simple, Fast Dominance Algorithm".
+DominatorTree::DominatorTree(const Function& function)
+    : rpo_(ComputeReversePostOrder(function)),
+      idom_(function.blocks.size(), kUnreachable),
+      children_(function.blocks.size()) {
+  std::vector<size_t> order(function.blocks.size());
+  for (size_t i = 0; i < rpo_.size(); i++) {
+    order[rpo_[i]] = i;
+  }
+
+  auto intersect = [&](BlockId a, BlockId b) {
+    while (a != b) {
+      while (order[a] > order[b]) {
+        a = idom_[a];
+      }
+      while (order[b] > order[a]) {
+        b = idom_[b];
+      }
+    }
+    return a;
+  };
+
+  idom_[0] = 0;
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (size_t i = 1; i < rpo_.size(); i++) {
+      BlockId block = rpo_[i];
+      BlockId new_idom = kUnreachable;
+      for (BlockId predecessor : function.blocks[block].predecessors) {
+        if (idom_[predecessor] == kUnreachable) {
+          continue;
+        }
+        new_idom = new_idom == kUnreachable
+                       ? predecessor
+                       : intersect(predecessor, new_idom);
+      }
+      if (idom_[block] != new_idom) {
+        idom_[block] = new_idom;
+        changed = true;
+      }
+    }
+  }
+
+  for (size_t i = 1; i < rpo_.size(); i++) {
+    children_[idom_[rpo_[i]]].push_back(rpo_[i]);
+  }
+}
+
+auto DominatorTree::Dominates(BlockId dominator, BlockId block) const
+    -> bool {
+  if (!IsReachable(block)) {
+    return false;
+  }
+  while (block != dominator) {
+    if (block == 0) {
+      return false;
+    }
+    block = idom_[block];
+  }
+  return true;
+}
+
+// ====================Transformations====================
+auto ReplaceUses(Function& function, std::vector<ValueId> replacements)
+    -> void {
+  replacements.resize(function.value_count, kNoValue);
+  auto resolve = [&](ValueId value) {
+    ValueId root = value;
+    while (replacements[root] != kNoValue) {
+      root = replacements[root];
+    }
+    // Compress the chain for later lookups.
+    while (replacements[value] != kNoValue) {
+      ValueId next = replacements[value];
+      replacements[value] = root;
+      value = next;
+    }
+    return root;
+  };
+
+  for (Block& block : function.blocks) {
+    for (Instruction& phi : block.phis) {
+      for (ValueId& operand : phi.operands) {
+        operand = resolve(operand);
+      }
+    }
+    for (Instruction& instruction : block.instructions) {
+      for (ValueId& operand : instruction.operands) {
+        operand = resolve(operand);
+      }
+    }
+  }
+}
+
+auto RemoveEdge(Function& function, BlockId from, BlockId to) -> void {
+  Block& block = function.blocks[to];
+  auto it = std::find(block.predecessors.begin(), block.predecessors.end(),
+                      from);
+  if (it == block.predecessors.end()) {
+    return;
+  }
+  auto position = it - block.predecessors.begin();
+  block.predecessors.erase(it);
+  for (Instruction& phi : block.phis) {
+    phi.operands.erase(phi.operands.begin() + position);
+  }
+}
+
+auto RemoveUnreachableBlocks(Function& function) -> bool {
+  std::vector<BlockId> rpo = ComputeReversePostOrder(function);
+  if (rpo.size() == function.blocks.size()) {
+    return false;
+  }
+
+  std::vector<bool> reachable(function.blocks.size(), false);
+  for (BlockId block : rpo) {
+    reachable[block] = true;
+  }
+  for (BlockId block = 0; block < function.blocks.size(); block++) {
+    if (reachable[block]) {
+      continue;
+    }
+    // Copy the targets: removing an edge into the block itself changes them.
+    std::vector<BlockId> successors = Successors(function.blocks[block]);
+    for (BlockId successor : successors) {
+      if (reachable[successor]) {
+        RemoveEdge(function, block, successor);
+      }
+    }
+  }
+
+  // Keep the surviving blocks in their original order.
+  std::vector<BlockId> renumbered(function.blocks.size(), 0);
+  std::vector<Block> blocks;
+  for (BlockId block = 0; block < function.blocks.size(); block++) {
+    if (reachable[block]) {
+      renumbered[block] = static_cast<BlockId>(blocks.size());
+      blocks.push_back(std::move(function.blocks[block]));
+    }
+  }
+  for (Block& block : blocks) {
+    for (BlockId& predecessor : block.predecessors) {
+      predecessor = renumbered[predecessor];
+    }
+    for (BlockId& target : block.instructions.back().targets) {
+      target = renumbered[target];
+    }
+  }
+  function.blocks = std::move(blocks);
+  return true;
+}
+
+auto MergeBlocks(Function& function) -> bool {
+  bool changed = false;
+  std::vector<ValueId> replacements(function.value_count, kNoValue);
+  for (BlockId block = 0; block < function.blocks.size(); block++) {
+    while (true) {
+      Instruction& jump = function.blocks[block].instructions.back();
+      if (jump.opcode != Opcode::JUMP || jump.targets.empty()) {
+        break;
+      }
+      BlockId successor = jump.targets[0];
+      Block& next = function.blocks[successor];
+      if (successor == 0 || successor == block ||
+          next.predecessors.size() != 1) {
+        break;
+      }
+
+      // With a single predecessor, every phi has a single operand.
+      for (const Instruction& phi : next.phis) {
+        replacements[phi.result] = phi.operands[0];
+      }
+      next.phis.clear();
+      for (BlockId target : Successors(next)) {
+        std::replace(function.blocks[target].predecessors.begin(),
+                     function.blocks[target].predecessors.end(), successor,
+                     block);
+      }
+      // The emptied block keeps a terminator without targets until it is
+      // deleted as unreachable.
+      std::vector<Instruction>& instructions =
+          function.blocks[block].instructions;
+      Instruction terminator = std::move(instructions.back());
+      terminator.targets.clear();
+      instructions.pop_back();
+      std::move(next.instructions.begin(), next.instructions.end(),
+                std::back_inserter(instructions));
+      next.instructions = {std::move(terminator)};
+      next.predecessors.clear();
+      changed = true;
+    }
+  }
+  if (changed) {
+    ReplaceUses(function, std::move(replacements));
+    RemoveUnreachableBlocks(function);
+  }
+  return changed;
+}
+
+auto InsertTypeGuard(Function& function, BlockId block, size_t position,
+                     ValueId value, Type type, const Token& name,
+                     const FrameState& state) -> BlockId {
+  BlockId rest = function.NewBlock();
+  BlockId deopt = function.NewBlock();
+  {
+    std::vector<Instruction>& instructions =
+        function.blocks[block].instructions;
+    auto split = instructions.begin() + static_cast<ptrdiff_t>(position);
+    std::vector<Instruction>& moved = function.blocks[rest].instructions;
+    moved.emplace_back();
+    std::move(split, instructions.end(), std::back_inserter(moved));
+    instructions.erase(split, instructions.end());
+  }
+  for (BlockId successor : Successors(function.blocks[rest])) {
+    std::replace(function.blocks[successor].predecessors.begin(),
+                 function.blocks[successor].predecessors.end(), block, rest);
+  }
+
+  Instruction check;
+  check.opcode = Opcode::IS_TYPE;
+  check.result = function.NewValue();
+  check.operands = {value};
+  check.token = name;
+  check.index = static_cast<uint64_t>(type);
+  Instruction branch;
+  branch.opcode = Opcode::BRANCH;
+  branch.operands = {check.result};
+  branch.targets = {rest, deopt};
+  function.blocks[block].instructions.push_back(std::move(check));
+  function.blocks[block].instructions.push_back(std::move(branch));
+  function.AddEdge(block, rest);
+  function.AddEdge(block, deopt);
+
+  // Write the frame state back before leaving.
+  for (const FrameSlot& slot : state) {
+    Instruction store;
+    store.opcode = slot.distance ? Opcode::STORE_FREE : Opcode::STORE_GLOBAL;
+    store.operands = {slot.value};
+    store.token = slot.name;
+    store.index = slot.distance.value_or(0);
+    function.blocks[deopt].instructions.push_back(std::move(store));
+  }
+  Instruction leave;
+  leave.opcode = Opcode::DEOPT;
+  leave.token = name;
+  leave.index = static_cast<uint64_t>(type);
+  function.blocks[deopt].instructions.push_back(std::move(leave));
+
+  Instruction& assume = function.blocks[rest].instructions.front();
+  assume.opcode = Opcode::ASSUME_TYPE;
+  assume.result = function.NewValue();
+  assume.operands = {value};
+  assume.token = name;
+  assume.index = static_cast<uint64_t>(type);
+  ValueId refined = assume.result;
+
+  DominatorTree dominators{function};
+  for (BlockId id = 0; id < function.blocks.size(); id++) {
+    Block& current = function.blocks[id];
+    for (Instruction& phi : current.phis) {
+      for (size_t i = 0; i < phi.operands.size(); i++) {
+        if (phi.operands[i] == value &&
+            dominators.Dominates(rest, current.predecessors[i])) {
+          phi.operands[i] = refined;
+        }
+      }
+    }
+    if (!dominators.Dominates(rest, id)) {
+      continue;
+    }
+    for (Instruction& instruction : current.instructions) {
+      if (instruction.result == refined) {
+        continue;
+      }
+      std::replace(instruction.operands.begin(), instruction.operands.end(),
+                   value, refined);
+    }
+  }
+  return rest;
+}
+
+// ====================Verify====================
+auto Verify(const Function& function) -> std::optional<std::string> {
+  if (function.blocks.empty()) {
+    return "function has no blocks";
+  }
+
+  // Where each value is defined: its block and its position in the block,
+  // counting the phis first.
+  struct Location {
+    BlockId block;
+    size_t position;
+  };
+  std::vector<std::optional<Location>> locations(function.value_count);
+  std::vector<std::vector<BlockId>> expected_predecessors(
+      function.blocks.size());
+
+  for (BlockId id = 0; id < function.blocks.size(); id++) {
+    const Block& block = function.blocks[id];
+    if (block.instructions.empty() ||
+        !IsTerminator(block.instructions.back().opcode)) {
+      return std::format("{} does not end with a terminator", BlockName(id));
+    }
+
+    size_t position = 0;
+    auto define = [&](const Instruction& instruction)
+        -> std::optional<std::string> {
+      ValueId result = instruction.result;
+      if (result == kNoValue) {
+        return std::nullopt;
+      }
+      if (result >= function.value_count) {
+        return std::format("{} is out of range", ValueName(result));
+      }
+      if (locations[result]) {
+        return std::format("{} is defined twice", ValueName(result));
+      }
+      locations[result] = Location{id, position};
+      return std::nullopt;
+    };
+
+    for (const Instruction& phi : block.phis) {
+      if (phi.opcode != Opcode::PHI) {
+        return std::format("non-phi among the phis of {}", BlockName(id));
+      }
+      if (phi.operands.size() != block.predecessors.size()) {
+        return std::format("{} has {} operands for {} predecessors",
+                           ValueName(phi.result), phi.operands.size(),
+                           block.predecessors.size());
+      }
+      if (auto error = define(phi)) {
+        return error;
+      }
+      position++;
+    }
+    for (size_t i = 0; i < block.instructions.size(); i++) {
+      const Instruction& instruction = block.instructions[i];
+      if (instruction.opcode == Opcode::PHI) {
+        return std::format("phi {} after the top of {}",
+                           ValueName(instruction.result), BlockName(id));
+      }
+      if (IsTerminator(instruction.opcode) !=
+          (i + 1 == block.instructions.size())) {
+        return std::format("misplaced terminator in {}", BlockName(id));
+      }
+      if (auto error = define(instruction)) {
+        return error;
+      }
+      position++;
+    }
+    for (BlockId target : Successors(block)) {
+      if (target >= function.blocks.size()) {
+        return std::format("{} jumps to a missing block", BlockName(id));
+      }
+      expected_predecessors[target].push_back(id);
+    }
+  }
+
+  for (BlockId id = 0; id < function.blocks.size(); id++) {
+    std::vector<BlockId> actual = function.blocks[id].predecessors;
+    std::sort(actual.begin(), actual.end());
+    std::sort(expected_predecessors[id].begin(),
+              expected_predecessors[id].end());
+    if (actual != expected_predecessors[id]) {
+      return std::format("predecessors of {} do not match its incoming edges",
+                         BlockName(id));
+    }
+  }
+
+  DominatorTree dominators{function};
+  auto check_use = [&](ValueId operand, BlockId block, size_t position)
+      -> std::optional<std::string> {
+    if (operand >= function.value_count || !locations[operand]) {
+      return std::format("{} uses undefined {}", BlockName(block),
+                         ValueName(operand));
+    }
+    const Location& definition = locations[operand].value();
+    bool dominates = definition.block == block
+                         ? definition.position < position
+                         : dominators.Dominates(definition.block, block);
+    if (!dominates) {
+      return std::format("definition of {} does not dominate its use in {}",
+                         ValueName(operand), BlockName(block));
+    }
+    return std::nullopt;
+  };
+
+  for (BlockId id : dominators.GetReversePostOrder()) {
+    const Block& block = function.blocks[id];
+    for (const Instruction& phi : block.phis) {
+      for (size_t i = 0; i < phi.operands.size(); i++) {
+        BlockId predecessor = block.predecessors[i];
+        if (!dominators.IsReachable(predecessor)) {
+          continue;
+        }
+        // The operand is used at the end of the predecessor.
+        if (auto error = check_use(phi.operands[i], predecessor,
+                                   std::numeric_limits<size_t>::max())) {
+          return error;
+        }
+      }
+    }
+    size_t position = block.phis.size();
+    for (const Instruction& instruction : block.instructions) {
+      for (ValueId operand : instruction.operands) {
+        if (auto error = check_use(operand, id, position)) {
+          return error;
+        }
+      }
+      position++;
+    }
+  }
+  return std::nullopt;
+}
+
+// ====================Dump====================
+auto Dump(const Function& function, std::ostream& output) -> void {
+  output << std::format("function {}/{}\n", function.name, function.arity);
+  for (BlockId id = 0; id < function.blocks.size(); id++) {
+    const Block& block = function.blocks[id];
+    output << BlockName(id) << ':';
+    for (size_t i = 0; i < block.predecessors.size(); i++) {
+      output << (i == 0 ? "  ; preds: " : ", ")
+             << BlockName(block.predecessors[i]);
+    }
+    output << '\n';
+    for (const Instruction& phi : block.phis) {
+      output << "  " << Describe(function, phi) << '\n';
+    }
+    for (const Instruction& instruction : block.instructions) {
+      output << "  " << Describe(function, instruction) << '\n';
+    }
+  }
+}
+}  // namespace cclox::ir
@@ -0,0 +1,642 @@
+#include "ir_builder.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+
+#include "interpreter.h"
+#include "token_type.h"
+
+namespace cclox {
+using ir::BlockId, ir::Instruction, ir::Opcode, ir::ValueId;
+
+namespace {
+/**
+ * @brief Thrown while building when the function uses a construct the IR
+ * does not handle. The function then stays in the interpreter.
+ */
+class IrUnsupported : public std::runtime_error {
+ public:
+  explicit IrUnsupported(const std::string& message)
+      : std::runtime_error(message) {}
+};
+
+auto MakeInstruction(Opcode opcode, std::vector<ValueId> operands = {},
+                     const Token& token = Token{TokenType::NIL, ""})
+    -> Instruction {
+  Instruction instruction;
+  instruction.opcode = opcode;
+  instruction.operands = std::move(operands);
+  instruction.token = token;
+  return instruction;
+}
+}  // namespace
+
+auto IrBuilder::Build(const FunctionStmt& function)
+    -> std::optional<ir::Function> {
+  // An inlined callee may not have been called yet.
+  if (!function.IsBodyParsed()) {
+    return std::nullopt;
+  }
+  Reset(function.GetFunctionName().GetLexeme(), function.GetParams().size());
+  building_loop_ = false;
+  promote_ = false;
+  try {
+    scopes_.emplace_back();
+    const std::vector<Token>& params = function.GetParams();
+    for (size_t i = 0; i < params.size(); i++) {
+      Instruction param = MakeInstruction(Opcode::PARAM, {}, params[i]);
+      param.index = i;
+      Declare(params[i], Emit(std::move(param)));
+    }
+    for (const auto& statement : function.GetBody()) {
+      BuildStatement(statement);
+    }
+  } catch (const IrUnsupported&) {
+    return std::nullopt;
+  }
+
+  // Falling off the end of a function returns nil.
+  if (!IsTerminated()) {
+    Emit(MakeInstruction(Opcode::RETURN, {EmitConstant(Object{nullptr})}),
+         false);
+  }
+  return std::move(function_);
+}
+
+auto IrBuilder::BuildLoop(const WhileStmt& loop, bool write_through,
+                          const Speculation& speculation)
+    -> std::optional<ir::Function> {
+  building_loop_ = true;
+  write_through_ = write_through;
+  // Promotion is only safe without calls; find out by building it.
+  for (bool promote : {true, false}) {
+    Reset("loop", 0);
+    promote_ = promote;
+    try {
+      BuildLoopBody(loop);
+    } catch (const IrUnsupported&) {
+      return std::nullopt;
+    }
+
+    bool calls = std::any_of(
+        function_.blocks.begin(), function_.blocks.end(),
+        [](const ir::Block& block) {
+          return std::any_of(block.instructions.begin(),
+                             block.instructions.end(),
+                             [](const Instruction& instruction) {
+                               return instruction.opcode == Opcode::CALL;
+                             });
+        });
+    if (!promote || !calls) {
+      break;
+    }
+  }
+  FinishLoop(speculation);
+  return std::move(function_);
+}
+
+// ====================Statement Visitors====================
+auto IrBuilder::operator()(const BlockStmtPtr& stmt) -> void {
+  scopes_.emplace_back();
+  for (const auto& statement : stmt->GetStatements()) {
+    BuildStatement(statement);
+  }
+  scopes_.pop_back();
+}
+
+auto IrBuilder::operator()(const ClassStmtPtr&) -> void {
+  throw IrUnsupported("class declaration");
+}
+
+auto IrBuilder::operator()(const ExprStmtPtr& stmt) -> void {
+  BuildExpression(stmt->GetExpression());
+}
+
+auto IrBuilder::operator()(const FunctionStmtPtr&) -> void {
+  throw IrUnsupported("nested function");
+}
+
+auto IrBuilder::operator()(const IfStmtPtr& stmt) -> void {
+  ValueId condition = BuildExpression(stmt->GetCondition());
+  const std::optional<StmtPtr>& else_branch_opt = stmt->GetElseBranch();
+
+  BlockId then_block = NewBlock();
+  BlockId else_block = else_branch_opt ? NewBlock() : 0;
+  BlockId merge_block = NewBlock();
+  EmitBranch(condition, then_block, else_branch_opt ? else_block : merge_block);
+
+  SealBlock(then_block);
+  current_ = then_block;
+  BuildStatement(stmt->GetThenBranch());
+  EmitJump(merge_block);
+
+  if (else_branch_opt) {
+    SealBlock(else_block);
+    current_ = else_block;
+    BuildStatement(else_branch_opt.value());
+    EmitJump(merge_block);
+  }
+
+  SealBlock(merge_block);
+  current_ = merge_block;
+}
+
+auto IrBuilder::operator()(const PrintStmtPtr& stmt) -> void {
+  Emit(MakeInstruction(Opcode::PRINT,
+                       {BuildExpression(stmt->GetExpression())}),
+       false);
+}
+
+auto IrBuilder::operator()(const ReturnStmtPtr& stmt) -> void {
+  if (building_loop_) {
+    throw IrUnsupported("return from a loop");
+  }
+  const std::optional<ExprPtr>& value_expr_opt = stmt->GetValue();
+  ValueId value = value_expr_opt ? BuildExpression(value_expr_opt.value())
+                                 : EmitConstant(Object{nullptr});
+  Emit(MakeInstruction(Opcode::RETURN, {value}, stmt->GetKeyword()), false);
+  StartUnreachableBlock();
+}
+
+auto IrBuilder::operator()(const VarStmtPtr& stmt) -> void {
+  const std::optional<ExprPtr>& initializer_opt = stmt->GetInitializer();
+  ValueId value = initializer_opt ? BuildExpression(initializer_opt.value())
+                                  : EmitConstant(Object{nullptr});
+  const Token& variable = stmt->GetVariable();
+  Declare(variable, Emit(MakeInstruction(Opcode::COPY, {value}, variable)));
+}
+
+auto IrBuilder::operator()(const WhileStmtPtr& stmt) -> void {
+  BuildLoopBody(*stmt);
+}
+
+// ====================Expression Visitors====================
+auto IrBuilder::operator()(const AssignExprPtr& expr) -> ValueId {
+  ValueId value = BuildExpression(expr->GetValue());
+  const Token& name = expr->GetVariable();
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(expr);
+  std::optional<VariableId> variable =
+      depth ? FindLocal(name.GetLexeme(), depth.value()) : std::nullopt;
+  if (!variable) {
+    StoreNonLocal(name, expr, value);
+    return value;
+  }
+
+  ValueId copy = Emit(MakeInstruction(Opcode::COPY, {value}, name));
+  WriteVariable(variable.value(), current_, copy);
+  return copy;
+}
+
+auto IrBuilder::operator()(const BinaryExprPtr& expr) -> ValueId {
+  ValueId left = BuildExpression(expr->GetLeftExpression());
+  ValueId right = BuildExpression(expr->GetRightExpression());
+
+  using enum TokenType;
+  const Token& op = expr->GetOperator();
+  Opcode opcode = Opcode::ADD;
+  switch (op.GetType()) {
+    case BANG_EQUAL:
+      opcode = Opcode::NE;
+      break;
+    case EQUAL_EQUAL:
+      opcode = Opcode::EQ;
+      break;
+    case GREATER:
+      opcode = Opcode::GT;
+      break;
+    case GREATER_EQUAL:
+      opcode = Opcode::GE;
+      break;
+    case LESS:
+      opcode = Opcode::LT;
+      break;
+    case LESS_EQUAL:
+      opcode = Opcode::LE;
+      break;
+    case MINUS:
+      opcode = Opcode::SUB;
+      break;
+    case PLUS:
+      opcode = Opcode::ADD;
+      break;
+    case SLASH:
+      opcode = Opcode::DIV;
+      break;
+    case STAR:
+      opcode = Opcode::MUL;
+      break;
+    default:
+      throw IrUnsupported("binary operator");
+  }
+  return Emit(MakeInstruction(opcode, {left, right}, op));
+}
+
+auto IrBuilder::operator()(const CallExprPtr& expr) -> ValueId {
+  std::vector<ValueId> operands{BuildExpression(expr->GetCallee())};
+  for (const auto& argument : expr->GetArguments()) {
+    operands.push_back(BuildExpression(argument));
+  }
+  return Emit(
+      MakeInstruction(Opcode::CALL, std::move(operands), expr->GetParen()));
+}
+
+auto IrBuilder::operator()(const GetExprPtr& expr) -> ValueId {
+  ValueId object = BuildExpression(expr->GetObject());
+  return Emit(
+      MakeInstruction(Opcode::GET_PROPERTY, {object}, expr->GetProperty()));
+}
+
+auto IrBuilder::operator()(const GroupingExprPtr& expr) -> ValueId {
+  return BuildExpression(expr->GetExpression());
+}
+
+auto IrBuilder::operator()(const LiteralExprPtr& expr) -> ValueId {
+  return EmitConstant(expr->GetValue());
+}
+
+auto IrBuilder::operator()(const LogicalExprPtr& expr) -> ValueId {
+  ValueId left = BuildExpression(expr->GetLeftExpression());
+  BlockId left_end = current_;
+  BlockId right_block = NewBlock();
+  BlockId merge_block = NewBlock();
+
+  // The left operand is the result when it short-circuits.
+  if (expr->GetOperator().GetType() == TokenType::OR) {
+    EmitBranch(left, merge_block, right_block);
+  } else {
+    EmitBranch(left, right_block, merge_block);
+  }
+
+  SealBlock(right_block);
+  current_ = right_block;
+  ValueId right = BuildExpression(expr->GetRightExpression());
+  EmitJump(merge_block);
+
+  SealBlock(merge_block);
+  current_ = merge_block;
+  Instruction phi = MakeInstruction(Opcode::PHI);
+  phi.result = function_.NewValue();
+  // One operand per predecessor, in the order the edges were added.
+  for (BlockId predecessor : function_.blocks[merge_block].predecessors) {
+    phi.operands.push_back(predecessor == left_end ? left : right);
+  }
+  ValueId result = phi.result;
+  function_.blocks[merge_block].phis.push_back(std::move(phi));
+  return result;
+}
+
+auto IrBuilder::operator()(const SetExprPtr& expr) -> ValueId {
+  ValueId object = BuildExpression(expr->GetObject());
+  Emit(MakeInstruction(Opcode::CHECK_INSTANCE, {object}, expr->GetProperty()),
+       false);
+  ValueId value = BuildExpression(expr->GetValue());
+  Emit(MakeInstruction(Opcode::SET_PROPERTY, {object, value},
+                       expr->GetProperty()),
+       false);
+  return value;
+}
+
+auto IrBuilder::operator()(const SuperExprPtr&) -> ValueId {
+  throw IrUnsupported("super");
+}
+
+auto IrBuilder::operator()(const ThisExprPtr& expr) -> ValueId {
+  return LoadNonLocal(expr->GetKeyword(), expr);
+}
+
+auto IrBuilder::operator()(const UnaryExprPtr& expr) -> ValueId {
+  ValueId right = BuildExpression(expr->GetRightExpression());
+  const Token& op = expr->GetOperator();
+  Opcode opcode = op.GetType() == TokenType::BANG ? Opcode::NOT : Opcode::NEG;
+  return Emit(MakeInstruction(opcode, {right}, op));
+}
+
+auto IrBuilder::operator()(const VariableExprPtr& expr) -> ValueId {
+  const Token& name = expr->GetVariable();
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(expr);
+  std::optional<VariableId> variable =
+      depth ? FindLocal(name.GetLexeme(), depth.value()) : std::nullopt;
+  if (!variable) {
+    return LoadNonLocal(name, expr);
+  }
+  return ReadVariable(variable.value(), current_);
+}
+
+// ====================Private Methods====================
+auto IrBuilder::Reset(std::string name, size_t arity) -> void {
+  function_ = ir::Function{};
+  function_.name = std::move(name);
+  function_.arity = arity;
+  scopes_.clear();
+  variables_.clear();
+  definitions_.clear();
+  sealed_.clear();
+  incomplete_phis_.clear();
+  promoted_.clear();
+  assigned_.clear();
+
+  current_ = NewBlock();
+  SealBlock(current_);
+}
+
+auto IrBuilder::BuildLoopBody(const WhileStmt& loop) -> void {
+  // The header stays unsealed until the back-edge from the body is known.
+  BlockId header = NewBlock();
+  EmitJump(header);
+
+  current_ = header;
+  ValueId condition = BuildExpression(loop.GetCondition());
+  BlockId body = NewBlock();
+  BlockId exit = NewBlock();
+  EmitBranch(condition, body, exit);
+
+  SealBlock(body);
+  current_ = body;
+  BuildStatement(loop.GetBody());
+  EmitJump(header);
+
+  SealBlock(header);
+  SealBlock(exit);
+  current_ = exit;
+}
+
+auto IrBuilder::FinishLoop(const Speculation& speculation) -> void {
+  // `BuildLoopBody` starts the loop right after the entry block.
+  constexpr BlockId kHeader = 1;
+  struct Guard {
+    ValueId value;
+    ir::Type type;
+    Token name;
+    bool every_iteration;
+  };
+  std::vector<Guard> guards;
+  ir::FrameState state;
+  for (const auto& [key, variable] : promoted_) {
+    const Token& name = variables_[variable];
+    std::optional<uint64_t> distance = key.first;
+    bool assigned = assigned_.contains(variable);
+    if (assigned && !write_through_) {
+      Instruction store =
+          MakeInstruction(distance ? Opcode::STORE_FREE : Opcode::STORE_GLOBAL,
+                          {ReadVariable(variable, current_)}, name);
+      store.index = distance.value_or(0);
+      Emit(std::move(store), false);
+      state.push_back({name, distance, ReadVariable(variable, kHeader)});
+    }
+    ir::Type type = speculation ? speculation(name, distance) : ir::Type::ANY;
+    if (type != ir::Type::ANY && type != ir::Type::NONE) {
+      guards.push_back({ReadVariable(variable, assigned ? kHeader : 0), type,
+                        name, assigned});
+    }
+  }
+  Emit(MakeInstruction(Opcode::RETURN, {EmitConstant(Object{nullptr})}),
+       false);
+
+  // The guards split blocks, so the builder's state is stale from here on.
+  BlockId preheader = 0;
+  BlockId header = kHeader;
+  for (const Guard& guard : guards) {
+    if (guard.every_iteration) {
+      header = ir::InsertTypeGuard(function_, header, 0, guard.value,
+                                   guard.type, guard.name, state);
+    } else {
+      // Nothing was assigned yet on entry.
+      preheader = ir::InsertTypeGuard(
+          function_, preheader,
+          function_.blocks[preheader].instructions.size() - 1, guard.value,
+          guard.type, guard.name, {});
+    }
+  }
+}
+
+auto IrBuilder::BuildStatement(const StmtPtr& stmt) -> void {
+  std::visit(*this, stmt);
+}
+
+auto IrBuilder::BuildExpression(const ExprPtr& expr) -> ValueId {
+  return std::visit(*this, expr);
+}
+
+auto IrBuilder::Emit(Instruction instruction, bool defines_value) -> ValueId {
+  if (defines_value) {
+    instruction.result = function_.NewValue();
+  }
+  ValueId result = instruction.result;
+  function_.blocks[current_].instructions.push_back(std::move(instruction));
+  return result;
+}
+
+auto IrBuilder::EmitConstant(Object value) -> ValueId {
+  Instruction instruction = MakeInstruction(Opcode::CONST);
+  instruction.constant = std::move(value);
+  return Emit(std::move(instruction));
+}
+
+auto IrBuilder::EmitJump(BlockId target) -> void {
+  if (IsTerminated()) {
+    return;
+  }
+  Instruction jump = MakeInstruction(Opcode::JUMP);
+  jump.targets = {target};
+  Emit(std::move(jump), false);
+  function_.AddEdge(current_, target);
+}
+
+auto IrBuilder::EmitBranch(ValueId condition, BlockId if_true,
+                           BlockId if_false) -> void {
+  Instruction branch = MakeInstruction(Opcode::BRANCH, {condition});
+  branch.targets = {if_true, if_false};
+  Emit(std::move(branch), false);
+  function_.AddEdge(current_, if_true);
+  function_.AddEdge(current_, if_false);
+}
+
+auto IrBuilder::IsTerminated() const -> bool {
+  const std::vector<Instruction>& instructions =
+      function_.blocks[current_].instructions;
+  return !instructions.empty() && ir::IsTerminator(instructions.back().opcode);
+}
+
+auto IrBuilder::StartUnreachableBlock() -> void {
+  current_ = NewBlock();
+  SealBlock(current_);
+}
+
+auto IrBuilder::NewBlock() -> BlockId {
+  definitions_.emplace_back();
+  sealed_.push_back(false);
+  incomplete_phis_.emplace_back();
+  return function_.NewBlock();
+}
+
+// ====================SSA construction====================
+auto IrBuilder::Declare(const Token& name, ValueId value) -> void {
+  VariableId variable = variables_.size();
+  variables_.push_back(name);
+  scopes_.back()[name.GetLexeme()] = variable;
+  WriteVariable(variable, current_, value);
+}
+
+auto IrBuilder::FindLocal(const std::string& name, uint64_t depth) const
+    -> std::optional<VariableId> {
+  // Deeper variables belong to enclosing functions.
+  if (depth >= scopes_.size()) {
+    return std::nullopt;
+  }
+  const auto& scope = scopes_[scopes_.size() - 1 - depth];
+  auto it = scope.find(name);
+  if (it == scope.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+auto IrBuilder::WriteVariable(VariableId variable, BlockId block,
+                              ValueId value) -> void {
+  definitions_[block][variable] = value;
+}
+
+auto IrBuilder::ReadVariable(VariableId variable, BlockId block) -> ValueId {
+  auto it = definitions_[block].find(variable);
+  if (it != definitions_[block].end()) {
+    return it->second;
+  }
+  return ReadVariableRecursive(variable, block);
+}
+
+auto IrBuilder::ReadVariableRecursive(VariableId variable, BlockId block)
+    -> ValueId {
+  const std::vector<BlockId>& predecessors =
+      function_.blocks[block].predecessors;
+  ValueId value = ir::kNoValue;
+  if (!sealed_[block]) {
+    value = NewPhi(variable, block);
+    incomplete_phis_[block][variable] = value;
+  } else if (predecessors.empty()) {
+    // Only unreachable code reads variables in a block without predecessors.
+    Instruction undefined = MakeInstruction(Opcode::CONST);
+    undefined.result = function_.NewValue();
+    value = undefined.result;
+    auto& instructions = function_.blocks[block].instructions;
+    instructions.insert(instructions.begin(), std::move(undefined));
+  } else if (predecessors.size() == 1) {
+    value = ReadVariable(variable, predecessors[0]);
+  } else {
+    value = NewPhi(variable, block);
+    // Record the phi first to break cycles through loops.
+    WriteVariable(variable, block, value);
+    AddPhiOperands(variable, block, value);
+  }
+  WriteVariable(variable, block, value);
+  return value;
+}
+
+auto IrBuilder::NewPhi(VariableId variable, BlockId block) -> ValueId {
+  Instruction phi = MakeInstruction(Opcode::PHI, {}, variables_[variable]);
+  phi.result = function_.NewValue();
+  function_.blocks[block].phis.push_back(std::move(phi));
+  return function_.blocks[block].phis.back().result;
+}
+
+auto IrBuilder::AddPhiOperands(VariableId variable, BlockId block,
+                               ValueId phi) -> void {
+  // Reading the operands can add phis to other blocks (and to this one), so
+  // look the phi up again once they are known.
+  std::vector<ValueId> operands;
+  // Copy the predecessors: reading a variable never adds edges, but it may
+  // grow `function_.blocks`' vectors.
+  std::vector<BlockId> predecessors = function_.blocks[block].predecessors;
+  for (BlockId predecessor : predecessors) {
+    operands.push_back(ReadVariable(variable, predecessor));
+  }
+  for (Instruction& instruction : function_.blocks[block].phis) {
+    if (instruction.result == phi) {
+      instruction.operands = std::move(operands);
+      return;
+    }
+  }
+}
+
+auto IrBuilder::SealBlock(BlockId block) -> void {
+  // Move the map out: completing a phi can create more incomplete phis in
+  // other (unsealed) blocks, but not in this one once it is sealed.
+  sealed_[block] = true;
+  auto incomplete = std::move(incomplete_phis_[block]);
+  incomplete_phis_[block].clear();
+  for (const auto& [variable, phi] : incomplete) {
+    AddPhiOperands(variable, block, phi);
+  }
+}
+
+auto IrBuilder::LoadNonLocal(const Token& name, const ExprPtr& expr)
+    -> ValueId {
+  if (std::optional<VariableId> promoted = FindPromoted(name, expr)) {
+    return ReadVariable(promoted.value(), current_);
+  }
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(expr);
+  if (!depth) {
+    return Emit(MakeInstruction(Opcode::LOAD_GLOBAL, {}, name));
+  }
+  Instruction load = MakeInstruction(Opcode::LOAD_FREE, {}, name);
+  // The function's own environment is the one below the closure.
+  load.index = depth.value() - scopes_.size();
+  return Emit(std::move(load));
+}
+
+auto IrBuilder::StoreNonLocal(const Token& name, const ExprPtr& expr,
+                              ValueId value) -> void {
+  if (std::optional<VariableId> promoted = FindPromoted(name, expr)) {
+    WriteVariable(promoted.value(), current_, value);
+    assigned_.insert(promoted.value());
+    if (!write_through_) {
+      return;
+    }
+  }
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(expr);
+  if (!depth) {
+    Emit(MakeInstruction(Opcode::STORE_GLOBAL, {value}, name), false);
+    return;
+  }
+  Instruction store = MakeInstruction(Opcode::STORE_FREE, {value}, name);
+  store.index = depth.value() - scopes_.size();
+  Emit(std::move(store), false);
+}
+
+auto IrBuilder::FindPromoted(const Token& name, const ExprPtr& expr)
+    -> std::optional<VariableId> {
+  if (!promote_) {
+    return std::nullopt;
+  }
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(expr);
+  std::optional<uint64_t> distance;
+  if (depth) {
+    distance = depth.value() - scopes_.size();
+  } else if (interpreter_.GetGlobalEnvironment()->Find(name.GetLexeme()) ==
+             nullptr) {
+    // Reading an undefined global throws, which must not happen early.
+    return std::nullopt;
+  }
+
+  auto key = std::pair{distance, name.GetLexeme()};
+  auto it = promoted_.find(key);
+  if (it != promoted_.end()) {
+    return it->second;
+  }
+
+  Instruction load = MakeInstruction(
+      distance ? Opcode::LOAD_FREE : Opcode::LOAD_GLOBAL, {}, name);
+  load.index = distance.value_or(0);
+  load.result = function_.NewValue();
+  // The entry block only jumps to the loop header.
+  std::vector<Instruction>& entry = function_.blocks[0].instructions;
+  entry.insert(entry.end() - 1, load);
+
+  VariableId variable = variables_.size();
+  variables_.push_back(name);
+  promoted_.emplace(std::move(key), variable);
+  WriteVariable(variable, 0, load.result);
+  return variable;
+}
+}  // namespace cclox
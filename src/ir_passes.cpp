@@ -0,0 +1,884 @@
+#include "ir_passes.h"
+
+#include <algorithm>
+#include <bit>
+#include <climits>
+#include <cstddef>
+#include <format>
+#include <iterator>
+#include <map>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "interpreter.h"
+
+namespace cclox::ir {
+namespace {
+auto IsFoldable(Opcode opcode) -> bool {
+  return IsPure(opcode) && opcode != Opcode::CONST &&
+         opcode != Opcode::PARAM && opcode != Opcode::PHI;
+}
+
+/**
+ * @brief Folds `instruction` if its operands are constants and it does not
+ * throw.
+ */
+auto Fold(const Definitions& definitions, const Instruction& instruction)
+    -> std::optional<Object> {
+  std::vector<const Object*> operands;
+  for (ValueId operand : instruction.operands) {
+    const Instruction* definition = definitions[operand];
+    if (definition == nullptr || definition->opcode != Opcode::CONST) {
+      return std::nullopt;
+    }
+    operands.push_back(&definition->constant);
+  }
+
+  const Object& left = *operands[0];
+  const Object& right = operands.size() > 1 ? *operands[1] : left;
+  // Integer division by zero (or overflowing) traps; leave it to run time.
+  if (instruction.opcode == Opcode::DIV && left.IsInteger() &&
+      right.IsInteger() &&
+      (right.Get<int32_t>() == 0 ||
+       (left.Get<int32_t>() == INT32_MIN && right.Get<int32_t>() == -1))) {
+    return std::nullopt;
+  }
+
+  try {
+    return Evaluate(instruction.opcode, left, right, instruction.token);
+  } catch (const RuntimeError&) {
+    return std::nullopt;
+  }
+}
+
+auto MakeConstant(ValueId result, Object value) -> Instruction {
+  Instruction instruction;
+  instruction.opcode = Opcode::CONST;
+  instruction.result = result;
+  instruction.constant = std::move(value);
+  return instruction;
+}
+
+/**
+ * @brief Whether two constants are the same value of the same type.
+ */
+auto IsSameConstant(const Object& left, const Object& right) -> bool {
+  return left.Value() == right.Value();
+}
+
+/**
+ * @brief Returns the one value a phi merges, ignoring the phi itself, or
+ * `kNoValue` if it merges several values.
+ */
+auto TrivialPhiValue(const Instruction& phi) -> ValueId {
+  ValueId value = kNoValue;
+  for (ValueId operand : phi.operands) {
+    if (operand == phi.result || operand == value) {
+      continue;
+    }
+    if (value != kNoValue) {
+      return kNoValue;
+    }
+    value = operand;
+  }
+  return value;
+}
+
+/**
+ * @brief A natural loop: the header and every block that reaches one of the
+ * header's back-edges without passing through it.
+ */
+struct Loop {
+  BlockId header;
+  std::vector<bool> body;
+  size_t size{0};
+};
+
+auto FindLoops(const Function& function, const DominatorTree& dominators)
+    -> std::vector<Loop> {
+  std::vector<Loop> loops;
+  for (BlockId header : dominators.GetReversePostOrder()) {
+    Loop loop{header, std::vector<bool>(function.blocks.size(), false)};
+    std::vector<BlockId> worklist;
+    for (BlockId predecessor : function.blocks[header].predecessors) {
+      if (dominators.Dominates(header, predecessor)) {
+        worklist.push_back(predecessor);
+      }
+    }
+    if (worklist.empty()) {
+      continue;
+    }
+    loop.body[header] = true;
+    loop.size = 1;
+    while (!worklist.empty()) {
+      BlockId block = worklist.back();
+      worklist.pop_back();
+      if (loop.body[block] || !dominators.IsReachable(block)) {
+        continue;
+      }
+      loop.body[block] = true;
+      loop.size++;
+      for (BlockId predecessor : function.blocks[block].predecessors) {
+        worklist.push_back(predecessor);
+      }
+    }
+    loops.push_back(std::move(loop));
+  }
+  // Inner loops first, so that their invariants can move on outwards.
+  std::sort(loops.begin(), loops.end(),
+            [](const Loop& a, const Loop& b) { return a.size < b.size; });
+  return loops;
+}
+
+/**
+ * @brief Returns the loop's preheader: the only block outside the loop that
+ * jumps to its header, and to nothing else.
+ */
+auto FindPreheader(const Function& function, const Loop& loop)
+    -> std::optional<BlockId> {
+  std::optional<BlockId> preheader;
+  for (BlockId predecessor : function.blocks[loop.header].predecessors) {
+    if (loop.body[predecessor]) {
+      continue;
+    }
+    if (preheader) {
+      return std::nullopt;
+    }
+    preheader = predecessor;
+  }
+  if (preheader &&
+      function.blocks[preheader.value()].instructions.back().opcode !=
+          Opcode::JUMP) {
+    return std::nullopt;
+  }
+  return preheader;
+}
+
+/**
+ * @brief Hoists the invariant instructions of one loop.
+ * @return Whether any instruction moved.
+ */
+auto HoistInvariants(Function& function, const DominatorTree& dominators,
+                     const Loop& loop) -> bool {
+  std::optional<BlockId> preheader = FindPreheader(function, loop);
+  if (!preheader) {
+    return false;
+  }
+
+  // Values defined inside the loop, and whether the loop writes variables
+  // of enclosing functions (calls may do so too).
+  std::vector<bool> defined_in_loop(function.value_count, false);
+  bool writes_free_variables = false;
+  for (BlockId block : dominators.GetReversePostOrder()) {
+    if (!loop.body[block]) {
+      continue;
+    }
+    for (const Instruction& phi : function.blocks[block].phis) {
+      defined_in_loop[phi.result] = true;
+    }
+    for (const Instruction& instruction :
+         function.blocks[block].instructions) {
+      if (instruction.result != kNoValue) {
+        defined_in_loop[instruction.result] = true;
+      }
+      writes_free_variables |= instruction.opcode == Opcode::STORE_FREE ||
+                               instruction.opcode == Opcode::CALL;
+    }
+  }
+
+  Definitions definitions = ComputeDefinitions(function);
+  // The positions of the instructions to hoist, in dependency order.
+  std::vector<std::pair<BlockId, size_t>> hoisted;
+  for (BlockId block : dominators.GetReversePostOrder()) {
+    if (!loop.body[block]) {
+      continue;
+    }
+    // Whether everything before the current instruction in the header stays
+    // unobservable once the hoisted instructions are gone.
+    bool at_header_top = block == loop.header;
+    const std::vector<Instruction>& instructions =
+        function.blocks[block].instructions;
+    for (size_t i = 0; i < instructions.size(); i++) {
+      const Instruction& instruction = instructions[i];
+      bool operands_invariant = std::none_of(
+          instruction.operands.begin(), instruction.operands.end(),
+          [&](ValueId operand) { return defined_in_loop[operand]; });
+      bool invariant_opcode =
+          (IsPure(instruction.opcode) && instruction.opcode != Opcode::PHI) ||
+          (instruction.opcode == Opcode::LOAD_FREE &&
+           (instruction.token.GetType() == TokenType::THIS ||
+            !writes_free_variables));
+      bool can_throw = CanThrow(definitions, instruction);
+
+      if (operands_invariant && invariant_opcode &&
+          (!can_throw || at_header_top)) {
+        hoisted.emplace_back(block, i);
+        defined_in_loop[instruction.result] = false;
+      } else if (can_throw || !IsRemovable(definitions, instruction)) {
+        at_header_top = false;
+      }
+    }
+  }
+  if (hoisted.empty()) {
+    return false;
+  }
+
+  std::vector<Instruction> moved;
+  for (const auto& [block, index] : hoisted) {
+    moved.push_back(std::move(function.blocks[block].instructions[index]));
+  }
+  // Erase from the back so the recorded positions stay valid.
+  for (auto it = hoisted.rbegin(); it != hoisted.rend(); ++it) {
+    auto& instructions = function.blocks[it->first].instructions;
+    instructions.erase(instructions.begin() +
+                       static_cast<std::ptrdiff_t>(it->second));
+  }
+  auto& destination = function.blocks[preheader.value()].instructions;
+  destination.insert(destination.end() - 1,
+                     std::make_move_iterator(moved.begin()),
+                     std::make_move_iterator(moved.end()));
+  return true;
+}
+
+// An operation and its operands, or a constant and its value.
+using ExpressionKey = std::tuple<Opcode, std::vector<ValueId>, std::string>;
+
+/**
+ * @brief Encodes a constant so that only identical values of the same type
+ * compare equal.
+ */
+auto ConstantKey(const Object& value) -> std::string {
+  if (value.IsInteger()) {
+    return std::format("i{}", value.Get<int32_t>());
+  }
+  if (value.IsDouble()) {
+    return std::format("d{}", std::bit_cast<uint64_t>(value.Get<double>()));
+  }
+  if (value.IsBool()) {
+    return value.Get<bool>() ? "true" : "false";
+  }
+  if (value.IsString()) {
+    return "s" + value.Get<std::string>();
+  }
+  return "nil";
+}
+
+/**
+ * @brief Numbers the values of the blocks dominated by `block`.
+ */
+auto NumberValues(Function& function, const DominatorTree& dominators,
+                  BlockId block, std::map<ExpressionKey, ValueId>& available,
+                  std::vector<ValueId>& replacements) -> bool {
+  bool changed = false;
+  std::vector<ExpressionKey> added;
+  auto resolve = [&](ValueId value) {
+    while (replacements[value] != kNoValue) {
+      value = replacements[value];
+    }
+    return value;
+  };
+
+  std::vector<Instruction>& instructions = function.blocks[block].instructions;
+  for (auto it = instructions.begin(); it != instructions.end();) {
+    for (ValueId& operand : it->operands) {
+      operand = resolve(operand);
+    }
+    bool is_constant = it->opcode == Opcode::CONST;
+    if (!is_constant &&
+        (!IsFoldable(it->opcode) || it->opcode == Opcode::COPY)) {
+      ++it;
+      continue;
+    }
+
+    ExpressionKey key{it->opcode, it->operands,
+                      is_constant ? ConstantKey(it->constant) : ""};
+    // Equality is commutative.
+    if (it->opcode == Opcode::EQ || it->opcode == Opcode::NE) {
+      std::sort(std::get<1>(key).begin(), std::get<1>(key).end());
+    }
+    auto [existing, inserted] = available.emplace(key, it->result);
+    if (inserted) {
+      added.push_back(std::move(key));
+      ++it;
+    } else {
+      replacements[it->result] = existing->second;
+      it = instructions.erase(it);
+      changed = true;
+    }
+  }
+
+  for (BlockId child : dominators.GetChildren(block)) {
+    changed |= NumberValues(function, dominators, child, available,
+                            replacements);
+  }
+
+  for (const ExpressionKey& key : added) {
+    available.erase(key);
+  }
+  return changed;
+}
+
+auto Size(const Function& function) -> size_t {
+  size_t size = 0;
+  for (const Block& block : function.blocks) {
+    size += block.phis.size() + block.instructions.size();
+  }
+  return size;
+}
+
+/**
+ * @brief Whether any instruction of `function` satisfies `predicate`.
+ */
+template <typename Predicate>
+auto AnyInstruction(const Function& function, Predicate predicate) -> bool {
+  return std::any_of(
+      function.blocks.begin(), function.blocks.end(), [&](const Block& block) {
+        return std::any_of(block.instructions.begin(),
+                           block.instructions.end(), predicate);
+      });
+}
+
+/**
+ * @brief Replaces the call at `position` in `block` with the candidate's
+ * body, guarded by a check that the callee is still the same function.
+ *
+ * The block is split after the call: it ends in a branch to a copy of the
+ * body or to a fallback block that makes the original call, and both continue
+ * in a new block where a phi merges the returned values.
+ */
+auto InlineCall(Function& function, BlockId block, size_t position,
+                const InlineCandidate& candidate) -> void {
+  const Function& body = *candidate.body;
+  Instruction call = std::move(function.blocks[block].instructions[position]);
+
+  BlockId continuation = function.NewBlock();
+  {
+    std::vector<Instruction>& instructions =
+        function.blocks[block].instructions;
+    function.blocks[continuation].instructions.assign(
+        std::make_move_iterator(instructions.begin() +
+                                static_cast<std::ptrdiff_t>(position) + 1),
+        std::make_move_iterator(instructions.end()));
+    instructions.resize(position);
+  }
+  for (BlockId successor :
+       function.blocks[continuation].instructions.back().targets) {
+    std::vector<BlockId>& predecessors =
+        function.blocks[successor].predecessors;
+    std::replace(predecessors.begin(), predecessors.end(), block,
+                 continuation);
+  }
+
+  BlockId fallback = function.NewBlock();
+  auto offset = static_cast<BlockId>(function.blocks.size());
+  ValueId value_offset = function.value_count;
+  function.value_count += body.value_count;
+
+  Instruction guard;
+  guard.opcode = Opcode::IS_CALLEE;
+  guard.result = function.NewValue();
+  guard.operands = {call.operands[0]};
+  guard.token = call.token;
+  guard.constant = candidate.callee;
+  Instruction branch;
+  branch.opcode = Opcode::BRANCH;
+  branch.operands = {guard.result};
+  branch.targets = {offset, fallback};
+  function.blocks[block].instructions.push_back(std::move(guard));
+  function.blocks[block].instructions.push_back(std::move(branch));
+  // The edge into the inlined entry is added as the body is copied.
+  function.AddEdge(block, fallback);
+
+  // The value each predecessor of the continuation returns.
+  std::vector<std::pair<BlockId, ValueId>> returns;
+  for (BlockId id = 0; id < body.blocks.size(); id++) {
+    Block copy = body.blocks[id];
+    for (Instruction& phi : copy.phis) {
+      phi.result += value_offset;
+      for (ValueId& operand : phi.operands) {
+        operand += value_offset;
+      }
+    }
+    for (Instruction& instruction : copy.instructions) {
+      if (instruction.result != kNoValue) {
+        instruction.result += value_offset;
+      }
+      for (ValueId& operand : instruction.operands) {
+        operand += value_offset;
+      }
+      for (BlockId& target : instruction.targets) {
+        target += offset;
+      }
+      if (instruction.opcode == Opcode::PARAM) {
+        instruction.opcode = Opcode::COPY;
+        instruction.operands = {call.operands[instruction.index + 1]};
+        instruction.index = 0;
+      } else if (instruction.opcode == Opcode::RETURN) {
+        returns.emplace_back(offset + id, instruction.operands[0]);
+        instruction.opcode = Opcode::JUMP;
+        instruction.operands.clear();
+        instruction.targets = {continuation};
+      }
+    }
+    for (BlockId& predecessor : copy.predecessors) {
+      predecessor += offset;
+    }
+    if (id == 0) {
+      copy.predecessors = {block};
+    }
+    function.blocks.push_back(std::move(copy));
+  }
+  for (const auto& [from, value] : returns) {
+    function.AddEdge(from, continuation);
+  }
+
+  // The fallback makes the call as before, and is never inlined itself.
+  Instruction jump;
+  jump.opcode = Opcode::JUMP;
+  jump.targets = {continuation};
+  Instruction phi;
+  phi.opcode = Opcode::PHI;
+  phi.result = call.result;
+  call.result = function.NewValue();
+  call.index = kNoInline;
+  for (const auto& [from, value] : returns) {
+    phi.operands.push_back(value);
+  }
+  phi.operands.push_back(call.result);
+  function.blocks[fallback].instructions.push_back(std::move(call));
+  function.blocks[fallback].instructions.push_back(std::move(jump));
+  function.AddEdge(fallback, continuation);
+  function.blocks[continuation].phis.push_back(std::move(phi));
+}
+/**
+ * @brief The type of an instruction's result given its operands' types.
+ */
+auto Transfer(const Instruction& instruction, const std::vector<Type>& types)
+    -> Type {
+  using enum Opcode;
+  if (instruction.opcode == PHI) {
+    // Operands flowing in over back-edges may not be known yet.
+    Type type = Type::NONE;
+    for (ValueId operand : instruction.operands) {
+      type = Join(type, types[operand]);
+    }
+    return type;
+  }
+
+  std::vector<Type> operands;
+  for (ValueId operand : instruction.operands) {
+    if (types[operand] == Type::NONE) {
+      return Type::NONE;
+    }
+    operands.push_back(types[operand]);
+  }
+
+  switch (instruction.opcode) {
+    case CONST:
+      return TypeOf(instruction.constant);
+    case ASSUME_TYPE:
+      return static_cast<Type>(instruction.index);
+    case COPY:
+      return operands[0];
+    case ADD:
+      // Two strings, or else two numbers.
+      if (operands[0] == Type::STRING || operands[1] == Type::STRING) {
+        return Type::STRING;
+      }
+      if (!IsNumeric(operands[0]) && !IsNumeric(operands[1])) {
+        return Type::ANY;
+      }
+      return operands[0] == Type::DOUBLE || operands[1] == Type::DOUBLE
+                 ? Type::DOUBLE
+                 : Type::NUMBER;
+    case SUB:
+    case MUL:
+    case DIV:
+      // Integer division never overflows: `INT32_MIN / -1` traps instead.
+      if (instruction.opcode == DIV && operands[0] == Type::INT &&
+          operands[1] == Type::INT) {
+        return Type::INT;
+      }
+      return operands[0] == Type::DOUBLE || operands[1] == Type::DOUBLE
+                 ? Type::DOUBLE
+                 : Type::NUMBER;
+    case NEG:
+      return operands[0] == Type::DOUBLE ? Type::DOUBLE : Type::NUMBER;
+    case NOT:
+    case EQ:
+    case NE:
+    case LT:
+    case LE:
+    case GT:
+    case GE:
+    case IS_CALLEE:
+    case IS_TYPE:
+      return Type::BOOL;
+    default:
+      return Type::ANY;
+  }
+}
+
+}  // namespace
+
+// ====================ConstantPropagation====================
+auto ConstantPropagation::Run(Function& function) -> bool {
+  bool changed = false;
+  bool folded = true;
+  while (folded) {
+    folded = false;
+    Definitions definitions = ComputeDefinitions(function);
+    // Instructions replaced by constants, which must not be read through
+    // `definitions` anymore.
+    std::vector<std::pair<ValueId, Object>> constants;
+
+    for (BlockId id = 0; id < function.blocks.size(); id++) {
+      Block& block = function.blocks[id];
+      for (const Instruction& phi : block.phis) {
+        ValueId value = TrivialPhiValue(phi);
+        if (value == kNoValue) {
+          std::optional<Object> constant;
+          bool same = !phi.operands.empty();
+          for (ValueId operand : phi.operands) {
+            const Instruction* definition = definitions[operand];
+            if (operand == phi.result) {
+              continue;
+            }
+            if (definition == nullptr || definition->opcode != Opcode::CONST ||
+                (constant &&
+                 !IsSameConstant(constant.value(), definition->constant))) {
+              same = false;
+              break;
+            }
+            constant = definition->constant;
+          }
+          if (same && constant) {
+            constants.emplace_back(phi.result, std::move(constant.value()));
+          }
+        }
+      }
+
+      for (Instruction& instruction : block.instructions) {
+        if (IsFoldable(instruction.opcode)) {
+          if (std::optional<Object> value = Fold(definitions, instruction)) {
+            constants.emplace_back(instruction.result, std::move(*value));
+          }
+        } else if (instruction.opcode == Opcode::BRANCH) {
+          const Instruction* condition =
+              definitions[instruction.operands[0]];
+          if (condition != nullptr && condition->opcode == Opcode::CONST) {
+            bool truthy = condition->constant.IsTruthy();
+            BlockId taken = instruction.targets[truthy ? 0 : 1];
+            BlockId not_taken = instruction.targets[truthy ? 1 : 0];
+            instruction.opcode = Opcode::JUMP;
+            instruction.operands.clear();
+            instruction.targets = {taken};
+            if (not_taken != taken) {
+              RemoveEdge(function, id, not_taken);
+            }
+            folded = true;
+          }
+        }
+      }
+    }
+
+    // Turn the folded values into constants. Phis become constants at the
+    // top of their block.
+    for (auto& [result, value] : constants) {
+      for (Block& block : function.blocks) {
+        auto phi = std::find_if(
+            block.phis.begin(), block.phis.end(),
+            [&](const Instruction& i) { return i.result == result; });
+        if (phi != block.phis.end()) {
+          block.phis.erase(phi);
+          block.instructions.insert(block.instructions.begin(),
+                                    MakeConstant(result, std::move(value)));
+          break;
+        }
+        auto instruction = std::find_if(
+            block.instructions.begin(), block.instructions.end(),
+            [&](const Instruction& i) { return i.result == result; });
+        if (instruction != block.instructions.end()) {
+          *instruction = MakeConstant(result, std::move(value));
+          break;
+        }
+      }
+      folded = true;
+    }
+
+    if (RemoveUnreachableBlocks(function)) {
+      folded = true;
+    }
+    changed |= folded;
+  }
+  return changed;
+}
+
+// ====================CopyPropagation====================
+auto CopyPropagation::Run(Function& function) -> bool {
+  bool changed = false;
+  bool replaced = true;
+  while (replaced) {
+    replaced = false;
+    std::vector<ValueId> replacements(function.value_count, kNoValue);
+    for (Block& block : function.blocks) {
+      std::erase_if(block.phis, [&](const Instruction& phi) {
+        ValueId value = TrivialPhiValue(phi);
+        if (value == kNoValue) {
+          return false;
+        }
+        replacements[phi.result] = value;
+        return true;
+      });
+      std::erase_if(block.instructions, [&](const Instruction& instruction) {
+        if (instruction.opcode != Opcode::COPY) {
+          return false;
+        }
+        replacements[instruction.result] = instruction.operands[0];
+        return true;
+      });
+    }
+    replaced = std::any_of(replacements.begin(), replacements.end(),
+                           [](ValueId value) { return value != kNoValue; });
+    if (replaced) {
+      ReplaceUses(function, std::move(replacements));
+      changed = true;
+    }
+  }
+  return changed;
+}
+
+// ====================DeadCodeElimination====================
+auto DeadCodeElimination::Run(Function& function) -> bool {
+  bool changed = RemoveUnreachableBlocks(function);
+  changed |= MergeBlocks(function);
+
+  Definitions definitions = ComputeDefinitions(function);
+  std::vector<bool> live(function.value_count, false);
+  std::vector<const Instruction*> worklist;
+  for (const Block& block : function.blocks) {
+    for (const Instruction& instruction : block.instructions) {
+      if (!IsRemovable(definitions, instruction)) {
+        worklist.push_back(&instruction);
+      }
+    }
+  }
+  while (!worklist.empty()) {
+    const Instruction* instruction = worklist.back();
+    worklist.pop_back();
+    for (ValueId operand : instruction->operands) {
+      if (!live[operand]) {
+        live[operand] = true;
+        worklist.push_back(definitions[operand]);
+      }
+    }
+  }
+
+  auto is_dead = [&](const Instruction& instruction) {
+    return instruction.result != kNoValue && !live[instruction.result] &&
+           IsRemovable(definitions, instruction);
+  };
+  // `definitions` points into the blocks, so decide before erasing.
+  std::vector<bool> dead(function.value_count, false);
+  for (const Block& block : function.blocks) {
+    for (const Instruction& phi : block.phis) {
+      dead[phi.result] = is_dead(phi);
+    }
+    for (const Instruction& instruction : block.instructions) {
+      if (instruction.result != kNoValue) {
+        dead[instruction.result] = is_dead(instruction);
+      }
+    }
+  }
+  auto erase = [&](const Instruction& instruction) {
+    return instruction.result != kNoValue && dead[instruction.result];
+  };
+  for (Block& block : function.blocks) {
+    size_t size = block.phis.size() + block.instructions.size();
+    std::erase_if(block.phis, erase);
+    std::erase_if(block.instructions, erase);
+    changed |= size != block.phis.size() + block.instructions.size();
+  }
+  return changed;
+}
+
+// ====================CommonSubexpressionElimination====================
+auto CommonSubexpressionElimination::Run(Function& function) -> bool {
+  DominatorTree dominators{function};
+  std::map<ExpressionKey, ValueId> available;
+  std::vector<ValueId> replacements(function.value_count, kNoValue);
+  bool changed =
+      NumberValues(function, dominators, 0, available, replacements);
+  if (changed) {
+    // Phis (and uses in blocks visited earlier) still need rewriting.
+    ReplaceUses(function, std::move(replacements));
+  }
+  return changed;
+}
+
+// ====================LoopInvariantCodeMotion====================
+auto LoopInvariantCodeMotion::Run(Function& function) -> bool {
+  bool changed = false;
+  DominatorTree dominators{function};
+  for (const Loop& loop : FindLoops(function, dominators)) {
+    // Hoisting moves instructions between blocks but leaves the control flow
+    // and therefore the loops and dominators intact.
+    changed |= HoistInvariants(function, dominators, loop);
+  }
+  return changed;
+}
+
+// ====================TypeInference====================
+auto TypeInference::Run(Function& function) -> bool {
+  std::vector<Type>& types = function.types;
+  types.assign(function.value_count, Type::NONE);
+  std::vector<BlockId> order = ComputeReversePostOrder(function);
+  // Types only grow, so this terminates after a few sweeps: each value's
+  // type can rise at most three times.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    auto update = [&](const Instruction& instruction) {
+      Type type =
+          Join(types[instruction.result], Transfer(instruction, types));
+      if (type != types[instruction.result]) {
+        types[instruction.result] = type;
+        changed = true;
+      }
+    };
+    for (BlockId block : order) {
+      for (const Instruction& phi : function.blocks[block].phis) {
+        update(phi);
+      }
+      for (const Instruction& instruction :
+           function.blocks[block].instructions) {
+        if (instruction.result != kNoValue) {
+          update(instruction);
+        }
+      }
+    }
+  }
+  return false;
+}
+
+// ====================Inlining====================
+auto Inlining::Run(Function& function) -> bool {
+  bool changed = false;
+  // Inlining appends the rest of the block to a new block, which the scan
+  // reaches later, along with the inlined body.
+  for (BlockId block = 0; block < function.blocks.size(); block++) {
+    Definitions definitions = ComputeDefinitions(function);
+    const std::vector<Instruction>& instructions =
+        function.blocks[block].instructions;
+    for (size_t i = 0; i < instructions.size(); i++) {
+      const Instruction& call = instructions[i];
+      if (call.opcode != Opcode::CALL || call.index == kNoInline) {
+        continue;
+      }
+      const Instruction* callee = definitions[call.operands[0]];
+      if (callee == nullptr || callee->opcode != Opcode::LOAD_GLOBAL) {
+        continue;
+      }
+      const std::string& name = callee->token.GetLexeme();
+      std::optional<InlineCandidate> candidate = lookup_(name);
+      if (!candidate) {
+        continue;
+      }
+
+      std::optional<std::string> reason =
+          Reject(function, call, candidate.value());
+      if (report_ != nullptr) {
+        *report_ << std::format(
+            "[line {}] {}: {}\n", call.token.GetLineNumber(), function.name,
+            reason ? std::format("not inlining {}: {}", name, reason.value())
+                   : std::format("inlined {} ({} instructions)", name,
+                                 Size(*candidate->body)));
+      }
+      if (reason) {
+        // Decide once; later rounds would reject it again.
+        function.blocks[block].instructions[i].index = kNoInline;
+        continue;
+      }
+      InlineCall(function, block, i, candidate.value());
+      changed = true;
+      break;
+    }
+  }
+  return changed;
+}
+
+auto Inlining::Reject(const Function& function, const Instruction& call,
+                      const InlineCandidate& candidate) const
+    -> std::optional<std::string> {
+  const Function& body = *candidate.body;
+  const std::string& name = body.name;
+  if (name == function.name ||
+      AnyInstruction(body, [&](const Instruction& instruction) {
+        return instruction.opcode == Opcode::LOAD_GLOBAL &&
+               instruction.token.GetLexeme() == name;
+      })) {
+    return "recursive";
+  }
+  if (call.operands.size() - 1 != body.arity) {
+    return "wrong number of arguments";
+  }
+  if (AnyInstruction(body, [](const Instruction& instruction) {
+        return instruction.opcode == Opcode::LOAD_FREE ||
+               instruction.opcode == Opcode::STORE_FREE;
+      })) {
+    return "uses variables of enclosing functions";
+  }
+  if (!body.blocks[0].predecessors.empty()) {
+    return "loops back to its entry";
+  }
+  size_t size = Size(body);
+  if (size > kMaxCalleeSize) {
+    return std::format("too large ({} instructions)", size);
+  }
+  if (Size(function) + size > kMaxSize) {
+    return "size budget exhausted";
+  }
+  return std::nullopt;
+}
+
+// ====================PassManager====================
+auto PassManager::CreateDefault() -> PassManager {
+  PassManager manager;
+  manager.AddDefaultPasses();
+  return manager;
+}
+
+auto PassManager::AddDefaultPasses() -> PassManager& {
+  return Add(std::make_unique<CopyPropagation>())
+      .Add(std::make_unique<ConstantPropagation>())
+      .Add(std::make_unique<CommonSubexpressionElimination>())
+      .Add(std::make_unique<LoopInvariantCodeMotion>())
+      .Add(std::make_unique<DeadCodeElimination>());
+}
+
+auto PassManager::Add(std::unique_ptr<Pass> pass) -> PassManager& {
+  passes_.push_back(std::move(pass));
+  return *this;
+}
+
+auto PassManager::Run(Function& function) const -> void {
+  for (size_t round = 0; round < kMaxRounds; round++) {
+    bool changed = false;
+    for (const auto& pass : passes_) {
+      changed |= pass->Run(function);
+      if (verify_) {
+        if (std::optional<std::string> error = Verify(function)) {
+          throw std::logic_error(std::format(
+              "invalid IR after {}: {}", pass->Name(), error.value()));
+        }
+      }
+    }
+    if (!changed) {
+      return;
+    }
+  }
+}
+}  // namespace cclox::ir
@@ -0,0 +1,647 @@
+#include "jit.h"
+
+#include <array>
+#include <climits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <variant>
+
+#include "environment.h"
+#include "expr.h"
+#include "interpreter.h"
+#include "lox_function.h"
+#include "stmt.h"
+#include "token_type.h"
+
+namespace cclox {
+/**
+ * @brief Thrown while compiling when the function uses a construct the JIT
+ * does not handle. The function then stays in the interpreter.
+ */
+class JitUnsupported : public std::runtime_error {
+ public:
+  explicit JitUnsupported(const std::string& message)
+      : std::runtime_error(message) {}
+};
+
+/**
+ * @brief Translates one function body to x86-64.
+ *
+ * Values live in `eax` while an expression is evaluated. Parameters, locals
+ * and expression temporaries share one stack of 8-byte frame slots below the
+ * saved registers, so `rsp` stays fixed (and 16-byte aligned) for the whole
+ * body and calls need no extra alignment work.
+ *
+ * Register usage: `rbx` holds the `Jit*`, `r13` the result pointer.
+ */
+class FunctionCompiler {
+ public:
+  FunctionCompiler(Jit& jit, Interpreter& interpreter)
+      : jit_(jit), interpreter_(interpreter) {}
+
+  auto Compile(const FunctionStmt& function) -> std::vector<uint8_t>;
+
+  // ====================Statements====================
+  auto operator()(const BlockStmtPtr& stmt) -> void;
+
+  auto operator()(const ClassStmtPtr& stmt) -> void;
+
+  auto operator()(const ExprStmtPtr& stmt) -> void;
+
+  auto operator()(const FunctionStmtPtr& stmt) -> void;
+
+  auto operator()(const IfStmtPtr& stmt) -> void;
+
+  auto operator()(const PrintStmtPtr& stmt) -> void;
+
+  auto operator()(const ReturnStmtPtr& stmt) -> void;
+
+  auto operator()(const VarStmtPtr& stmt) -> void;
+
+  auto operator()(const WhileStmtPtr& stmt) -> void;
+
+  // ====================Expressions====================
+  enum class Type { INT, BOOL };
+
+  auto operator()(const AssignExprPtr& expr) -> Type;
+
+  auto operator()(const BinaryExprPtr& expr) -> Type;
+
+  auto operator()(const CallExprPtr& expr) -> Type;
+
+  auto operator()(const GetExprPtr& expr) -> Type;
+
+  auto operator()(const GroupingExprPtr& expr) -> Type;
+
+  auto operator()(const LiteralExprPtr& expr) -> Type;
+
+  auto operator()(const LogicalExprPtr& expr) -> Type;
+
+  auto operator()(const SetExprPtr& expr) -> Type;
+
+  auto operator()(const SuperExprPtr& expr) -> Type;
+
+  auto operator()(const ThisExprPtr& expr) -> Type;
+
+  auto operator()(const UnaryExprPtr& expr) -> Type;
+
+  auto operator()(const VariableExprPtr& expr) -> Type;
+
+ private:
+  struct Local {
+    int32_t slot;
+    Type type;
+  };
+
+  using Scope = std::unordered_map<std::string, Local>;
+
+  // Bytes used by the saved rbx and r13 below the frame pointer.
+  static constexpr int32_t kSavedRegisterBytes = 16;
+
+  auto CompileStatement(const StmtPtr& stmt) -> void;
+
+  auto CompileExpression(const ExprPtr& expr) -> Type;
+
+  auto BeginScope() -> void;
+
+  auto EndScope() -> void;
+
+  auto FindLocal(const std::string& name) const -> const Local*;
+
+  auto AllocateSlots(int32_t count) -> int32_t;
+
+  auto ReleaseSlots(int32_t count) noexcept -> void;
+
+  static auto SlotDisp(int32_t slot) -> int32_t;
+
+  X64Assembler assembler_;
+  Jit& jit_;
+  Interpreter& interpreter_;
+  std::vector<Scope> scopes_;
+  // Number of slots in use at the current point, and the high-water mark.
+  int32_t slots_in_use_{0};
+  int32_t max_slots_{0};
+  Label bailout_;
+  Label epilogue_;
+};
+
+auto FunctionCompiler::Compile(const FunctionStmt& function)
+    -> std::vector<uint8_t> {
+  if (!function.IsBodyParsed()) {
+    throw JitUnsupported("unparsed body");
+  }
+  X64Assembler& a = assembler_;
+
+  // Prologue.
+  a.Push(Reg::RBP);
+  a.MovRR64(Reg::RBP, Reg::RSP);
+  a.Push(Reg::RBX);
+  a.Push(Reg::R13);
+  size_t frame_size_offset = a.SubRspImm32();
+  a.MovRR64(Reg::RBX, Reg::RDI);
+  a.MovRR64(Reg::R13, Reg::RDX);
+
+  BeginScope();
+  const std::vector<Token>& params = function.GetParams();
+  for (size_t i = 0; i < params.size(); i++) {
+    int32_t slot = AllocateSlots(1);
+    a.Load64(Reg::RAX, Reg::RSI, static_cast<int32_t>(8 * i));
+    a.Store32(Reg::RBP, SlotDisp(slot), Reg::RAX);
+    scopes_.back()[params[i].GetLexeme()] = Local{slot, Type::INT};
+  }
+
+  for (const auto& statement : function.GetBody()) {
+    CompileStatement(statement);
+  }
+  EndScope();
+
+  // Falling off the end of a function returns nil.
+  a.MovRI32(Reg::RAX, Jit::NIL);
+  a.Jmp(epilogue_);
+
+  a.Bind(bailout_);
+  a.MovRI32(Reg::RAX, Jit::BAILOUT);
+
+  a.Bind(epilogue_);
+  a.Lea(Reg::RSP, Reg::RBP, -kSavedRegisterBytes);
+  a.Pop(Reg::R13);
+  a.Pop(Reg::RBX);
+  a.Pop(Reg::RBP);
+  a.Ret();
+
+  // Keep rsp 16-byte aligned at call sites.
+  int32_t frame_size = (max_slots_ * 8 + 15) / 16 * 16;
+  a.PatchImm32(frame_size_offset, frame_size);
+
+  return a.Code();
+}
+
+// ====================Statements====================
+auto FunctionCompiler::operator()(const BlockStmtPtr& stmt) -> void {
+  BeginScope();
+  for (const auto& statement : stmt->GetStatements()) {
+    CompileStatement(statement);
+  }
+  EndScope();
+}
+
+auto FunctionCompiler::operator()(const ClassStmtPtr&) -> void {
+  throw JitUnsupported("class declaration");
+}
+
+auto FunctionCompiler::operator()(const ExprStmtPtr& stmt) -> void {
+  CompileExpression(stmt->GetExpression());
+}
+
+auto FunctionCompiler::operator()(const FunctionStmtPtr&) -> void {
+  throw JitUnsupported("nested function");
+}
+
+auto FunctionCompiler::operator()(const IfStmtPtr& stmt) -> void {
+  X64Assembler& a = assembler_;
+  Label else_branch;
+  Label end;
+
+  CompileExpression(stmt->GetCondition());
+  a.Test32(Reg::RAX, Reg::RAX);
+  a.Jcc(Cond::E, else_branch);
+  CompileStatement(stmt->GetThenBranch());
+  a.Jmp(end);
+  a.Bind(else_branch);
+  if (stmt->GetElseBranch()) {
+    CompileStatement(stmt->GetElseBranch().value());
+  }
+  a.Bind(end);
+}
+
+auto FunctionCompiler::operator()(const PrintStmtPtr&) -> void {
+  throw JitUnsupported("print statement");
+}
+
+auto FunctionCompiler::operator()(const ReturnStmtPtr& stmt) -> void {
+  X64Assembler& a = assembler_;
+  const std::optional<ExprPtr>& value = stmt->GetValue();
+  if (!value) {
+    a.MovRI32(Reg::RAX, Jit::NIL);
+    a.Jmp(epilogue_);
+    return;
+  }
+
+  Type type = CompileExpression(value.value());
+  a.Movsxd(Reg::RAX, Reg::RAX);
+  a.Store64(Reg::R13, 0, Reg::RAX);
+  a.MovRI32(Reg::RAX, type == Type::INT ? Jit::INT : Jit::BOOL);
+  a.Jmp(epilogue_);
+}
+
+auto FunctionCompiler::operator()(const VarStmtPtr& stmt) -> void {
+  const std::optional<ExprPtr>& initializer = stmt->GetInitializer();
+  if (!initializer) {
+    throw JitUnsupported("nil local");
+  }
+
+  Type type = CompileExpression(initializer.value());
+  int32_t slot = AllocateSlots(1);
+  assembler_.Store32(Reg::RBP, SlotDisp(slot), Reg::RAX);
+  scopes_.back()[stmt->GetVariable().GetLexeme()] = Local{slot, type};
+}
+
+auto FunctionCompiler::operator()(const WhileStmtPtr& stmt) -> void {
+  X64Assembler& a = assembler_;
+  Label header;
+  Label exit;
+
+  a.Bind(header);
+  CompileExpression(stmt->GetCondition());
+  a.Test32(Reg::RAX, Reg::RAX);
+  a.Jcc(Cond::E, exit);
+  CompileStatement(stmt->GetBody());
+  a.Jmp(header);
+  a.Bind(exit);
+}
+
+// ====================Expressions====================
+auto FunctionCompiler::operator()(const AssignExprPtr& expr) -> Type {
+  const Local* local = FindLocal(expr->GetVariable().GetLexeme());
+  if (local == nullptr) {
+    throw JitUnsupported("assignment to non-local variable");
+  }
+
+  Type type = CompileExpression(expr->GetValue());
+  if (type != local->type) {
+    throw JitUnsupported("local changes type");
+  }
+  assembler_.Store32(Reg::RBP, SlotDisp(local->slot), Reg::RAX);
+  return type;
+}
+
+auto FunctionCompiler::operator()(const BinaryExprPtr& expr) -> Type {
+  X64Assembler& a = assembler_;
+  using enum TokenType;
+
+  int32_t left_slot = AllocateSlots(1);
+  Type left = CompileExpression(expr->GetLeftExpression());
+  a.Store32(Reg::RBP, SlotDisp(left_slot), Reg::RAX);
+  Type right = CompileExpression(expr->GetRightExpression());
+  a.MovRR64(Reg::RCX, Reg::RAX);
+  a.Load32(Reg::RAX, Reg::RBP, SlotDisp(left_slot));
+  ReleaseSlots(1);
+
+  TokenType op = expr->GetOperator().GetType();
+  if (op == EQUAL_EQUAL || op == BANG_EQUAL) {
+    if (left != right) {
+      // An integer never equals a boolean.
+      a.MovRI32(Reg::RAX, op == EQUAL_EQUAL ? 0 : 1);
+    } else {
+      a.Cmp32(Reg::RAX, Reg::RCX);
+      a.SetCC(op == EQUAL_EQUAL ? Cond::E : Cond::NE, Reg::RAX);
+    }
+    return Type::BOOL;
+  }
+
+  if (left != Type::INT || right != Type::INT) {
+    throw JitUnsupported("non-integer operand");
+  }
+
+  switch (op) {
+    case GREATER:
+      a.Cmp32(Reg::RAX, Reg::RCX);
+      a.SetCC(Cond::G, Reg::RAX);
+      return Type::BOOL;
+    case GREATER_EQUAL:
+      a.Cmp32(Reg::RAX, Reg::RCX);
+      a.SetCC(Cond::GE, Reg::RAX);
+      return Type::BOOL;
+    case LESS:
+      a.Cmp32(Reg::RAX, Reg::RCX);
+      a.SetCC(Cond::L, Reg::RAX);
+      return Type::BOOL;
+    case LESS_EQUAL:
+      a.Cmp32(Reg::RAX, Reg::RCX);
+      a.SetCC(Cond::LE, Reg::RAX);
+      return Type::BOOL;
+    case PLUS:
+      // Overflow promotes to a double in the interpreter, so bail out.
+      a.Add32(Reg::RAX, Reg::RCX);
+      a.Jcc(Cond::O, bailout_);
+      return Type::INT;
+    case MINUS:
+      a.Sub32(Reg::RAX, Reg::RCX);
+      a.Jcc(Cond::O, bailout_);
+      return Type::INT;
+    case STAR:
+      a.Imul32(Reg::RAX, Reg::RCX);
+      a.Jcc(Cond::O, bailout_);
+      return Type::INT;
+    case SLASH: {
+      Label divide;
+      a.Test32(Reg::RCX, Reg::RCX);
+      a.Jcc(Cond::E, bailout_);
+      a.CmpImm32(Reg::RCX, -1);
+      a.Jcc(Cond::NE, divide);
+      a.CmpImm32(Reg::RAX, INT32_MIN);
+      a.Jcc(Cond::E, bailout_);
+      a.Bind(divide);
+      a.Cdq();
+      a.Idiv32(Reg::RCX);
+      return Type::INT;
+    }
+    default:
+      throw JitUnsupported("unknown binary operator");
+  }
+}
+
+auto FunctionCompiler::operator()(const CallExprPtr& expr) -> Type {
+  X64Assembler& a = assembler_;
+
+  // Only direct calls to global functions are compiled.
+  const auto* callee_ptr = std::get_if<VariableExprPtr>(&expr->GetCallee());
+  if (callee_ptr == nullptr) {
+    throw JitUnsupported("indirect call");
+  }
+  const VariableExprPtr& callee = *callee_ptr;
+  const std::string& name = callee->GetVariable().GetLexeme();
+  if (FindLocal(name) != nullptr ||
+      interpreter_.GetResolvedDepth(ExprPtr{callee})) {
+    throw JitUnsupported("call through a local variable");
+  }
+
+  const Object* global =
+      interpreter_.GetGlobalEnvironment()->Find(name);
+  if (global == nullptr || !global->IsLoxFunction()) {
+    throw JitUnsupported("callee is not a function");
+  }
+  LoxCallablePtr callable = global->AsLoxCallable().value();
+  const auto& target = static_cast<const LoxFunction&>(*callable);
+  const std::vector<ExprPtr>& arguments = expr->GetArguments();
+  if (target.IsInitializer() || target.Arity() != arguments.size()) {
+    throw JitUnsupported("callee signature mismatch");
+  }
+  JitProfile& target_profile = target.GetJitProfile();
+  if (!jit_.Compile(target, target_profile)) {
+    throw JitUnsupported("callee is not compilable");
+  }
+
+  uint64_t site = jit_.call_sites_.size();
+  jit_.call_sites_.push_back(
+      Jit::CallSite{global, std::move(callable), &target_profile});
+
+  // Arguments go into consecutive slots laid out as an ascending int64 array:
+  // argument `i` lives in slot `base + count - 1 - i`.
+  auto count = static_cast<int32_t>(arguments.size());
+  int32_t base = AllocateSlots(count + 1);
+  int32_t out_slot = base + count;
+  for (int32_t i = 0; i < count; i++) {
+    if (CompileExpression(arguments[static_cast<size_t>(i)]) != Type::INT) {
+      throw JitUnsupported("non-integer argument");
+    }
+    a.Movsxd(Reg::RAX, Reg::RAX);
+    a.Store64(Reg::RBP, SlotDisp(base + count - 1 - i), Reg::RAX);
+  }
+
+  a.MovRR64(Reg::RDI, Reg::RBX);
+  a.MovRI64(Reg::RSI, site);
+  a.Lea(Reg::RDX, Reg::RBP, SlotDisp(base + count - 1));
+  a.Lea(Reg::RCX, Reg::RBP, SlotDisp(out_slot));
+  a.MovRI64(Reg::RAX, reinterpret_cast<uint64_t>(&Jit::CallHelper));
+  a.CallR(Reg::RAX);
+  // Anything but an integer result leaves the typed world.
+  a.Test32(Reg::RAX, Reg::RAX);
+  a.Jcc(Cond::NE, bailout_);
+  a.Load32(Reg::RAX, Reg::RBP, SlotDisp(out_slot));
+  ReleaseSlots(count + 1);
+
+  return Type::INT;
+}
+
+auto FunctionCompiler::operator()(const GetExprPtr&) -> Type {
+  throw JitUnsupported("property access");
+}
+
+auto FunctionCompiler::operator()(const GroupingExprPtr& expr) -> Type {
+  return CompileExpression(expr->GetExpression());
+}
+
+auto FunctionCompiler::operator()(const LiteralExprPtr& expr) -> Type {
+  const Object& value = expr->GetValue();
+  if (value.IsInteger()) {
+    assembler_.MovRI32(Reg::RAX, value.Get<int32_t>());
+    return Type::INT;
+  }
+  if (value.IsBool()) {
+    assembler_.MovRI32(Reg::RAX, value.Get<bool>() ? 1 : 0);
+    return Type::BOOL;
+  }
+
+  throw JitUnsupported("non-integer literal");
+}
+
+auto FunctionCompiler::operator()(const LogicalExprPtr& expr) -> Type {
+  X64Assembler& a = assembler_;
+  Label done;
+
+  Type left = CompileExpression(expr->GetLeftExpression());
+  a.Test32(Reg::RAX, Reg::RAX);
+  // `or` keeps a truthy left operand, `and` keeps a falsey one.
+  a.Jcc(expr->GetOperator().GetType() == TokenType::OR ? Cond::NE : Cond::E,
+        done);
+  Type right = CompileExpression(expr->GetRightExpression());
+  if (left != right) {
+    throw JitUnsupported("mixed-type logical operator");
+  }
+  a.Bind(done);
+
+  return left;
+}
+
+auto FunctionCompiler::operator()(const SetExprPtr&) -> Type {
+  throw JitUnsupported("property assignment");
+}
+
+auto FunctionCompiler::operator()(const SuperExprPtr&) -> Type {
+  throw JitUnsupported("super");
+}
+
+auto FunctionCompiler::operator()(const ThisExprPtr&) -> Type {
+  throw JitUnsupported("this");
+}
+
+auto FunctionCompiler::operator()(const UnaryExprPtr& expr) -> Type {
+  X64Assembler& a = assembler_;
+  Type type = CompileExpression(expr->GetRightExpression());
+
+  if (expr->GetOperator().GetType() == TokenType::BANG) {
+    a.Test32(Reg::RAX, Reg::RAX);
+    a.SetCC(Cond::E, Reg::RAX);
+    return Type::BOOL;
+  }
+
+  if (type != Type::INT) {
+    throw JitUnsupported("negating a boolean");
+  }
+  a.Neg32(Reg::RAX);
+  a.Jcc(Cond::O, bailout_);
+  return Type::INT;
+}
+
+auto FunctionCompiler::operator()(const VariableExprPtr& expr) -> Type {
+  const Local* local = FindLocal(expr->GetVariable().GetLexeme());
+  if (local == nullptr) {
+    throw JitUnsupported("non-local variable");
+  }
+
+  assembler_.Load32(Reg::RAX, Reg::RBP, SlotDisp(local->slot));
+  return local->type;
+}
+
+// ====================Private helpers====================
+auto FunctionCompiler::CompileStatement(const StmtPtr& stmt) -> void {
+  std::visit(*this, stmt);
+}
+
+auto FunctionCompiler::CompileExpression(const ExprPtr& expr) -> Type {
+  return std::visit(*this, expr);
+}
+
+auto FunctionCompiler::BeginScope() -> void {
+  scopes_.emplace_back();
+}
+
+auto FunctionCompiler::EndScope() -> void {
+  ReleaseSlots(static_cast<int32_t>(scopes_.back().size()));
+  scopes_.pop_back();
+}
+
+auto FunctionCompiler::FindLocal(const std::string& name) const
+    -> const Local* {
+  for (auto rit = scopes_.rbegin(); rit != scopes_.rend(); rit++) {
+    auto it = rit->find(name);
+    if (it != rit->end()) {
+      return &it->second;
+    }
+  }
+  return nullptr;
+}
+
+auto FunctionCompiler::AllocateSlots(int32_t count) -> int32_t {
+  int32_t first = slots_in_use_;
+  slots_in_use_ += count;
+  max_slots_ = std::max(max_slots_, slots_in_use_);
+  return first;
+}
+
+auto FunctionCompiler::ReleaseSlots(int32_t count) noexcept -> void {
+  slots_in_use_ -= count;
+}
+
+auto FunctionCompiler::SlotDisp(int32_t slot) -> int32_t {
+  return -kSavedRegisterBytes - 8 * (slot + 1);
+}
+
+// ====================Jit====================
+auto Jit::TryCall(const LoxFunction& function, JitProfile& profile,
+                  const std::vector<Object>& arguments)
+    -> std::optional<Object> {
+  if (profile.state == JitProfile::State::COLD) {
+    profile.calls++;
+    if (IsHot(profile)) {
+      Compile(function, profile);
+    }
+  }
+  if (profile.state != JitProfile::State::COMPILED) {
+    return std::nullopt;
+  }
+
+  // Entry guard: the compiled code assumes integer arguments.
+  std::array<int64_t, 256> args{};
+  for (size_t i = 0; i < arguments.size(); i++) {
+    const auto* value = std::get_if<int32_t>(&arguments[i].Value());
+    if (value == nullptr) {
+      RecordBailout(profile);
+      return std::nullopt;
+    }
+    args[i] = *value;
+  }
+
+  int64_t out = 0;
+  switch (profile.entry(this, args.data(), &out)) {
+    case INT:
+      return Object{static_cast<int32_t>(out)};
+    case BOOL:
+      return Object{out != 0};
+    case NIL:
+      return Object{nullptr};
+    default:
+      RecordBailout(profile);
+      return std::nullopt;
+  }
+}
+
+auto Jit::Compile(const LoxFunction& function, JitProfile& profile) -> bool {
+  using enum JitProfile::State;
+  if (profile.state != COLD) {
+    return profile.state != FAILED;
+  }
+
+#if defined(__x86_64__)
+  profile.state = COMPILING;
+  try {
+    FunctionCompiler compiler{*this, interpreter_};
+    auto memory = std::make_unique<ExecutableMemory>(
+        compiler.Compile(*function.GetDeclaration()));
+    if (!memory->IsValid()) {
+      profile.state = FAILED;
+      return false;
+    }
+    profile.entry = reinterpret_cast<NativeEntry>(
+        const_cast<void*>(memory->Entry()));
+    profile.code = std::move(memory);
+    profile.state = COMPILED;
+    return true;
+  } catch (const JitUnsupported&) {
+    profile.state = FAILED;
+    return false;
+  }
+#else
+  profile.state = FAILED;
+  return false;
+#endif
+}
+
+auto Jit::CallHelper(Jit* jit, uint64_t site, const int64_t* args,
+                     int64_t* out) -> int64_t {
+  const CallSite& call_site = jit->call_sites_[site];
+  // Guard: the global still holds the function the site was compiled for.
+  const auto* callee =
+      std::get_if<LoxCallablePtr>(&call_site.global->Value());
+  if (callee == nullptr || callee->get() != call_site.expected.get()) {
+    return BAILOUT;
+  }
+
+  JitProfile& target = *call_site.target;
+  if (target.state != JitProfile::State::COMPILED) {
+    return BAILOUT;
+  }
+
+  int64_t status = target.entry(jit, args, out);
+  if (status == BAILOUT) {
+    jit->RecordBailout(target);
+  }
+  return status;
+}
+
+auto Jit::RecordBailout(JitProfile& profile) noexcept -> void {
+  // Code that keeps bailing out is not worth its guards; drop it. The code is
+  // only unmapped when the profile dies, since a caller may be running it.
+  if (++profile.bailouts >= kMaxBailouts &&
+      profile.state == JitProfile::State::COMPILED) {
+    profile.state = JitProfile::State::FAILED;
+  }
+}
+
+auto Jit::IsHot(const JitProfile& profile) const noexcept -> bool {
+  return mode_ == JitMode::FORCE ||
+         profile.calls + profile.back_edges >= kHotThreshold;
+}
+}  // namespace cclox
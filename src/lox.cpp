@@ -1,12 +1,21 @@
 #include "lox.h"
 
 #include <sysexits.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <format>
 #include <fstream>
+#include <future>
 #include <iostream>
 #include <sstream>
+#include <thread>
+#include <utility>
+#include <variant>
 
 #include "ast_printer.h"
+#include "cpp_emitter.h"
+#include "heap_snapshot.h"
 #include "interpreter.h"
 #include "parser.h"
 #include "resolver.h"
@@ -15,35 +24,202 @@
 #include "token_type.h"
 
 namespace cclox {
-bool Lox::had_error = false;
-bool Lox::had_runtime_error = false;
+thread_local bool Lox::had_error = false;
+thread_local bool Lox::had_runtime_error = false;
 
 auto Lox::RunFile(std::string_view path) -> void {
-  std::ifstream file{path.data()};
+  Run(ReadFile(path), std::filesystem::path{path}.parent_path());
 
-  // Check if the file was opened successfully.
-  if (!file.is_open()) {
-    std::cerr << "Error: Unable to open file: " << path << std::endl;
-    std::exit(EX_NOINPUT);
+  // Indicate an error in the exit code.
+  if (had_error) {
+    return;
+  }
+  if (had_runtime_error) {
+    return;
   }
+}
 
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  // Check if reading the file was successful.
-  if (file.fail() && !file.eof()) {
-    std::cerr << "Error: Failed to read from file: " << path << std::endl;
-    std::exit(EX_IOERR);
+auto Lox::RunStream(std::istream& input) -> void {
+  StreamScanner scanner{input, output_};
+  Parser parser{[&scanner] { return scanner.ScanTokens(); }, output_};
+  // The functions and classes a statement defines refer to it, so only
+  // statements that cannot define any are dropped once they have run, with
+  // their resolutions and compiled loops.
+  std::deque<StmtPtr> kept;
+  interpreter_.StartExecutionBudget();
+  while (std::optional<StmtPtr> statement = parser.ParseNext()) {
+    if (had_error) {
+      continue;
+    }
+    // Background compiles read resolutions while they run.
+    interpreter_.GetBackgroundCompiler().Stop();
+    std::vector<ExprPtr> resolved;
+    Resolver resolver{interpreter_, resolved};
+    resolver.ResolveStatement(statement.value());
+    if (had_error) {
+      continue;
+    }
+
+    if (DefinesCallables(statement.value())) {
+      if (!interpreter_.ExecuteTopLevel(
+              kept.emplace_back(std::move(statement.value())))) {
+        return;
+      }
+      continue;
+    }
+    bool ran = interpreter_.ExecuteTopLevel(statement.value());
+    interpreter_.ForgetVariables(resolved);
+    interpreter_.ForgetLoops(statement.value());
+    if (!ran) {
+      return;
+    }
   }
+  interpreter_.EndProgram();
+}
 
-  Run(buffer.str());
+auto Lox::RunBatch(const std::vector<std::string>& paths, size_t thread_count)
+    -> bool {
+  bool succeeded = true;
+  if (thread_count <= 1) {
+    for (const std::string& path : paths) {
+      succeeded = RunBatchScript(path) && succeeded;
+    }
+    return succeeded;
+  }
 
-  // Indicate an error in the exit code.
-  if (had_error) {
-    return;
+  // Each thread takes the next script and buffers its output, which is
+  // written here once all the scripts before it have been.
+  std::vector<std::promise<std::pair<std::string, bool>>> results(
+      paths.size());
+  std::vector<std::future<std::pair<std::string, bool>>> futures;
+  futures.reserve(paths.size());
+  for (auto& result : results) {
+    futures.push_back(result.get_future());
+  }
+  std::atomic<size_t> next{0};
+  std::vector<std::jthread> threads;
+  for (size_t i = 0; i < std::min(thread_count, paths.size()); i++) {
+    threads.emplace_back([this, &paths, &results, &next] {
+      std::ostringstream output;
+      Lox lox{output};
+      lox.interpreter_.CopySettings(interpreter_);
+      lox.lazy_parsing_ = lazy_parsing_;
+      for (size_t index = next++; index < paths.size(); index = next++) {
+        bool script_succeeded = lox.RunBatchScript(paths[index]);
+        results[index].set_value({output.str(), script_succeeded});
+        output.str({});
+      }
+    });
   }
+
+  for (auto& future : futures) {
+    auto [output, script_succeeded] = future.get();
+    output_ << output;
+    succeeded = script_succeeded && succeeded;
+  }
+  return succeeded;
+}
+
+auto Lox::Load(std::string_view path) -> bool {
+  std::optional<std::vector<StmtPtr>> statements =
+      Compile(ReadFile(path), std::filesystem::path{path}.parent_path());
+  if (!statements) {
+    return false;
+  }
+
+  loaded_ = std::move(statements.value());
+  interpreter_.Interpret(loaded_);
+  return !had_runtime_error;
+}
+
+auto Lox::SnapshotFile(std::string_view path,
+                       const std::filesystem::path& snapshot) -> bool {
+  std::string source = ReadFile(path);
+  // Functions are saved by declaration, so every body must be parsed.
+  std::optional<std::vector<StmtPtr>> statements =
+      Compile(source, std::filesystem::path{path}.parent_path());
+  if (!statements) {
+    return false;
+  }
+
+  loaded_ = std::move(statements.value());
+  interpreter_.Interpret(loaded_);
   if (had_runtime_error) {
-    return;
+    return false;
+  }
+  try {
+    HeapSnapshot::Write(snapshot, source, loaded_, interpreter_);
+  } catch (const SnapshotError& error) {
+    output_ << std::format("Error: {}\n", error.what());
+    return false;
   }
+  return true;
+}
+
+auto Lox::RunFromSnapshot(std::string_view path,
+                          const std::filesystem::path& snapshot,
+                          const std::string& entry) -> bool {
+  std::string source = ReadFile(path);
+  std::optional<std::vector<StmtPtr>> statements =
+      Compile(source, std::filesystem::path{path}.parent_path());
+  if (!statements) {
+    return false;
+  }
+
+  loaded_ = std::move(statements.value());
+  try {
+    HeapSnapshot::Read(snapshot, source, loaded_, interpreter_);
+  } catch (const SnapshotError& error) {
+    output_ << std::format("Error: {}\n", error.what());
+    return false;
+  }
+  std::optional<Object> function = GetGlobal(entry);
+  if (!function || !function->IsLoxCallable()) {
+    output_ << std::format("Error: The script must define a function {}().\n",
+                           entry);
+    return false;
+  }
+  try {
+    interpreter_.CallFromHost(function.value(), {});
+  } catch (const RuntimeError& error) {
+    ReportRuntimeError(output_, error);
+    return false;
+  }
+  return true;
+}
+
+auto Lox::GetGlobal(const std::string& name) const -> std::optional<Object> {
+  const Object* value = interpreter_.GetGlobalEnvironment()->Find(name);
+  if (value == nullptr) {
+    return std::nullopt;
+  }
+  return *value;
+}
+
+auto Lox::Call(const Object& callee, const std::vector<Object>& arguments)
+    -> Object {
+  return interpreter_.CallFromHost(callee, arguments);
+}
+
+auto Lox::PrepareFork() -> void {
+  interpreter_.StopThreads();
+}
+
+auto Lox::EmitCpp(std::string_view path, std::ostream& cpp) -> bool {
+  std::optional<std::vector<StmtPtr>> statements =
+      Compile(ReadFile(path), std::filesystem::path{path}.parent_path());
+  if (!statements) {
+    return false;
+  }
+
+  // Only hand out a complete program.
+  std::ostringstream program;
+  CppEmitter emitter{program, path};
+  if (!emitter.Emit(statements.value(), output_)) {
+    return false;
+  }
+  cpp << program.str();
+  return true;
 }
 
 auto Lox::RunPrompt() -> void {
@@ -58,16 +234,153 @@ auto Lox::RunPrompt() -> void {
     if (!std::getline(std::cin, line)) {
       break;
     }
-    Run(std::move(line));
+    RunLine(std::move(line));
     // The string `line` is left in a valid but unspecified state after move, so
     // `clear()` to reset the string state to avoid clang-tidy warning.
     line.clear();
-    // Reset this flag in the interactive loop. If the user makes a mistake,
-    // it shouldn't kill their entire session
-    had_error = false;
   }
 }
 
+auto Lox::RunLine(std::string line) -> void {
+  // Reset this flag for each line. If the user makes a mistake, it shouldn't
+  // kill their entire session
+  had_error = false;
+  Scanner scanner{std::move(line), output_};
+  std::vector<Token> tokens = scanner.ScanTokens();
+  if (had_error) {
+    return;
+  }
+  Parser parser{std::move(tokens), output_};
+  std::vector<StmtPtr> statements = parser.Parse();
+  if (had_error) {
+    return;
+  }
+
+  // Background compiles read resolutions while they run.
+  interpreter_.GetBackgroundCompiler().Stop();
+  // Resolve each statement on its own, to know which expressions to forget
+  // once it has been dropped.
+  std::vector<std::vector<ExprPtr>> resolved(statements.size());
+  for (size_t i = 0; i < statements.size(); i++) {
+    Resolver resolver{interpreter_, resolved[i]};
+    resolver.ResolveStatement(statements[i]);
+  }
+
+  if (!had_error) {
+    // The code compiled for the session's functions is kept across lines,
+    // unless this one redefines a function that code may call or inline.
+    bool redefines_function =
+        std::ranges::any_of(statements, [this](const StmtPtr& statement) {
+          std::optional<std::string> name = DeclaredName(statement);
+          const Object* global =
+              name ? interpreter_.GetGlobalEnvironment()->Find(name.value())
+                   : nullptr;
+          return global != nullptr && global->IsLoxFunction();
+        });
+    interpreter_.SetKeepsCompiledCode(true);
+    bool ran = true;
+    interpreter_.StartExecutionBudget();
+    for (size_t i = 0; i < statements.size() && ran; i++) {
+      if (DefinesCallables(statements[i])) {
+        ran = interpreter_.ExecuteTopLevel(
+            session_.emplace_back(std::move(statements[i])));
+        resolved[i].clear();
+      } else {
+        ran = interpreter_.ExecuteTopLevel(statements[i]);
+        interpreter_.ForgetLoops(statements[i]);
+      }
+    }
+    if (ran) {
+      interpreter_.EndProgram();
+    }
+    interpreter_.SetKeepsCompiledCode(false);
+    if (redefines_function) {
+      interpreter_.ClearCompiledCode();
+    }
+  }
+
+  for (const std::vector<ExprPtr>& exprs : resolved) {
+    interpreter_.ForgetVariables(exprs);
+  }
+}
+
+auto Lox::SetLazyParsingEnabled(bool enabled) noexcept -> void {
+  lazy_parsing_ = enabled;
+}
+
+auto Lox::SetJitMode(JitMode mode) noexcept -> void {
+  interpreter_.GetJit().SetMode(mode);
+}
+
+auto Lox::SetTraceJitMode(JitMode mode) noexcept -> void {
+  interpreter_.GetTraceJit().SetMode(mode);
+}
+
+auto Lox::SetOptimizerEnabled(bool enabled) noexcept -> void {
+  interpreter_.GetOptimizer().SetEnabled(enabled);
+}
+
+auto Lox::SetBackgroundCompileEnabled(bool enabled) noexcept -> void {
+  interpreter_.GetOptimizer().SetBackgroundCompileEnabled(enabled);
+}
+
+auto Lox::SetIrDumpStream(std::ostream* dump) noexcept -> void {
+  interpreter_.GetOptimizer().SetDumpStream(dump);
+}
+
+auto Lox::SetInlineReportStream(std::ostream* report) noexcept -> void {
+  interpreter_.GetOptimizer().SetInlineReportStream(report);
+}
+
+auto Lox::PrintDeoptStats(std::ostream& output) -> void {
+  for (const auto& [reason, count] :
+       interpreter_.GetOptimizer().GetDeoptCounts()) {
+    output << std::format("{} ({})\n", reason, count);
+  }
+}
+
+auto Lox::SetVmEnabled(bool enabled) noexcept -> void {
+  interpreter_.GetVm().SetEnabled(enabled);
+}
+
+auto Lox::SetVmProfileEnabled(bool enabled) noexcept -> void {
+  interpreter_.GetVm().SetProfileEnabled(enabled);
+}
+
+auto Lox::SetBytecodeDumpStream(std::ostream* dump) noexcept -> void {
+  interpreter_.GetVm().SetDumpStream(dump);
+}
+
+auto Lox::PrintVmProfile(std::ostream& output) -> void {
+  interpreter_.GetVm().PrintProfile(output);
+}
+
+auto Lox::SetRegisterVmEnabled(bool enabled) noexcept -> void {
+  interpreter_.GetRegisterVm().SetEnabled(enabled);
+}
+
+auto Lox::SetRegisterCodeDumpStream(std::ostream* dump) noexcept -> void {
+  interpreter_.GetRegisterVm().SetDumpStream(dump);
+}
+
+auto Lox::SetWorkerCount(size_t count) noexcept -> void {
+  interpreter_.SetWorkerCount(count);
+}
+
+auto Lox::SetExecutionBudget(
+    std::optional<uint64_t> fuel,
+    std::optional<std::chrono::milliseconds> time_limit) -> void {
+  interpreter_.SetExecutionBudget(fuel, time_limit);
+}
+
+auto Lox::SetHeapLimit(std::optional<size_t> limit) -> void {
+  interpreter_.SetHeapLimit(limit);
+}
+
+auto Lox::GetHeapUsage() const noexcept -> HeapUsage {
+  return interpreter_.GetHeapUsage();
+}
+
 auto Lox::Error(std::ostream& output, uint32_t line_number,
                 std::string_view message) -> void {
   Report(output, line_number, "", message);
@@ -92,19 +405,33 @@ auto Lox::ReportRuntimeError(std::ostream& output, const RuntimeError& error)
 
 // =========================Private Methods=========================
 
-auto Lox::Run(std::string source) -> void {
+auto Lox::Run(std::string source, const std::filesystem::path& directory)
+    -> void {
+  std::optional<std::vector<StmtPtr>> statements =
+      Compile(std::move(source), directory, lazy_parsing_);
+  if (!statements) {
+    return;
+  }
+
+  interpreter_.Interpret(statements.value());
+}
+
+auto Lox::Compile(std::string source, const std::filesystem::path& directory,
+                  bool lazy) -> std::optional<std::vector<StmtPtr>> {
   Scanner scanner{std::move(source), output_};
   std::vector<Token> tokens = scanner.ScanTokens();
   // Stop if there was a lexing error.
   if (had_error) {
-    return;
+    return std::nullopt;
   }
 
   Parser parser{std::move(tokens), output_};
+  parser.SetDirectory(directory);
+  parser.SetLazy(lazy);
   std::vector<StmtPtr> statements = parser.Parse();
   // Stop if there was a parsing error.
   if (had_error) {
-    return;
+    return std::nullopt;
   }
 
   Resolver resolver{interpreter_};
@@ -112,15 +439,151 @@ auto Lox::Run(std::string source) -> void {
 
   // Stop if there was a resolution error.
   if (had_error) {
-    return;
+    return std::nullopt;
+  }
+
+  return statements;
+}
+
+auto Lox::ParseModule(const std::filesystem::path& path, std::ostream& output)
+    -> std::optional<std::vector<StmtPtr>> {
+  std::optional<std::string> source = TryReadFile(path.string());
+  if (!source) {
+    return std::nullopt;
+  }
+
+  // Tell the module's errors apart from those reported before.
+  bool had_error_before = std::exchange(had_error, false);
+  Scanner scanner{std::move(source.value()), output};
+  std::vector<Token> tokens = scanner.ScanTokens();
+  std::vector<StmtPtr> statements;
+  // Stop if there was a lexing error.
+  if (!had_error) {
+    Parser parser{std::move(tokens), output};
+    parser.SetDirectory(path.parent_path());
+    statements = parser.Parse();
+  }
+  bool failed = std::exchange(had_error, had_error_before);
+  if (failed) {
+    return std::nullopt;
+  }
+  return statements;
+}
+
+auto Lox::ResolveModule(Interpreter& interpreter,
+                        const std::vector<StmtPtr>& statements) -> bool {
+  bool had_error_before = std::exchange(had_error, false);
+  Resolver resolver{interpreter};
+  resolver.ResolveModule(statements);
+  return !std::exchange(had_error, had_error_before);
+}
+
+auto Lox::CompileLazyBody(Interpreter& interpreter, FunctionStmt& function)
+    -> bool {
+  const LazyBody& lazy_body = *function.GetLazyBody();
+  // The tokens are kept until the body compiles, so that a failed call can
+  // be retried.
+  std::vector<Token> tokens = lazy_body.tokens;
+  tokens.emplace_back(TokenType::EoF, "", std::nullopt,
+                      tokens.back().GetLineNumber());
+
+  bool had_error_before = std::exchange(had_error, false);
+  Parser parser{std::move(tokens), interpreter.GetOutputStream()};
+  parser.SetDirectory(lazy_body.directory);
+  parser.SetLazy(true);
+  std::vector<StmtPtr> body = parser.ParseLazyBody();
+  if (!had_error) {
+    lazy_body.resolve(body);
+  }
+  if (std::exchange(had_error, had_error_before)) {
+    return false;
+  }
+  function.SetBody(std::move(body));
+  return true;
+}
+
+auto Lox::RunBatchScript(const std::string& path) -> bool {
+  bool succeeded = false;
+  if (std::optional<std::string> source = TryReadFile(path)) {
+    Run(std::move(source.value()), std::filesystem::path{path}.parent_path());
+    succeeded = !had_error && !had_runtime_error;
+  }
+  interpreter_.Reset();
+  ResetLoxInterpreterState();
+  return succeeded;
+}
+
+auto Lox::DeclaredName(const StmtPtr& stmt) -> std::optional<std::string> {
+  if (const auto* var_stmt = std::get_if<VarStmtPtr>(&stmt)) {
+    return (*var_stmt)->GetVariable().GetLexeme();
+  }
+  if (const auto* function = std::get_if<FunctionStmtPtr>(&stmt)) {
+    return (*function)->GetFunctionName().GetLexeme();
+  }
+  if (const auto* klass = std::get_if<ClassStmtPtr>(&stmt)) {
+    return (*klass)->GetClassName().GetLexeme();
+  }
+  return std::nullopt;
+}
+
+auto Lox::DefinesCallables(const StmtPtr& stmt) -> bool {
+  if (std::holds_alternative<FunctionStmtPtr>(stmt) ||
+      std::holds_alternative<ClassStmtPtr>(stmt)) {
+    return true;
+  }
+  if (const auto* block = std::get_if<BlockStmtPtr>(&stmt)) {
+    return std::ranges::any_of((*block)->GetStatements(), DefinesCallables);
+  }
+  if (const auto* if_stmt = std::get_if<IfStmtPtr>(&stmt)) {
+    const std::optional<StmtPtr>& else_branch = (*if_stmt)->GetElseBranch();
+    return DefinesCallables((*if_stmt)->GetThenBranch()) ||
+           (else_branch && DefinesCallables(else_branch.value()));
+  }
+  if (const auto* while_stmt = std::get_if<WhileStmtPtr>(&stmt)) {
+    return DefinesCallables((*while_stmt)->GetBody());
+  }
+  return false;
+}
+
+auto Lox::ReadFile(std::string_view path) -> std::string {
+  std::ifstream file{path.data()};
+
+  // Check if the file was opened successfully.
+  if (!file.is_open()) {
+    std::cerr << "Error: Unable to open file: " << path << std::endl;
+    std::exit(EX_NOINPUT);
   }
 
-  interpreter_.Interpret(statements);
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  // Check if reading the file was successful.
+  if (file.fail() && !file.eof()) {
+    std::cerr << "Error: Failed to read from file: " << path << std::endl;
+    std::exit(EX_IOERR);
+  }
+
+  return buffer.str();
+}
+
+auto Lox::TryReadFile(std::string_view path) -> std::optional<std::string> {
+  std::ifstream file{path.data()};
+  if (!file.is_open()) {
+    std::cerr << std::format("Error: Unable to open file: {}\n", path);
+    return std::nullopt;
+  }
+
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  if (file.fail() && !file.eof()) {
+    std::cerr << std::format("Error: Failed to read from file: {}\n", path);
+    return std::nullopt;
+  }
+  return buffer.str();
 }
 
 auto Lox::ResetLoxInterpreterState() noexcept -> void {
   // Since `had_error` and `had_runtime_error` are static variables, their
-  // lifetime is the program's lifetime. Thus, we have to reset these variables
+  // lifetime is the thread's lifetime. Thus, we have to reset these variables
   // every time we create a new Lox instance.
   had_error = false;
   had_runtime_error = false;
@@ -0,0 +1,129 @@
+#include "lox_channel.h"
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+
+#include "interpreter.h"
+
+namespace cclox {
+namespace {
+// Where waiters for any channel sleep. Channels are woken together, so that
+// `select` can wait for several at once.
+std::mutex change_mutex;
+std::condition_variable change_condition;
+std::atomic<size_t> change_count{0};
+std::atomic<size_t> sleeper_count{0};
+}  // namespace
+
+LoxChannel::LoxChannel(size_t capacity)
+    : capacity_(capacity), cells_(std::make_unique<Cell[]>(capacity)) {
+  for (size_t i = 0; i < capacity_; i++) {
+    cells_[i].sequence.store(2 * i, std::memory_order_relaxed);
+  }
+}
+
+auto LoxChannel::Call(Interpreter&, const std::vector<Object>&) -> Object {
+  throw NativeError("Can only call functions and classes.");
+}
+
+auto LoxChannel::TrySend(const Object& value) -> SendResult {
+  sending_.fetch_add(1);
+  if (closed_.load()) {
+    sending_.fetch_sub(1);
+    return SendResult::CLOSED;
+  }
+
+  size_t position = send_position_.load(std::memory_order_relaxed);
+  Cell* cell;
+  while (true) {
+    cell = &cells_[position % capacity_];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    auto lag = static_cast<intptr_t>(sequence - 2 * position);
+    if (lag == 0) {
+      if (send_position_.compare_exchange_weak(position, position + 1,
+                                               std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (lag < 0) {
+      // The cell still holds the value sent a lap ago.
+      sending_.fetch_sub(1);
+      return SendResult::FULL;
+    } else {
+      position = send_position_.load(std::memory_order_relaxed);
+    }
+  }
+  cell->value = value;
+  cell->sequence.store(2 * position + 1, std::memory_order_release);
+  sending_.fetch_sub(1);
+  NotifyChange();
+  return SendResult::SENT;
+}
+
+auto LoxChannel::TryRecv() -> std::optional<Object> {
+  size_t position = recv_position_.load(std::memory_order_relaxed);
+  Cell* cell;
+  while (true) {
+    cell = &cells_[position % capacity_];
+    size_t sequence = cell->sequence.load(std::memory_order_acquire);
+    auto lag = static_cast<intptr_t>(sequence - (2 * position + 1));
+    if (lag == 0) {
+      if (recv_position_.compare_exchange_weak(position, position + 1,
+                                               std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (lag < 0) {
+      return std::nullopt;
+    } else {
+      position = recv_position_.load(std::memory_order_relaxed);
+    }
+  }
+  Object value = std::exchange(cell->value, Object{nullptr});
+  cell->sequence.store(2 * (position + capacity_), std::memory_order_release);
+  NotifyChange();
+  return value;
+}
+
+auto LoxChannel::Close() -> void {
+  closed_.store(true);
+  NotifyChange();
+}
+
+auto LoxChannel::IsDrained() -> bool {
+  // A send that passed its check of `closed_` before the close is counted in
+  // `sending_` until its value is in place, and later sends fail, so once
+  // both are seen the positions stop moving forward.
+  return closed_.load() && sending_.load() == 0 &&
+         recv_position_.load() == send_position_.load();
+}
+
+auto LoxChannel::WaitForChange(const std::function<bool()>& ready,
+                               std::chrono::microseconds timeout) -> void {
+  // Either a notifier's read of `sleeper_count` comes after this, or this
+  // reads from it and `ready` sees the change.
+  sleeper_count.fetch_add(1);
+  size_t changes = change_count.load();
+  if (!ready()) {
+    // Any change `ready` missed comes after the sleeper was counted, so it
+    // bumps `change_count` under the lock.
+    std::unique_lock lock{change_mutex};
+    change_condition.wait_for(lock, timeout, [changes] {
+      return change_count.load() != changes;
+    });
+  }
+  sleeper_count.fetch_sub(1);
+}
+
+auto LoxChannel::NotifyChange() -> void {
+  // A read-modify-write, to order it with `WaitForChange`'s.
+  if (sleeper_count.fetch_add(0) == 0) {
+    return;
+  }
+  {
+    std::lock_guard lock{change_mutex};
+    change_count.fetch_add(1);
+  }
+  change_condition.notify_all();
+}
+}  // namespace cclox
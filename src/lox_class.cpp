@@ -2,7 +2,6 @@
 
 #include <memory>
 
-#include "lox_function.h"
 #include "lox_instance.h"
 #include "object.h"
 
@@ -35,12 +34,10 @@ auto LoxClass::Arity() const noexcept -> size_t {
 
 auto LoxClass::Call(Interpreter& interpreter,
                     const std::vector<Object>& arguments) -> Object {
-  LoxInstancePtr instance = LoxInstance::Create(*this);
+  LoxInstancePtr instance = LoxInstance::Create(shared_from_this());
   LoxCallablePtr initializer = FindMethod("init");
   if (initializer) {
-    std::static_pointer_cast<LoxFunction>(initializer)
-        ->Bind(instance)
-        ->Call(interpreter, arguments);
+    initializer->Bind(instance)->Call(interpreter, arguments);
   }
 
   return Object{std::move(instance)};
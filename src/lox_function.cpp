@@ -14,6 +14,45 @@ auto LoxFunction::Arity() const noexcept -> size_t {
 
 auto LoxFunction::Call(Interpreter& interpreter,
                        const std::vector<Object>& arguments) -> Object {
+  if (!declaration_->IsBodyParsed()) {
+    interpreter.CompileLazyBody(*declaration_);
+  }
+  Jit& jit = interpreter.GetJit();
+  JitProfile* profile = nullptr;
+  // Compiled code would not count fuel.
+  bool may_compile = !is_initializer_ && !interpreter.IsMetered();
+  if (jit.IsEnabled() && may_compile) {
+    profile = &GetJitProfile();
+    std::optional<Object> result = jit.TryCall(*this, *profile, arguments);
+    if (result) {
+      return std::move(result.value());
+    }
+  }
+  Optimizer& optimizer = interpreter.GetOptimizer();
+  if (optimizer.IsEnabled() && may_compile) {
+    std::optional<Object> result =
+        optimizer.TryCall(*declaration_, closure_, arguments);
+    if (result) {
+      return std::move(result.value());
+    }
+  }
+  Vm& vm = interpreter.GetVm();
+  if (vm.IsEnabled() && may_compile) {
+    std::optional<Object> result = vm.TryCall(*declaration_, closure_, arguments);
+    if (result) {
+      return std::move(result.value());
+    }
+  }
+  RegisterVm& register_vm = interpreter.GetRegisterVm();
+  if (register_vm.IsEnabled() && may_compile) {
+    std::optional<Object> result =
+        register_vm.TryCall(*declaration_, closure_, arguments);
+    if (result) {
+      return std::move(result.value());
+    }
+  }
+  Jit::ActiveProfileScope active_profile{jit, profile};
+
   auto environment = Environment::Create(closure_);
   const std::vector<Token>& params = declaration_->GetParams();
   for (size_t i = 0; i < params.size(); i++) {
@@ -48,8 +87,19 @@ auto LoxFunction::ToString() const -> std::string {
 auto LoxFunction::Bind(const LoxInstancePtr& instance) const -> LoxCallablePtr {
   auto environment = Environment::Create(closure_);
   environment->Define("this", Object{instance});
-  return std::make_shared<LoxFunction>(declaration_, std::move(environment),
-                                       is_initializer_);
+  auto bound = std::make_shared<LoxFunction>(
+      declaration_, std::move(environment), is_initializer_);
+  // Every bound copy of a method shares the method's profile, which exists
+  // only while the JIT is enabled.
+  bound->jit_profile_ = jit_profile_;
+  return bound;
+}
+
+auto LoxFunction::GetJitProfile() const -> JitProfile& {
+  if (!jit_profile_) {
+    jit_profile_ = std::make_shared<JitProfile>();
+  }
+  return *jit_profile_;
 }
 
 }  // namespace cclox
@@ -1,12 +1,37 @@
 #include "lox_instance.h"
 
 #include "interpreter.h"
-#include "lox_function.h"
 #include "object.h"
+#include "ref_count_arena.h"
 
 namespace cclox {
-auto LoxInstance::Create(const LoxClass& klass) -> LoxInstancePtr {
-  return std::shared_ptr<LoxInstance>(new LoxInstance(klass));
+auto LoxInstance::Create(std::shared_ptr<const LoxClass> klass)
+    -> LoxInstancePtr {
+  // Instances are most of a program's data, so their counts are kept apart;
+  // see `RefCountArena`.
+  return {new LoxInstance(std::move(klass)), std::default_delete<LoxInstance>{},
+          RefCountAllocator<LoxInstance>{}};
+}
+
+LoxInstance::~LoxInstance() {
+  // The fields that hold the last reference to an instance are moved here,
+  // and each such instance's own fields are taken before it dies, so that its
+  // destructor finds nothing left to destroy.
+  std::vector<Object> dying;
+  auto take_last_references = [&dying](FieldMap& fields) {
+    for (auto& [name, value] : fields) {
+      const auto* instance = std::get_if<LoxInstancePtr>(&value.Value());
+      if (instance != nullptr && instance->use_count() == 1) {
+        dying.push_back(std::move(value));
+      }
+    }
+  };
+  take_last_references(fields_);
+  while (!dying.empty()) {
+    Object value = std::move(dying.back());
+    dying.pop_back();
+    take_last_references(value.Get<LoxInstancePtr>()->fields_);
+  }
 }
 
 auto LoxInstance::GetField(const Token& field) -> Object {
@@ -15,10 +40,9 @@ auto LoxInstance::GetField(const Token& field) -> Object {
     return fields_.at(field_name);
   }
 
-  LoxCallablePtr method = klass_.FindMethod(field_name);
+  LoxCallablePtr method = klass_->FindMethod(field_name);
   if (method) {
-    LoxCallablePtr new_method =
-        static_pointer_cast<LoxFunction>(method)->Bind(shared_from_this());
+    LoxCallablePtr new_method = method->Bind(shared_from_this());
     return Object{std::move(new_method)};
   }
 
@@ -27,10 +51,22 @@ auto LoxInstance::GetField(const Token& field) -> Object {
 }
 
 auto LoxInstance::SetField(const Token& field, const Object& value) -> void {
-  fields_[field.GetLexeme()] = value;
+  if (frozen_) {
+    throw RuntimeError(field, "Cannot modify a frozen instance.");
+  }
+  PutField(field.GetLexeme(), value);
+}
+
+auto LoxInstance::PutField(const std::string& name, const Object& value)
+    -> void {
+  auto [it, inserted] = fields_.try_emplace(name);
+  charge_.Adjust(inserted ? HeapCharge::SizeOf(it->first, value)
+                          : HeapCharge::SizeOf(value),
+                 HeapCharge::SizeOf(it->second));
+  it->second = value;
 }
 
 auto LoxInstance::ToString() const -> std::string {
-  return std::format("{} instance", klass_.ToString());
+  return std::format("{} instance", klass_->ToString());
 }
 }  // namespace cclox
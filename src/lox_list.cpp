@@ -0,0 +1,67 @@
+#include "lox_list.h"
+
+#include <cstddef>
+#include <format>
+#include <memory>
+#include <utility>
+
+#include "interpreter.h"
+
+namespace cclox {
+auto LoxSequence::Call(Interpreter&, const std::vector<Object>&) -> Object {
+  throw NativeError("Can only call functions and classes.");
+}
+
+LoxList::LoxList(std::vector<Object> elements)
+    : elements_(std::make_shared<std::vector<Object>>(std::move(elements))) {
+  size_t bytes = elements_->capacity() * sizeof(Object);
+  for (const Object& element : *elements_) {
+    bytes += HeapCharge::SizeOf(element);
+  }
+  charge_.Adjust(bytes, 0);
+}
+
+auto LoxList::ToString() const -> std::string {
+  std::string text = "[";
+  for (size_t i = 0; i < elements_->size(); i++) {
+    if (i > 0) {
+      text += ", ";
+    }
+    text += (*elements_)[i].ToString();
+  }
+  return text + "]";
+}
+
+auto LoxList::Push(Object value) -> void {
+  charge_.Adjust(sizeof(Object) + HeapCharge::SizeOf(value), 0);
+  elements_->push_back(std::move(value));
+}
+
+auto LoxList::Set(size_t index, const Object& value) -> void {
+  Object& element = (*elements_)[index];
+  charge_.Adjust(HeapCharge::SizeOf(value), HeapCharge::SizeOf(element));
+  element = value;
+}
+
+auto LoxList::Slice(size_t begin, size_t end) const
+    -> std::shared_ptr<LoxSequence> {
+  return std::make_shared<LoxList>(std::vector<Object>(
+      elements_->begin() + static_cast<std::ptrdiff_t>(begin),
+      elements_->begin() + static_cast<std::ptrdiff_t>(end)));
+}
+
+auto LoxList::Share() const -> std::shared_ptr<LoxList> {
+  // Only the elements are shared; the copy counts its own references.
+  return std::make_shared<LoxList>(*this);
+}
+
+auto LoxRange::ToString() const -> std::string {
+  return std::format("range({}, {})", start_, end_);
+}
+
+auto LoxRange::Slice(size_t begin, size_t end) const
+    -> std::shared_ptr<LoxSequence> {
+  return std::make_shared<LoxRange>(start_ + static_cast<int32_t>(begin),
+                                    start_ + static_cast<int32_t>(end));
+}
+}  // namespace cclox
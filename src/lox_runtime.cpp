@@ -0,0 +1,177 @@
+#include "lox_runtime.h"
+
+#include <sysexits.h>
+#include <format>
+#include <iostream>
+
+#include "interpreter.h"
+#include "lox.h"
+#include "token.h"
+#include "token_type.h"
+
+namespace cclox::runtime {
+namespace {
+auto MakeToken(uint32_t line, std::string lexeme = "") -> Token {
+  return Token{TokenType::IDENTIFIER, std::move(lexeme), std::nullopt, line};
+}
+
+/**
+ * @brief The interpreter handed to `LoxCallable::Call`. Compiled functions
+ * ignore it; `LoxClass` only passes it on to initializers.
+ */
+auto Context() -> Interpreter& {
+  static Interpreter interpreter{std::cout};
+  return interpreter;
+}
+}  // namespace
+
+auto Global::ThrowUndefined(uint32_t line) const -> void {
+  throw RuntimeError{MakeToken(line, name_),
+                     "Undefined variable '" + name_ + "'."};
+}
+
+// ====================CompiledFunction====================
+auto CompiledFunction::Call(Interpreter&, const std::vector<Object>& arguments)
+    -> Object {
+  Object result = (*body_)(arguments, self_);
+  if (is_initializer_) {
+    return Object{self_};
+  }
+  return result;
+}
+
+auto CompiledFunction::ToString() const -> std::string {
+  return std::format("<fn {}>", name_);
+}
+
+auto CompiledFunction::Bind(const LoxInstancePtr& instance) const
+    -> LoxCallablePtr {
+  return std::make_shared<CompiledFunction>(name_, arity_, is_initializer_,
+                                            body_, instance);
+}
+
+auto MakeFunction(std::string name, size_t arity, bool is_initializer,
+                  CompiledFunction::Body body) -> LoxCallablePtr {
+  return std::make_shared<CompiledFunction>(
+      std::move(name), arity, is_initializer,
+      std::make_shared<const CompiledFunction::Body>(std::move(body)),
+      nullptr);
+}
+
+auto CheckSuperclass(Object superclass, uint32_t line) -> Object {
+  if (!superclass.IsLoxClass()) {
+    throw RuntimeError(MakeToken(line), "Superclass must be a class.");
+  }
+  return superclass;
+}
+
+auto MakeClass(std::string name, std::optional<Object> superclass,
+               LoxClass::MethodMap methods) -> Object {
+  return Object{std::make_shared<LoxClass>(
+      std::move(name), std::move(superclass), std::move(methods))};
+}
+
+auto Native(const std::string& name) -> Object {
+  return *Context().GetGlobalEnvironment()->Find(name);
+}
+
+// ====================Operators====================
+auto Equal(const Operands& operands) -> bool {
+  return Interpreter::Equal(operands.left, operands.right);
+}
+
+auto Greater(const Operands& operands, uint32_t line) -> bool {
+  return Interpreter::Greater(operands.left, MakeToken(line), operands.right);
+}
+
+auto GreaterEqual(const Operands& operands, uint32_t line) -> bool {
+  return !Interpreter::Less(operands.left, MakeToken(line), operands.right);
+}
+
+auto Less(const Operands& operands, uint32_t line) -> bool {
+  return Interpreter::Less(operands.left, MakeToken(line), operands.right);
+}
+
+auto LessEqual(const Operands& operands, uint32_t line) -> bool {
+  return !Interpreter::Greater(operands.left, MakeToken(line), operands.right);
+}
+
+auto Add(const Operands& operands, uint32_t line) -> Object {
+  return Interpreter::Add(operands.left, MakeToken(line), operands.right);
+}
+
+auto Subtract(const Operands& operands, uint32_t line) -> Object {
+  return Interpreter::Subtract(operands.left, MakeToken(line), operands.right);
+}
+
+auto Multiply(const Operands& operands, uint32_t line) -> Object {
+  return Interpreter::Multiply(operands.left, MakeToken(line), operands.right);
+}
+
+auto Divide(const Operands& operands, uint32_t line) -> Object {
+  return Interpreter::Divide(operands.left, MakeToken(line), operands.right);
+}
+
+auto Negate(const Object& operand, uint32_t line) -> Object {
+  return Interpreter::Subtract(Object{static_cast<int32_t>(0)},
+                               MakeToken(line), operand);
+}
+
+// ====================Calls and properties====================
+auto Call(const CallOperands& operands, uint32_t line) -> Object {
+  return Context().Call(operands.callee, operands.arguments, MakeToken(line));
+}
+
+auto GetProperty(const Object& object, const std::string& name, uint32_t line)
+    -> Object {
+  std::optional<LoxInstancePtr> instance_opt = object.AsLoxInstance();
+  if (instance_opt) {
+    return instance_opt.value()->GetField(MakeToken(line, name));
+  }
+
+  throw RuntimeError(MakeToken(line, name), "Only instances have properties.");
+}
+
+auto FieldTarget(const Object& object, uint32_t line) -> LoxInstancePtr {
+  std::optional<LoxInstancePtr> instance_opt = object.AsLoxInstance();
+  if (!instance_opt) {
+    throw RuntimeError(MakeToken(line), "Only instances have fields.");
+  }
+  return instance_opt.value();
+}
+
+auto SetField(const LoxInstancePtr& instance, const std::string& name,
+              Object value, uint32_t line) -> Object {
+  instance->SetField(MakeToken(line, name), value);
+  return value;
+}
+
+auto GetSuperMethod(const Object& superclass, const LoxInstancePtr& self,
+                    const std::string& name, uint32_t line) -> Object {
+  auto superclass_ptr =
+      static_pointer_cast<LoxClass>(superclass.AsLoxCallable().value());
+  LoxCallablePtr method = superclass_ptr->FindMethod(name);
+  if (method == nullptr) {
+    throw RuntimeError(MakeToken(line, name),
+                       std::format("Undefined property '{}'.", name));
+  }
+  return Object{method->Bind(self)};
+}
+
+auto Print(const Object& value) -> void {
+  std::cout << value.ToString() << '\n';
+}
+
+auto Run(void (*main)()) -> int {
+  try {
+    main();
+    // The program ends once its async calls have, as in the interpreter.
+    Context().RunEventLoop();
+  } catch (const RuntimeError& error) {
+    Lox::ReportRuntimeError(std::cout, error);
+    Context().CancelAsyncCalls();
+    return EX_SOFTWARE;
+  }
+  return 0;
+}
+}  // namespace cclox::runtime
@@ -0,0 +1,45 @@
+#include "module_cache.h"
+
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+#include <utility>
+
+#include "lox.h"
+
+namespace cclox {
+namespace {
+std::mutex cache_mutex;
+// Keyed by canonical path.
+std::unordered_map<std::string, std::shared_ptr<const Module>> cache;
+}  // namespace
+
+auto ModuleCache::Load(const std::filesystem::path& path, std::ostream& output)
+    -> std::shared_ptr<const Module> {
+  std::error_code error;
+  std::filesystem::file_time_type modified =
+      std::filesystem::last_write_time(path, error);
+  if (error) {
+    return nullptr;
+  }
+
+  // Held while parsing, so that threads importing the same module parse it
+  // once.
+  std::lock_guard lock{cache_mutex};
+  std::shared_ptr<const Module>& cached = cache[path.string()];
+  if (cached && cached->modified == modified) {
+    return cached;
+  }
+
+  std::optional<std::vector<StmtPtr>> statements =
+      Lox::ParseModule(path, output);
+  if (!statements) {
+    return nullptr;
+  }
+  cached = std::make_shared<const Module>(
+      Module{modified, std::move(statements.value())});
+  return cached;
+}
+}  // namespace cclox
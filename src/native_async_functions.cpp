@@ -0,0 +1,130 @@
+#include "native_async_functions.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <format>
+#include <memory>
+#include <optional>
+#include <utility>
+
+#include "event_loop.h"
+#include "interpreter.h"
+
+namespace cclox {
+namespace {
+/**
+ * @brief A file being read by `readFile`, closed when the read is dropped.
+ */
+struct FileRead {
+  FileRead(std::string path, int fd, std::shared_ptr<LoxPromise> promise)
+      : path(std::move(path)), fd(fd), promise(std::move(promise)) {}
+
+  FileRead(const FileRead&) = delete;
+
+  auto operator=(const FileRead&) -> FileRead& = delete;
+
+  ~FileRead() { close(fd); }
+
+  enum class Status { MORE, WOULD_BLOCK, DONE };
+
+  /**
+   * @brief Reads one block, and settles the promise at the end of the file or
+   * on an error.
+   */
+  auto ReadBlock() -> Status {
+    std::array<char, 65536> buffer;
+    ssize_t count = read(fd, buffer.data(), buffer.size());
+    if (count > 0) {
+      contents.append(buffer.data(), static_cast<size_t>(count));
+      return Status::MORE;
+    }
+    if (count == 0) {
+      promise->Resolve(Object{std::move(contents)});
+      return Status::DONE;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+      return Status::WOULD_BLOCK;
+    }
+    promise->Reject(std::make_exception_ptr(
+        NativeError(std::format("Could not read '{}'.", path))));
+    return Status::DONE;
+  }
+
+  std::string path;
+  int fd;
+  std::string contents;
+  std::shared_ptr<LoxPromise> promise;
+};
+
+/**
+ * @brief Reads a regular file a block per turn of the loop.
+ */
+auto ReadRegularFile(const std::shared_ptr<FileRead>& file, EventLoop& loop)
+    -> void {
+  if (file->ReadBlock() != FileRead::Status::DONE) {
+    loop.Post([file, &loop] { ReadRegularFile(file, loop); });
+  }
+}
+}  // namespace
+
+auto NativeAsyncFunction::Call(Interpreter& interpreter,
+                               const std::vector<Object>& arguments)
+    -> Object {
+  std::optional<LoxCallablePtr> callee = arguments[0].AsLoxCallable();
+  if (!callee) {
+    throw NativeError("Can only call functions and classes.");
+  }
+  return Object{
+      LoxCallablePtr{interpreter.GetEventLoop().Start(callee.value())}};
+}
+
+auto NativeSleepFunction::Call(Interpreter& interpreter,
+                               const std::vector<Object>& arguments)
+    -> Object {
+  std::optional<double> milliseconds = arguments[0].AsDouble();
+  if (!milliseconds || milliseconds.value() < 0) {
+    throw NativeError("Expected a non-negative number of milliseconds.");
+  }
+  EventLoop& loop = interpreter.GetEventLoop();
+  auto promise = std::make_shared<LoxPromise>(loop);
+  loop.AddTimer(std::chrono::milliseconds{static_cast<int64_t>(
+                    std::ceil(milliseconds.value()))},
+                [promise] { promise->Resolve(Object{nullptr}); });
+  return Object{LoxCallablePtr{promise}};
+}
+
+auto NativeReadFileFunction::Call(Interpreter& interpreter,
+                                  const std::vector<Object>& arguments)
+    -> Object {
+  std::optional<std::string> path = arguments[0].AsString();
+  if (!path) {
+    throw NativeError("Expected a path.");
+  }
+  int fd = open(path->c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (fd < 0) {
+    throw NativeError(std::format("Could not open '{}'.", path.value()));
+  }
+
+  EventLoop& loop = interpreter.GetEventLoop();
+  auto promise = std::make_shared<LoxPromise>(loop);
+  auto file = std::make_shared<FileRead>(path.value(), fd, promise);
+  bool watched = loop.WatchReadable(fd, [file, &loop] {
+    FileRead::Status status;
+    do {
+      status = file->ReadBlock();
+    } while (status == FileRead::Status::MORE);
+    if (status == FileRead::Status::DONE) {
+      loop.Unwatch(file->fd);
+    }
+  });
+  if (!watched) {
+    loop.Post([file, &loop] { ReadRegularFile(file, loop); });
+  }
+  return Object{LoxCallablePtr{promise}};
+}
+}  // namespace cclox
@@ -0,0 +1,163 @@
+#include "native_channel_functions.h"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+
+#include "environment.h"
+#include "interpreter.h"
+#include "lox_channel.h"
+#include "lox_list.h"
+#include "native_list_functions.h"
+#include "object_copier.h"
+#include "task_scheduler.h"
+
+namespace cclox {
+namespace {
+// Where the last `select` on this thread received from.
+thread_local size_t last_selected = 0;
+
+auto ToChannel(const Object& value) -> LoxChannelPtr {
+  std::optional<LoxCallablePtr> callable = value.AsLoxCallable();
+  auto channel =
+      std::dynamic_pointer_cast<LoxChannel>(callable.value_or(nullptr));
+  if (!channel) {
+    throw NativeError("Expected a channel.");
+  }
+  return channel;
+}
+
+/**
+ * @brief Copies `value` for whichever task receives it. Functions in the copy
+ * reach an empty stand-in for the sender's globals, as globals are looked up
+ * in the receiver's own.
+ */
+auto CopyForSend(Interpreter& interpreter, const Object& value) -> Object {
+  ObjectCopier copier;
+  copier.Map(interpreter.GetGlobalEnvironment(), Environment::Create());
+  return copier.Copy(value);
+}
+
+/**
+ * @brief Waits until `attempt` succeeds. `attempt` must keep returning true
+ * once it has, as it is called again by each waiting step.
+ * @throws NativeError If the running code's deadline passes first, or its
+ * program fails meanwhile.
+ */
+auto WaitFor(Interpreter& interpreter, const std::function<bool()>& attempt)
+    -> void {
+  TaskScheduler& scheduler = interpreter.GetTaskScheduler();
+  if (!scheduler.BlockUntil(
+          attempt,
+          [&attempt](std::chrono::microseconds timeout) {
+            LoxChannel::WaitForChange(attempt, timeout);
+          },
+          interpreter.GetExecutionLimits().deadline)) {
+    if (scheduler.IsCancelled()) {
+      throw NativeError("The program was aborted.");
+    }
+    throw NativeError("Time limit exceeded.");
+  }
+}
+
+auto Send(LoxChannel& channel, const Object& value) -> bool {
+  LoxChannel::SendResult result = channel.TrySend(value);
+  if (result == LoxChannel::SendResult::CLOSED) {
+    throw NativeError("Cannot send to a closed channel.");
+  }
+  return result == LoxChannel::SendResult::SENT;
+}
+}  // namespace
+
+auto NativeChannelFunction::Call(Interpreter&,
+                                 const std::vector<Object>& arguments)
+    -> Object {
+  int32_t capacity = ToInteger(arguments[0]);
+  if (capacity < 1) {
+    throw NativeError("Channel capacity must be at least 1.");
+  }
+  return Object{LoxCallablePtr{
+      std::make_shared<LoxChannel>(static_cast<size_t>(capacity))}};
+}
+
+auto NativeSendFunction::Call(Interpreter& interpreter,
+                              const std::vector<Object>& arguments) -> Object {
+  LoxChannelPtr channel = ToChannel(arguments[0]);
+  Object value = CopyForSend(interpreter, arguments[1]);
+  bool sent = false;
+  WaitFor(interpreter, [&] { return sent || (sent = Send(*channel, value)); });
+  return Object{nullptr};
+}
+
+auto NativeRecvFunction::Call(Interpreter& interpreter,
+                              const std::vector<Object>& arguments) -> Object {
+  LoxChannelPtr channel = ToChannel(arguments[0]);
+  std::optional<Object> value;
+  bool drained = false;
+  WaitFor(interpreter, [&] {
+    if (value || drained) {
+      return true;
+    }
+    value = channel->TryRecv();
+    drained = !value && channel->IsDrained();
+    return value || drained;
+  });
+  return value.value_or(Object{nullptr});
+}
+
+auto NativeTrySendFunction::Call(Interpreter& interpreter,
+                                 const std::vector<Object>& arguments)
+    -> Object {
+  LoxChannelPtr channel = ToChannel(arguments[0]);
+  return Object{Send(*channel, CopyForSend(interpreter, arguments[1]))};
+}
+
+auto NativeTryRecvFunction::Call(Interpreter&,
+                                 const std::vector<Object>& arguments)
+    -> Object {
+  return ToChannel(arguments[0])->TryRecv().value_or(Object{nullptr});
+}
+
+auto NativeCloseFunction::Call(Interpreter&,
+                               const std::vector<Object>& arguments) -> Object {
+  ToChannel(arguments[0])->Close();
+  return Object{nullptr};
+}
+
+auto NativeSelectFunction::Call(Interpreter& interpreter,
+                                const std::vector<Object>& arguments)
+    -> Object {
+  std::vector<LoxChannelPtr> channels;
+  channels.reserve(arguments.size());
+  for (const Object& argument : arguments) {
+    channels.push_back(ToChannel(argument));
+  }
+
+  std::optional<Object> value;
+  size_t selected = 0;
+  bool drained = false;
+  WaitFor(interpreter, [&] {
+    if (value || drained) {
+      return true;
+    }
+    drained = true;
+    for (size_t i = 1; i <= channels.size(); i++) {
+      size_t index = (last_selected + i) % channels.size();
+      if ((value = channels[index]->TryRecv())) {
+        selected = last_selected = index;
+        return true;
+      }
+      drained = drained && channels[index]->IsDrained();
+    }
+    return drained;
+  });
+  if (!value) {
+    return Object{nullptr};
+  }
+  auto result = std::make_shared<LoxList>(std::vector<Object>{
+      Object{static_cast<int32_t>(selected)}, std::move(value.value())});
+  return Object{LoxCallablePtr{result}};
+}
+}  // namespace cclox
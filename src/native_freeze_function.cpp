@@ -0,0 +1,57 @@
+#include "native_freeze_function.h"
+
+#include <memory>
+#include <optional>
+
+#include "lox_instance.h"
+#include "lox_list.h"
+
+namespace cclox {
+namespace {
+/**
+ * @brief Freezes what `value` reaches.
+ * @return Whether any thread can read `value` at the same time as others,
+ * which holds for frozen lists only if it holds for their elements.
+ */
+auto Freeze(const Object& value) -> bool {
+  if (std::optional<LoxInstancePtr> instance = value.AsLoxInstance()) {
+    if (!instance.value()->IsFrozen()) {
+      instance.value()->Freeze();
+      for (const auto& [name, field] : instance.value()->GetFields()) {
+        Freeze(field);
+      }
+    }
+    // Its methods run in its class's environment, which tasks must copy.
+    return false;
+  }
+  std::optional<LoxCallablePtr> callable = value.AsLoxCallable();
+  if (!callable) {
+    return true;
+  }
+  if (auto list = std::dynamic_pointer_cast<LoxList>(callable.value())) {
+    // A list met again while its elements are frozen is in a cycle, which
+    // only copying preserves; it stays unshareable.
+    if (list->IsFrozen()) {
+      return list->IsShareable();
+    }
+    list->Freeze();
+    bool shareable = true;
+    for (const Object& element : list->GetElements()) {
+      shareable = Freeze(element) && shareable;
+    }
+    if (shareable) {
+      list->MarkShareable();
+    }
+    return shareable;
+  }
+  return std::dynamic_pointer_cast<LoxRange>(callable.value()) != nullptr;
+}
+}  // namespace
+
+auto NativeFreezeFunction::Call(Interpreter&,
+                                const std::vector<Object>& arguments)
+    -> Object {
+  Freeze(arguments[0]);
+  return arguments[0];
+}
+}  // namespace cclox
@@ -0,0 +1,11 @@
+#include "native_import_function.h"
+
+#include "interpreter.h"
+
+namespace cclox {
+auto NativeImportFunction::Call(Interpreter& interpreter,
+                                const std::vector<Object>& arguments)
+    -> Object {
+  return interpreter.ImportModule(arguments[0].Get<std::string>());
+}
+}  // namespace cclox
@@ -0,0 +1,100 @@
+#include "native_list_functions.h"
+
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <memory>
+#include <optional>
+
+#include "interpreter.h"
+
+namespace cclox {
+namespace {
+/**
+ * @brief Checks that `value` is a list that can be changed.
+ */
+auto ToMutableList(const Object& value) -> LoxListPtr {
+  std::optional<LoxCallablePtr> callable = value.AsLoxCallable();
+  auto list = std::dynamic_pointer_cast<LoxList>(callable.value_or(nullptr));
+  if (!list) {
+    throw NativeError("Expected a list.");
+  }
+  if (list->IsFrozen()) {
+    throw NativeError("Cannot modify a frozen list.");
+  }
+  return list;
+}
+
+auto ToIndex(const Object& value, size_t length) -> size_t {
+  int32_t index = ToInteger(value);
+  if (index < 0 || static_cast<size_t>(index) >= length) {
+    throw NativeError(
+        std::format("Index {} is out of bounds for length {}.", index, length));
+  }
+  return static_cast<size_t>(index);
+}
+}  // namespace
+
+auto ToInteger(const Object& value) -> int32_t {
+  std::optional<double> number = value.AsDouble();
+  if (!number || std::trunc(number.value()) != number.value() ||
+      number.value() < std::numeric_limits<int32_t>::min() ||
+      number.value() > std::numeric_limits<int32_t>::max()) {
+    throw NativeError("Expected an integer.");
+  }
+  return static_cast<int32_t>(number.value());
+}
+
+auto ToSequence(const Object& value) -> LoxSequencePtr {
+  std::optional<LoxCallablePtr> callable = value.AsLoxCallable();
+  auto sequence =
+      std::dynamic_pointer_cast<LoxSequence>(callable.value_or(nullptr));
+  if (!sequence) {
+    throw NativeError("Expected a list or range.");
+  }
+  return sequence;
+}
+
+auto NativeListFunction::Call(Interpreter&,
+                              const std::vector<Object>& arguments) -> Object {
+  return Object{LoxCallablePtr{std::make_shared<LoxList>(arguments)}};
+}
+
+auto NativeRangeFunction::Call(Interpreter&,
+                               const std::vector<Object>& arguments)
+    -> Object {
+  if (arguments.size() > 2) {
+    throw NativeError(std::format("Expected at most 2 arguments but got {}.",
+                                  arguments.size()));
+  }
+  int32_t start = arguments.size() == 2 ? ToInteger(arguments[0]) : 0;
+  int32_t end = ToInteger(arguments.back());
+  return Object{LoxCallablePtr{std::make_shared<LoxRange>(start, end)}};
+}
+
+auto NativeLengthFunction::Call(Interpreter&,
+                                const std::vector<Object>& arguments)
+    -> Object {
+  return Object{static_cast<int32_t>(ToSequence(arguments[0])->Length())};
+}
+
+auto NativeGetFunction::Call(Interpreter&,
+                             const std::vector<Object>& arguments) -> Object {
+  LoxSequencePtr sequence = ToSequence(arguments[0]);
+  return sequence->At(ToIndex(arguments[1], sequence->Length()));
+}
+
+auto NativeSetFunction::Call(Interpreter&,
+                             const std::vector<Object>& arguments) -> Object {
+  LoxListPtr list = ToMutableList(arguments[0]);
+  list->Set(ToIndex(arguments[1], list->Length()), arguments[2]);
+  return arguments[2];
+}
+
+auto NativePushFunction::Call(Interpreter&,
+                              const std::vector<Object>& arguments) -> Object {
+  ToMutableList(arguments[0])->Push(arguments[1]);
+  return arguments[0];
+}
+}  // namespace cclox
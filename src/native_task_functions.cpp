@@ -0,0 +1,311 @@
+#include "native_task_functions.h"
+
+#include <algorithm>
+#include <format>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <utility>
+
+#include "environment.h"
+#include "event_loop.h"
+#include "interpreter.h"
+#include "lox_class.h"
+#include "lox_function.h"
+#include "lox_list.h"
+#include "native_list_functions.h"
+#include "object_copier.h"
+#include "task_scheduler.h"
+
+namespace cclox {
+namespace {
+// The chunks of a parallel loop per worker, so that workers finishing early
+// can steal from those finishing late.
+constexpr size_t kChunksPerWorker = 4;
+
+/**
+ * @brief What a task computes from its values, in a worker's context.
+ */
+using TaskBody = std::function<Object(Interpreter& interpreter,
+                                      const std::vector<Object>& values)>;
+
+/**
+ * @brief What a task runs on, copied from its spawner.
+ */
+struct Task {
+  std::vector<Object> values;
+  TaskBody body;
+  std::shared_ptr<Environment> globals;
+  // The spawner's globals and the classes the copies were made from, which
+  // the task's result refers to instead of copies.
+  std::shared_ptr<Environment> spawner_globals;
+  std::vector<std::pair<LoxCallablePtr, LoxCallablePtr>> copied_classes;
+  // What was left of the spawner's fuel and time.
+  ExecutionLimits limits;
+};
+
+auto TakeOutput(TaskContext& context) -> std::string {
+  std::string output = context.output.str();
+  context.output.str({});
+  return output;
+}
+
+auto RunTask(const Task& task, LoxFuture& future, TaskContext& context)
+    -> void {
+  Interpreter& interpreter = context.interpreter;
+  const std::shared_ptr<Environment>& globals =
+      interpreter.GetGlobalEnvironment();
+  for (const auto& [name, value] : task.globals->GetValues()) {
+    globals->Define(name, value);
+  }
+  // The context may be running another task, which this one interrupts.
+  ExecutionLimits interrupted = interpreter.GetExecutionLimits();
+  interpreter.SetExecutionLimits(task.limits);
+
+  try {
+    Object result = task.body(interpreter, task.values);
+    interpreter.RunEventLoop();
+    interpreter.AwaitSpawnedTasks();
+
+    ObjectCopier copier;
+    copier.Map(task.globals, task.spawner_globals);
+    copier.Map(globals, task.spawner_globals);
+    for (const auto& [copy, original] : task.copied_classes) {
+      copier.Map(copy, original);
+    }
+    Object copy = copier.Copy(result);
+    future.Complete(std::move(copy), TakeOutput(context));
+  } catch (const RuntimeError& error) {
+    interpreter.CancelAsyncCalls();
+    interpreter.DiscardSpawnedTasks();
+    future.Fail(error, TakeOutput(context));
+  }
+  interpreter.SetExecutionLimits(interrupted);
+}
+
+/**
+ * @brief Starts a task computing `body` from copies of `values` and of the
+ * spawner's globals. The copies are made on the spawner's thread: the task
+ * must neither see later changes nor touch the spawner's objects.
+ */
+auto StartTask(Interpreter& interpreter, const std::vector<Object>& values,
+               TaskBody body) -> std::shared_ptr<LoxFuture> {
+  interpreter.CompileLazyBodies();
+  auto task = std::make_shared<Task>();
+  ObjectCopier copier;
+  task->spawner_globals = interpreter.GetGlobalEnvironment();
+  task->globals = copier.CopyEnvironment(task->spawner_globals);
+  task->values.reserve(values.size());
+  for (const Object& value : values) {
+    task->values.push_back(copier.Copy(value));
+  }
+  task->body = std::move(body);
+  task->copied_classes = copier.GetCopiedClasses();
+  task->limits = interpreter.GetExecutionLimits();
+
+  auto future = std::make_shared<LoxFuture>(interpreter);
+  interpreter.GetTaskScheduler().Submit(
+      [task, future](TaskContext& context) {
+        RunTask(*task, *future, context);
+      });
+  return future;
+}
+
+/**
+ * @brief Checks that a task can call `value` with `count` arguments. Only
+ * Lox functions and classes can be copied to a task.
+ */
+auto ToTaskCallee(const Object& value, size_t count) -> LoxCallablePtr {
+  std::optional<LoxCallablePtr> callee = value.AsLoxCallable();
+  if (!callee || (!std::dynamic_pointer_cast<LoxFunction>(callee.value()) &&
+                  !std::dynamic_pointer_cast<LoxClass>(callee.value()))) {
+    throw NativeError("Can only spawn functions and classes.");
+  }
+  if (callee.value()->Arity() != count) {
+    throw NativeError(std::format("Expected {} arguments but got {}.",
+                                  callee.value()->Arity(), count));
+  }
+  return callee.value();
+}
+
+/**
+ * @brief Reads the `ordered` flag of a parallel loop, the optional argument
+ * after its `required` ones.
+ */
+auto IsOrdered(const std::vector<Object>& arguments, size_t required)
+    -> bool {
+  if (arguments.size() > required + 1) {
+    throw NativeError(std::format("Expected at most {} arguments but got {}.",
+                                  required + 1, arguments.size()));
+  }
+  return arguments.size() == required || arguments[required].IsTruthy();
+}
+
+/**
+ * @brief Runs `body` on `fn` and chunks of `sequence` in parallel, and passes
+ * each chunk's index and result to `combine`: in the order of the chunks if
+ * `ordered`, else roughly in the order they finish.
+ *
+ * If a chunk fails, or `combine` throws, the remaining chunks are still
+ * waited for, but their output is dropped.
+ */
+auto RunChunks(Interpreter& interpreter, const LoxSequencePtr& sequence,
+               const Object& fn, bool ordered, const TaskBody& body,
+               const std::function<void(size_t, Object)>& combine) -> void {
+  interpreter.CompileLazyBodies();
+  TaskScheduler& scheduler = interpreter.GetTaskScheduler();
+  size_t length = sequence->Length();
+  size_t chunk_count =
+      std::min(length, scheduler.GetWorkerCount() * kChunksPerWorker);
+  if (chunk_count == 0) {
+    return;
+  }
+  size_t chunk_size = (length + chunk_count - 1) / chunk_count;
+
+  std::vector<std::shared_ptr<LoxFuture>> futures;
+  for (size_t begin = 0; begin < length; begin += chunk_size) {
+    Object chunk{LoxCallablePtr{
+        sequence->Slice(begin, std::min(begin + chunk_size, length))}};
+    futures.push_back(StartTask(interpreter, {fn, chunk}, body));
+  }
+
+  std::vector<size_t> pending(futures.size());
+  std::iota(pending.begin(), pending.end(), 0);
+  try {
+    while (!pending.empty()) {
+      auto next = pending.begin();
+      if (!ordered) {
+        next = std::find_if(pending.begin(), pending.end(),
+                            [&](size_t i) { return futures[i]->IsDone(); });
+        if (next == pending.end()) {
+          next = pending.begin();
+        }
+      }
+      size_t chunk = *next;
+      pending.erase(next);
+      combine(chunk, futures[chunk]->Await(interpreter));
+    }
+  } catch (...) {
+    // The chunks run the program's code, which must outlive them.
+    for (size_t chunk : pending) {
+      scheduler.Wait(*futures[chunk]);
+    }
+    throw;
+  }
+}
+}  // namespace
+
+auto NativeSpawnFunction::Call(Interpreter& interpreter,
+                               const std::vector<Object>& arguments)
+    -> Object {
+  ToTaskCallee(arguments[0], arguments.size() - 1);
+  auto future = StartTask(
+      interpreter, arguments,
+      [](Interpreter& context, const std::vector<Object>& values) {
+        LoxCallablePtr callee = values[0].AsLoxCallable().value();
+        return callee->Call(context, {values.begin() + 1, values.end()});
+      });
+  interpreter.AddSpawnedTask(future);
+  return Object{LoxCallablePtr{future}};
+}
+
+auto NativeAwaitFunction::Call(Interpreter& interpreter,
+                               const std::vector<Object>& arguments)
+    -> Object {
+  LoxCallablePtr callable = arguments[0].AsLoxCallable().value_or(nullptr);
+  if (auto future = std::dynamic_pointer_cast<LoxFuture>(callable)) {
+    return future->Await(interpreter);
+  }
+  if (auto promise = std::dynamic_pointer_cast<LoxPromise>(callable)) {
+    return interpreter.GetEventLoop().Await(promise);
+  }
+  throw NativeError("Can only await futures and promises.");
+}
+
+auto NativeParallelMapFunction::Call(Interpreter& interpreter,
+                                     const std::vector<Object>& arguments)
+    -> Object {
+  LoxSequencePtr sequence = ToSequence(arguments[0]);
+  ToTaskCallee(arguments[1], 1);
+  bool ordered = IsOrdered(arguments, 2);
+
+  std::vector<Object> chunks;
+  RunChunks(
+      interpreter, sequence, arguments[1], ordered,
+      [](Interpreter& context, const std::vector<Object>& values) {
+        LoxCallablePtr fn = values[0].AsLoxCallable().value();
+        LoxSequencePtr chunk = ToSequence(values[1]);
+        auto results = std::make_shared<LoxList>();
+        results->Reserve(chunk->Length());
+        for (size_t i = 0; i < chunk->Length(); i++) {
+          results->Push(fn->Call(context, {chunk->At(i)}));
+        }
+        return Object{LoxCallablePtr{results}};
+      },
+      [&](size_t chunk, Object results) {
+        if (chunks.size() <= chunk) {
+          chunks.resize(chunk + 1);
+        }
+        chunks[chunk] = std::move(results);
+      });
+
+  auto list = std::make_shared<LoxList>();
+  list->Reserve(sequence->Length());
+  for (const Object& chunk : chunks) {
+    auto results = std::static_pointer_cast<LoxList>(
+        chunk.AsLoxCallable().value());
+    for (const Object& result : results->GetElements()) {
+      list->Push(result);
+    }
+  }
+  return Object{LoxCallablePtr{list}};
+}
+
+auto NativeParallelReduceFunction::Call(Interpreter& interpreter,
+                                        const std::vector<Object>& arguments)
+    -> Object {
+  LoxSequencePtr sequence = ToSequence(arguments[0]);
+  LoxCallablePtr fn = ToTaskCallee(arguments[1], 2);
+  bool ordered = IsOrdered(arguments, 3);
+
+  Object accumulator = arguments[2];
+  RunChunks(
+      interpreter, sequence, arguments[1], ordered,
+      [](Interpreter& context, const std::vector<Object>& values) {
+        LoxCallablePtr fn = values[0].AsLoxCallable().value();
+        LoxSequencePtr chunk = ToSequence(values[1]);
+        Object partial = chunk->At(0);
+        for (size_t i = 1; i < chunk->Length(); i++) {
+          partial = fn->Call(context, {std::move(partial), chunk->At(i)});
+        }
+        return partial;
+      },
+      [&](size_t, Object partial) {
+        accumulator =
+            fn->Call(interpreter, {std::move(accumulator), std::move(partial)});
+      });
+  return accumulator;
+}
+
+auto NativeParallelForFunction::Call(Interpreter& interpreter,
+                                     const std::vector<Object>& arguments)
+    -> Object {
+  LoxSequencePtr sequence = ToSequence(arguments[0]);
+  ToTaskCallee(arguments[1], 1);
+  bool ordered = IsOrdered(arguments, 2);
+
+  RunChunks(
+      interpreter, sequence, arguments[1], ordered,
+      [](Interpreter& context, const std::vector<Object>& values) {
+        LoxCallablePtr fn = values[0].AsLoxCallable().value();
+        LoxSequencePtr chunk = ToSequence(values[1]);
+        for (size_t i = 0; i < chunk->Length(); i++) {
+          fn->Call(context, {chunk->At(i)});
+        }
+        return Object{nullptr};
+      },
+      [](size_t, Object) {});
+  return Object{nullptr};
+}
+}  // namespace cclox
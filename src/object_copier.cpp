@@ -0,0 +1,127 @@
+#include "object_copier.h"
+
+#include <memory>
+#include <utility>
+
+#include "lox_class.h"
+#include "lox_function.h"
+#include "lox_instance.h"
+#include "lox_list.h"
+
+namespace cclox {
+auto ObjectCopier::Copy(const Object& value) -> Object {
+  if (std::optional<LoxCallablePtr> callable = value.AsLoxCallable()) {
+    return Object{CopyCallable(callable.value())};
+  }
+  if (std::optional<LoxInstancePtr> instance = value.AsLoxInstance()) {
+    return Object{CopyInstance(instance.value())};
+  }
+  return value;
+}
+
+auto ObjectCopier::CopyEnvironment(
+    const std::shared_ptr<Environment>& environment)
+    -> std::shared_ptr<Environment> {
+  if (!environment) {
+    return nullptr;
+  }
+  if (auto it = environments_.find(environment.get());
+      it != environments_.end()) {
+    return it->second;
+  }
+  const std::shared_ptr<Environment>& enclosing =
+      environment->GetEnclosingEnvironment();
+  std::shared_ptr<Environment> enclosing_copy = CopyEnvironment(enclosing);
+  // Copying the enclosing environments can reach this one through a closure.
+  if (auto it = environments_.find(environment.get());
+      it != environments_.end()) {
+    return it->second;
+  }
+
+  auto copy = enclosing_copy ? Environment::Create(enclosing_copy)
+                             : Environment::Create();
+  environments_.emplace(environment.get(), copy);
+  for (const auto& [name, value] : environment->GetValues()) {
+    copy->Define(name, Copy(value));
+  }
+  return copy;
+}
+
+auto ObjectCopier::Map(const LoxCallablePtr& from, LoxCallablePtr to) -> void {
+  callables_[from.get()] = std::move(to);
+}
+
+auto ObjectCopier::Map(const std::shared_ptr<Environment>& from,
+                       std::shared_ptr<Environment> to) -> void {
+  environments_[from.get()] = std::move(to);
+}
+
+auto ObjectCopier::CopyCallable(const LoxCallablePtr& callable)
+    -> LoxCallablePtr {
+  if (auto it = callables_.find(callable.get()); it != callables_.end()) {
+    return it->second;
+  }
+  // Each copy is recorded before what it refers to is copied, so that cycles
+  // back to it end at the copy.
+  if (auto function = std::dynamic_pointer_cast<LoxFunction>(callable)) {
+    auto copy = std::make_shared<LoxFunction>(function->declaration_, nullptr,
+                                              function->is_initializer_);
+    callables_.emplace(callable.get(), copy);
+    copy->closure_ = CopyEnvironment(function->closure_);
+    if (function->jit_profile_) {
+      // Profiled on its own, for its bound copies to share.
+      copy->jit_profile_ = std::make_shared<JitProfile>();
+    }
+    return copy;
+  }
+  if (auto klass = std::dynamic_pointer_cast<LoxClass>(callable)) {
+    auto copy = std::make_shared<LoxClass>(klass->name_, std::nullopt,
+                                           LoxClass::MethodMap{});
+    callables_.emplace(callable.get(), copy);
+    copied_classes_.emplace_back(copy, callable);
+    if (klass->superclass_) {
+      copy->superclass_ = Copy(klass->superclass_.value());
+    }
+    for (const auto& [name, method] : klass->methods_) {
+      copy->methods_.emplace(name, CopyCallable(method));
+    }
+    return copy;
+  }
+  if (auto list = std::dynamic_pointer_cast<LoxList>(callable)) {
+    if (list->IsShareable()) {
+      LoxListPtr copy = list->Share();
+      callables_.emplace(callable.get(), copy);
+      return copy;
+    }
+    auto copy = std::make_shared<LoxList>();
+    callables_.emplace(callable.get(), copy);
+    copy->Reserve(list->Length());
+    for (const Object& element : list->GetElements()) {
+      copy->Push(Copy(element));
+    }
+    if (list->IsFrozen()) {
+      copy->Freeze();
+    }
+    return copy;
+  }
+  // Natives, ranges and futures hold no mutable Lox state, and channels are
+  // shared by design.
+  return callable;
+}
+
+auto ObjectCopier::CopyInstance(const LoxInstancePtr& instance)
+    -> LoxInstancePtr {
+  if (auto it = instances_.find(instance.get()); it != instances_.end()) {
+    return it->second;
+  }
+  LoxInstancePtr copy = LoxInstance::Create(nullptr);
+  instances_.emplace(instance.get(), copy);
+  copy->klass_ = std::static_pointer_cast<const LoxClass>(
+      CopyCallable(std::const_pointer_cast<LoxClass>(instance->klass_)));
+  for (const auto& [name, value] : instance->fields_) {
+    copy->PutField(name, Copy(value));
+  }
+  copy->frozen_ = instance->frozen_;
+  return copy;
+}
+}  // namespace cclox
@@ -0,0 +1,614 @@
+#include "optimizer.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+
+#include "background_compiler.h"
+#include "environment.h"
+#include "interpreter.h"
+#include "ir_builder.h"
+#include "ir_passes.h"
+#include "lox_function.h"
+#include "lox_instance.h"
+
+namespace cclox {
+using ir::Instruction, ir::Opcode;
+
+namespace {
+/**
+ * @brief Computes an arithmetic operation or comparison on numbers with the
+ * interpreter's semantics, skipping the type checks of `ir::Evaluate`. Unary
+ * operations only use `left`.
+ */
+auto EvaluateNumbers(Opcode opcode, const Object& left, const Object& right)
+    -> Object {
+  using enum Opcode;
+  const auto* left_int = std::get_if<int32_t>(&left.Value());
+  const auto* right_int = std::get_if<int32_t>(&right.Value());
+  if (left_int != nullptr && right_int != nullptr) {
+    int32_t a = *left_int;
+    int32_t b = *right_int;
+    int32_t result = 0;
+    switch (opcode) {
+      case ADD:
+        if (!__builtin_add_overflow(a, b, &result)) {
+          return Object{result};
+        }
+        break;
+      case SUB:
+        if (!__builtin_sub_overflow(a, b, &result)) {
+          return Object{result};
+        }
+        break;
+      case MUL:
+        if (!__builtin_mul_overflow(a, b, &result)) {
+          return Object{result};
+        }
+        break;
+      case DIV:
+        return Object{a / b};
+      case NEG:
+        if (!__builtin_sub_overflow(0, a, &result)) {
+          return Object{result};
+        }
+        break;
+      case EQ:
+        return Object{a == b};
+      case NE:
+        return Object{a != b};
+      case LT:
+        return Object{a < b};
+      case LE:
+        return Object{a <= b};
+      case GT:
+        return Object{a > b};
+      case GE:
+        return Object{a >= b};
+      default:
+        break;
+    }
+  }
+
+  double a = left_int != nullptr ? *left_int : std::get<double>(left.Value());
+  double b =
+      right_int != nullptr ? *right_int : std::get<double>(right.Value());
+  switch (opcode) {
+    case ADD:
+      return Object{a + b};
+    case SUB:
+      return Object{a - b};
+    case MUL:
+      return Object{a * b};
+    case DIV:
+      return Object{a / b};
+    case NEG:
+      return Object{0 - a};
+    case EQ:
+      return Object{a == b};
+    case NE:
+      return Object{a != b};
+    case LT:
+      return Object{a < b};
+    // Like the interpreter, these negate the opposite comparison, which
+    // differs from `<=` and `>=` for NaN.
+    case LE:
+      return Object{!(a > b)};
+    case GT:
+      return Object{a > b};
+    case GE:
+      return Object{!(a < b)};
+    default:
+      break;
+  }
+  throw std::logic_error("not a numeric operation");
+}
+
+/**
+ * @brief Whether a loop built without writing its variables through can
+ * throw once it has started iterating, losing assignments it has not stored
+ * yet. Code before the loop and the blocks leaving it do not count.
+ */
+auto MayThrowWhileIterating(const ir::Function& function) -> bool {
+  for (ir::BlockId id = 1; id < function.blocks.size(); id++) {
+    const std::vector<Instruction>& instructions =
+        function.blocks[id].instructions;
+    Opcode terminator = instructions.back().opcode;
+    if (terminator == Opcode::RETURN || terminator == Opcode::DEOPT) {
+      continue;
+    }
+    if (std::any_of(instructions.begin(), instructions.end(),
+                    [&](const Instruction& instruction) {
+                      return ir::CanThrow(function.types, instruction);
+                    })) {
+      return true;
+    }
+  }
+  return false;
+}
+
+auto IsTruthy(ir::Type type, const Object& value) -> bool {
+  return type == ir::Type::BOOL ? std::get<bool>(value.Value())
+                                : value.IsTruthy();
+}
+}  // namespace
+
+Optimizer::Optimizer(Interpreter& interpreter)
+    : interpreter_(interpreter),
+      pipeline_(CreatePipeline()),
+      background_pipeline_(CreatePipeline()) {
+  pipeline_->find_global = [this](const std::string& name) {
+    return interpreter_.GetGlobalEnvironment()->Find(name);
+  };
+}
+
+auto Optimizer::CreatePipeline() -> std::unique_ptr<Pipeline> {
+  auto pipeline = std::make_unique<Pipeline>();
+  auto inlining = std::make_unique<ir::Inlining>(
+      [this, &pipeline = *pipeline](const std::string& name) {
+        return FindInlineCandidate(pipeline, name);
+      });
+  pipeline->inlining = inlining.get();
+  // Inline first, so that the inlined code is optimized in the same round.
+  pipeline->passes.Add(std::move(inlining)).AddDefaultPasses();
+  return pipeline;
+}
+
+auto Optimizer::Clear() noexcept -> void {
+  if (background_) {
+    // The background compiler reads the program's AST.
+    interpreter_.GetBackgroundCompiler().Cancel();
+    pending_.clear();
+    finished_.clear();
+    has_finished_.store(false);
+    background_pipeline_->inline_bodies.clear();
+  }
+  functions_.clear();
+  pipeline_->inline_bodies.clear();
+  loops_.clear();
+}
+
+auto Optimizer::TryCall(const FunctionStmt& declaration,
+                        const std::shared_ptr<Environment>& closure,
+                        const std::vector<Object>& arguments)
+    -> std::optional<Object> {
+  CompiledCodePtr code = Compile(declaration);
+  if (code == nullptr) {
+    return std::nullopt;
+  }
+  return Execute(*code, closure, arguments);
+}
+
+auto Optimizer::Precompile(const FunctionStmt& declaration) -> void {
+  if (!enabled_ || !background_ || !declaration.IsBodyParsed() ||
+      functions_.contains(&declaration)) {
+    return;
+  }
+  if (pending_.insert(&declaration).second) {
+    CompileInBackground(declaration, 0);
+  }
+}
+
+auto Optimizer::Compile(const FunctionStmt& declaration) -> CompiledCodePtr {
+  if (!pending_.empty()) {
+    // No optimized code of the function is running yet, so it is safe to
+    // install the new code now.
+    InstallFinished();
+  }
+  auto it = functions_.find(&declaration);
+  if (it != functions_.end() &&
+      (it->second == nullptr || !Invalidate(*it->second))) {
+    return it->second;
+  }
+
+  uint64_t invalidations =
+      it != functions_.end() ? it->second->invalidations : 0;
+  if (background_) {
+    if (it != functions_.end()) {
+      // Interpret the function until its new code is ready.
+      functions_.erase(it);
+    }
+    if (pending_.insert(&declaration).second) {
+      CompileInBackground(declaration, invalidations);
+    }
+    return nullptr;
+  }
+
+  CompiledCodePtr code = Build(declaration, *pipeline_, dump_);
+  if (code != nullptr) {
+    code->invalidations = invalidations;
+  }
+  functions_.insert_or_assign(&declaration, code);
+  return code;
+}
+
+auto Optimizer::Build(const FunctionStmt& declaration, Pipeline& pipeline,
+                      std::ostream* dump) const -> CompiledCodePtr {
+  std::optional<ir::Function> function =
+      IrBuilder{interpreter_}.Build(declaration);
+  if (!function) {
+    return nullptr;
+  }
+  Optimize(pipeline, function.value());
+  Dump(function.value(), dump);
+  auto code = std::make_shared<CompiledCode>();
+  code->function = std::move(function.value());
+  return code;
+}
+
+auto Optimizer::CompileInBackground(const FunctionStmt& declaration,
+                                    uint64_t invalidations) -> void {
+  // The globals keep changing while the job runs, so it inlines the functions
+  // they hold now. The guards of inlined calls catch later redefinitions.
+  auto globals = std::make_shared<Environment::VariableMap>();
+  for (const auto& [name, value] :
+       interpreter_.GetGlobalEnvironment()->GetValues()) {
+    if (value.IsLoxFunction()) {
+      globals->emplace(name, value);
+    }
+  }
+  bool dump = dump_ != nullptr;
+  bool report = report_ != nullptr;
+
+  interpreter_.GetBackgroundCompiler().Submit(
+      [this, &declaration, invalidations, globals, dump, report] {
+        Pipeline& pipeline = *background_pipeline_;
+        pipeline.find_global = [&globals](const std::string& name) {
+          auto it = globals->find(name);
+          return it != globals->end() ? &it->second : nullptr;
+        };
+        std::ostringstream dump_text;
+        std::ostringstream report_text;
+        pipeline.inlining->SetReportStream(report ? &report_text : nullptr);
+        CompiledCodePtr code =
+            Build(declaration, pipeline, dump ? &dump_text : nullptr);
+        if (code != nullptr) {
+          code->invalidations = invalidations;
+        }
+
+        std::lock_guard lock{finished_mutex_};
+        finished_.push_back(FinishedCompile{&declaration, std::move(code),
+                                            dump_text.str(),
+                                            report_text.str()});
+        has_finished_.store(true, std::memory_order_release);
+      });
+}
+
+auto Optimizer::InstallFinished() -> void {
+  if (!has_finished_.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::vector<FinishedCompile> finished;
+  {
+    std::lock_guard lock{finished_mutex_};
+    finished.swap(finished_);
+    has_finished_.store(false, std::memory_order_relaxed);
+  }
+  for (FinishedCompile& compile : finished) {
+    if (report_ != nullptr) {
+      *report_ << compile.report;
+    }
+    if (dump_ != nullptr) {
+      *dump_ << compile.dump;
+    }
+    pending_.erase(compile.declaration);
+    functions_.insert_or_assign(compile.declaration, std::move(compile.code));
+  }
+}
+
+auto Optimizer::OnBackEdge(const WhileStmt& loop,
+                           const std::shared_ptr<Environment>& environment)
+    -> bool {
+  using enum LoopProfile::State;
+  LoopProfile& profile = loops_[&loop];
+  if (profile.state == FAILED) {
+    return false;
+  }
+  if (profile.state == COMPILED && Invalidate(*profile.code)) {
+    profile.state = COLD;
+    profile.iterations = 0;
+  }
+  if (profile.state == COLD) {
+    if (++profile.iterations < kHotLoopThreshold) {
+      return false;
+    }
+    CompiledCodePtr code = CompileLoop(loop, environment, profile.speculate);
+    if (code == nullptr) {
+      profile.state = FAILED;
+      return false;
+    }
+    if (profile.code != nullptr) {
+      code->invalidations = profile.code->invalidations;
+    }
+    profile.code = std::move(code);
+    profile.state = COMPILED;
+  }
+
+  // The loop may invalidate its own code while it runs.
+  CompiledCodePtr code = profile.code;
+  if (Execute(*code, environment, {})) {
+    return true;
+  }
+  // A speculated type did not hold: warm up again and compile the loop
+  // without speculation.
+  profile.state = COLD;
+  profile.iterations = 0;
+  profile.speculate = false;
+  return false;
+}
+
+auto Optimizer::CompileLoop(const WhileStmt& loop,
+                            const std::shared_ptr<Environment>& environment,
+                            bool speculate) -> CompiledCodePtr {
+  IrBuilder::Speculation speculation;
+  if (speculate) {
+    // Each variable is speculated to keep the type it holds right now.
+    speculation = [&](const Token& name, std::optional<uint64_t> distance) {
+      const Object* value =
+          distance ? environment->FindAt(distance.value(), name.GetLexeme())
+                   : interpreter_.GetGlobalEnvironment()->Find(
+                         name.GetLexeme());
+      if (value == nullptr) {
+        return ir::Type::ANY;
+      }
+      ir::Type type = ir::TypeOf(*value);
+      // Integers may overflow into doubles.
+      return ir::IsNumeric(type) ? ir::Type::NUMBER : type;
+    };
+  }
+
+  // Keep the loop's variables in SSA values until it is left, unless it could
+  // throw with assignments that were not stored yet.
+  for (bool write_through : {false, true}) {
+    std::optional<ir::Function> function =
+        IrBuilder{interpreter_}.BuildLoop(loop, write_through, speculation);
+    if (!function) {
+      return nullptr;
+    }
+    Optimize(*pipeline_, function.value());
+    if (!write_through && MayThrowWhileIterating(function.value())) {
+      continue;
+    }
+    Dump(function.value(), dump_);
+    auto code = std::make_shared<CompiledCode>();
+    code->function = std::move(function.value());
+    return code;
+  }
+  return nullptr;
+}
+
+auto Optimizer::Optimize(const Pipeline& pipeline,
+                         ir::Function& function) const -> void {
+  pipeline.passes.Run(function);
+  ir::TypeInference{}.Run(function);
+}
+
+auto Optimizer::Dump(const ir::Function& function, std::ostream* dump)
+    -> void {
+  if (dump != nullptr) {
+    ir::Dump(function, *dump);
+    *dump << '\n';
+  }
+}
+
+auto Optimizer::Invalidate(CompiledCode& code) -> bool {
+  if (code.guard_failures < kMaxGuardFailures ||
+      code.invalidations >= kMaxInvalidations) {
+    return false;
+  }
+  const Instruction& guard = *code.failed_guard;
+  deopts_[std::format("[line {}] {}: invalidated, {} was redefined",
+                      guard.token.GetLineNumber(), code.function.name,
+                      guard.constant.ToString())]++;
+  code.invalidations++;
+  return true;
+}
+
+auto Optimizer::FindInlineCandidate(Pipeline& pipeline,
+                                    const std::string& name) const
+    -> std::optional<ir::InlineCandidate> {
+  const Object* global = pipeline.find_global(name);
+  if (global == nullptr || !global->IsLoxFunction()) {
+    return std::nullopt;
+  }
+  auto function = std::static_pointer_cast<LoxFunction>(
+      std::get<LoxCallablePtr>(global->Value()));
+  if (function->IsInitializer()) {
+    return std::nullopt;
+  }
+
+  const FunctionStmt* declaration = function->GetDeclaration().get();
+  auto it = pipeline.inline_bodies.find(declaration);
+  if (it == pipeline.inline_bodies.end()) {
+    std::optional<ir::Function> body =
+        IrBuilder{interpreter_}.Build(*declaration);
+    if (body) {
+      static const ir::PassManager kPipeline = ir::PassManager::CreateDefault();
+      kPipeline.Run(body.value());
+    }
+    it = pipeline.inline_bodies.emplace(declaration, std::move(body)).first;
+  }
+  if (!it->second) {
+    return std::nullopt;
+  }
+  return ir::InlineCandidate{*global, &it->second.value()};
+}
+
+auto Optimizer::Execute(CompiledCode& code,
+                        const std::shared_ptr<Environment>& closure,
+                        const std::vector<Object>& arguments)
+    -> std::optional<Object> {
+  const ir::Function& function = code.function;
+  const std::shared_ptr<Environment>& globals =
+      interpreter_.GetGlobalEnvironment();
+  // Values whose type was inferred use the specialized operations.
+  const std::vector<ir::Type>& types = function.types;
+  std::vector<Object> values(function.value_count);
+  // Phi operands are read before any phi of the block is written.
+  std::vector<Object> incoming;
+
+  ir::BlockId previous = 0;
+  ir::BlockId current = 0;
+  while (true) {
+    const ir::Block& block = function.blocks[current];
+    if (!block.phis.empty()) {
+      size_t edge = static_cast<size_t>(
+          std::find(block.predecessors.begin(), block.predecessors.end(),
+                    previous) -
+          block.predecessors.begin());
+      incoming.clear();
+      for (const Instruction& phi : block.phis) {
+        incoming.push_back(values[phi.operands[edge]]);
+      }
+      for (size_t i = 0; i < block.phis.size(); i++) {
+        values[block.phis[i].result] = std::move(incoming[i]);
+      }
+    }
+
+    const std::vector<Instruction>& instructions = block.instructions;
+    for (size_t i = 0; i + 1 < instructions.size(); i++) {
+      const Instruction& instruction = instructions[i];
+      const std::vector<ir::ValueId>& operands = instruction.operands;
+      switch (instruction.opcode) {
+        case Opcode::CONST:
+          values[instruction.result] = instruction.constant;
+          break;
+        case Opcode::PARAM:
+          values[instruction.result] = arguments[instruction.index];
+          break;
+        case Opcode::COPY:
+          values[instruction.result] = values[operands[0]];
+          break;
+        case Opcode::ADD:
+        case Opcode::SUB:
+        case Opcode::MUL:
+        case Opcode::DIV:
+        case Opcode::NEG:
+        case Opcode::EQ:
+        case Opcode::NE:
+        case Opcode::LT:
+        case Opcode::LE:
+        case Opcode::GT:
+        case Opcode::GE: {
+          const Object& left = values[operands[0]];
+          const Object& right = values[operands.back()];
+          if (ir::IsNumeric(types[operands[0]]) &&
+              ir::IsNumeric(types[operands.back()])) {
+            values[instruction.result] =
+                EvaluateNumbers(instruction.opcode, left, right);
+          } else {
+            values[instruction.result] =
+                ir::Evaluate(instruction.opcode, left, right, instruction.token);
+          }
+          break;
+        }
+        case Opcode::NOT:
+          values[instruction.result] =
+              Object{!IsTruthy(types[operands[0]], values[operands[0]])};
+          break;
+        case Opcode::LOAD_GLOBAL:
+          values[instruction.result] = globals->Get(instruction.token);
+          break;
+        case Opcode::STORE_GLOBAL:
+          globals->Assign(instruction.token, values[operands[0]]);
+          break;
+        case Opcode::LOAD_FREE:
+          values[instruction.result] =
+              closure->GetAt(instruction.index, instruction.token);
+          break;
+        case Opcode::STORE_FREE:
+          closure->AssignAt(instruction.index, instruction.token,
+                            values[operands[0]]);
+          break;
+        case Opcode::GET_PROPERTY: {
+          std::optional<LoxInstancePtr> instance_opt =
+              values[operands[0]].AsLoxInstance();
+          if (!instance_opt) {
+            throw RuntimeError(instruction.token,
+                               "Only instances have properties.");
+          }
+          values[instruction.result] =
+              instance_opt.value()->GetField(instruction.token);
+          break;
+        }
+        case Opcode::CHECK_INSTANCE:
+          if (!values[operands[0]].AsLoxInstance()) {
+            throw RuntimeError(instruction.token,
+                               "Only instances have fields.");
+          }
+          break;
+        case Opcode::SET_PROPERTY:
+          values[operands[0]].AsLoxInstance().value()->SetField(
+              instruction.token, values[operands[1]]);
+          break;
+        case Opcode::CALL: {
+          std::vector<Object> call_arguments;
+          call_arguments.reserve(operands.size() - 1);
+          for (size_t j = 1; j < operands.size(); j++) {
+            call_arguments.push_back(values[operands[j]]);
+          }
+          values[instruction.result] = interpreter_.Call(
+              values[operands[0]], call_arguments, instruction.token);
+          break;
+        }
+        case Opcode::IS_CALLEE: {
+          const auto* callee =
+              std::get_if<LoxCallablePtr>(&values[operands[0]].Value());
+          bool same =
+              callee != nullptr &&
+              callee->get() ==
+                  std::get<LoxCallablePtr>(instruction.constant.Value()).get();
+          if (!same) {
+            code.guard_failures++;
+            code.failed_guard = &instruction;
+          }
+          values[instruction.result] = Object{same};
+          break;
+        }
+        case Opcode::ASSUME_TYPE:
+          values[instruction.result] = values[operands[0]];
+          break;
+        case Opcode::IS_TYPE:
+          values[instruction.result] =
+              Object{ir::HasType(values[operands[0]],
+                                 static_cast<ir::Type>(instruction.index))};
+          break;
+        case Opcode::PRINT:
+          interpreter_.GetOutputStream()
+              << values[operands[0]].ToString() << '\n';
+          break;
+        default:
+          break;
+      }
+    }
+
+    const Instruction& terminator = instructions.back();
+    switch (terminator.opcode) {
+      case Opcode::JUMP:
+        previous = current;
+        current = terminator.targets[0];
+        break;
+      case Opcode::BRANCH:
+        previous = current;
+        current = terminator.targets[IsTruthy(types[terminator.operands[0]],
+                                              values[terminator.operands[0]])
+                                         ? 0
+                                         : 1];
+        break;
+      case Opcode::DEOPT:
+        deopts_[std::format("[line {}] {}: deoptimized, {} is not a {}",
+                            terminator.token.GetLineNumber(), function.name,
+                            terminator.token.GetLexeme(),
+                            ir::TypeName(static_cast<ir::Type>(
+                                terminator.index)))]++;
+        return std::nullopt;
+      default:
+        return std::move(values[terminator.operands[0]]);
+    }
+  }
+}
+}  // namespace cclox
@@ -1,11 +1,13 @@
 #include "parser.h"
 
 #include <initializer_list>
+#include <iterator>
 #include <memory>
 #include <variant>
 
 #include "expr.h"
 #include "lox.h"
+#include "scanner.h"
 #include "stmt.h"
 #include "token.h"
 #include "token_type.h"
@@ -18,12 +20,14 @@
  *    declaration   → classDecl
  *                  | funDecl
  *                  | varDecl
+ *                  | importDecl
  *                  | statement;
  *
  *    classDecl     → "class" IDENTIFIER ( "<" IDENTIFIER )?
- *                     "{" function* "}" ;
- *    funDecl       → "fun" function ;
+ *                     "{" ( "async"? function )* "}" ;
+ *    funDecl       → "async"? "fun" function ;
  *    varDecl       → "var" IDENTIFIER ( "=" expression )? ";" ;
+ *    importDecl    → "import" STRING ";" ;
  *
  * Statements:
  *    statement     → exprStmt
@@ -57,7 +61,7 @@
  *    comparison    → term ( ( ">" | ">=" | "<" | "<=" ) term )* ;
  *    term          → factor ( ( "-" | "+" ) factor )* ;
  *    factor        → unary ( ( "/" | "*" ) unary )* ;
- *    unary         → ( "!" | "-" ) unary | call ;
+ *    unary         → ( "!" | "-" | "await" ) unary | call ;
  *    call          → primary ( "(" arguments? ")" | "." IDENTIFIER )* ;
  *    primary       → "true" | "false" | "nil" | "this"
  *                  | NUMBER | STRING | IDENTIFIER | "(" expression ")"
@@ -80,6 +84,15 @@ auto Parser::Parse() -> std::vector<StmtPtr> {
   return statements;
 }
 
+auto Parser::ParseNext() -> std::optional<StmtPtr> {
+  tokens_.erase(tokens_.begin(), tokens_.begin() + current_);
+  current_ = 0;
+  if (IsAtEnd()) {
+    return std::nullopt;
+  }
+  return ParseDeclaration();
+}
+
 auto Parser::ParseDeclaration() -> StmtPtr {
   using enum TokenType;
 
@@ -90,9 +103,16 @@ auto Parser::ParseDeclaration() -> StmtPtr {
     if (Match(FUN)) {
       return ParseFunction("function");
     }
+    if (Match(ASYNC)) {
+      Consume(FUN, "Expect 'fun' after 'async'.");
+      return ParseFunction("function", true);
+    }
     if (Match(VAR)) {
       return ParseVarDeclaration();
     }
+    if (Match(IMPORT)) {
+      return ParseImportDeclaration();
+    }
 
     return ParseStatement();
   } catch (const ParseError& error) {
@@ -117,7 +137,7 @@ auto Parser::ParseClassDeclaration() -> StmtPtr {
 
   std::vector<StmtPtr> methods;
   while (!Check(RIGHT_BRACE) && !IsAtEnd()) {
-    methods.emplace_back(ParseFunction("method"));
+    methods.emplace_back(ParseFunction("method", Match(ASYNC)));
   }
   Consume(RIGHT_BRACE, "Expect '}' after class body.");
 
@@ -125,7 +145,7 @@ auto Parser::ParseClassDeclaration() -> StmtPtr {
                                      move(methods));
 }
 
-auto Parser::ParseFunction(std::string_view kind) -> StmtPtr {
+auto Parser::ParseFunction(std::string_view kind, bool is_async) -> StmtPtr {
   using enum TokenType;
   using std::move;
 
@@ -147,12 +167,74 @@ auto Parser::ParseFunction(std::string_view kind) -> StmtPtr {
 
   // Parse function body.
   Consume(LEFT_BRACE, std::format("Expect '{{' before {} body.", kind));
+  if (lazy_ && !is_async) {
+    return std::make_unique<FunctionStmt>(move(name), move(parameters),
+                                          PreParseBody());
+  }
   std::vector<StmtPtr> body = ParseBlockStatement();
 
+  if (is_async) {
+    if (kind == "method" && name.GetLexeme() == "init") {
+      Lox::Error(output_, name, "Can't make an initializer async.");
+    }
+    body = MakeAsyncBody(name.GetLineNumber(), move(body));
+  }
+
   return std::make_unique<FunctionStmt>(move(name), move(parameters),
                                         move(body));
 }
 
+auto Parser::PreParseBody() -> std::shared_ptr<LazyBody> {
+  using enum TokenType;
+
+  auto body = std::make_shared<LazyBody>();
+  body->directory = directory_;
+  size_t depth = 1;
+  while (!IsAtEnd()) {
+    if (Check(LEFT_BRACE)) {
+      depth++;
+    } else if (Check(RIGHT_BRACE)) {
+      depth--;
+    }
+    body->tokens.push_back(Advance());
+    if (depth == 0) {
+      return body;
+    }
+  }
+  throw Error(Peek(), "Expect '}' after block.");
+}
+
+auto Parser::ParseLazyBody() -> std::vector<StmtPtr> {
+  try {
+    return ParseBlockStatement();
+  } catch (const ParseError& error) {
+    return {};
+  }
+}
+
+auto Parser::MakeAsyncBody(uint32_t line, std::vector<StmtPtr> body)
+    -> std::vector<StmtPtr> {
+  using enum TokenType;
+  using std::move;
+
+  // `async fun f(a) { body }` becomes `fun f(a) { fun fun() { body } return
+  // async(fun); }`. Both names are keywords, so no code in `body` can refer to
+  // the inner function or replace the native.
+  Token function_name{IDENTIFIER, "fun", std::nullopt, line};
+  Token native_name{IDENTIFIER, "async", std::nullopt, line};
+
+  std::vector<StmtPtr> async_body;
+  async_body.emplace_back(std::make_unique<FunctionStmt>(
+      function_name, std::vector<Token>{}, move(body)));
+  auto call = std::make_shared<CallExpr>(
+      std::make_shared<VariableExpr>(move(native_name)),
+      Token{RIGHT_PAREN, ")", std::nullopt, line},
+      std::vector<ExprPtr>{std::make_shared<VariableExpr>(function_name)});
+  async_body.emplace_back(std::make_unique<ReturnStmt>(
+      Token{RETURN, "return", std::nullopt, line}, move(call)));
+  return async_body;
+}
+
 auto Parser::ParseVarDeclaration() -> StmtPtr {
   using enum TokenType;
   using std::move;
@@ -168,6 +250,35 @@ auto Parser::ParseVarDeclaration() -> StmtPtr {
   return std::make_unique<VarStmt>(move(name), move(initializer));
 }
 
+auto Parser::ParseImportDeclaration() -> StmtPtr {
+  using enum TokenType;
+  using std::move;
+
+  Token keyword = Previous();
+  Token path = Consume(STRING, "Expect module path after 'import'.");
+  Consume(SEMICOLON, "Expect ';' after module path.");
+
+  std::filesystem::path module_path =
+      directory_ / path.GetLiteral().Get<std::string>();
+  std::string module_name = module_path.stem().string();
+  if (!Scanner::IsIdentifier(module_name)) {
+    Lox::Error(output_, path, "Module name must be an identifier.");
+  }
+
+  // `import "lib/name.lox";` becomes `var name = import("<directory>/lib/
+  // name.lox");`. `import` is a keyword, so no code can replace the native.
+  uint32_t line = keyword.GetLineNumber();
+  auto call = std::make_shared<CallExpr>(
+      std::make_shared<VariableExpr>(
+          Token{IDENTIFIER, "import", std::nullopt, line}),
+      Token{RIGHT_PAREN, ")", std::nullopt, line},
+      std::vector<ExprPtr>{std::make_shared<LiteralExpr>(
+          Object{module_path.lexically_normal().string()})});
+  return std::make_unique<VarStmt>(
+      Token{IDENTIFIER, move(module_name), std::nullopt, line},
+      ExprPtr{move(call)});
+}
+
 auto Parser::ParseStatement() -> StmtPtr {
   using enum TokenType;
 
@@ -197,6 +308,7 @@ auto Parser::ParseForStatement() -> StmtPtr {
   using enum TokenType;
   using std::make_unique, std::move;
 
+  Token keyword = Previous();
   Consume(LEFT_PAREN, "Expect '(' after 'for'.");
 
   std::optional<StmtPtr> initializer_stmt;
@@ -234,7 +346,8 @@ auto Parser::ParseForStatement() -> StmtPtr {
   if (!condition_expr) {
     condition_expr = make_unique<LiteralExpr>(Object{true});
   }
-  body = make_unique<WhileStmt>(move(condition_expr.value()), move(body));
+  body = make_unique<WhileStmt>(move(keyword), move(condition_expr.value()),
+                               move(body));
 
   if (initializer_stmt) {
     std::vector<StmtPtr> statements;
@@ -289,12 +402,14 @@ auto Parser::ParseReturnStatement() -> StmtPtr {
 auto Parser::ParseWhileStatement() -> StmtPtr {
   using std::move;
 
+  Token keyword = Previous();
   Consume(TokenType::LEFT_PAREN, "Expect '(' after 'while'.");
   ExprPtr condition = ParseExpression();
   Consume(TokenType::RIGHT_PAREN, "Expect ')' after condition.");
   StmtPtr body = ParseStatement();
 
-  return std::make_unique<WhileStmt>(move(condition), move(body));
+  return std::make_unique<WhileStmt>(move(keyword), move(condition),
+                                     move(body));
 }
 
 auto Parser::ParseExpressionStatement() -> StmtPtr {
@@ -447,6 +562,16 @@ auto Parser::ParseUnary() -> ExprPtr {
     ExprPtr right = ParseUnary();
     return std::make_shared<UnaryExpr>(move(op), move(right));
   }
+  if (Match(AWAIT)) {
+    // A call to the `await` native, which no program can shadow as `await` is
+    // a keyword.
+    Token keyword = Previous();
+    ExprPtr value = ParseUnary();
+    Token callee{IDENTIFIER, "await", std::nullopt, keyword.GetLineNumber()};
+    return std::make_shared<CallExpr>(
+        std::make_shared<VariableExpr>(move(callee)), move(keyword),
+        std::vector<ExprPtr>{move(value)});
+  }
 
   return ParseCall();
 }
@@ -515,7 +640,7 @@ auto Parser::ParsePrimary() -> ExprPtr {
 }
 
 template<typename T, typename... Ts, typename>
-auto Parser::Match(T type, Ts... types) noexcept -> bool {
+auto Parser::Match(T type, Ts... types) -> bool {
   auto CheckAndAdvance = [this](TokenType type) {
     if (Check(type)) {
       Advance();
@@ -541,9 +666,14 @@ auto Parser::Check(TokenType type) const noexcept -> bool {
   return Peek().GetType() == type;
 }
 
-auto Parser::Advance() noexcept -> Token {
+auto Parser::Advance() -> Token {
   if (!IsAtEnd()) {
     current_++;
+    if (current_ == tokens_.size()) {
+      std::vector<Token> tokens = source_();
+      tokens_.insert(tokens_.end(), std::make_move_iterator(tokens.begin()),
+                     std::make_move_iterator(tokens.end()));
+    }
   }
   return Previous();
 }
@@ -566,7 +696,7 @@ auto Parser::Error(const Token& token, std::string_view message) const
   return ParseError{message};
 }
 
-auto Parser::Synchronize() noexcept -> void {
+auto Parser::Synchronize() -> void {
   Advance();
   using enum TokenType;
 
@@ -576,6 +706,7 @@ auto Parser::Synchronize() noexcept -> void {
     }
 
     switch (Peek().GetType()) {
+      case ASYNC:
       case CLASS:
       case FUN:
       case VAR:
@@ -0,0 +1,132 @@
+#include "ref_count_arena.h"
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace cclox {
+namespace {
+// Blocks come in multiples of this size, which is also their alignment.
+constexpr size_t kGranule = 16;
+constexpr size_t kMaxBlockSize = 128;
+// Chunks are aligned to their size, so that a block finds its chunk.
+constexpr size_t kChunkSize = 64 * 1024;
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+/**
+ * @brief The header of a chunk, whose blocks all have one size, followed by
+ * the blocks.
+ */
+struct alignas(kGranule) Chunk {
+  // The next chunk of the size class with room for a block.
+  Chunk* next_with_room{nullptr};
+  bool has_room{true};
+  FreeBlock* free_blocks{nullptr};
+  // Where blocks never handed out start.
+  size_t carved{sizeof(Chunk)};
+  size_t live_blocks{0};
+};
+
+// Each size class lists the chunks with room for a block. A chunk found full
+// when allocating leaves the list, and freeing one of its blocks puts it back.
+std::array<Chunk*, kMaxBlockSize / kGranule> chunks_with_room{};
+size_t chunk_count = 0;
+std::mutex mutex;
+
+auto SizeClass(size_t size) -> size_t {
+  return (size + kGranule - 1) / kGranule - 1;
+}
+
+auto ChunkOf(void* block) -> Chunk* {
+  return reinterpret_cast<Chunk*>(reinterpret_cast<uintptr_t>(block) &
+                                  ~(kChunkSize - 1));
+}
+
+/**
+ * @return A block of `block_size` bytes from `chunk`, or `nullptr` if it is
+ * full.
+ */
+auto TakeBlock(Chunk& chunk, size_t block_size) -> void* {
+  if (FreeBlock* block = chunk.free_blocks) {
+    chunk.free_blocks = block->next;
+    return block;
+  }
+  if (kChunkSize - chunk.carved < block_size) {
+    return nullptr;
+  }
+  void* block = reinterpret_cast<char*>(&chunk) + chunk.carved;
+  chunk.carved += block_size;
+  return block;
+}
+}  // namespace
+
+auto RefCountArena::Allocate(size_t size) -> void* {
+  if (size > kMaxBlockSize) {
+    return ::operator new(size);
+  }
+  size_t size_class = SizeClass(size);
+  size_t block_size = (size_class + 1) * kGranule;
+  std::lock_guard lock{mutex};
+  Chunk*& chunks = chunks_with_room[size_class];
+  while (chunks != nullptr) {
+    if (void* block = TakeBlock(*chunks, block_size)) {
+      chunks->live_blocks++;
+      return block;
+    }
+    chunks->has_room = false;
+    chunks = std::exchange(chunks->next_with_room, nullptr);
+  }
+  chunks = new (::operator new(kChunkSize, std::align_val_t{kChunkSize}))
+      Chunk{};
+  chunk_count++;
+  chunks->live_blocks++;
+  return TakeBlock(*chunks, block_size);
+}
+
+auto RefCountArena::Deallocate(void* block, size_t size) noexcept -> void {
+  if (size > kMaxBlockSize) {
+    ::operator delete(block);
+    return;
+  }
+  Chunk* chunk = ChunkOf(block);
+  std::lock_guard lock{mutex};
+  auto* free_block = static_cast<FreeBlock*>(block);
+  free_block->next = chunk->free_blocks;
+  chunk->free_blocks = free_block;
+  chunk->live_blocks--;
+  if (!chunk->has_room) {
+    Chunk*& chunks = chunks_with_room[SizeClass(size)];
+    chunk->has_room = true;
+    chunk->next_with_room = chunks;
+    chunks = chunk;
+  }
+}
+
+auto RefCountArena::ReleaseEmptyChunks() noexcept -> void {
+  std::lock_guard lock{mutex};
+  // Empty chunks have room, so they are all listed.
+  for (Chunk*& chunks : chunks_with_room) {
+    for (Chunk** link = &chunks; *link != nullptr;) {
+      Chunk* chunk = *link;
+      if (chunk->live_blocks != 0) {
+        link = &chunk->next_with_room;
+        continue;
+      }
+      *link = chunk->next_with_room;
+      chunk->~Chunk();
+      ::operator delete(chunk, std::align_val_t{kChunkSize});
+      chunk_count--;
+    }
+  }
+}
+
+auto RefCountArena::GetChunkCount() noexcept -> size_t {
+  std::lock_guard lock{mutex};
+  return chunk_count;
+}
+}  // namespace cclox
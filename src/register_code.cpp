@@ -0,0 +1,129 @@
+#include "register_code.h"
+
+#include <algorithm>
+#include <cctype>
+#include <format>
+#include <string>
+
+namespace cclox::register_code {
+namespace {
+/**
+ * @brief Formats a source operand: `r3` for a register, the value for a
+ * constant.
+ */
+auto OperandToString(const Code& code, uint32_t operand) -> std::string {
+  if (!IsConstant(operand)) {
+    return std::format("r{}", operand);
+  }
+  const Object& constant = code.constants[ConstantIndex(operand)];
+  return constant.IsString() ? std::format("\"{}\"", constant.ToString())
+                             : constant.ToString();
+}
+}  // namespace
+
+auto OpCodeName(OpCode opcode) -> std::string_view {
+  switch (opcode) {
+#define CCLOX_REGISTER_OP(name) \
+  case OpCode::name:            \
+    return #name;
+    CCLOX_REGISTER_OPCODES(CCLOX_REGISTER_OP)
+#undef CCLOX_REGISTER_OP
+  }
+  return "?";
+}
+
+auto Disassemble(const Code& code, std::ostream& output) -> void {
+  output << std::format("code {}/{} ({} registers)\n", code.name, code.arity,
+                        code.register_count);
+  for (size_t i = 0; i < code.code.size(); i++) {
+    const Instruction& instruction = code.code[i];
+    std::string name{OpCodeName(instruction.opcode)};
+    std::transform(name.begin(), name.end(), name.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    std::string text = std::format("{:4}  {}", i, name);
+    const std::string& lexeme = code.tokens[instruction.token].GetLexeme();
+
+    using enum OpCode;
+    switch (instruction.opcode) {
+      case MOVE:
+      case NEGATE:
+      case NOT:
+        text += std::format(" r{}, {}", instruction.a,
+                            OperandToString(code, instruction.b));
+        break;
+      case GET_GLOBAL:
+        text += std::format(" r{}, {}", instruction.a, lexeme);
+        break;
+      case SET_GLOBAL:
+        text += std::format(" {}, {}", lexeme,
+                            OperandToString(code, instruction.a));
+        break;
+      case GET_FREE:
+        text += std::format(" r{}, {}@{}", instruction.a, lexeme,
+                            instruction.b);
+        break;
+      case SET_FREE:
+        text += std::format(" {}@{}, {}", lexeme, instruction.b,
+                            OperandToString(code, instruction.a));
+        break;
+      case GET_PROPERTY:
+        text += std::format(" r{}, r{}.{}", instruction.a, instruction.b,
+                            lexeme);
+        break;
+      case CHECK_INSTANCE:
+        text += std::format(" r{}", instruction.a);
+        break;
+      case SET_PROPERTY:
+        text += std::format(" r{}.{}, {}", instruction.a, lexeme,
+                            OperandToString(code, instruction.b));
+        break;
+      case ADD:
+      case SUBTRACT:
+      case MULTIPLY:
+      case DIVIDE:
+      case EQUAL:
+      case NOT_EQUAL:
+      case LESS:
+      case LESS_EQUAL:
+      case GREATER:
+      case GREATER_EQUAL:
+        text += std::format(" r{}, {}, {}", instruction.a,
+                            OperandToString(code, instruction.b),
+                            OperandToString(code, instruction.c));
+        break;
+      case JUMP:
+        text += std::format(" -> {}", instruction.a);
+        break;
+      case JUMP_IF_FALSE:
+      case JUMP_IF_TRUE:
+        text += std::format(" {} -> {}", OperandToString(code, instruction.b),
+                            instruction.a);
+        break;
+      case JUMP_UNLESS_EQUAL:
+      case JUMP_UNLESS_NOT_EQUAL:
+      case JUMP_UNLESS_LESS:
+      case JUMP_UNLESS_LESS_EQUAL:
+      case JUMP_UNLESS_GREATER:
+      case JUMP_UNLESS_GREATER_EQUAL:
+        text += std::format(" {}, {} -> {}",
+                            OperandToString(code, instruction.b),
+                            OperandToString(code, instruction.c),
+                            instruction.a);
+        break;
+      case CALL:
+        text += std::format(" r{} ({} arguments)", instruction.a,
+                            instruction.b);
+        break;
+      case INVOKE:
+        text += std::format(" r{}.{} ({} arguments)", instruction.a, lexeme,
+                            instruction.b);
+        break;
+      case PRINT:
+      case RETURN:
+        text += " " + OperandToString(code, instruction.a);
+        break;
+    }
+    output << text << '\n';
+  }
+}
+}  // namespace cclox::register_code
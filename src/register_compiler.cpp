@@ -0,0 +1,556 @@
+#include "register_compiler.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <variant>
+
+#include "interpreter.h"
+#include "token_type.h"
+
+namespace cclox {
+using register_code::OpCode;
+
+namespace {
+/**
+ * @brief Thrown while compiling when the function uses a construct the
+ * register code does not handle. The function then stays in the interpreter.
+ */
+class RegisterUnsupported : public std::runtime_error {
+ public:
+  explicit RegisterUnsupported(const std::string& message)
+      : std::runtime_error(message) {}
+};
+
+/**
+ * @brief The instruction computing a binary operator, or, with `jump`, the
+ * one jumping unless a comparison holds.
+ */
+auto BinaryOpCode(TokenType type, bool jump) -> std::optional<OpCode> {
+  using enum TokenType;
+  switch (type) {
+    case BANG_EQUAL:
+      return jump ? OpCode::JUMP_UNLESS_NOT_EQUAL : OpCode::NOT_EQUAL;
+    case EQUAL_EQUAL:
+      return jump ? OpCode::JUMP_UNLESS_EQUAL : OpCode::EQUAL;
+    case GREATER:
+      return jump ? OpCode::JUMP_UNLESS_GREATER : OpCode::GREATER;
+    case GREATER_EQUAL:
+      return jump ? OpCode::JUMP_UNLESS_GREATER_EQUAL : OpCode::GREATER_EQUAL;
+    case LESS:
+      return jump ? OpCode::JUMP_UNLESS_LESS : OpCode::LESS;
+    case LESS_EQUAL:
+      return jump ? OpCode::JUMP_UNLESS_LESS_EQUAL : OpCode::LESS_EQUAL;
+    case MINUS:
+      return jump ? std::nullopt : std::optional{OpCode::SUBTRACT};
+    case PLUS:
+      return jump ? std::nullopt : std::optional{OpCode::ADD};
+    case SLASH:
+      return jump ? std::nullopt : std::optional{OpCode::DIVIDE};
+    case STAR:
+      return jump ? std::nullopt : std::optional{OpCode::MULTIPLY};
+    default:
+      return std::nullopt;
+  }
+}
+}  // namespace
+
+auto RegisterCompiler::Compile(const FunctionStmt& function)
+    -> std::optional<register_code::Code> {
+  if (!function.IsBodyParsed()) {
+    return std::nullopt;
+  }
+  code_ = register_code::Code{};
+  code_.name = function.GetFunctionName().GetLexeme();
+  code_.arity = function.GetParams().size();
+  target_.reset();
+  scopes_.clear();
+  free_.clear();
+  token_indices_.clear();
+  // Instructions without a token of their own use the function's name.
+  AddToken(function.GetFunctionName());
+
+  try {
+    // The arguments are in the first registers when the frame starts.
+    scopes_.emplace_back();
+    for (const Token& param : function.GetParams()) {
+      Declare(param, Allocate());
+    }
+    for (const auto& statement : function.GetBody()) {
+      CompileStatement(statement);
+    }
+  } catch (const RegisterUnsupported&) {
+    return std::nullopt;
+  }
+
+  // Falling off the end of a function returns nil.
+  Emit(OpCode::RETURN, function.GetFunctionName(),
+       register_code::ConstantOperand(AddConstant(Object{nullptr})));
+  return std::move(code_);
+}
+
+// ====================Statement Visitors====================
+auto RegisterCompiler::operator()(const BlockStmtPtr& stmt) -> void {
+  scopes_.emplace_back();
+  for (const auto& statement : stmt->GetStatements()) {
+    CompileStatement(statement);
+  }
+  EndScope();
+}
+
+auto RegisterCompiler::operator()(const ClassStmtPtr&) -> void {
+  throw RegisterUnsupported("class declaration");
+}
+
+auto RegisterCompiler::operator()(const ExprStmtPtr& stmt) -> void {
+  Release(CompileExpression(stmt->GetExpression()));
+}
+
+auto RegisterCompiler::operator()(const FunctionStmtPtr&) -> void {
+  throw RegisterUnsupported("nested function");
+}
+
+auto RegisterCompiler::operator()(const IfStmtPtr& stmt) -> void {
+  size_t then_jump = CompileCondition(stmt->GetCondition());
+  CompileStatement(stmt->GetThenBranch());
+
+  const std::optional<StmtPtr>& else_branch_opt = stmt->GetElseBranch();
+  if (!else_branch_opt) {
+    PatchJump(then_jump);
+    return;
+  }
+  size_t else_jump = Emit(OpCode::JUMP, code_.tokens[0]);
+  PatchJump(then_jump);
+  CompileStatement(else_branch_opt.value());
+  PatchJump(else_jump);
+}
+
+auto RegisterCompiler::operator()(const PrintStmtPtr& stmt) -> void {
+  Operand value = CompileExpression(stmt->GetExpression());
+  Emit(OpCode::PRINT, code_.tokens[0], value.operand);
+  Release(value);
+}
+
+auto RegisterCompiler::operator()(const ReturnStmtPtr& stmt) -> void {
+  const std::optional<ExprPtr>& value_expr_opt = stmt->GetValue();
+  if (!value_expr_opt) {
+    Emit(OpCode::RETURN, stmt->GetKeyword(),
+         register_code::ConstantOperand(AddConstant(Object{nullptr})));
+    return;
+  }
+  Operand value = CompileExpression(value_expr_opt.value());
+  Emit(OpCode::RETURN, stmt->GetKeyword(), value.operand);
+  Release(value);
+}
+
+auto RegisterCompiler::operator()(const VarStmtPtr& stmt) -> void {
+  // The initializer cannot refer to the variable, so it is computed straight
+  // into the variable's register.
+  uint32_t reg = Allocate();
+  const std::optional<ExprPtr>& initializer_opt = stmt->GetInitializer();
+  if (initializer_opt) {
+    CompileInto(initializer_opt.value(), reg);
+  } else {
+    Emit(OpCode::MOVE, stmt->GetVariable(), reg,
+         register_code::ConstantOperand(AddConstant(Object{nullptr})));
+  }
+  Declare(stmt->GetVariable(), reg);
+}
+
+auto RegisterCompiler::operator()(const WhileStmtPtr& stmt) -> void {
+  auto start = static_cast<uint32_t>(code_.code.size());
+  size_t exit_jump = CompileCondition(stmt->GetCondition());
+  CompileStatement(stmt->GetBody());
+  Emit(OpCode::JUMP, code_.tokens[0], start);
+  PatchJump(exit_jump);
+}
+
+// ====================Expression Visitors====================
+auto RegisterCompiler::operator()(const AssignExprPtr& expr) -> Operand {
+  std::optional<uint32_t> target = std::exchange(target_, std::nullopt);
+  const Token& name = expr->GetVariable();
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(expr);
+  if (depth) {
+    if (std::optional<uint32_t> reg =
+            FindLocal(name.GetLexeme(), depth.value())) {
+      CompileInto(expr->GetValue(), reg.value());
+      return MoveTo(target, Operand{reg.value(), false}, name);
+    }
+  }
+
+  Operand value = CompileExpression(expr->GetValue(), target);
+  if (depth) {
+    Emit(OpCode::SET_FREE, name, value.operand,
+         static_cast<uint32_t>(depth.value() - scopes_.size()));
+  } else {
+    Emit(OpCode::SET_GLOBAL, name, value.operand);
+  }
+  return value;
+}
+
+auto RegisterCompiler::operator()(const BinaryExprPtr& expr) -> Operand {
+  std::optional<uint32_t> target = std::exchange(target_, std::nullopt);
+  const Token& op = expr->GetOperator();
+  std::optional<OpCode> opcode = BinaryOpCode(op.GetType(), false);
+  if (!opcode) {
+    throw RegisterUnsupported("binary operator");
+  }
+
+  Operand left = CompileExpression(expr->GetLeftExpression());
+  if (!left.temporary && !register_code::IsConstant(left.operand) &&
+      AssignsLocal(expr->GetRightExpression())) {
+    // Keep the value the local has before the right operand runs.
+    left = MoveTo(Allocate(), left, op);
+    left.temporary = true;
+  }
+  Operand right = CompileExpression(expr->GetRightExpression());
+  // The operands are read before the result is written, so the result may
+  // reuse their registers.
+  Release(right);
+  Release(left);
+  Operand result = Destination(target);
+  Emit(opcode.value(), op, result.operand, left.operand, right.operand);
+  return result;
+}
+
+auto RegisterCompiler::operator()(const CallExprPtr& expr) -> Operand {
+  std::optional<uint32_t> target = std::exchange(target_, std::nullopt);
+  const std::vector<ExprPtr>& arguments = expr->GetArguments();
+  auto argument_count = static_cast<uint32_t>(arguments.size());
+  // The callee, or the instance of a method call, and then the arguments.
+  uint32_t base = AllocateRange(argument_count + 1);
+
+  // A method call looks the method up before evaluating the arguments, so
+  // the lookup can only be delayed into `INVOKE` past simple arguments.
+  const auto* get = std::get_if<GetExprPtr>(&expr->GetCallee());
+  bool invoke =
+      get != nullptr &&
+      std::all_of(arguments.begin(), arguments.end(),
+                  [&](const ExprPtr& argument) { return IsSimple(argument); });
+  CompileInto(invoke ? (*get)->GetObject() : expr->GetCallee(), base);
+  for (uint32_t i = 0; i < argument_count; i++) {
+    CompileInto(arguments[i], base + 1 + i);
+  }
+  if (invoke) {
+    Emit(OpCode::INVOKE, (*get)->GetProperty(), base, argument_count,
+         AddToken(expr->GetParen()));
+  } else {
+    Emit(OpCode::CALL, expr->GetParen(), base, argument_count);
+  }
+
+  for (uint32_t i = 0; i < argument_count; i++) {
+    Free(base + 1 + i);
+  }
+  return MoveTo(target, Operand{base, true}, expr->GetParen());
+}
+
+auto RegisterCompiler::operator()(const GetExprPtr& expr) -> Operand {
+  std::optional<uint32_t> target = std::exchange(target_, std::nullopt);
+  Operand object = CompileExpression(expr->GetObject());
+  Release(object);
+  Operand result = Destination(target);
+  Emit(OpCode::GET_PROPERTY, expr->GetProperty(), result.operand,
+       object.operand);
+  return result;
+}
+
+auto RegisterCompiler::operator()(const GroupingExprPtr& expr) -> Operand {
+  std::optional<uint32_t> target = std::exchange(target_, std::nullopt);
+  return CompileExpression(expr->GetExpression(), target);
+}
+
+auto RegisterCompiler::operator()(const LiteralExprPtr& expr) -> Operand {
+  std::optional<uint32_t> target = std::exchange(target_, std::nullopt);
+  Operand constant{register_code::ConstantOperand(AddConstant(expr->GetValue())),
+                   false};
+  return MoveTo(target, constant, code_.tokens[0]);
+}
+
+auto RegisterCompiler::operator()(const LogicalExprPtr& expr) -> Operand {
+  std::optional<uint32_t> target = std::exchange(target_, std::nullopt);
+  // The right operand may read the local that is the target, so the result
+  // is built in a temporary.
+  uint32_t result = Allocate();
+  const Token& op = expr->GetOperator();
+  CompileInto(expr->GetLeftExpression(), result);
+  // The left operand is the result when it short-circuits.
+  size_t jump = Emit(op.GetType() == TokenType::OR ? OpCode::JUMP_IF_TRUE
+                                                   : OpCode::JUMP_IF_FALSE,
+                     op, 0, result);
+  CompileInto(expr->GetRightExpression(), result);
+  PatchJump(jump);
+  return MoveTo(target, Operand{result, true}, op);
+}
+
+auto RegisterCompiler::operator()(const SetExprPtr& expr) -> Operand {
+  std::optional<uint32_t> target = std::exchange(target_, std::nullopt);
+  const Token& property = expr->GetProperty();
+  Operand object = CompileExpression(expr->GetObject());
+  if (!object.temporary && !register_code::IsConstant(object.operand) &&
+      AssignsLocal(expr->GetValue())) {
+    object = MoveTo(Allocate(), object, property);
+    object.temporary = true;
+  }
+  Emit(OpCode::CHECK_INSTANCE, property, object.operand);
+  // Not computed into the target, which may be the object's register.
+  Operand value = CompileExpression(expr->GetValue());
+  Emit(OpCode::SET_PROPERTY, property, object.operand, value.operand);
+  Release(object);
+  return MoveTo(target, value, property);
+}
+
+auto RegisterCompiler::operator()(const SuperExprPtr&) -> Operand {
+  throw RegisterUnsupported("super");
+}
+
+auto RegisterCompiler::operator()(const ThisExprPtr& expr) -> Operand {
+  std::optional<uint32_t> target = std::exchange(target_, std::nullopt);
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(expr);
+  if (!depth) {
+    throw RegisterUnsupported("unresolved this");
+  }
+  Operand result = Destination(target);
+  Emit(OpCode::GET_FREE, expr->GetKeyword(), result.operand,
+       static_cast<uint32_t>(depth.value() - scopes_.size()));
+  return result;
+}
+
+auto RegisterCompiler::operator()(const UnaryExprPtr& expr) -> Operand {
+  std::optional<uint32_t> target = std::exchange(target_, std::nullopt);
+  const Token& op = expr->GetOperator();
+  Operand right = CompileExpression(expr->GetRightExpression());
+  Release(right);
+  Operand result = Destination(target);
+  Emit(op.GetType() == TokenType::BANG ? OpCode::NOT : OpCode::NEGATE, op,
+       result.operand, right.operand);
+  return result;
+}
+
+auto RegisterCompiler::operator()(const VariableExprPtr& expr) -> Operand {
+  std::optional<uint32_t> target = std::exchange(target_, std::nullopt);
+  const Token& name = expr->GetVariable();
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(expr);
+  if (!depth) {
+    Operand result = Destination(target);
+    Emit(OpCode::GET_GLOBAL, name, result.operand);
+    return result;
+  }
+  if (std::optional<uint32_t> reg =
+          FindLocal(name.GetLexeme(), depth.value())) {
+    return MoveTo(target, Operand{reg.value(), false}, name);
+  }
+  Operand result = Destination(target);
+  Emit(OpCode::GET_FREE, name, result.operand,
+       static_cast<uint32_t>(depth.value() - scopes_.size()));
+  return result;
+}
+
+// ====================Private Methods====================
+auto RegisterCompiler::CompileStatement(const StmtPtr& stmt) -> void {
+  std::visit(*this, stmt);
+}
+
+auto RegisterCompiler::CompileExpression(const ExprPtr& expr,
+                                         std::optional<uint32_t> target)
+    -> Operand {
+  target_ = target;
+  return std::visit(*this, expr);
+}
+
+auto RegisterCompiler::CompileInto(const ExprPtr& expr, uint32_t target)
+    -> void {
+  CompileExpression(expr, target);
+}
+
+auto RegisterCompiler::CompileCondition(const ExprPtr& condition) -> size_t {
+  const auto* binary = std::get_if<BinaryExprPtr>(&condition);
+  std::optional<OpCode> jump =
+      binary != nullptr
+          ? BinaryOpCode((*binary)->GetOperator().GetType(), true)
+          : std::nullopt;
+  if (!jump) {
+    Operand value = CompileExpression(condition);
+    Release(value);
+    return Emit(OpCode::JUMP_IF_FALSE, code_.tokens[0], 0, value.operand);
+  }
+
+  // Comparisons jump on their operands, without materializing a boolean.
+  const Token& op = (*binary)->GetOperator();
+  Operand left = CompileExpression((*binary)->GetLeftExpression());
+  if (!left.temporary && !register_code::IsConstant(left.operand) &&
+      AssignsLocal((*binary)->GetRightExpression())) {
+    left = MoveTo(Allocate(), left, op);
+    left.temporary = true;
+  }
+  Operand right = CompileExpression((*binary)->GetRightExpression());
+  Release(right);
+  Release(left);
+  return Emit(jump.value(), op, 0, left.operand, right.operand);
+}
+
+auto RegisterCompiler::Destination(std::optional<uint32_t> target)
+    -> Operand {
+  if (target) {
+    return Operand{target.value(), false};
+  }
+  return Operand{Allocate(), true};
+}
+
+auto RegisterCompiler::MoveTo(std::optional<uint32_t> target,
+                              const Operand& operand, const Token& token)
+    -> Operand {
+  if (!target) {
+    return operand;
+  }
+  if (operand.operand != target.value()) {
+    Emit(OpCode::MOVE, token, target.value(), operand.operand);
+    Release(operand);
+  }
+  return Operand{target.value(), false};
+}
+
+auto RegisterCompiler::Emit(OpCode opcode, const Token& token, uint32_t a,
+                            uint32_t b, uint32_t c) -> size_t {
+  register_code::Instruction instruction;
+  instruction.opcode = opcode;
+  instruction.token = AddToken(token);
+  instruction.a = a;
+  instruction.b = b;
+  instruction.c = c;
+  code_.code.push_back(instruction);
+  return code_.code.size() - 1;
+}
+
+auto RegisterCompiler::AddConstant(const Object& value) -> uint32_t {
+  code_.constants.push_back(value);
+  return static_cast<uint32_t>(code_.constants.size() - 1);
+}
+
+auto RegisterCompiler::AddToken(const Token& token) -> uint32_t {
+  // Runtime errors and lookups only use the lexeme and the line.
+  auto key = std::pair{token.GetLineNumber(), token.GetLexeme()};
+  auto [it, inserted] = token_indices_.try_emplace(
+      std::move(key), static_cast<uint32_t>(code_.tokens.size()));
+  if (inserted) {
+    code_.tokens.push_back(token);
+  }
+  return it->second;
+}
+
+auto RegisterCompiler::PatchJump(size_t jump) -> void {
+  code_.code[jump].a = static_cast<uint32_t>(code_.code.size());
+}
+
+// ====================Register allocation====================
+auto RegisterCompiler::Allocate() -> uint32_t {
+  return AllocateRange(1);
+}
+
+auto RegisterCompiler::AllocateRange(uint32_t count) -> uint32_t {
+  auto top = static_cast<uint32_t>(code_.register_count);
+  auto is_free = [&](uint32_t reg) { return reg >= top || free_.contains(reg); };
+  // The lowest free register starting `count` free ones, or the top of the
+  // frame, which grows as needed.
+  uint32_t start = top;
+  for (uint32_t candidate : free_) {
+    uint32_t reg = candidate;
+    while (reg < candidate + count && is_free(reg)) {
+      reg++;
+    }
+    if (reg == candidate + count) {
+      start = candidate;
+      break;
+    }
+  }
+  for (uint32_t reg = start; reg < start + count; reg++) {
+    free_.erase(reg);
+  }
+  code_.register_count = std::max<size_t>(code_.register_count, start + count);
+  return start;
+}
+
+auto RegisterCompiler::Free(uint32_t reg) -> void {
+  free_.insert(reg);
+}
+
+auto RegisterCompiler::Release(const Operand& operand) -> void {
+  if (operand.temporary) {
+    Free(operand.operand);
+  }
+}
+
+auto RegisterCompiler::Declare(const Token& name, uint32_t reg) -> void {
+  scopes_.back()[name.GetLexeme()] = reg;
+}
+
+auto RegisterCompiler::EndScope() -> void {
+  for (const auto& [name, reg] : scopes_.back()) {
+    Free(reg);
+  }
+  scopes_.pop_back();
+}
+
+auto RegisterCompiler::FindLocal(const std::string& name, uint64_t depth) const
+    -> std::optional<uint32_t> {
+  // Deeper variables belong to enclosing functions.
+  if (depth >= scopes_.size()) {
+    return std::nullopt;
+  }
+  const auto& scope = scopes_[scopes_.size() - 1 - depth];
+  auto it = scope.find(name);
+  if (it == scope.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+auto RegisterCompiler::AssignsLocal(const ExprPtr& expr) const -> bool {
+  // Calls cannot assign locals: no closure captures them.
+  if (std::holds_alternative<AssignExprPtr>(expr)) {
+    return true;
+  }
+  if (const auto* binary = std::get_if<BinaryExprPtr>(&expr)) {
+    return AssignsLocal((*binary)->GetLeftExpression()) ||
+           AssignsLocal((*binary)->GetRightExpression());
+  }
+  if (const auto* logical = std::get_if<LogicalExprPtr>(&expr)) {
+    return AssignsLocal((*logical)->GetLeftExpression()) ||
+           AssignsLocal((*logical)->GetRightExpression());
+  }
+  if (const auto* unary = std::get_if<UnaryExprPtr>(&expr)) {
+    return AssignsLocal((*unary)->GetRightExpression());
+  }
+  if (const auto* grouping = std::get_if<GroupingExprPtr>(&expr)) {
+    return AssignsLocal((*grouping)->GetExpression());
+  }
+  if (const auto* get = std::get_if<GetExprPtr>(&expr)) {
+    return AssignsLocal((*get)->GetObject());
+  }
+  if (const auto* set = std::get_if<SetExprPtr>(&expr)) {
+    return AssignsLocal((*set)->GetObject()) ||
+           AssignsLocal((*set)->GetValue());
+  }
+  if (const auto* call = std::get_if<CallExprPtr>(&expr)) {
+    const std::vector<ExprPtr>& arguments = (*call)->GetArguments();
+    return AssignsLocal((*call)->GetCallee()) ||
+           std::any_of(arguments.begin(), arguments.end(),
+                       [&](const ExprPtr& argument) {
+                         return AssignsLocal(argument);
+                       });
+  }
+  return false;
+}
+
+auto RegisterCompiler::IsSimple(const ExprPtr& expr) const -> bool {
+  if (std::holds_alternative<LiteralExprPtr>(expr)) {
+    return true;
+  }
+  const auto* variable = std::get_if<VariableExprPtr>(&expr);
+  if (variable == nullptr) {
+    return false;
+  }
+  std::optional<uint64_t> depth = interpreter_.GetResolvedDepth(*variable);
+  return depth && FindLocal((*variable)->GetVariable().GetLexeme(),
+                            depth.value());
+}
+}  // namespace cclox
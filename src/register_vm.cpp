@@ -0,0 +1,306 @@
+#include "register_vm.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "environment.h"
+#include "interpreter.h"
+#include "lox_instance.h"
+#include "register_compiler.h"
+#include "vm.h"
+#include "vm_operators.h"
+
+namespace cclox {
+using bytecode::OpCode;
+using register_code::Instruction;
+
+auto RegisterVm::TryCall(const FunctionStmt& declaration,
+                         const std::shared_ptr<Environment>& closure,
+                         const std::vector<Object>& arguments)
+    -> std::optional<Object> {
+  register_code::Code* code = Compile(declaration);
+  if (code == nullptr) {
+    return std::nullopt;
+  }
+  return Run(*code, closure, arguments);
+}
+
+auto RegisterVm::Compile(const FunctionStmt& declaration)
+    -> register_code::Code* {
+  auto it = functions_.find(&declaration);
+  if (it == functions_.end()) {
+    std::optional<register_code::Code> code =
+        RegisterCompiler{interpreter_}.Compile(declaration);
+    if (code && dump_ != nullptr) {
+      register_code::Disassemble(code.value(), *dump_);
+    }
+    it = functions_.emplace(&declaration, std::move(code)).first;
+  }
+  return it->second ? &it->second.value() : nullptr;
+}
+
+// Every handler ends with `VM_DISPATCH()`, which jumps straight to the
+// handler of the instruction at `ip`.
+#if CCLOX_THREADED_DISPATCH
+#define VM_CASE(name) op_##name:
+#define VM_DISPATCH() goto* ip->handler
+#else
+#define VM_CASE(name) case register_code::OpCode::name:
+#define VM_DISPATCH() goto dispatch
+#endif
+
+// Source operands name a register or a constant.
+#define VM_OPERAND(operand)                                               \
+  (register_code::IsConstant(operand)                                     \
+       ? constants[register_code::ConstantIndex(operand)]                 \
+       : registers[operand])
+
+auto RegisterVm::Run(register_code::Code& code,
+                     const std::shared_ptr<Environment>& closure,
+                     const std::vector<Object>& arguments) -> Object {
+#if CCLOX_THREADED_DISPATCH
+  static const void* const kHandlers[] = {
+#define CCLOX_REGISTER_OP(name) &&op_##name,
+      CCLOX_REGISTER_OPCODES(CCLOX_REGISTER_OP)
+#undef CCLOX_REGISTER_OP
+  };
+  if (code.threaded_with != kHandlers) {
+    for (Instruction& instruction : code.code) {
+      instruction.handler =
+          kHandlers[static_cast<size_t>(instruction.opcode)];
+    }
+    code.threaded_with = kHandlers;
+  }
+#endif
+
+  const std::shared_ptr<Environment>& globals =
+      interpreter_.GetGlobalEnvironment();
+  const std::vector<Token>& tokens = code.tokens;
+  const std::vector<Object>& constants = code.constants;
+  const Instruction* instructions = code.code.data();
+  const Instruction* ip = instructions;
+
+  // The parameters are the first registers.
+  std::vector<Object> frame(code.register_count);
+  Object* registers = frame.data();
+  std::copy(arguments.begin(), arguments.end(), registers);
+
+#if CCLOX_THREADED_DISPATCH
+  VM_DISPATCH();
+#else
+dispatch:
+  switch (ip->opcode) {
+#endif
+
+  VM_CASE(MOVE) {
+    registers[ip->a] = VM_OPERAND(ip->b);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(GET_GLOBAL) {
+    registers[ip->a] = globals->Get(tokens[ip->token]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(SET_GLOBAL) {
+    globals->Assign(tokens[ip->token], VM_OPERAND(ip->a));
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(GET_FREE) {
+    registers[ip->a] = closure->GetAt(ip->b, tokens[ip->token]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(SET_FREE) {
+    closure->AssignAt(ip->b, tokens[ip->token], VM_OPERAND(ip->a));
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(GET_PROPERTY) {
+    std::optional<LoxInstancePtr> instance_opt =
+        VM_OPERAND(ip->b).AsLoxInstance();
+    if (!instance_opt) {
+      throw RuntimeError(tokens[ip->token], "Only instances have properties.");
+    }
+    registers[ip->a] = instance_opt.value()->GetField(tokens[ip->token]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(CHECK_INSTANCE) {
+    if (!VM_OPERAND(ip->a).AsLoxInstance()) {
+      throw RuntimeError(tokens[ip->token], "Only instances have fields.");
+    }
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(SET_PROPERTY) {
+    VM_OPERAND(ip->a).AsLoxInstance().value()->SetField(tokens[ip->token],
+                                                        VM_OPERAND(ip->b));
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(ADD) {
+    registers[ip->a] = Arithmetic<OpCode::ADD>(
+        VM_OPERAND(ip->b), tokens[ip->token], VM_OPERAND(ip->c));
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(SUBTRACT) {
+    registers[ip->a] = Arithmetic<OpCode::SUBTRACT>(
+        VM_OPERAND(ip->b), tokens[ip->token], VM_OPERAND(ip->c));
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(MULTIPLY) {
+    registers[ip->a] = Arithmetic<OpCode::MULTIPLY>(
+        VM_OPERAND(ip->b), tokens[ip->token], VM_OPERAND(ip->c));
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(DIVIDE) {
+    registers[ip->a] = Interpreter::Divide(VM_OPERAND(ip->b),
+                                           tokens[ip->token], VM_OPERAND(ip->c));
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(EQUAL) {
+    registers[ip->a] = Object{Compare<OpCode::EQUAL>(
+        VM_OPERAND(ip->b), tokens[ip->token], VM_OPERAND(ip->c))};
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(NOT_EQUAL) {
+    registers[ip->a] = Object{Compare<OpCode::NOT_EQUAL>(
+        VM_OPERAND(ip->b), tokens[ip->token], VM_OPERAND(ip->c))};
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(LESS) {
+    registers[ip->a] = Object{Compare<OpCode::LESS>(
+        VM_OPERAND(ip->b), tokens[ip->token], VM_OPERAND(ip->c))};
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(LESS_EQUAL) {
+    registers[ip->a] = Object{Compare<OpCode::LESS_EQUAL>(
+        VM_OPERAND(ip->b), tokens[ip->token], VM_OPERAND(ip->c))};
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(GREATER) {
+    registers[ip->a] = Object{Compare<OpCode::GREATER>(
+        VM_OPERAND(ip->b), tokens[ip->token], VM_OPERAND(ip->c))};
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(GREATER_EQUAL) {
+    registers[ip->a] = Object{Compare<OpCode::GREATER_EQUAL>(
+        VM_OPERAND(ip->b), tokens[ip->token], VM_OPERAND(ip->c))};
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(NEGATE) {
+    registers[ip->a] =
+        Arithmetic<OpCode::SUBTRACT>(Object{static_cast<int32_t>(0)},
+                                     tokens[ip->token], VM_OPERAND(ip->b));
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(NOT) {
+    registers[ip->a] = Object{!VM_OPERAND(ip->b).IsTruthy()};
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP) {
+    ip = instructions + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP_IF_FALSE) {
+    ip = VM_OPERAND(ip->b).IsTruthy() ? ip + 1 : instructions + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP_IF_TRUE) {
+    ip = VM_OPERAND(ip->b).IsTruthy() ? instructions + ip->a : ip + 1;
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP_UNLESS_EQUAL) {
+    ip = Compare<OpCode::EQUAL>(VM_OPERAND(ip->b), tokens[ip->token],
+                                VM_OPERAND(ip->c))
+             ? ip + 1
+             : instructions + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP_UNLESS_NOT_EQUAL) {
+    ip = Compare<OpCode::NOT_EQUAL>(VM_OPERAND(ip->b), tokens[ip->token],
+                                    VM_OPERAND(ip->c))
+             ? ip + 1
+             : instructions + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP_UNLESS_LESS) {
+    ip = Compare<OpCode::LESS>(VM_OPERAND(ip->b), tokens[ip->token],
+                               VM_OPERAND(ip->c))
+             ? ip + 1
+             : instructions + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP_UNLESS_LESS_EQUAL) {
+    ip = Compare<OpCode::LESS_EQUAL>(VM_OPERAND(ip->b), tokens[ip->token],
+                                     VM_OPERAND(ip->c))
+             ? ip + 1
+             : instructions + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP_UNLESS_GREATER) {
+    ip = Compare<OpCode::GREATER>(VM_OPERAND(ip->b), tokens[ip->token],
+                                  VM_OPERAND(ip->c))
+             ? ip + 1
+             : instructions + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP_UNLESS_GREATER_EQUAL) {
+    ip = Compare<OpCode::GREATER_EQUAL>(VM_OPERAND(ip->b), tokens[ip->token],
+                                        VM_OPERAND(ip->c))
+             ? ip + 1
+             : instructions + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(CALL) {
+    Object* callee = registers + ip->a;
+    std::vector<Object> call_arguments(callee + 1, callee + 1 + ip->b);
+    *callee = interpreter_.Call(*callee, call_arguments, tokens[ip->token]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(INVOKE) {
+    Object* receiver = registers + ip->a;
+    std::optional<LoxInstancePtr> instance_opt = receiver->AsLoxInstance();
+    if (!instance_opt) {
+      throw RuntimeError(tokens[ip->token], "Only instances have properties.");
+    }
+    Object method = instance_opt.value()->GetField(tokens[ip->token]);
+    std::vector<Object> call_arguments(receiver + 1, receiver + 1 + ip->b);
+    *receiver = interpreter_.Call(method, call_arguments, tokens[ip->c]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(PRINT) {
+    interpreter_.GetOutputStream() << VM_OPERAND(ip->a).ToString() << '\n';
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(RETURN) {
+    return VM_OPERAND(ip->a);
+  }
+
+#if !CCLOX_THREADED_DISPATCH
+  }
+  return Object{nullptr};
+#endif
+}
+
+#undef VM_OPERAND
+#undef VM_DISPATCH
+#undef VM_CASE
+}  // namespace cclox
@@ -4,6 +4,7 @@
 
 #include "expr.h"
 #include "lox.h"
+#include "parser.h"
 #include "stmt.h"
 
 namespace cclox {
@@ -124,6 +125,24 @@ auto Resolver::ResolveStatement(const StmtPtr& stmt) -> void {
   std::visit(*this, stmt);
 }
 
+auto Resolver::ResolveModule(const std::vector<StmtPtr>& statements) -> void {
+  BeginScope();
+  for (const auto& statement : statements) {
+    if (const auto* var = std::get_if<VarStmtPtr>(&statement)) {
+      Define((*var)->GetVariable());
+    } else if (const auto* function =
+                   std::get_if<FunctionStmtPtr>(&statement)) {
+      Define((*function)->GetFunctionName());
+    } else if (const auto* klass = std::get_if<ClassStmtPtr>(&statement)) {
+      Define((*klass)->GetClassName());
+    }
+  }
+  in_module_ = true;
+  ResolveStatements(statements);
+  in_module_ = false;
+  EndScope();
+}
+
 auto Resolver::ResolveExpression(const ExprPtr& expr) -> void {
   // The visitor needs access to the `expr_var` variable, so we define a lambda
   // instead of implementing overload methods
@@ -222,7 +241,8 @@ auto Resolver::Declare(const Token& variable) -> void {
   }
 
   SymbolTable& scope = scopes_.back();
-  if (scope.contains(variable.GetLexeme())) {
+  bool module_top_level = in_module_ && scopes_.size() == 1;
+  if (scope.contains(variable.GetLexeme()) && !module_top_level) {
     Lox::Error(interpreter_.GetOutputStream(), variable,
                "Already a variable with this name in this scope.");
   }
@@ -246,6 +266,9 @@ auto Resolver::ResolveLocalVariable(const ExprPtr& expr, const Token& variable)
       // Safety check before casting the variable to unsigned type.
       assert(depth >= 0);
       interpreter_.ResolveVariable(expr, static_cast<uint64_t>(depth));
+      if (resolved_ != nullptr) {
+        resolved_->push_back(expr);
+      }
       return;
     }
   }
@@ -262,7 +285,21 @@ auto Resolver::ResolveFunction(const FunctionStmtPtr& function,
     Declare(param);
     Define(param);
   }
-  ResolveStatements(function->GetBody());
+  if (function->IsBodyParsed()) {
+    ResolveStatements(function->GetBody());
+  } else {
+    // The body is resolved once parsed, in the scopes it sees from here.
+    function->GetLazyBody()->resolve =
+        [&interpreter = interpreter_, scopes = scopes_, type,
+         class_type = current_class_](const std::vector<StmtPtr>& body) {
+          Resolver resolver{interpreter};
+          resolver.scopes_ = scopes;
+          resolver.current_function_ = type;
+          resolver.current_class_ = class_type;
+          resolver.ResolveStatements(body);
+        };
+    interpreter_.AddLazyFunction(*function);
+  }
 
   EndScope();
 
@@ -1,4 +1,6 @@
 #include "scanner.h"
+
+#include <algorithm>
 #include <stdexcept>
 #include "object.h"
 #include "token.h"
@@ -20,12 +22,15 @@ namespace cclox {
 // A map of reserved keywords in the Lox language.
 const Scanner::TokenTypeMap Scanner::keywords = {
     {"and", TokenType::AND},
+    {"async",  TokenType::ASYNC},
+    {"await",  TokenType::AWAIT},
     {"class",  TokenType::CLASS},
     {"else",   TokenType::ELSE},
     {"false",  TokenType::FALSE},
     {"for",    TokenType::FOR},
     {"fun",    TokenType::FUN},
     {"if",     TokenType::IF},
+    {"import", TokenType::IMPORT},
     {"nil",    TokenType::NIL},
     {"or",     TokenType::OR},
     {"print",  TokenType::PRINT},
@@ -50,6 +55,27 @@ auto Scanner::ScanTokens() -> std::vector<Token> {
   return tokens_;
 }
 
+auto Scanner::EndsInString(std::string_view line, bool in_string) noexcept
+    -> bool {
+  for (size_t i = 0; i < line.size(); i++) {
+    if (line[i] == '"') {
+      in_string = !in_string;
+    } else if (!in_string && line.substr(i).starts_with("//")) {
+      // The rest of the line is a comment.
+      break;
+    }
+  }
+  return in_string;
+}
+
+auto Scanner::IsIdentifier(std::string_view text) -> bool {
+  if (text.empty() || !IsAlpha(text.front())) {
+    return false;
+  }
+  return std::ranges::all_of(text, IsAlphaNumeric) &&
+         !keywords.contains(std::string{text});
+}
+
 auto Scanner::IsAtEnd() const noexcept -> bool {
   return current_ >= source_.size();
 }
@@ -240,15 +266,15 @@ auto Scanner::PeekNext() const noexcept -> char {
   return source_[current_ + 1];
 }
 
-auto Scanner::IsAlpha(char c) const noexcept -> bool {
+auto Scanner::IsAlpha(char c) noexcept -> bool {
   return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
 }
 
-auto Scanner::IsDigit(char c) const noexcept -> bool {
+auto Scanner::IsDigit(char c) noexcept -> bool {
   return c >= '0' && c <= '9';
 }
 
-auto Scanner::IsAlphaNumeric(char c) const noexcept -> bool {
+auto Scanner::IsAlphaNumeric(char c) noexcept -> bool {
   return IsAlpha(c) || IsDigit(c);
 }
 
@@ -264,4 +290,37 @@ auto Scanner::AddToken(TokenType type, std::optional<Object> literal) -> void {
   std::string text = source_.substr(start_, current_ - start_);
   tokens_.emplace_back(type, std::move(text), std::move(literal), line_number_);
 }
+
+auto StreamScanner::ScanTokens() -> std::vector<Token> {
+  std::string source;
+  uint32_t first_line = line_number_;
+  bool in_string = false;
+  std::string line;
+  while (std::getline(input_, line)) {
+    in_string = Scanner::EndsInString(line, in_string);
+    source += line;
+    // The last line may end without a newline, which would start another.
+    if (!input_.eof()) {
+      line_number_++;
+      source += '\n';
+    }
+    if (in_string) {
+      continue;
+    }
+
+    Scanner scanner{std::move(source), output_, first_line};
+    std::vector<Token> tokens = scanner.ScanTokens();
+    // More lines follow.
+    tokens.pop_back();
+    if (!tokens.empty()) {
+      return tokens;
+    }
+    source.clear();
+    first_line = line_number_;
+  }
+
+  // An unterminated string is reported here.
+  Scanner scanner{std::move(source), output_, first_line};
+  return scanner.ScanTokens();
+}
 }  // namespace cclox
@@ -0,0 +1,354 @@
+#include "server.h"
+
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <sysexits.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <format>
+#include <iostream>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+
+#include "ref_count_arena.h"
+
+namespace cclox {
+namespace {
+// Set when the server is interrupted or terminated.
+volatile std::sig_atomic_t stop_requested = 0;
+
+auto RequestStop(int) -> void {
+  stop_requested = 1;
+}
+
+// A worker that dies sooner than this after it started most likely fails on
+// start, so the next one is started after a delay, which doubles with each
+// such death in a row.
+constexpr std::chrono::seconds kMinWorkerLifetime{1};
+constexpr std::chrono::milliseconds kMinRespawnDelay{100};
+constexpr std::chrono::milliseconds kMaxRespawnDelay{10'000};
+
+/**
+ * @brief Sleeps for `delay`, or until a signal is handled.
+ */
+auto Sleep(std::chrono::milliseconds delay) -> void {
+  timespec duration{
+      .tv_sec = static_cast<time_t>(delay.count() / 1000),
+      .tv_nsec = static_cast<long>(delay.count() % 1000 * 1'000'000)};
+  nanosleep(&duration, nullptr);
+}
+
+/**
+ * @return Whether all of `data` was written before the peer closed.
+ */
+auto WriteAll(int fd, std::string_view data) -> bool {
+  while (!data.empty()) {
+    ssize_t written = send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    data.remove_prefix(static_cast<size_t>(written));
+  }
+  return true;
+}
+}  // namespace
+
+Server::Server(Lox& lox, Object handler, size_t worker_count)
+    : lox_(lox),
+      handler_(std::move(handler)),
+      worker_count_(std::max<size_t>(worker_count, 1)) {}
+
+auto Server::LineReader::Next() -> std::optional<std::string> {
+  while (true) {
+    size_t end = buffer_.find('\n');
+    if (end != std::string::npos) {
+      std::string line = buffer_.substr(0, end);
+      buffer_.erase(0, end + 1);
+      return line;
+    }
+    std::array<char, 4096> chunk;
+    ssize_t count = read(fd_, chunk.data(), chunk.size());
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      // A last line without a newline still counts.
+      if (buffer_.empty()) {
+        return std::nullopt;
+      }
+      return std::exchange(buffer_, {});
+    }
+    buffer_.append(chunk.data(), static_cast<size_t>(count));
+  }
+}
+
+auto Server::ServeSocket(const std::string& path) -> int {
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    std::cerr << "Error: Socket path is too long: " << path << '\n';
+    return EX_USAGE;
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+
+  // A socket left behind by an earlier server is replaced.
+  struct stat info{};
+  if (lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode)) {
+    unlink(path.c_str());
+  }
+  int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0 ||
+      bind(listener, reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) < 0 ||
+      listen(listener, SOMAXCONN) < 0) {
+    std::cerr << std::format("Error: Unable to listen on {}: {}\n", path,
+                             std::strerror(errno));
+    if (listener >= 0) {
+      close(listener);
+    }
+    return EX_UNAVAILABLE;
+  }
+
+  // Without `SA_RESTART`, so that waiting for workers is interrupted.
+  struct sigaction action{};
+  action.sa_handler = RequestStop;
+  sigaction(SIGINT, &action, nullptr);
+  sigaction(SIGTERM, &action, nullptr);
+
+  lox_.PrepareFork();
+  auto serve = [this, listener] {
+    while (true) {
+      int connection = accept(listener, nullptr, nullptr);
+      if (connection < 0) {
+        if (errno == EINTR || errno == ECONNABORTED) {
+          continue;
+        }
+        return;
+      }
+      ServeConnection(connection);
+      close(connection);
+    }
+  };
+  using Clock = std::chrono::steady_clock;
+  // When each worker started.
+  std::unordered_map<pid_t, Clock::time_point> workers;
+  for (size_t i = 0; i < worker_count_; i++) {
+    if (pid_t pid = Fork({}, serve); pid > 0) {
+      workers.emplace(pid, Clock::now());
+    }
+  }
+
+  std::chrono::milliseconds respawn_delay{0};
+  while (stop_requested == 0) {
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // No worker could be forked.
+      break;
+    }
+    auto worker = workers.find(pid);
+    if (worker == workers.end()) {
+      continue;
+    }
+    bool died_early = Clock::now() - worker->second < kMinWorkerLifetime;
+    workers.erase(worker);
+    ReportExit(pid, status);
+    respawn_delay = died_early ? std::clamp(respawn_delay * 2,
+                                            kMinRespawnDelay, kMaxRespawnDelay)
+                               : std::chrono::milliseconds{0};
+    Sleep(respawn_delay);
+    if (stop_requested != 0) {
+      break;
+    }
+    if (pid_t replacement = Fork({}, serve); replacement > 0) {
+      workers.emplace(replacement, Clock::now());
+    }
+  }
+
+  for (const auto& [pid, started] : workers) {
+    kill(pid, SIGTERM);
+  }
+  for (const auto& [pid, started] : workers) {
+    waitpid(pid, nullptr, 0);
+  }
+  close(listener);
+  unlink(path.c_str());
+  return workers.empty() && stop_requested == 0 ? EX_OSERR : 0;
+}
+
+auto Server::ServeStdin() -> int {
+  lox_.PrepareFork();
+  stdin_workers_.resize(worker_count_);
+  for (StdinWorker& worker : stdin_workers_) {
+    if (!StartStdinWorker(worker)) {
+      std::cerr << std::format("Error: Unable to start a worker: {}\n",
+                               std::strerror(errno));
+      return EX_OSERR;
+    }
+  }
+
+  // Workers are handed requests in turn, and each has at most one in flight,
+  // so the responses are read back in the order of the requests.
+  std::deque<size_t> busy;
+  size_t next = 0;
+  std::string request;
+  while (std::getline(std::cin, request)) {
+    size_t index = next++ % worker_count_;
+    if (busy.size() == worker_count_) {
+      WriteResponse(stdin_workers_[busy.front()]);
+      busy.pop_front();
+    }
+    StdinWorker& worker = stdin_workers_[index];
+    request += '\n';
+    if (!WriteAll(worker.fd, request)) {
+      // The worker died between requests: its last one was answered before
+      // it was handed this one, so no response is missing.
+      ReplaceStdinWorker(worker);
+      WriteAll(worker.fd, request);
+    }
+    busy.push_back(index);
+    if (std::cin.rdbuf()->in_avail() == 0) {
+      // Reading the next request may block, so its client must see the
+      // responses so far.
+      std::cout.flush();
+    }
+  }
+  for (size_t index : busy) {
+    WriteResponse(stdin_workers_[index]);
+  }
+  std::cout.flush();
+
+  for (StdinWorker& worker : stdin_workers_) {
+    close(worker.fd);
+  }
+  for (StdinWorker& worker : stdin_workers_) {
+    waitpid(worker.pid, nullptr, 0);
+  }
+  return 0;
+}
+
+template <typename Serve>
+auto Server::Fork(const std::vector<int>& inherited, Serve serve) -> pid_t {
+  // Whatever is buffered would be written again by the worker.
+  std::cout.flush();
+  std::cerr.flush();
+  pid_t pid = fork();
+  if (pid != 0) {
+    return pid;
+  }
+
+  std::signal(SIGINT, SIG_DFL);
+  std::signal(SIGTERM, SIG_DFL);
+  for (int fd : inherited) {
+    close(fd);
+  }
+  dup2(STDERR_FILENO, STDOUT_FILENO);
+  serve();
+  std::cout.flush();
+  // The server's destructors and exit handlers are not the worker's to run.
+  _exit(0);
+}
+
+auto Server::StartStdinWorker(StdinWorker& worker) -> bool {
+  std::array<int, 2> fds{};
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()) < 0) {
+    return false;
+  }
+  // The worker must not hold the other workers' sockets open.
+  std::vector<int> inherited{fds[0]};
+  for (const StdinWorker& other : stdin_workers_) {
+    if (other.fd >= 0) {
+      inherited.push_back(other.fd);
+    }
+  }
+  pid_t pid = Fork(inherited, [this, fd = fds[1]] { ServeConnection(fd); });
+  close(fds[1]);
+  if (pid < 0) {
+    close(fds[0]);
+    return false;
+  }
+  worker.pid = pid;
+  worker.fd = fds[0];
+  worker.reader = LineReader{fds[0]};
+  return true;
+}
+
+auto Server::WriteResponse(StdinWorker& worker) -> void {
+  std::optional<std::string> response = worker.reader.Next();
+  if (response) {
+    std::cout << response.value() << '\n';
+    return;
+  }
+
+  std::cout << "Error: The worker serving the request died.\n";
+  ReplaceStdinWorker(worker);
+}
+
+auto Server::ReplaceStdinWorker(StdinWorker& worker) -> void {
+  close(worker.fd);
+  worker.fd = -1;
+  int status = 0;
+  waitpid(worker.pid, &status, 0);
+  ReportExit(worker.pid, status);
+  if (!StartStdinWorker(worker)) {
+    std::cerr << std::format("Error: Unable to start a worker: {}\n",
+                             std::strerror(errno));
+    std::exit(EX_OSERR);
+  }
+}
+
+auto Server::ServeConnection(int fd) -> void {
+  LineReader reader{fd};
+  while (std::optional<std::string> request = reader.Next()) {
+    std::string response = Respond(request.value());
+    // The request's instances are gone, and so may be whole chunks of their
+    // reference counts.
+    RefCountArena::ReleaseEmptyChunks();
+    // What the handler printed goes out before its response.
+    std::cout.flush();
+    if (!WriteAll(fd, response + '\n')) {
+      return;
+    }
+  }
+}
+
+auto Server::Respond(const std::string& request) -> std::string {
+  try {
+    std::string response = lox_.Call(handler_, {Object{request}}).ToString();
+    // A newline would end the response early.
+    std::replace(response.begin(), response.end(), '\n', ' ');
+    return response;
+  } catch (const RuntimeError& error) {
+    return std::format("{} [line {}]", error.what(),
+                       error.token_.GetLineNumber());
+  }
+}
+
+auto Server::ReportExit(pid_t pid, int status) -> void {
+  if (WIFSIGNALED(status)) {
+    std::cerr << std::format(
+        "Worker {} was killed by signal {}; starting another.\n", pid,
+        WTERMSIG(status));
+  } else {
+    std::cerr << std::format(
+        "Worker {} exited with status {}; starting another.\n", pid,
+        WEXITSTATUS(status));
+  }
+}
+}  // namespace cclox
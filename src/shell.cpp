@@ -9,22 +9,274 @@
 */
 
 #include <sysexits.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
 #include <iostream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "lox.h"
+#include "lox_callable.h"
+#include "server.h"
 
-auto main(int argc, char* argv[]) -> int {
-  if (argc > 2) {
-    std::cout << "Usage: cclox [script]\n";
-    std::exit(EX_USAGE);
+namespace {
+auto PrintUsage() -> void {
+  std::cout << "Usage: cclox [--jit | --jit=force] "
+               "[--trace-jit | --trace-jit=force] [--opt | --opt=background] "
+               "[--dump-ir]\n"
+               "             [--inline-report] [--deopt-stats] [--vm] "
+               "[--vm-profile] [--dump-bytecode]\n"
+               "             [--register-vm] [--dump-registers] [--workers=N] "
+               "[--strict]\n"
+               "             [--fuel=N] [--timeout=MS] [--heap-limit=MB] "
+               "[--heap-stats]\n"
+               "             [script | -]\n"
+               "       cclox --emit-cpp script\n"
+               "       cclox --snapshot-out=PATH [options] script\n"
+               "       cclox --snapshot-in=PATH [--entry=NAME] [options] "
+               "script\n"
+               "       cclox --serve[=N] [--socket=PATH] [options] script\n"
+               "       cclox --batch[=N] [--manifest=PATH] [options] "
+               "[script...]\n";
+  std::exit(EX_USAGE);
+}
+
+auto ParseCount(std::string_view arg) -> size_t {
+  std::string_view count = arg.substr(arg.find('=') + 1);
+  size_t value = 0;
+  auto [end, error] =
+      std::from_chars(count.data(), count.data() + count.size(), value);
+  if (error != std::errc{} || end != count.data() + count.size()) {
+    PrintUsage();
+  }
+  return value;
+}
+
+/**
+ * @brief Reads the paths listed in a manifest, one per line, skipping blank
+ * lines. A manifest named `-` is read from standard input.
+ */
+auto ReadManifest(std::string_view path, std::vector<std::string>& scripts)
+    -> void {
+  std::ifstream file;
+  if (path != "-") {
+    file.open(std::string{path});
+    if (!file.is_open()) {
+      std::cerr << "Error: Unable to open file: " << path << '\n';
+      std::exit(EX_NOINPUT);
+    }
   }
+  std::istream& manifest = path == "-" ? std::cin : file;
+  std::string line;
+  while (std::getline(manifest, line)) {
+    if (!line.empty()) {
+      scripts.push_back(std::move(line));
+    }
+  }
+}
 
+/**
+ * @brief Loads `script` and serves requests with its `handle` function.
+ * @return The exit code.
+ */
+auto Serve(cclox::Lox& lox, std::string_view script, size_t worker_count,
+           std::optional<std::string_view> socket) -> int {
+  if (!lox.Load(script)) {
+    return EX_DATAERR;
+  }
+  std::optional<cclox::Object> handler = lox.GetGlobal("handle");
+  if (!handler || !handler->IsLoxFunction() ||
+      handler->AsLoxCallable().value()->Arity() != 1) {
+    std::cerr << "Error: The script must define a function handle(request).\n";
+    return EX_DATAERR;
+  }
+  cclox::Server server{lox, handler.value(), worker_count};
+  return socket ? server.ServeSocket(std::string{socket.value()})
+                : server.ServeStdin();
+}
+}  // namespace
+
+auto main(int argc, char* argv[]) -> int {
   cclox::Lox lox;
-  if (argc == 2) {
-    lox.RunFile(argv[1]);
+  // Function bodies are parsed on first call unless `--strict` asks for
+  // every syntax error up front.
+  lox.SetLazyParsingEnabled(true);
+  std::vector<std::string_view> scripts;
+  bool emit_cpp = false;
+  bool deopt_stats = false;
+  bool vm_profile = false;
+  std::optional<size_t> serve;
+  std::optional<std::string_view> socket;
+  std::optional<size_t> batch;
+  std::vector<std::string_view> manifests;
+  std::optional<std::string_view> snapshot_out;
+  std::optional<std::string_view> snapshot_in;
+  std::string entry = "main";
+  std::optional<uint64_t> fuel;
+  std::optional<std::chrono::milliseconds> timeout;
+  std::optional<size_t> heap_limit;
+  bool heap_stats = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string_view arg{argv[i]};
+    if (arg == "--jit") {
+      lox.SetJitMode(cclox::JitMode::ON);
+    } else if (arg == "--jit=force") {
+      lox.SetJitMode(cclox::JitMode::FORCE);
+    } else if (arg == "--trace-jit") {
+      lox.SetTraceJitMode(cclox::JitMode::ON);
+    } else if (arg == "--trace-jit=force") {
+      lox.SetTraceJitMode(cclox::JitMode::FORCE);
+    } else if (arg == "--opt") {
+      lox.SetOptimizerEnabled(true);
+    } else if (arg == "--opt=background") {
+      lox.SetOptimizerEnabled(true);
+      lox.SetBackgroundCompileEnabled(true);
+    } else if (arg == "--dump-ir") {
+      lox.SetOptimizerEnabled(true);
+      lox.SetIrDumpStream(&std::cerr);
+    } else if (arg == "--inline-report") {
+      lox.SetOptimizerEnabled(true);
+      lox.SetInlineReportStream(&std::cerr);
+    } else if (arg == "--deopt-stats") {
+      lox.SetOptimizerEnabled(true);
+      deopt_stats = true;
+    } else if (arg == "--vm") {
+      lox.SetVmEnabled(true);
+    } else if (arg == "--vm-profile") {
+      lox.SetVmEnabled(true);
+      lox.SetVmProfileEnabled(true);
+      vm_profile = true;
+    } else if (arg == "--dump-bytecode") {
+      lox.SetVmEnabled(true);
+      lox.SetBytecodeDumpStream(&std::cerr);
+    } else if (arg == "--register-vm") {
+      lox.SetRegisterVmEnabled(true);
+    } else if (arg == "--dump-registers") {
+      lox.SetRegisterVmEnabled(true);
+      lox.SetRegisterCodeDumpStream(&std::cerr);
+    } else if (arg.starts_with("--workers=")) {
+      lox.SetWorkerCount(ParseCount(arg));
+    } else if (arg == "--serve") {
+      serve = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    } else if (arg.starts_with("--serve=")) {
+      serve = ParseCount(arg);
+    } else if (arg.starts_with("--socket=")) {
+      socket = arg.substr(arg.find('=') + 1);
+    } else if (arg == "--batch") {
+      batch = 1;
+    } else if (arg.starts_with("--batch=")) {
+      batch = ParseCount(arg);
+    } else if (arg.starts_with("--manifest=")) {
+      manifests.push_back(arg.substr(arg.find('=') + 1));
+    } else if (arg.starts_with("--fuel=")) {
+      fuel = ParseCount(arg);
+    } else if (arg.starts_with("--timeout=")) {
+      timeout = std::chrono::milliseconds{
+          static_cast<std::chrono::milliseconds::rep>(ParseCount(arg))};
+    } else if (arg.starts_with("--heap-limit=")) {
+      size_t megabytes = ParseCount(arg);
+      if (megabytes > SIZE_MAX >> 20) {
+        PrintUsage();
+      }
+      heap_limit = megabytes << 20;
+    } else if (arg == "--heap-stats") {
+      heap_stats = true;
+    } else if (arg == "--strict") {
+      lox.SetLazyParsingEnabled(false);
+    } else if (arg.starts_with("--snapshot-out=")) {
+      snapshot_out = arg.substr(arg.find('=') + 1);
+    } else if (arg.starts_with("--snapshot-in=")) {
+      snapshot_in = arg.substr(arg.find('=') + 1);
+    } else if (arg.starts_with("--entry=")) {
+      entry = arg.substr(arg.find('=') + 1);
+    } else if (arg == "--emit-cpp") {
+      emit_cpp = true;
+    } else if (arg.starts_with("--")) {
+      PrintUsage();
+    } else {
+      scripts.push_back(arg);
+    }
+  }
+
+  lox.SetExecutionBudget(fuel, timeout);
+  if (heap_limit || heap_stats) {
+    lox.SetHeapLimit(heap_limit);
+  }
+
+  bool batch_mode = batch || !manifests.empty();
+  if (scripts.size() > 1 && !batch_mode) {
+    PrintUsage();
+  }
+  std::optional<std::string_view> script;
+  if (!scripts.empty()) {
+    script = scripts.front();
+  }
+
+  if (emit_cpp) {
+    if (!script || batch_mode) {
+      PrintUsage();
+    }
+    return lox.EmitCpp(script.value(), std::cout) ? 0 : EX_DATAERR;
+  }
+
+  if (snapshot_out || snapshot_in) {
+    if (!script || script == "-" || batch_mode || serve || socket ||
+        (snapshot_out && snapshot_in)) {
+      PrintUsage();
+    }
+    bool ok = snapshot_out
+                  ? lox.SnapshotFile(script.value(), snapshot_out.value())
+                  : lox.RunFromSnapshot(script.value(), snapshot_in.value(),
+                                        entry);
+    return ok ? 0 : EX_DATAERR;
+  }
+
+  if (serve || socket) {
+    if (!script || serve == 0 || batch_mode) {
+      PrintUsage();
+    }
+    size_t worker_count =
+        serve.value_or(std::max<size_t>(std::thread::hardware_concurrency(), 1));
+    return Serve(lox, script.value(), worker_count, socket);
+  }
+
+  int status = 0;
+  if (batch_mode) {
+    if (batch == 0) {
+      PrintUsage();
+    }
+    std::vector<std::string> paths{scripts.begin(), scripts.end()};
+    for (std::string_view manifest : manifests) {
+      ReadManifest(manifest, paths);
+    }
+    status = lox.RunBatch(paths, batch.value_or(1)) ? 0 : EX_DATAERR;
+  } else if (script == "-") {
+    lox.RunStream(std::cin);
+  } else if (script) {
+    lox.RunFile(script.value());
   } else {
     lox.RunPrompt();
   }
+  if (deopt_stats) {
+    lox.PrintDeoptStats(std::cerr);
+  }
+  if (vm_profile) {
+    lox.PrintVmProfile(std::cerr);
+  }
+  if (heap_stats) {
+    cclox::HeapUsage usage = lox.GetHeapUsage();
+    std::cerr << "Heap: " << usage.current << " bytes in use, " << usage.peak
+              << " bytes at peak\n";
+  }
 
-  return 0;
+  return status;
 }
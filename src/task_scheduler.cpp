@@ -0,0 +1,245 @@
+#include "task_scheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace cclox {
+namespace {
+// The scheduler and worker the current thread belongs to, if any.
+thread_local const TaskScheduler* current_scheduler = nullptr;
+thread_local size_t current_worker = 0;
+
+/**
+ * @brief Calls `sleep` with `timeout`, or with what is left until `deadline`
+ * if that is sooner.
+ * @return Whether `deadline` was still ahead.
+ */
+auto SleepBefore(const std::function<void(std::chrono::microseconds)>& sleep,
+                 std::chrono::microseconds timeout,
+                 const TaskScheduler::Deadline& deadline) -> bool {
+  if (deadline) {
+    auto left = std::chrono::ceil<std::chrono::microseconds>(
+        deadline.value() - std::chrono::steady_clock::now());
+    if (left.count() <= 0) {
+      return false;
+    }
+    timeout = std::min(timeout, left);
+  }
+  sleep(timeout);
+  return true;
+}
+}  // namespace
+
+// ====================LoxFuture====================
+auto LoxFuture::Call(Interpreter& interpreter, const std::vector<Object>&)
+    -> Object {
+  return Await(interpreter);
+}
+
+auto LoxFuture::Await(Interpreter& interpreter) -> Object {
+  if (&interpreter != &spawner_) {
+    throw NativeError("Only the spawner of a task can await it.");
+  }
+  if (!interpreter.GetTaskScheduler().Wait(
+          *this, interpreter.GetExecutionLimits().deadline)) {
+    throw NativeError("Time limit exceeded.");
+  }
+  interpreter.GetOutputStream() << std::exchange(output_, {});
+  if (error_) {
+    throw error_.value();
+  }
+  return result_;
+}
+
+auto LoxFuture::Complete(Object result, std::string output) -> void {
+  std::lock_guard lock{mutex_};
+  result_ = std::move(result);
+  output_ = std::move(output);
+  done_ = true;
+  done_condition_.notify_all();
+}
+
+auto LoxFuture::Fail(RuntimeError error, std::string output) -> void {
+  std::lock_guard lock{mutex_};
+  error_ = std::move(error);
+  output_ = std::move(output);
+  done_ = true;
+  done_condition_.notify_all();
+}
+
+auto LoxFuture::IsDone() const -> bool {
+  std::lock_guard lock{mutex_};
+  return done_;
+}
+
+auto LoxFuture::WaitFor(std::chrono::microseconds timeout) const -> void {
+  std::unique_lock lock{mutex_};
+  done_condition_.wait_for(lock, timeout, [this] { return done_; });
+}
+
+// ====================TaskScheduler====================
+TaskScheduler::TaskScheduler(Interpreter& root, size_t worker_count)
+    : root_(root), worker_count_(worker_count) {
+  // Workers steal from each other, so all of them exist before any starts.
+  for (size_t i = 0; i < worker_count + kMaxBlockedWorkers; i++) {
+    workers_.push_back(std::make_unique<Worker>());
+  }
+  for (size_t i = 0; i < worker_count; i++) {
+    StartWorker();
+  }
+}
+
+TaskScheduler::~TaskScheduler() {
+  {
+    std::lock_guard lock{idle_mutex_};
+    stopping_ = true;
+  }
+  idle_condition_.notify_all();
+  for (size_t i = 0; i < started_.load(); i++) {
+    workers_[i]->thread.join();
+  }
+}
+
+auto TaskScheduler::Submit(Job job) -> void {
+  size_t index = current_scheduler == this
+                     ? current_worker
+                     : next_worker_.fetch_add(1) % started_.load();
+  {
+    Worker& worker = *workers_[index];
+    std::lock_guard lock{worker.mutex};
+    worker.jobs.push_back(std::move(job));
+  }
+  queued_.fetch_add(1);
+  {
+    // Idle workers check `queued_` holding the lock, so they cannot miss this.
+    std::lock_guard lock{idle_mutex_};
+  }
+  idle_condition_.notify_one();
+}
+
+auto TaskScheduler::Wait(const LoxFuture& future, const Deadline& deadline)
+    -> bool {
+  return WaitUntil([&future] { return future.IsDone(); },
+                   [&future](std::chrono::microseconds timeout) {
+                     future.WaitFor(timeout);
+                   },
+                   deadline);
+}
+
+auto TaskScheduler::WaitUntil(
+    const std::function<bool()>& ready,
+    const std::function<void(std::chrono::microseconds)>& sleep,
+    const Deadline& deadline) -> bool {
+  if (current_scheduler != this) {
+    while (!ready()) {
+      if (!SleepBefore(sleep, std::chrono::milliseconds{10}, deadline)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  while (!ready()) {
+    if (std::optional<Job> job = Take(current_worker)) {
+      Run(current_worker, job.value());
+    } else {
+      // What we wait for happens on another worker; check for new jobs now
+      // and then.
+      if (!SleepBefore(sleep, std::chrono::microseconds{100}, deadline)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+auto TaskScheduler::BlockUntil(
+    const std::function<bool()>& ready,
+    const std::function<void(std::chrono::microseconds)>& sleep,
+    const Deadline& deadline) -> bool {
+  bool on_worker = current_scheduler == this;
+  if (on_worker) {
+    size_t blocked = blocked_.fetch_add(1) + 1;
+    std::lock_guard lock{start_mutex_};
+    size_t started = started_.load();
+    if (started - blocked < worker_count_ && started < workers_.size()) {
+      StartWorker();
+    }
+  }
+  bool done = true;
+  while (!ready()) {
+    if (cancelled_.load() ||
+        !SleepBefore(sleep, std::chrono::milliseconds{10}, deadline)) {
+      done = false;
+      break;
+    }
+  }
+  if (on_worker) {
+    blocked_.fetch_sub(1);
+  }
+  return done;
+}
+
+auto TaskScheduler::StartWorker() -> void {
+  // Jobs can be dealt to the worker, or stolen from it, before it runs.
+  size_t index = started_.fetch_add(1);
+  workers_[index]->thread = std::thread{[this, index] { RunWorker(index); }};
+}
+
+auto TaskScheduler::RunWorker(size_t index) -> void {
+  current_scheduler = this;
+  current_worker = index;
+  while (true) {
+    if (std::optional<Job> job = Take(index)) {
+      Run(index, job.value());
+      continue;
+    }
+    std::unique_lock lock{idle_mutex_};
+    idle_condition_.wait(lock,
+                         [this] { return stopping_ || queued_.load() > 0; });
+    if (stopping_) {
+      return;
+    }
+  }
+}
+
+auto TaskScheduler::Take(size_t index) -> std::optional<Job> {
+  {
+    Worker& worker = *workers_[index];
+    std::lock_guard lock{worker.mutex};
+    if (!worker.jobs.empty()) {
+      Job job = std::move(worker.jobs.back());
+      worker.jobs.pop_back();
+      queued_.fetch_sub(1);
+      return job;
+    }
+  }
+  size_t started = started_.load();
+  for (size_t i = 1; i < started; i++) {
+    Worker& victim = *workers_[(index + i) % started];
+    std::lock_guard lock{victim.mutex};
+    if (!victim.jobs.empty()) {
+      Job job = std::move(victim.jobs.front());
+      victim.jobs.pop_front();
+      queued_.fetch_sub(1);
+      return job;
+    }
+  }
+  return std::nullopt;
+}
+
+auto TaskScheduler::Run(size_t index, Job& job) -> void {
+  Worker& worker = *workers_[index];
+  if (worker.contexts.size() == worker.depth) {
+    worker.contexts.push_back(std::make_unique<TaskContext>(root_));
+  }
+  TaskContext& context = *worker.contexts[worker.depth];
+  uint64_t program = program_.load();
+  if (context.program != program) {
+    context.interpreter.ClearCompiledCode();
+    context.program = program;
+  }
+  worker.depth++;
+  job(context);
+  worker.depth--;
+}
+}  // namespace cclox
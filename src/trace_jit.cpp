@@ -0,0 +1,880 @@
+#include "trace_jit.h"
+
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <tuple>
+#include <variant>
+
+#include "environment.h"
+#include "expr.h"
+#include "interpreter.h"
+#include "token_type.h"
+
+namespace cclox {
+/**
+ * @brief Thrown when an iteration leaves what traces can express, e.g. a call,
+ * a `print`, or a non-integer value. The loop is then never traced again.
+ */
+class TraceAborted : public std::runtime_error {
+ public:
+  explicit TraceAborted(const std::string& message)
+      : std::runtime_error(message) {}
+};
+
+/**
+ * @brief Records one iteration of a loop as a linear trace.
+ *
+ * Every expression is evaluated twice at once: symbolically, as the id of the
+ * trace instruction producing it, and concretely, with the value it has in
+ * this iteration. The concrete value decides which branch is recorded.
+ * Redundant loads never reach the trace since each slot's current value is
+ * tracked; constant operands are folded and identical pure instructions are
+ * emitted once.
+ */
+class TraceRecorder {
+ public:
+  /**
+   * @param slots The slots of the loop's earlier traces. Their types must not
+   * change, so traces can fall through to one another.
+   */
+  TraceRecorder(Interpreter& interpreter,
+                const std::shared_ptr<Environment>& environment,
+                std::vector<TraceSlot> slots)
+      : interpreter_(interpreter),
+        environment_(environment),
+        slot_values_(slots.size()) {
+    for (TraceSlot& slot : slots) {
+      slot.written = false;
+    }
+    trace_.slots = std::move(slots);
+  }
+
+  /**
+   * @brief Records the next iteration of `loop`.
+   * @return The trace, or `std::nullopt` if the loop is about to finish.
+   * @throws TraceAborted if the iteration cannot be traced.
+   */
+  auto Record(const WhileStmt& loop) -> std::optional<Trace>;
+
+  // ====================Statements====================
+  auto operator()(const BlockStmtPtr& stmt) -> void;
+
+  auto operator()(const ClassStmtPtr& stmt) -> void;
+
+  auto operator()(const ExprStmtPtr& stmt) -> void;
+
+  auto operator()(const FunctionStmtPtr& stmt) -> void;
+
+  auto operator()(const IfStmtPtr& stmt) -> void;
+
+  auto operator()(const PrintStmtPtr& stmt) -> void;
+
+  auto operator()(const ReturnStmtPtr& stmt) -> void;
+
+  auto operator()(const VarStmtPtr& stmt) -> void;
+
+  auto operator()(const WhileStmtPtr& stmt) -> void;
+
+  // ====================Expressions====================
+  struct Value {
+    int32_t id;
+    bool is_bool;
+    // The value in the iteration being recorded; 0 or 1 for booleans.
+    int32_t current;
+  };
+
+  auto operator()(const AssignExprPtr& expr) -> Value;
+
+  auto operator()(const BinaryExprPtr& expr) -> Value;
+
+  auto operator()(const CallExprPtr& expr) -> Value;
+
+  auto operator()(const GetExprPtr& expr) -> Value;
+
+  auto operator()(const GroupingExprPtr& expr) -> Value;
+
+  auto operator()(const LiteralExprPtr& expr) -> Value;
+
+  auto operator()(const LogicalExprPtr& expr) -> Value;
+
+  auto operator()(const SetExprPtr& expr) -> Value;
+
+  auto operator()(const SuperExprPtr& expr) -> Value;
+
+  auto operator()(const ThisExprPtr& expr) -> Value;
+
+  auto operator()(const UnaryExprPtr& expr) -> Value;
+
+  auto operator()(const VariableExprPtr& expr) -> Value;
+
+ private:
+  auto RecordStatement(const StmtPtr& stmt) -> void;
+
+  auto RecordExpression(const ExprPtr& expr) -> Value;
+
+  /**
+   * @brief Appends an instruction, or returns an identical pure instruction
+   * that was already emitted.
+   */
+  auto Emit(TraceOp op, int32_t a = -1, int32_t b = -1, int32_t imm = 0)
+      -> int32_t;
+
+  auto Constant(int32_t value, bool is_bool) -> Value;
+
+  auto IsConstant(const Value& value) const -> bool;
+
+  /**
+   * @brief Converts a value to a boolean; integers are truthy unless 0.
+   */
+  auto Truthy(const Value& value) -> Value;
+
+  auto Guard(const Value& condition) -> void;
+
+  /**
+   * @brief Finds (or creates) the slot of an outer variable.
+   */
+  auto Slot(const Token& variable, const ExprPtr& expr) -> size_t;
+
+  /**
+   * @brief Finds a variable declared inside the loop body.
+   */
+  auto FindBodyLocal(const std::string& name) -> Value*;
+
+  Interpreter& interpreter_;
+  const std::shared_ptr<Environment>& environment_;
+  Trace trace_;
+  // The value each slot holds at this point of the iteration.
+  std::vector<std::optional<Value>> slot_values_;
+  // Variables declared inside the loop body, one map per block.
+  std::vector<std::unordered_map<std::string, Value>> scopes_;
+  std::map<std::tuple<TraceOp, int32_t, int32_t, int32_t>, int32_t> emitted_;
+};
+
+auto TraceRecorder::Record(const WhileStmt& loop) -> std::optional<Trace> {
+  Value condition = Truthy(RecordExpression(loop.GetCondition()));
+  if (condition.current == 0) {
+    return std::nullopt;
+  }
+  if (!IsConstant(condition)) {
+    Emit(TraceOp::EXIT_IF_FALSE, condition.id);
+  }
+
+  RecordStatement(loop.GetBody());
+
+  for (size_t slot = 0; slot < trace_.slots.size(); slot++) {
+    const std::optional<Value>& value = slot_values_[slot];
+    if (!trace_.slots[slot].written) {
+      continue;
+    }
+    const TraceInstruction& definition =
+        trace_.instructions[static_cast<size_t>(value->id)];
+    // Storing back the value that was loaded is a no-op.
+    if (definition.op == TraceOp::LOAD &&
+        definition.a == static_cast<int32_t>(slot)) {
+      trace_.slots[slot].written = false;
+      continue;
+    }
+    trace_.instructions.push_back(
+        TraceInstruction{TraceOp::STORE, static_cast<int32_t>(slot),
+                         value->id, 0});
+  }
+
+  return std::move(trace_);
+}
+
+// ====================Statements====================
+auto TraceRecorder::operator()(const BlockStmtPtr& stmt) -> void {
+  scopes_.emplace_back();
+  for (const auto& statement : stmt->GetStatements()) {
+    RecordStatement(statement);
+  }
+  scopes_.pop_back();
+}
+
+auto TraceRecorder::operator()(const ClassStmtPtr&) -> void {
+  throw TraceAborted("class declaration");
+}
+
+auto TraceRecorder::operator()(const ExprStmtPtr& stmt) -> void {
+  RecordExpression(stmt->GetExpression());
+}
+
+auto TraceRecorder::operator()(const FunctionStmtPtr&) -> void {
+  throw TraceAborted("function declaration");
+}
+
+auto TraceRecorder::operator()(const IfStmtPtr& stmt) -> void {
+  Value condition = Truthy(RecordExpression(stmt->GetCondition()));
+  Guard(condition);
+  if (condition.current != 0) {
+    RecordStatement(stmt->GetThenBranch());
+  } else if (stmt->GetElseBranch()) {
+    RecordStatement(stmt->GetElseBranch().value());
+  }
+}
+
+auto TraceRecorder::operator()(const PrintStmtPtr&) -> void {
+  throw TraceAborted("print statement");
+}
+
+auto TraceRecorder::operator()(const ReturnStmtPtr&) -> void {
+  throw TraceAborted("return statement");
+}
+
+auto TraceRecorder::operator()(const VarStmtPtr& stmt) -> void {
+  const std::optional<ExprPtr>& initializer = stmt->GetInitializer();
+  if (!initializer) {
+    throw TraceAborted("nil local");
+  }
+  Value value = RecordExpression(initializer.value());
+  if (scopes_.empty()) {
+    throw TraceAborted("declaration outside a block");
+  }
+  scopes_.back().insert_or_assign(stmt->GetVariable().GetLexeme(), value);
+}
+
+auto TraceRecorder::operator()(const WhileStmtPtr&) -> void {
+  // Inner loops get their own traces.
+  throw TraceAborted("nested loop");
+}
+
+// ====================Expressions====================
+auto TraceRecorder::operator()(const AssignExprPtr& expr) -> Value {
+  Value value = RecordExpression(expr->GetValue());
+
+  const std::string& name = expr->GetVariable().GetLexeme();
+  if (Value* local = FindBodyLocal(name)) {
+    *local = value;
+    return value;
+  }
+
+  size_t slot = Slot(expr->GetVariable(), expr);
+  if (trace_.slots[slot].is_bool != value.is_bool) {
+    throw TraceAborted("variable changes type");
+  }
+  slot_values_[slot] = value;
+  trace_.slots[slot].written = true;
+  return value;
+}
+
+auto TraceRecorder::operator()(const BinaryExprPtr& expr) -> Value {
+  using enum TokenType;
+  Value left = RecordExpression(expr->GetLeftExpression());
+  Value right = RecordExpression(expr->GetRightExpression());
+  TokenType type = expr->GetOperator().GetType();
+
+  if (type == EQUAL_EQUAL || type == BANG_EQUAL) {
+    if (left.is_bool != right.is_bool) {
+      // An integer never equals a boolean.
+      return Constant(type == BANG_EQUAL ? 1 : 0, true);
+    }
+    bool equal = left.current == right.current;
+    bool result = type == EQUAL_EQUAL ? equal : !equal;
+    if (IsConstant(left) && IsConstant(right)) {
+      return Constant(result ? 1 : 0, true);
+    }
+    TraceOp op = type == EQUAL_EQUAL ? TraceOp::EQ : TraceOp::NE;
+    return Value{Emit(op, left.id, right.id), true, result ? 1 : 0};
+  }
+
+  if (left.is_bool || right.is_bool) {
+    throw TraceAborted("non-integer operand");
+  }
+
+  TraceOp op;
+  bool is_bool = false;
+  int32_t result = 0;
+  int32_t a = left.current;
+  int32_t b = right.current;
+  switch (type) {
+    case PLUS:
+      op = TraceOp::ADD;
+      if (__builtin_add_overflow(a, b, &result)) {
+        throw TraceAborted("integer overflow");
+      }
+      break;
+    case MINUS:
+      op = TraceOp::SUB;
+      if (__builtin_sub_overflow(a, b, &result)) {
+        throw TraceAborted("integer overflow");
+      }
+      break;
+    case STAR:
+      op = TraceOp::MUL;
+      if (__builtin_mul_overflow(a, b, &result)) {
+        throw TraceAborted("integer overflow");
+      }
+      break;
+    case SLASH:
+      op = TraceOp::DIV;
+      if (b == 0 || (a == INT32_MIN && b == -1)) {
+        throw TraceAborted("invalid division");
+      }
+      result = a / b;
+      break;
+    case GREATER:
+      op = TraceOp::GT;
+      is_bool = true;
+      result = a > b ? 1 : 0;
+      break;
+    case GREATER_EQUAL:
+      op = TraceOp::GE;
+      is_bool = true;
+      result = a >= b ? 1 : 0;
+      break;
+    case LESS:
+      op = TraceOp::LT;
+      is_bool = true;
+      result = a < b ? 1 : 0;
+      break;
+    case LESS_EQUAL:
+      op = TraceOp::LE;
+      is_bool = true;
+      result = a <= b ? 1 : 0;
+      break;
+    default:
+      throw TraceAborted("unknown binary operator");
+  }
+
+  if (IsConstant(left) && IsConstant(right)) {
+    return Constant(result, is_bool);
+  }
+  return Value{Emit(op, left.id, right.id), is_bool, result};
+}
+
+auto TraceRecorder::operator()(const CallExprPtr&) -> Value {
+  throw TraceAborted("call");
+}
+
+auto TraceRecorder::operator()(const GetExprPtr&) -> Value {
+  throw TraceAborted("property access");
+}
+
+auto TraceRecorder::operator()(const GroupingExprPtr& expr) -> Value {
+  return RecordExpression(expr->GetExpression());
+}
+
+auto TraceRecorder::operator()(const LiteralExprPtr& expr) -> Value {
+  const Object& value = expr->GetValue();
+  if (value.IsInteger()) {
+    return Constant(value.Get<int32_t>(), false);
+  }
+  if (value.IsBool()) {
+    return Constant(value.Get<bool>() ? 1 : 0, true);
+  }
+  throw TraceAborted("non-integer literal");
+}
+
+auto TraceRecorder::operator()(const LogicalExprPtr& expr) -> Value {
+  // The result is one of the operands, so record the path actually taken and
+  // guard on the left operand's truthiness.
+  Value left = RecordExpression(expr->GetLeftExpression());
+  bool is_or = expr->GetOperator().GetType() == TokenType::OR;
+  Value condition = Truthy(left);
+  bool truthy = condition.current != 0;
+  Guard(condition);
+  if (truthy == is_or) {
+    return left;
+  }
+  return RecordExpression(expr->GetRightExpression());
+}
+
+auto TraceRecorder::operator()(const SetExprPtr&) -> Value {
+  throw TraceAborted("property assignment");
+}
+
+auto TraceRecorder::operator()(const SuperExprPtr&) -> Value {
+  throw TraceAborted("super");
+}
+
+auto TraceRecorder::operator()(const ThisExprPtr&) -> Value {
+  throw TraceAborted("this");
+}
+
+auto TraceRecorder::operator()(const UnaryExprPtr& expr) -> Value {
+  Value right = RecordExpression(expr->GetRightExpression());
+
+  if (expr->GetOperator().GetType() == TokenType::BANG) {
+    Value condition = Truthy(right);
+    int32_t result = condition.current == 0 ? 1 : 0;
+    if (IsConstant(condition)) {
+      return Constant(result, true);
+    }
+    return Value{Emit(TraceOp::NOT, condition.id), true, result};
+  }
+
+  if (right.is_bool || right.current == INT32_MIN) {
+    throw TraceAborted("invalid negation");
+  }
+  if (IsConstant(right)) {
+    return Constant(-right.current, false);
+  }
+  return Value{Emit(TraceOp::NEG, right.id), false, -right.current};
+}
+
+auto TraceRecorder::operator()(const VariableExprPtr& expr) -> Value {
+  const Token& variable = expr->GetVariable();
+  if (Value* local = FindBodyLocal(variable.GetLexeme())) {
+    return *local;
+  }
+
+  size_t slot = Slot(variable, expr);
+  return slot_values_[slot].value();
+}
+
+// ====================Private helpers====================
+auto TraceRecorder::RecordStatement(const StmtPtr& stmt) -> void {
+  std::visit(*this, stmt);
+}
+
+auto TraceRecorder::RecordExpression(const ExprPtr& expr) -> Value {
+  return std::visit(*this, expr);
+}
+
+auto TraceRecorder::Emit(TraceOp op, int32_t a, int32_t b, int32_t imm)
+    -> int32_t {
+  bool pure = op != TraceOp::GUARD_TRUE && op != TraceOp::GUARD_FALSE &&
+              op != TraceOp::EXIT_IF_FALSE && op != TraceOp::STORE;
+  auto key = std::make_tuple(op, a, b, imm);
+  if (pure) {
+    auto it = emitted_.find(key);
+    if (it != emitted_.end()) {
+      return it->second;
+    }
+  }
+
+  auto id = static_cast<int32_t>(trace_.instructions.size());
+  trace_.instructions.push_back(TraceInstruction{op, a, b, imm});
+  if (pure) {
+    emitted_.emplace(key, id);
+  }
+  return id;
+}
+
+auto TraceRecorder::Constant(int32_t value, bool is_bool) -> Value {
+  return Value{Emit(TraceOp::CONST, -1, -1, value), is_bool, value};
+}
+
+auto TraceRecorder::IsConstant(const Value& value) const -> bool {
+  return trace_.instructions[static_cast<size_t>(value.id)].op ==
+         TraceOp::CONST;
+}
+
+auto TraceRecorder::Truthy(const Value& value) -> Value {
+  if (value.is_bool) {
+    return value;
+  }
+  int32_t result = value.current != 0 ? 1 : 0;
+  if (IsConstant(value)) {
+    return Constant(result, true);
+  }
+  return Value{Emit(TraceOp::NE, value.id, Constant(0, false).id), true,
+               result};
+}
+
+auto TraceRecorder::Guard(const Value& condition) -> void {
+  if (IsConstant(condition)) {
+    return;
+  }
+  Emit(condition.current != 0 ? TraceOp::GUARD_TRUE : TraceOp::GUARD_FALSE,
+       condition.id);
+}
+
+auto TraceRecorder::Slot(const Token& variable, const ExprPtr& expr)
+    -> size_t {
+  const std::string& name = variable.GetLexeme();
+  std::optional<uint64_t> distance = interpreter_.GetResolvedDepth(expr);
+  if (distance) {
+    // Each block inside the body adds one environment below the loop's.
+    if (*distance < scopes_.size()) {
+      throw TraceAborted("unresolved body variable");
+    }
+    *distance -= scopes_.size();
+  }
+
+  size_t slot = 0;
+  while (slot < trace_.slots.size() &&
+         !(trace_.slots[slot].distance == distance &&
+           trace_.slots[slot].name == name)) {
+    slot++;
+  }
+  if (slot < trace_.slots.size() && slot_values_[slot]) {
+    return slot;
+  }
+
+  const Object* value =
+      distance ? environment_->FindAt(*distance, name)
+               : interpreter_.GetGlobalEnvironment()->Find(name);
+  if (value == nullptr || !(value->IsInteger() || value->IsBool())) {
+    throw TraceAborted("non-integer variable");
+  }
+  bool is_bool = value->IsBool();
+  if (slot == trace_.slots.size()) {
+    trace_.slots.push_back(TraceSlot{distance, name, is_bool, false});
+    slot_values_.emplace_back();
+  } else if (trace_.slots[slot].is_bool != is_bool) {
+    throw TraceAborted("variable changes type");
+  }
+
+  int32_t current = is_bool ? (value->Get<bool>() ? 1 : 0)
+                            : value->Get<int32_t>();
+  slot_values_[slot] = Value{Emit(TraceOp::LOAD, static_cast<int32_t>(slot)),
+                             is_bool, current};
+  return slot;
+}
+
+auto TraceRecorder::FindBodyLocal(const std::string& name) -> Value* {
+  for (auto rit = scopes_.rbegin(); rit != scopes_.rend(); rit++) {
+    auto it = rit->find(name);
+    if (it != rit->end()) {
+      return &it->second;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * @brief Compiles the traces of a loop into one native loop.
+ *
+ * Slots are addressed through `rbx`, which points at the unboxed values the
+ * caller passes in. Every trace value gets its own frame slot; constants are
+ * encoded as immediates and instructions whose result is never used are
+ * skipped.
+ *
+ * A side exit leaves every slot as it was at the top of the iteration, so a
+ * trace whose guard fails simply falls through to the next trace, and only
+ * the last one returns to the interpreter. Completed iterations always jump
+ * back to the first trace.
+ */
+class TraceCompiler {
+ public:
+  explicit TraceCompiler(const std::vector<Trace>& traces) : traces_(traces) {}
+
+  auto Compile() -> std::vector<uint8_t>;
+
+ private:
+  auto EmitTrace(const Trace& trace, Label& loop_header, Label& loop_done,
+                 Label& side_exit) -> void;
+
+  auto Load(const Trace& trace, Reg reg, int32_t id) -> void;
+
+  auto ValueDisp(int32_t id) const -> int32_t;
+
+  static auto ComputeLiveness(const Trace& trace) -> std::vector<bool>;
+
+  const std::vector<Trace>& traces_;
+  X64Assembler assembler_;
+};
+
+auto TraceCompiler::Compile() -> std::vector<uint8_t> {
+  X64Assembler& a = assembler_;
+  Label loop_header;
+  Label loop_done;
+  Label epilogue;
+
+  a.Push(Reg::RBP);
+  a.MovRR64(Reg::RBP, Reg::RSP);
+  a.Push(Reg::RBX);
+  a.Push(Reg::R12);
+  size_t frame_size_offset = a.SubRspImm32();
+  a.MovRR64(Reg::RBX, Reg::RDI);
+
+  a.Bind(loop_header);
+  size_t values = 0;
+  for (const Trace& trace : traces_) {
+    Label side_exit;
+    EmitTrace(trace, loop_header, loop_done, side_exit);
+    a.Bind(side_exit);
+    values = std::max(values, trace.instructions.size());
+  }
+  a.MovRI32(Reg::RAX, 1);
+  a.Jmp(epilogue);
+
+  a.Bind(loop_done);
+  a.MovRI32(Reg::RAX, 0);
+
+  a.Bind(epilogue);
+  a.Lea(Reg::RSP, Reg::RBP, -16);
+  a.Pop(Reg::R12);
+  a.Pop(Reg::RBX);
+  a.Pop(Reg::RBP);
+  a.Ret();
+
+  a.PatchImm32(frame_size_offset,
+               static_cast<int32_t>((values * 8 + 15) / 16 * 16));
+  return a.Code();
+}
+
+auto TraceCompiler::EmitTrace(const Trace& trace, Label& loop_header,
+                              Label& loop_done, Label& side_exit) -> void {
+  X64Assembler& a = assembler_;
+  std::vector<bool> live = ComputeLiveness(trace);
+  for (size_t i = 0; i < trace.instructions.size(); i++) {
+    if (!live[i]) {
+      continue;
+    }
+    const TraceInstruction& inst = trace.instructions[i];
+    auto id = static_cast<int32_t>(i);
+    switch (inst.op) {
+      case TraceOp::CONST:
+        break;
+      case TraceOp::LOAD:
+        a.Load32(Reg::RAX, Reg::RBX, 8 * inst.a);
+        a.Store32(Reg::RBP, ValueDisp(id), Reg::RAX);
+        break;
+      case TraceOp::ADD:
+      case TraceOp::SUB:
+      case TraceOp::MUL:
+        Load(trace, Reg::RAX, inst.a);
+        Load(trace, Reg::RCX, inst.b);
+        if (inst.op == TraceOp::ADD) {
+          a.Add32(Reg::RAX, Reg::RCX);
+        } else if (inst.op == TraceOp::SUB) {
+          a.Sub32(Reg::RAX, Reg::RCX);
+        } else {
+          a.Imul32(Reg::RAX, Reg::RCX);
+        }
+        // Overflow would promote the value to a double.
+        a.Jcc(Cond::O, side_exit);
+        a.Store32(Reg::RBP, ValueDisp(id), Reg::RAX);
+        break;
+      case TraceOp::DIV: {
+        Label divide;
+        Load(trace, Reg::RAX, inst.a);
+        Load(trace, Reg::RCX, inst.b);
+        a.Test32(Reg::RCX, Reg::RCX);
+        a.Jcc(Cond::E, side_exit);
+        a.CmpImm32(Reg::RCX, -1);
+        a.Jcc(Cond::NE, divide);
+        a.CmpImm32(Reg::RAX, INT32_MIN);
+        a.Jcc(Cond::E, side_exit);
+        a.Bind(divide);
+        a.Cdq();
+        a.Idiv32(Reg::RCX);
+        a.Store32(Reg::RBP, ValueDisp(id), Reg::RAX);
+        break;
+      }
+      case TraceOp::NEG:
+        Load(trace, Reg::RAX, inst.a);
+        a.Neg32(Reg::RAX);
+        a.Jcc(Cond::O, side_exit);
+        a.Store32(Reg::RBP, ValueDisp(id), Reg::RAX);
+        break;
+      case TraceOp::NOT:
+        Load(trace, Reg::RAX, inst.a);
+        a.Test32(Reg::RAX, Reg::RAX);
+        a.SetCC(Cond::E, Reg::RAX);
+        a.Store32(Reg::RBP, ValueDisp(id), Reg::RAX);
+        break;
+      case TraceOp::EQ:
+      case TraceOp::NE:
+      case TraceOp::LT:
+      case TraceOp::LE:
+      case TraceOp::GT:
+      case TraceOp::GE: {
+        static constexpr Cond kConditions[] = {Cond::E, Cond::NE, Cond::L,
+                                               Cond::LE, Cond::G, Cond::GE};
+        Load(trace, Reg::RAX, inst.a);
+        Load(trace, Reg::RCX, inst.b);
+        a.Cmp32(Reg::RAX, Reg::RCX);
+        a.SetCC(kConditions[static_cast<size_t>(inst.op) -
+                            static_cast<size_t>(TraceOp::EQ)],
+                Reg::RAX);
+        a.Store32(Reg::RBP, ValueDisp(id), Reg::RAX);
+        break;
+      }
+      case TraceOp::GUARD_TRUE:
+        Load(trace, Reg::RAX, inst.a);
+        a.Test32(Reg::RAX, Reg::RAX);
+        a.Jcc(Cond::E, side_exit);
+        break;
+      case TraceOp::GUARD_FALSE:
+        Load(trace, Reg::RAX, inst.a);
+        a.Test32(Reg::RAX, Reg::RAX);
+        a.Jcc(Cond::NE, side_exit);
+        break;
+      case TraceOp::EXIT_IF_FALSE:
+        Load(trace, Reg::RAX, inst.a);
+        a.Test32(Reg::RAX, Reg::RAX);
+        a.Jcc(Cond::E, loop_done);
+        break;
+      case TraceOp::STORE:
+        Load(trace, Reg::RAX, inst.b);
+        a.Movsxd(Reg::RAX, Reg::RAX);
+        a.Store64(Reg::RBX, 8 * inst.a, Reg::RAX);
+        break;
+    }
+  }
+  a.Jmp(loop_header);
+}
+
+auto TraceCompiler::Load(const Trace& trace, Reg reg, int32_t id) -> void {
+  const TraceInstruction& inst = trace.instructions[static_cast<size_t>(id)];
+  if (inst.op == TraceOp::CONST) {
+    assembler_.MovRI32(reg, inst.imm);
+  } else {
+    assembler_.Load32(reg, Reg::RBP, ValueDisp(id));
+  }
+}
+
+auto TraceCompiler::ValueDisp(int32_t id) const -> int32_t {
+  return -16 - 8 * (id + 1);
+}
+
+auto TraceCompiler::ComputeLiveness(const Trace& trace) -> std::vector<bool> {
+  // Guards, exits, stores and divisions (which may trap) are roots; any other
+  // instruction is live only if a live instruction uses it.
+  const std::vector<TraceInstruction>& instructions = trace.instructions;
+  std::vector<bool> live(instructions.size(), false);
+  for (size_t i = instructions.size(); i-- > 0;) {
+    const TraceInstruction& inst = instructions[i];
+    switch (inst.op) {
+      case TraceOp::GUARD_TRUE:
+      case TraceOp::GUARD_FALSE:
+      case TraceOp::EXIT_IF_FALSE:
+      case TraceOp::STORE:
+      case TraceOp::DIV:
+        live[i] = true;
+        break;
+      default:
+        break;
+    }
+    if (!live[i]) {
+      continue;
+    }
+    int32_t operands[] = {inst.op == TraceOp::STORE ? -1 : inst.a, inst.b};
+    for (int32_t operand : operands) {
+      if (operand >= 0) {
+        live[static_cast<size_t>(operand)] = true;
+      }
+    }
+  }
+  return live;
+}
+
+// ====================TraceJit====================
+auto TraceJit::OnBackEdge(const WhileStmt& loop,
+                          const std::shared_ptr<Environment>& environment)
+    -> Exit {
+  LoopProfile& profile = loops_[&loop];
+  if (profile.state == LoopProfile::State::COLD) {
+    uint64_t threshold = mode_ == JitMode::FORCE ? 1 : kHotLoopThreshold;
+    if (++profile.iterations < threshold) {
+      return Exit::NOT_RUN;
+    }
+    Record(loop, environment, profile);
+    if (profile.traces.empty()) {
+      return Exit::NOT_RUN;
+    }
+  }
+  if (profile.state != LoopProfile::State::COMPILED) {
+    return Exit::NOT_RUN;
+  }
+
+  Exit exit = Run(profile, environment);
+  if (exit == Exit::SIDE_EXIT && profile.traces.size() < kMaxTracesPerLoop) {
+    // Every trace failed at the top of this iteration. Record the path it
+    // takes as another trace and try again.
+    size_t traces = profile.traces.size();
+    Record(loop, environment, profile);
+    if (profile.traces.size() > traces &&
+        profile.state == LoopProfile::State::COMPILED) {
+      exit = Run(profile, environment);
+    }
+  }
+  return exit;
+}
+
+auto TraceJit::Record(const WhileStmt& loop,
+                      const std::shared_ptr<Environment>& environment,
+                      LoopProfile& profile) -> void {
+#if defined(__x86_64__)
+  try {
+    TraceRecorder recorder{interpreter_, environment, profile.slots};
+    std::optional<Trace> trace = recorder.Record(loop);
+    if (!trace) {
+      // The loop is about to finish; try again next time it runs.
+      return;
+    }
+
+    std::vector<Trace> traces = profile.traces;
+    traces.push_back(std::move(trace.value()));
+    auto code =
+        std::make_unique<ExecutableMemory>(TraceCompiler{traces}.Compile());
+    if (!code->IsValid()) {
+      profile.state = LoopProfile::State::FAILED;
+      return;
+    }
+
+    // The new trace's slots extend those of the earlier traces.
+    std::vector<TraceSlot> slots = traces.back().slots;
+    for (size_t i = 0; i < profile.slots.size(); i++) {
+      slots[i].written = slots[i].written || profile.slots[i].written;
+    }
+    profile.slots = std::move(slots);
+    profile.traces = std::move(traces);
+    profile.entry = reinterpret_cast<int64_t (*)(int64_t*)>(
+        const_cast<void*>(code->Entry()));
+    profile.code = std::move(code);
+    profile.state = LoopProfile::State::COMPILED;
+  } catch (const TraceAborted&) {
+    // A loop keeps the traces it already has.
+    if (profile.traces.empty()) {
+      profile.state = LoopProfile::State::FAILED;
+    }
+  }
+#else
+  profile.state = LoopProfile::State::FAILED;
+#endif
+}
+
+auto TraceJit::Run(LoopProfile& profile,
+                   const std::shared_ptr<Environment>& environment) -> Exit {
+  const std::vector<TraceSlot>& slots = profile.slots;
+  std::vector<Object*> variables(slots.size());
+  std::vector<int64_t> values(slots.size());
+
+  // Hoisted type guards: check and unbox every slot once per entry.
+  for (size_t i = 0; i < slots.size(); i++) {
+    const TraceSlot& slot = slots[i];
+    Object* variable =
+        slot.distance
+            ? environment->FindAt(*slot.distance, slot.name)
+            : interpreter_.GetGlobalEnvironment()->FindAt(0, slot.name);
+    const bool* as_bool =
+        variable ? std::get_if<bool>(&variable->Value()) : nullptr;
+    const int32_t* as_int =
+        variable ? std::get_if<int32_t>(&variable->Value()) : nullptr;
+    if (slot.is_bool ? as_bool == nullptr : as_int == nullptr) {
+      RecordSideExit(profile);
+      return Exit::NOT_RUN;
+    }
+    variables[i] = variable;
+    values[i] = slot.is_bool ? (*as_bool ? 1 : 0) : *as_int;
+  }
+
+  int64_t status = profile.entry(values.data());
+
+  for (size_t i = 0; i < slots.size(); i++) {
+    if (!slots[i].written) {
+      continue;
+    }
+    *variables[i] = slots[i].is_bool
+                        ? Object{values[i] != 0}
+                        : Object{static_cast<int32_t>(values[i])};
+  }
+
+  if (status == 0) {
+    return Exit::LOOP_DONE;
+  }
+  RecordSideExit(profile);
+  return Exit::SIDE_EXIT;
+}
+
+auto TraceJit::RecordSideExit(LoopProfile& profile) noexcept -> void {
+  if (++profile.side_exits >= kMaxSideExits) {
+    profile.state = LoopProfile::State::FAILED;
+  }
+}
+}  // namespace cclox
@@ -0,0 +1,403 @@
+#include "vm.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <format>
+#include <tuple>
+#include <utility>
+
+#include "bytecode_compiler.h"
+#include "environment.h"
+#include "interpreter.h"
+#include "lox_instance.h"
+#include "vm_operators.h"
+
+namespace cclox {
+using bytecode::Instruction, bytecode::OpCode;
+
+auto Vm::TryCall(const FunctionStmt& declaration,
+                 const std::shared_ptr<Environment>& closure,
+                 const std::vector<Object>& arguments)
+    -> std::optional<Object> {
+  bytecode::Chunk* chunk = Compile(declaration);
+  if (chunk == nullptr) {
+    return std::nullopt;
+  }
+  if (profile_) {
+    return Run<true>(*chunk, closure, arguments);
+  }
+  return Run<false>(*chunk, closure, arguments);
+}
+
+auto Vm::PrintProfile(std::ostream& output, size_t count) const -> void {
+  std::vector<std::tuple<uint64_t, OpCode, OpCode>> pairs;
+  uint64_t total = 0;
+  for (size_t first = 0; first < bytecode::kOpCodeCount; first++) {
+    for (size_t second = 0; second < bytecode::kOpCodeCount; second++) {
+      uint64_t executed = (*pairs_)[first][second];
+      if (executed != 0) {
+        pairs.emplace_back(executed, static_cast<OpCode>(first),
+                           static_cast<OpCode>(second));
+        total += executed;
+      }
+    }
+  }
+  std::sort(pairs.begin(), pairs.end(),
+            [](const auto& a, const auto& b) { return a > b; });
+
+  output << std::format("{} opcode pairs executed\n", total);
+  for (size_t i = 0; i < std::min(count, pairs.size()); i++) {
+    const auto& [executed, first, second] = pairs[i];
+    output << std::format(
+        "{:6.2f}%  {:>12}  {} {}\n",
+        100.0 * static_cast<double>(executed) / static_cast<double>(total),
+        executed, bytecode::OpCodeName(first), bytecode::OpCodeName(second));
+  }
+}
+
+auto Vm::Compile(const FunctionStmt& declaration) -> bytecode::Chunk* {
+  auto it = chunks_.find(&declaration);
+  if (it == chunks_.end()) {
+    // Profiles are taken on the plain instructions, to find new sequences
+    // worth fusing.
+    std::optional<bytecode::Chunk> chunk =
+        BytecodeCompiler{interpreter_, !profile_}.Compile(declaration);
+    if (chunk && dump_ != nullptr) {
+      bytecode::Disassemble(chunk.value(), *dump_);
+    }
+    it = chunks_.emplace(&declaration, std::move(chunk)).first;
+  }
+  return it->second ? &it->second.value() : nullptr;
+}
+
+// Every handler ends with `VM_DISPATCH()`, which jumps straight to the
+// handler of the instruction at `ip`.
+#if CCLOX_THREADED_DISPATCH
+#define VM_CASE(name) op_##name:
+#define VM_JUMP() goto* ip->handler
+#else
+#define VM_CASE(name) case OpCode::name:
+#define VM_JUMP() goto dispatch
+#endif
+
+#define VM_DISPATCH()                                        \
+  do {                                                       \
+    if constexpr (kProfile) {                                \
+      (*pairs_)[static_cast<size_t>(last->opcode)]           \
+               [static_cast<size_t>(ip->opcode)]++;          \
+      last = ip;                                             \
+    }                                                        \
+    VM_JUMP();                                               \
+  } while (false)
+
+template <bool kProfile>
+auto Vm::Run(bytecode::Chunk& chunk,
+             const std::shared_ptr<Environment>& closure,
+             const std::vector<Object>& arguments) -> Object {
+#if CCLOX_THREADED_DISPATCH
+  static const void* const kHandlers[] = {
+#define CCLOX_BYTECODE_OP(name) &&op_##name,
+      CCLOX_BYTECODE_OPCODES(CCLOX_BYTECODE_OP)
+#undef CCLOX_BYTECODE_OP
+  };
+  if (chunk.threaded_with != kHandlers) {
+    for (Instruction& instruction : chunk.code) {
+      instruction.handler =
+          kHandlers[static_cast<size_t>(instruction.opcode)];
+    }
+    chunk.threaded_with = kHandlers;
+  }
+#endif
+
+  const std::shared_ptr<Environment>& globals =
+      interpreter_.GetGlobalEnvironment();
+  const std::vector<Token>& tokens = chunk.tokens;
+  const std::vector<Object>& constants = chunk.constants;
+  const Instruction* code = chunk.code.data();
+  const Instruction* ip = code;
+  [[maybe_unused]] const Instruction* last = ip;
+
+  // The parameters are the first locals.
+  std::vector<Object> stack(chunk.max_stack);
+  Object* slots = stack.data();
+  std::copy(arguments.begin(), arguments.end(), slots);
+  Object* sp = slots + arguments.size();
+
+#if CCLOX_THREADED_DISPATCH
+  VM_JUMP();
+#else
+dispatch:
+  switch (ip->opcode) {
+#endif
+
+  VM_CASE(CONSTANT) {
+    *sp++ = constants[ip->a];
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(POP) {
+    sp--;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(GET_LOCAL) {
+    *sp++ = slots[ip->a];
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(SET_LOCAL) {
+    slots[ip->a] = sp[-1];
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(GET_GLOBAL) {
+    *sp++ = globals->Get(tokens[ip->token]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(SET_GLOBAL) {
+    globals->Assign(tokens[ip->token], sp[-1]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(GET_FREE) {
+    *sp++ = closure->GetAt(ip->a, tokens[ip->token]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(SET_FREE) {
+    closure->AssignAt(ip->a, tokens[ip->token], sp[-1]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(GET_PROPERTY) {
+    std::optional<LoxInstancePtr> instance_opt = sp[-1].AsLoxInstance();
+    if (!instance_opt) {
+      throw RuntimeError(tokens[ip->token], "Only instances have properties.");
+    }
+    sp[-1] = instance_opt.value()->GetField(tokens[ip->token]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(CHECK_INSTANCE) {
+    if (!sp[-1].AsLoxInstance()) {
+      throw RuntimeError(tokens[ip->token], "Only instances have fields.");
+    }
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(SET_PROPERTY) {
+    sp[-2].AsLoxInstance().value()->SetField(tokens[ip->token], sp[-1]);
+    sp[-2] = std::move(sp[-1]);
+    sp--;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(ADD) {
+    sp[-2] = Arithmetic<OpCode::ADD>(sp[-2], tokens[ip->token], sp[-1]);
+    sp--;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(SUBTRACT) {
+    sp[-2] = Arithmetic<OpCode::SUBTRACT>(sp[-2], tokens[ip->token], sp[-1]);
+    sp--;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(MULTIPLY) {
+    sp[-2] = Arithmetic<OpCode::MULTIPLY>(sp[-2], tokens[ip->token], sp[-1]);
+    sp--;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(DIVIDE) {
+    sp[-2] = Interpreter::Divide(sp[-2], tokens[ip->token], sp[-1]);
+    sp--;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(NEGATE) {
+    sp[-1] = Arithmetic<OpCode::SUBTRACT>(Object{static_cast<int32_t>(0)},
+                                          tokens[ip->token], sp[-1]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(NOT) {
+    sp[-1] = Object{!sp[-1].IsTruthy()};
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(EQUAL) {
+    sp[-2] = Object{Compare<OpCode::EQUAL>(sp[-2], tokens[ip->token], sp[-1])};
+    sp--;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(NOT_EQUAL) {
+    sp[-2] =
+        Object{Compare<OpCode::NOT_EQUAL>(sp[-2], tokens[ip->token], sp[-1])};
+    sp--;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(LESS) {
+    sp[-2] = Object{Compare<OpCode::LESS>(sp[-2], tokens[ip->token], sp[-1])};
+    sp--;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(LESS_EQUAL) {
+    sp[-2] =
+        Object{Compare<OpCode::LESS_EQUAL>(sp[-2], tokens[ip->token], sp[-1])};
+    sp--;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(GREATER) {
+    sp[-2] =
+        Object{Compare<OpCode::GREATER>(sp[-2], tokens[ip->token], sp[-1])};
+    sp--;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(GREATER_EQUAL) {
+    sp[-2] = Object{
+        Compare<OpCode::GREATER_EQUAL>(sp[-2], tokens[ip->token], sp[-1])};
+    sp--;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP) {
+    ip = code + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP_IF_FALSE) {
+    sp--;
+    ip = sp->IsTruthy() ? ip + 1 : code + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP_IF_FALSE_OR_POP) {
+    if (sp[-1].IsTruthy()) {
+      sp--;
+      ip++;
+    } else {
+      ip = code + ip->a;
+    }
+    VM_DISPATCH();
+  }
+  VM_CASE(JUMP_IF_TRUE_OR_POP) {
+    if (sp[-1].IsTruthy()) {
+      ip = code + ip->a;
+    } else {
+      sp--;
+      ip++;
+    }
+    VM_DISPATCH();
+  }
+  VM_CASE(CALL) {
+    std::vector<Object> call_arguments(sp - ip->a, sp);
+    sp -= ip->a;
+    sp[-1] = interpreter_.Call(sp[-1], call_arguments, tokens[ip->token]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(PRINT) {
+    sp--;
+    interpreter_.GetOutputStream() << sp->ToString() << '\n';
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(RETURN) {
+    return std::move(sp[-1]);
+  }
+  VM_CASE(ADD_LOCAL_CONSTANT) {
+    *sp++ = Arithmetic<OpCode::ADD>(slots[ip->a], tokens[ip->token],
+                                    constants[ip->b]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(SUBTRACT_LOCAL_CONSTANT) {
+    *sp++ = Arithmetic<OpCode::SUBTRACT>(slots[ip->a], tokens[ip->token],
+                                         constants[ip->b]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(GET_LOCAL_GET_LOCAL) {
+    sp[0] = slots[ip->a];
+    sp[1] = slots[ip->b];
+    sp += 2;
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(LESS_JUMP_IF_FALSE) {
+    sp -= 2;
+    ip = Compare<OpCode::LESS>(sp[0], tokens[ip->token], sp[1]) ? ip + 1
+                                                                : code + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(LESS_EQUAL_JUMP_IF_FALSE) {
+    sp -= 2;
+    ip = Compare<OpCode::LESS_EQUAL>(sp[0], tokens[ip->token], sp[1])
+             ? ip + 1
+             : code + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(GREATER_JUMP_IF_FALSE) {
+    sp -= 2;
+    ip = Compare<OpCode::GREATER>(sp[0], tokens[ip->token], sp[1])
+             ? ip + 1
+             : code + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(GREATER_EQUAL_JUMP_IF_FALSE) {
+    sp -= 2;
+    ip = Compare<OpCode::GREATER_EQUAL>(sp[0], tokens[ip->token], sp[1])
+             ? ip + 1
+             : code + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(EQUAL_JUMP_IF_FALSE) {
+    sp -= 2;
+    ip = Compare<OpCode::EQUAL>(sp[0], tokens[ip->token], sp[1])
+             ? ip + 1
+             : code + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(NOT_EQUAL_JUMP_IF_FALSE) {
+    sp -= 2;
+    ip = Compare<OpCode::NOT_EQUAL>(sp[0], tokens[ip->token], sp[1])
+             ? ip + 1
+             : code + ip->a;
+    VM_DISPATCH();
+  }
+  VM_CASE(INVOKE) {
+    Object* receiver = sp - ip->a - 1;
+    std::optional<LoxInstancePtr> instance_opt = receiver->AsLoxInstance();
+    if (!instance_opt) {
+      throw RuntimeError(tokens[ip->token], "Only instances have properties.");
+    }
+    Object method = instance_opt.value()->GetField(tokens[ip->token]);
+    std::vector<Object> call_arguments(receiver + 1, sp);
+    sp = receiver + 1;
+    *receiver = interpreter_.Call(method, call_arguments, tokens[ip->b]);
+    ip++;
+    VM_DISPATCH();
+  }
+  VM_CASE(SET_LOCAL_POP) {
+    sp--;
+    slots[ip->a] = std::move(*sp);
+    ip++;
+    VM_DISPATCH();
+  }
+
+#if !CCLOX_THREADED_DISPATCH
+  }
+  return Object{nullptr};
+#endif
+}
+
+#undef VM_DISPATCH
+#undef VM_JUMP
+#undef VM_CASE
+}  // namespace cclox
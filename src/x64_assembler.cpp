@@ -0,0 +1,295 @@
+#include "x64_assembler.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cassert>
+#include <cstring>
+
+namespace cclox {
+namespace {
+auto Low3(Reg reg) -> uint8_t {
+  return static_cast<uint8_t>(static_cast<uint8_t>(reg) & 0x7);
+}
+
+auto IsExtended(Reg reg) -> bool {
+  return static_cast<uint8_t>(reg) >= 8;
+}
+}  // namespace
+
+auto X64Assembler::Bind(Label& label) -> void {
+  assert(!label.IsBound());
+  label.position_ = static_cast<int64_t>(code_.size());
+  for (size_t fixup : label.fixups_) {
+    PatchImm32(fixup, static_cast<int32_t>(label.position_ -
+                                           static_cast<int64_t>(fixup + 4)));
+  }
+  label.fixups_.clear();
+}
+
+auto X64Assembler::Push(Reg reg) -> void {
+  if (IsExtended(reg)) {
+    Emit8(0x41);
+  }
+  Emit8(static_cast<uint8_t>(0x50 + Low3(reg)));
+}
+
+auto X64Assembler::Pop(Reg reg) -> void {
+  if (IsExtended(reg)) {
+    Emit8(0x41);
+  }
+  Emit8(static_cast<uint8_t>(0x58 + Low3(reg)));
+}
+
+auto X64Assembler::Ret() -> void {
+  Emit8(0xC3);
+}
+
+// ====================Data movement====================
+auto X64Assembler::MovRR64(Reg dst, Reg src) -> void {
+  EmitRR(0x89, src, dst, true);
+}
+
+auto X64Assembler::MovRI32(Reg dst, int32_t imm) -> void {
+  if (IsExtended(dst)) {
+    Emit8(0x41);
+  }
+  Emit8(static_cast<uint8_t>(0xB8 + Low3(dst)));
+  Emit32(static_cast<uint32_t>(imm));
+}
+
+auto X64Assembler::MovRI64(Reg dst, uint64_t imm) -> void {
+  Emit8(static_cast<uint8_t>(0x48 | (IsExtended(dst) ? 0x1 : 0x0)));
+  Emit8(static_cast<uint8_t>(0xB8 + Low3(dst)));
+  Emit32(static_cast<uint32_t>(imm));
+  Emit32(static_cast<uint32_t>(imm >> 32));
+}
+
+auto X64Assembler::Load32(Reg dst, Reg base, int32_t disp) -> void {
+  EmitRex(false, dst, base);
+  Emit8(0x8B);
+  EmitMem(dst, base, disp);
+}
+
+auto X64Assembler::Store32(Reg base, int32_t disp, Reg src) -> void {
+  EmitRex(false, src, base);
+  Emit8(0x89);
+  EmitMem(src, base, disp);
+}
+
+auto X64Assembler::Load64(Reg dst, Reg base, int32_t disp) -> void {
+  EmitRex(true, dst, base);
+  Emit8(0x8B);
+  EmitMem(dst, base, disp);
+}
+
+auto X64Assembler::Store64(Reg base, int32_t disp, Reg src) -> void {
+  EmitRex(true, src, base);
+  Emit8(0x89);
+  EmitMem(src, base, disp);
+}
+
+auto X64Assembler::Lea(Reg dst, Reg base, int32_t disp) -> void {
+  EmitRex(true, dst, base);
+  Emit8(0x8D);
+  EmitMem(dst, base, disp);
+}
+
+auto X64Assembler::Movsxd(Reg dst, Reg src) -> void {
+  EmitRR(0x63, dst, src, true);
+}
+
+auto X64Assembler::SubRspImm32() -> size_t {
+  // REX.W 81 /5 id
+  Emit8(0x48);
+  Emit8(0x81);
+  EmitModRM(3, 5, Low3(Reg::RSP));
+  size_t offset = code_.size();
+  Emit32(0);
+  return offset;
+}
+
+auto X64Assembler::PatchImm32(size_t offset, int32_t value) -> void {
+  auto bits = static_cast<uint32_t>(value);
+  for (size_t i = 0; i < 4; i++) {
+    code_[offset + i] = static_cast<uint8_t>(bits >> (8 * i));
+  }
+}
+
+// ====================32-bit arithmetic====================
+auto X64Assembler::Add32(Reg dst, Reg src) -> void {
+  EmitRR(0x01, src, dst, false);
+}
+
+auto X64Assembler::Sub32(Reg dst, Reg src) -> void {
+  EmitRR(0x29, src, dst, false);
+}
+
+auto X64Assembler::Imul32(Reg dst, Reg src) -> void {
+  EmitRex(false, dst, src);
+  Emit8(0x0F);
+  Emit8(0xAF);
+  EmitModRM(3, Low3(dst), Low3(src));
+}
+
+auto X64Assembler::Neg32(Reg reg) -> void {
+  EmitRex(false, Reg::RAX, reg);
+  Emit8(0xF7);
+  EmitModRM(3, 3, Low3(reg));
+}
+
+auto X64Assembler::Xor32(Reg dst, Reg src) -> void {
+  EmitRR(0x31, src, dst, false);
+}
+
+auto X64Assembler::XorImm32(Reg dst, int32_t imm) -> void {
+  EmitRex(false, Reg::RAX, dst);
+  Emit8(0x81);
+  EmitModRM(3, 6, Low3(dst));
+  Emit32(static_cast<uint32_t>(imm));
+}
+
+auto X64Assembler::Cmp32(Reg lhs, Reg rhs) -> void {
+  EmitRR(0x39, rhs, lhs, false);
+}
+
+auto X64Assembler::CmpImm32(Reg lhs, int32_t imm) -> void {
+  EmitRex(false, Reg::RAX, lhs);
+  Emit8(0x81);
+  EmitModRM(3, 7, Low3(lhs));
+  Emit32(static_cast<uint32_t>(imm));
+}
+
+auto X64Assembler::Test32(Reg lhs, Reg rhs) -> void {
+  EmitRR(0x85, rhs, lhs, false);
+}
+
+auto X64Assembler::Cdq() -> void {
+  Emit8(0x99);
+}
+
+auto X64Assembler::Idiv32(Reg divisor) -> void {
+  EmitRex(false, Reg::RAX, divisor);
+  Emit8(0xF7);
+  EmitModRM(3, 7, Low3(divisor));
+}
+
+auto X64Assembler::SetCC(Cond cond, Reg dst) -> void {
+  // setcc dst8; movzx dst32, dst8. A bare REX prefix selects sil/dil/spl/bpl
+  // instead of the legacy high-byte registers.
+  if (static_cast<uint8_t>(dst) >= 4) {
+    Emit8(static_cast<uint8_t>(0x40 | (IsExtended(dst) ? 0x1 : 0x0)));
+  }
+  Emit8(0x0F);
+  Emit8(static_cast<uint8_t>(0x90 + static_cast<uint8_t>(cond)));
+  EmitModRM(3, 0, Low3(dst));
+
+  EmitRex(false, dst, dst);
+  if (static_cast<uint8_t>(dst) >= 4 && !IsExtended(dst)) {
+    Emit8(0x40);
+  }
+  Emit8(0x0F);
+  Emit8(0xB6);
+  EmitModRM(3, Low3(dst), Low3(dst));
+}
+
+// ====================Control flow====================
+auto X64Assembler::Jmp(Label& label) -> void {
+  Emit8(0xE9);
+  EmitRel32(label);
+}
+
+auto X64Assembler::Jcc(Cond cond, Label& label) -> void {
+  Emit8(0x0F);
+  Emit8(static_cast<uint8_t>(0x80 + static_cast<uint8_t>(cond)));
+  EmitRel32(label);
+}
+
+auto X64Assembler::CallR(Reg target) -> void {
+  EmitRex(false, Reg::RAX, target);
+  Emit8(0xFF);
+  EmitModRM(3, 2, Low3(target));
+}
+
+// ====================Private helpers====================
+auto X64Assembler::Emit8(uint8_t byte) -> void {
+  code_.push_back(byte);
+}
+
+auto X64Assembler::Emit32(uint32_t value) -> void {
+  for (size_t i = 0; i < 4; i++) {
+    Emit8(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+auto X64Assembler::EmitRex(bool wide, Reg reg, Reg rm) -> void {
+  uint8_t rex = 0x40;
+  if (wide) {
+    rex |= 0x8;
+  }
+  if (IsExtended(reg)) {
+    rex |= 0x4;
+  }
+  if (IsExtended(rm)) {
+    rex |= 0x1;
+  }
+  if (rex != 0x40) {
+    Emit8(rex);
+  }
+}
+
+auto X64Assembler::EmitModRM(uint8_t mod, uint8_t reg, uint8_t rm) -> void {
+  Emit8(static_cast<uint8_t>((mod << 6) | ((reg & 0x7) << 3) | (rm & 0x7)));
+}
+
+auto X64Assembler::EmitMem(Reg reg, Reg base, int32_t disp) -> void {
+  // Always use the [base + disp32] form. rsp/r12 as a base needs a SIB byte.
+  EmitModRM(2, Low3(reg), Low3(base));
+  if (Low3(base) == 4) {
+    Emit8(0x24);
+  }
+  Emit32(static_cast<uint32_t>(disp));
+}
+
+auto X64Assembler::EmitRR(uint8_t opcode, Reg reg, Reg rm, bool wide) -> void {
+  EmitRex(wide, reg, rm);
+  Emit8(opcode);
+  EmitModRM(3, Low3(reg), Low3(rm));
+}
+
+auto X64Assembler::EmitRel32(Label& label) -> void {
+  size_t offset = code_.size();
+  Emit32(0);
+  if (label.IsBound()) {
+    PatchImm32(offset, static_cast<int32_t>(label.position_ -
+                                            static_cast<int64_t>(offset + 4)));
+  } else {
+    label.fixups_.push_back(offset);
+  }
+}
+
+// ====================ExecutableMemory====================
+ExecutableMemory::ExecutableMemory(const std::vector<uint8_t>& code) {
+  auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t size = (code.size() + page_size - 1) / page_size * page_size;
+  void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED) {
+    return;
+  }
+
+  std::memcpy(memory, code.data(), code.size());
+  if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+    munmap(memory, size);
+    return;
+  }
+
+  memory_ = memory;
+  size_ = size;
+}
+
+ExecutableMemory::~ExecutableMemory() {
+  if (memory_ != nullptr) {
+    munmap(memory_, size_);
+  }
+}
+}  // namespace cclox
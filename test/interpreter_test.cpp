@@ -1,10 +1,18 @@
 #include <gtest/gtest.h>
 #include <sysexits.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <filesystem>
+#include <format>
 #include <fstream>
 #include <iostream>
 #include <ostream>
 #include <sstream>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include "lox.h"
 
@@ -21,20 +29,119 @@ std::string ReadFile(const std::string& filepath) {
   return buffer.str();
 }
 
+// How a program is run: which engines and tiers are enabled, and how it is
+// parsed.
+struct EngineOptions {
+  std::string name;
+  cclox::JitMode jit_mode{cclox::JitMode::OFF};
+  cclox::JitMode trace_jit_mode{cclox::JitMode::OFF};
+  bool optimize{false};
+  bool background_compile{false};
+  bool vm{false};
+  bool register_vm{false};
+  bool lazy{false};
+};
+
+// Every configuration each program runs in. The output must be the same in
+// all of them.
+std::vector<EngineOptions> AllEngines() {
+  return {
+      {.name = "TreeWalker"},
+      // Each eligible function compiled on its first call.
+      {.name = "ForcedJit", .jit_mode = cclox::JitMode::FORCE},
+      // Each loop traced on its first back-edge.
+      {.name = "ForcedTraceJit", .trace_jit_mode = cclox::JitMode::FORCE},
+      // Functions executed on their optimized SSA form.
+      {.name = "Optimizer", .optimize = true},
+      // Functions optimized on a background thread, which start running
+      // optimized whenever their code happens to be ready.
+      {.name = "BackgroundOptimizer",
+       .optimize = true,
+       .background_compile = true},
+      {.name = "Vm", .vm = true},
+      {.name = "RegisterVm", .register_vm = true},
+      // Function bodies parsed on their first call.
+      {.name = "LazyParsing", .lazy = true},
+  };
+}
+
+// Configures `lox` to run programs as `engine` does.
+void UseEngine(cclox::Lox& lox, const EngineOptions& engine) {
+  lox.SetJitMode(engine.jit_mode);
+  lox.SetTraceJitMode(engine.trace_jit_mode);
+  lox.SetOptimizerEnabled(engine.optimize);
+  lox.SetBackgroundCompileEnabled(engine.background_compile);
+  lox.SetVmEnabled(engine.vm);
+  lox.SetRegisterVmEnabled(engine.register_vm);
+  lox.SetLazyParsingEnabled(engine.lazy);
+}
+
+// Runs `input_file_path` as configured by `engine`, and compares its output
+// with the contents of `expected_output_path`.
+void RunTestFromFile(const std::string& input_file_path,
+                     const std::string& expected_output_path,
+                     const EngineOptions& engine) {
+  std::string expected_output = ReadFile(expected_output_path);
+
+  // The custom output stream, which will be used to compare with the expected
+  // output.
+  std::ostringstream output;
+  cclox::Lox lox{output};
+  UseEngine(lox, engine);
+
+  lox.RunFile(input_file_path);
+  EXPECT_EQ(output.str(), expected_output);
+}
+
 // Parameterized test class for handling directories of test cases
 class InterpreterTest : public ::testing::TestWithParam<std::string> {
  protected:
-  void RunTestFromFile(const std::string& input_file_path,
-                       const std::string& expected_output_path) {
+  // Compile the program to C++ with `--emit-cpp`, build it with the host
+  // compiler and compare what the executable prints.
+  void RunCompiledTestFromFile(const std::string& input_file_path,
+                               const std::string& expected_output_path) {
+#ifdef CCLOX_EMIT_CPP_COMPILER
     std::string expected_output = ReadFile(expected_output_path);
 
-    // The custom output stream, which will be used to compare with the expected
-    // output.
     std::ostringstream output;
+    std::ostringstream cpp;
     cclox::Lox lox{output};
+    if (!lox.EmitCpp(input_file_path, cpp)) {
+      if (output.str().find("Compiled programs can't run tasks.") !=
+          std::string::npos) {
+        GTEST_SKIP() << "Compiled programs can't run tasks.";
+      }
+      // Compile errors are reported exactly like the interpreter does.
+      EXPECT_EQ(output.str(), expected_output);
+      return;
+    }
+
+    std::string name = input_file_path;
+    std::replace(name.begin(), name.end(), '/', '_');
+    fs::path base = fs::temp_directory_path() / ("cclox" + name);
+    fs::path source = base.string() + ".cpp";
+    fs::path binary = base.string() + ".out";
+    fs::path stdout_path = base.string() + ".stdout";
+    std::ofstream{source} << cpp.str();
+
+    std::string compile =
+        std::format("{} {} -o {} {}", CCLOX_EMIT_CPP_COMPILER, source.string(),
+                    binary.string(), CCLOX_EMIT_CPP_LIBRARIES);
+    ASSERT_EQ(std::system(compile.c_str()), 0) << compile;
 
-    lox.RunFile(input_file_path);
-    EXPECT_EQ(output.str(), expected_output);
+    std::string run =
+        std::format("{} > {}", binary.string(), stdout_path.string());
+    std::system(run.c_str());
+    EXPECT_EQ(ReadFile(stdout_path.string()), expected_output);
+
+    fs::remove(source);
+    fs::remove(binary);
+    fs::remove(stdout_path);
+#else
+    (void)input_file_path;
+    (void)expected_output_path;
+    GTEST_SKIP() << "Configure with -DCCLOX_TEST_EMIT_CPP=ON to enable.";
+#endif
   }
 };
 
@@ -53,36 +160,402 @@ std::vector<std::string> CollectTestFiles(
   return test_files;
 }
 
+// Every test program.
+std::vector<std::string> AllTestFiles() {
+  return CollectTestFiles({
+      "../../test/assignment",
+      "../../test/async",
+      "../../test/block",
+      "../../test/bool",
+      "../../test/call",
+      "../../test/class",
+      "../../test/closure",
+      "../../test/constructor",
+      "../../test/field",
+      "../../test/for",
+      "../../test/freeze",
+      "../../test/function",
+      "../../test/if",
+      "../../test/inheritance",
+      "../../test/jit",
+      "../../test/list",
+      "../../test/logical_operator",
+      "../../test/module",
+      "../../test/number",
+      "../../test/operator",
+      "../../test/optimizer",
+      "../../test/string",
+      "../../test/task",
+      "../../test/this",
+      "../../test/trace",
+      "../../test/variable",
+      "../../test/vm",
+  });
+}
+
 // Instantiate the tests dynamically using `INSTANTIATE_TEST_SUITE_P`
 INSTANTIATE_TEST_SUITE_P(InterpreterSuite, InterpreterTest,
-                         ::testing::ValuesIn(CollectTestFiles({
-                             "../../test/assignment",
-                             "../../test/block",
-                             "../../test/bool",
-                             "../../test/call",
-                             "../../test/class",
-                             "../../test/closure",
-                             "../../test/constructor",
-                             "../../test/field",
-                             "../../test/for",
-                             "../../test/function",
-                             "../../test/if",
-                             "../../test/inheritance",
-                             "../../test/logical_operator",
-                             "../../test/number",
-                             "../../test/operator",
-                             "../../test/string",
-                             "../../test/this",
-                             "../../test/variable",
-                         })));
+                         ::testing::ValuesIn(AllTestFiles()));
+
+// Runs each program in each engine configuration.
+class InterpreterEngineTest
+    : public ::testing::TestWithParam<std::tuple<std::string, EngineOptions>> {
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    InterpreterSuite, InterpreterEngineTest,
+    ::testing::Combine(::testing::ValuesIn(AllTestFiles()),
+                       ::testing::ValuesIn(AllEngines())),
+    [](const auto& info) {
+      return std::format("{}_{}", std::get<1>(info.param).name, info.index);
+    });
 
 // Test each `.lox` file by comparing it to the expected `.txt` file
-TEST_P(InterpreterTest, RunsProgramCorrectly) {
+TEST_P(InterpreterEngineTest, RunsProgramCorrectly) {
+  const auto& [lox_file, engine] = GetParam();
+  std::string txt_file = lox_file.substr(0, lox_file.size() - 4) + ".txt";
+
+  ASSERT_TRUE(fs::exists(txt_file))
+      << "Expected output file missing: " << txt_file;
+  if (engine.lazy && ReadFile(txt_file).find("] Error") != std::string::npos) {
+    GTEST_SKIP() << "Errors in function bodies are reported on first call.";
+  }
+
+  RunTestFromFile(lox_file, txt_file, engine);
+}
+
+// Run every program again read as a stream, each declaration running as soon
+// as it is parsed. The output must not change, except for programs with
+// compile errors, since what comes before the error runs.
+TEST_P(InterpreterTest, RunsProgramCorrectlyFromStream) {
   std::string lox_file = GetParam();
   std::string txt_file = lox_file.substr(0, lox_file.size() - 4) + ".txt";
 
   ASSERT_TRUE(fs::exists(txt_file))
       << "Expected output file missing: " << txt_file;
+  std::string expected_output = ReadFile(txt_file);
+  if (expected_output.find("] Error") != std::string::npos) {
+    GTEST_SKIP() << "Statements before a compile error run in a stream.";
+  }
+  if (lox_file.find("/module/") != std::string::npos) {
+    GTEST_SKIP() << "Imports in a stream are relative to the working "
+                    "directory.";
+  }
+
+  std::ifstream input{lox_file};
+  std::ostringstream output;
+  cclox::Lox lox{output};
+  lox.RunStream(input);
+  EXPECT_EQ(output.str(), expected_output);
+}
+
+// Run every program again compiled ahead of time to C++. The output must not
+// change.
+TEST_P(InterpreterTest, RunsProgramCorrectlyWhenCompiledToCpp) {
+  std::string lox_file = GetParam();
+  std::string txt_file = lox_file.substr(0, lox_file.size() - 4) + ".txt";
+
+  ASSERT_TRUE(fs::exists(txt_file))
+      << "Expected output file missing: " << txt_file;
+
+  RunCompiledTestFromFile(lox_file, txt_file);
+}
+
+// Run every program again in one batch, each in the interpreter the ones
+// before it ran in, once reset, and again on several threads. The output must
+// be each program's output in turn.
+TEST(InterpreterBatchTest, RunsProgramsInOneBatch) {
+  std::vector<std::string> lox_files = AllTestFiles();
+  std::sort(lox_files.begin(), lox_files.end());
+  std::string expected_output;
+  for (const std::string& lox_file : lox_files) {
+    expected_output +=
+        ReadFile(lox_file.substr(0, lox_file.size() - 4) + ".txt");
+  }
+
+  for (size_t thread_count : {1, 4}) {
+    std::ostringstream output;
+    cclox::Lox lox{output};
+    lox.RunBatch(lox_files, thread_count);
+    EXPECT_EQ(output.str(), expected_output) << thread_count << " threads";
+  }
+}
+
+// A stream that ends without a newline reports an error at its end on its last
+// line, after running the loops before it, each traced and then dropped.
+TEST(InterpreterStreamTest, ReportsErrorsOnLastLineWithoutNewline) {
+  std::istringstream input{
+      "for (var i = 0; i < 3; i = i + 1) print i;\n"
+      "print"};
+  std::ostringstream output;
+  cclox::Lox lox{output};
+  lox.SetTraceJitMode(cclox::JitMode::FORCE);
+  lox.RunStream(input);
+  EXPECT_EQ(output.str(), "0\n1\n2\n[line 2] Error at end: Expect expression.\n");
+}
+
+// Run an interactive session a line at a time. Later lines must see what
+// earlier lines defined, also after a line with an error.
+TEST(InterpreterReplTest, KeepsDefinitionsAcrossLines) {
+  std::ostringstream output;
+  cclox::Lox lox{output};
+  for (const char* line :
+       {"fun add(a, b) { return a + b; }",
+        "class Point { init(x) { this.x = x; } }",
+        "for (var i = 0; i < 2; i = i + 1) print add(i, 1);",
+        "var twice; { fun f(x) { return x * 2; } twice = f; }", "print ;",
+        "print Point(add(2, 3)).x;", "print twice(4);"}) {
+    lox.RunLine(line);
+  }
+  EXPECT_EQ(output.str(),
+            "1\n2\n[line 1] Error at ';': Expect expression.\n5\n8\n");
+}
+
+// The code compiled for a session's functions is kept across lines, and
+// callers see a function a later line redefines, in every engine.
+TEST(InterpreterReplTest, SeesRedefinedFunctionsInCompiledCode) {
+  for (const EngineOptions& engine : AllEngines()) {
+    std::ostringstream output;
+    cclox::Lox lox{output};
+    UseEngine(lox, engine);
+    for (const char* line :
+         {"fun f(n) { return n + 1; }",
+          "fun g(n) { var s = 0; for (var i = 0; i < n; i = i + 1) s = s + "
+          "f(i); return s; }",
+          "print g(200);", "print g(200);", "fun f(n) { return n * 2; }",
+          "print g(200);",
+          "var s = 0; for (var i = 0; i < 200; i = i + 1) s = s + i; print s;"}) {
+      lox.RunLine(line);
+    }
+    EXPECT_EQ(output.str(), "20100\n20100\n39800\n19900\n") << engine.name;
+  }
+}
+
+// With lazy parsing, a syntax error in a function body is reported when the
+// function is first called, and not at all if it never is.
+TEST(InterpreterLazyParsingTest, ReportsBodyErrorsOnFirstCall) {
+  fs::path script = fs::temp_directory_path() / "cclox_lazy_parsing.lox";
+  std::ofstream{script} << "fun unused() { print ; }\n"
+                           "fun broken() { return 1 +; }\n"
+                           "fun works(n) { fun inner() { return n; } "
+                           "return inner() + 1; }\n"
+                           "print works(1);\n"
+                           "broken();\n"
+                           "print \"unreached\";\n";
+  std::ostringstream output;
+  cclox::Lox lox{output};
+  lox.SetLazyParsingEnabled(true);
+  lox.RunFile(script.string());
+  EXPECT_EQ(output.str(),
+            "2\n[line 2] Error at ';': Expect expression.\n"
+            "Runtime Error: Can't compile function 'broken'.\n[line 2]\n");
+  fs::remove(script);
+}
+
+// Save a script's heap after its top level ran, then load it in a fresh
+// interpreter and call `main`, which must see the globals as they were left,
+// closures and instances included, without the top level running again.
+TEST(InterpreterSnapshotTest, RestoresGlobalsWithoutRunningTopLevel) {
+  fs::path script = fs::temp_directory_path() / "cclox_snapshot.lox";
+  fs::path snapshot = fs::temp_directory_path() / "cclox_snapshot.bin";
+  std::ofstream{script}
+      << "var calls = 0;\n"
+         "fun square(n) { calls = calls + 1; return n * n; }\n"
+         "class Table {\n"
+         "  init(size) {\n"
+         "    this.entries = list();\n"
+         "    for (var i = 0; i < size; i = i + 1) {\n"
+         "      push(this.entries, square(i));\n"
+         "    }\n"
+         "  }\n"
+         "  at(i) { return get(this.entries, i); }\n"
+         "}\n"
+         "var table = Table(5);\n"
+         "fun counter() {\n"
+         "  var count = 0;\n"
+         "  fun next() { count = count + 1; return count; }\n"
+         "  return next;\n"
+         "}\n"
+         "var next = counter();\n"
+         "next();\n"
+         "var digits = range(2, 5);\n"
+         "print \"built\";\n"
+         "fun main() {\n"
+         "  print table.at(4);\n"
+         "  print calls;\n"
+         "  print next();\n"
+         "  print length(digits);\n"
+         "}\n";
+
+  std::ostringstream saved;
+  cclox::Lox saver{saved};
+  EXPECT_TRUE(saver.SnapshotFile(script.string(), snapshot));
+  EXPECT_EQ(saved.str(), "built\n");
+
+  std::ostringstream restored;
+  cclox::Lox restorer{restored};
+  EXPECT_TRUE(restorer.RunFromSnapshot(script.string(), snapshot, "main"));
+  EXPECT_EQ(restored.str(), "16\n5\n2\n3\n");
+
+  // A snapshot only loads with the script it was saved from.
+  std::ofstream{script, std::ios::app} << "// changed\n";
+  std::ostringstream rejected;
+  cclox::Lox rejecter{rejected};
+  EXPECT_FALSE(rejecter.RunFromSnapshot(script.string(), snapshot, "main"));
+  EXPECT_EQ(rejected.str(),
+            "Error: The snapshot was saved from a different script.\n");
+
+  fs::remove(script);
+  fs::remove(snapshot);
+}
+
+// A run that exceeds its fuel or its time fails with a runtime error, and the
+// next run starts with the full budget. The host catches the error of a call.
+TEST(InterpreterBudgetTest, StopsRunawayCode) {
+  fs::path script = fs::temp_directory_path() / "cclox_budget.lox";
+  std::ofstream{script} << "fun count(n) {\n"
+                           "  var i = 0;\n"
+                           "  while (i < n) i = i + 1;\n"
+                           "  return i;\n"
+                           "}\n"
+                           "print count(100);\n"
+                           "fun spin() { for (;;) {} }\n";
+
+  std::ostringstream output;
+  cclox::Lox lox{output};
+  lox.SetExecutionBudget(150, std::nullopt);
+  EXPECT_TRUE(lox.Load(script.string()));
+  std::optional<cclox::Object> count = lox.GetGlobal("count");
+  ASSERT_TRUE(count);
+  EXPECT_THROW(lox.Call(count.value(), {cclox::Object{1000}}),
+               cclox::RuntimeError);
+  EXPECT_EQ(lox.Call(count.value(), {cclox::Object{100}}).ToString(), "100");
+
+  lox.SetExecutionBudget(std::nullopt, std::chrono::milliseconds{20});
+  std::optional<cclox::Object> spin = lox.GetGlobal("spin");
+  ASSERT_TRUE(spin);
+  try {
+    lox.Call(spin.value(), {});
+    ADD_FAILURE() << "spin() returned";
+  } catch (const cclox::RuntimeError& error) {
+    EXPECT_STREQ(error.what(), "Runtime Error: Time limit exceeded.");
+  }
+  EXPECT_EQ(output.str(), "100\n");
+  fs::remove(script);
+}
+
+// Waits that block rather than run count against the time limit too: a run
+// stuck in a sleep, on an empty channel or on a task stuck there stops at its
+// deadline instead of waiting it out.
+TEST(InterpreterBudgetTest, StopsBlockedWaits) {
+  fs::path script = fs::temp_directory_path() / "cclox_blocked.lox";
+  const std::vector<std::pair<std::string, std::string>> cases{
+      {"await sleep(60000);\n", "[line 1]"},
+      {"var c = channel(1);\nrecv(c);\n", "[line 2]"},
+      // The task and its awaiter share the deadline, so either may report.
+      {"fun stuck() { return recv(channel(1)); }\nawait(spawn(stuck));\n",
+       ""},
+      {"async fun stuck() { await sleep(60000); }\nstuck();\n", "[line 0]"},
+  };
+  for (const auto& [source, line] : cases) {
+    std::ofstream{script} << source;
+    std::ostringstream output;
+    cclox::Lox lox{output};
+    lox.SetExecutionBudget(std::nullopt, std::chrono::milliseconds{50});
+    auto start = std::chrono::steady_clock::now();
+    lox.RunFile(script.string());
+    EXPECT_LT(std::chrono::steady_clock::now() - start,
+              std::chrono::seconds{10})
+        << source;
+    EXPECT_TRUE(output.str().starts_with(
+        "Runtime Error: Time limit exceeded.\n" + line))
+        << output.str();
+  }
+  fs::remove(script);
+}
+
+TEST(InterpreterHeapLimitTest, StopsUnboundedGrowth) {
+  fs::path script = fs::temp_directory_path() / "cclox_heap_limit.lox";
+  std::ofstream{script} << "class Node { init(next) { this.next = next; } }\n"
+                           "fun chain(n) {\n"
+                           "  var head = nil;\n"
+                           "  for (var i = 0; i < n; i = i + 1) head = "
+                           "Node(head);\n"
+                           "  return head;\n"
+                           "}\n"
+                           "fun grow() { var head = nil; for (;;) head = "
+                           "Node(head); }\n";
+
+  constexpr size_t kLimit = 1 << 20;
+  std::ostringstream output;
+  cclox::Lox lox{output};
+  lox.SetHeapLimit(kLimit);
+  EXPECT_TRUE(lox.Load(script.string()));
+  std::optional<cclox::Object> grow = lox.GetGlobal("grow");
+  ASSERT_TRUE(grow);
+  try {
+    lox.Call(grow.value(), {});
+    ADD_FAILURE() << "grow() returned";
+  } catch (const cclox::RuntimeError& error) {
+    EXPECT_STREQ(error.what(), "Runtime Error: Out of memory.");
+  }
+  cclox::HeapUsage usage = lox.GetHeapUsage();
+  EXPECT_GT(usage.peak, kLimit);
+  EXPECT_LT(usage.current, kLimit);
+
+  // The chain died with the failed call, so there is room again.
+  std::optional<cclox::Object> chain = lox.GetGlobal("chain");
+  ASSERT_TRUE(chain);
+  EXPECT_EQ(lox.Call(chain.value(), {cclox::Object{100}}).ToString(),
+            "Node instance");
+  EXPECT_EQ(output.str(), "");
+  fs::remove(script);
+}
+
+// The chain an out-of-memory error cuts short is long enough that destroying
+// it one instance inside another would overflow the stack.
+TEST(InterpreterHeapLimitTest, DropsLongChainsAfterRunningOut) {
+  fs::path script = fs::temp_directory_path() / "cclox_heap_chain.lox";
+  std::ofstream{script} << "class Node { init(next) { this.next = next; } }\n"
+                           "fun grow() {\n"
+                           "  var head = nil;\n"
+                           "  for (;;) head = Node(head);\n"
+                           "}\n"
+                           "grow();\n"
+                           "print \"unreached\";\n";
+
+  std::ostringstream output;
+  cclox::Lox lox{output};
+  lox.SetHeapLimit(size_t{16} << 20);
+  lox.RunFile(script.string());
+  EXPECT_EQ(output.str(), "Runtime Error: Out of memory.\n[line 4]\n");
+  EXPECT_LT(lox.GetHeapUsage().current, size_t{1} << 20);
+  fs::remove(script);
+}
+
+// A string stored in a list by `set` is counted until the list lets go of it.
+TEST(InterpreterHeapLimitTest, CountsValuesStoredInLists) {
+  fs::path script = fs::temp_directory_path() / "cclox_heap_set.lox";
+  std::ofstream{script} << "fun store(value) {\n"
+                           "  var big = \"x\";\n"
+                           "  for (var i = 0; i < 20; i = i + 1) big = big + "
+                           "big;\n"
+                           "  var items = list(nil);\n"
+                           "  set(items, 0, big);\n"
+                           "  set(items, 0, value);\n"
+                           "  return items;\n"
+                           "}\n";
 
-  RunTestFromFile(lox_file, txt_file);
+  std::ostringstream output;
+  cclox::Lox lox{output};
+  lox.SetHeapLimit(std::nullopt);
+  EXPECT_TRUE(lox.Load(script.string()));
+  std::optional<cclox::Object> store = lox.GetGlobal("store");
+  ASSERT_TRUE(store);
+  cclox::Object items = lox.Call(store.value(), {cclox::Object{"small"}});
+  cclox::HeapUsage usage = lox.GetHeapUsage();
+  EXPECT_GT(usage.peak, size_t{2} << 20);
+  EXPECT_LT(usage.current, size_t{1} << 20);
+  EXPECT_EQ(output.str(), "");
+  fs::remove(script);
 }
@@ -0,0 +1,289 @@
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "interpreter.h"
+#include "ir.h"
+#include "ir_builder.h"
+#include "ir_passes.h"
+#include "parser.h"
+#include "resolver.h"
+#include "scanner.h"
+#include "stmt.h"
+
+using cclox::Interpreter, cclox::IrBuilder, cclox::Parser, cclox::Resolver,
+    cclox::Scanner;
+using cclox::FunctionStmtPtr, cclox::StmtPtr, cclox::WhileStmtPtr;
+using cclox::ir::Function, cclox::ir::InlineCandidate, cclox::ir::Opcode,
+    cclox::ir::PassManager;
+
+namespace {
+// Parses and resolves `source`, which must declare the function `name` at the
+// top level, and builds its IR.
+class IrTest : public ::testing::Test {
+ protected:
+  auto Build(std::string source, const std::string& name)
+      -> std::optional<Function> {
+    Scanner scanner{std::move(source)};
+    Parser parser{scanner.ScanTokens()};
+    statements_ = parser.Parse();
+    Resolver resolver{interpreter_};
+    resolver.ResolveStatements(statements_);
+
+    for (const StmtPtr& statement : statements_) {
+      const auto* function = std::get_if<FunctionStmtPtr>(&statement);
+      if (function != nullptr &&
+          (*function)->GetFunctionName().GetLexeme() == name) {
+        return IrBuilder{interpreter_}.Build(**function);
+      }
+    }
+    return std::nullopt;
+  }
+
+  // Builds `name` and runs the default pipeline, verifying after each pass.
+  auto Optimize(std::string source, const std::string& name) -> Function {
+    std::optional<Function> function = Build(std::move(source), name);
+    EXPECT_TRUE(function);
+    EXPECT_EQ(cclox::ir::Verify(function.value()), std::nullopt);
+    PassManager pipeline = PassManager::CreateDefault();
+    pipeline.SetVerify(true);
+    pipeline.Run(function.value());
+    return std::move(function.value());
+  }
+
+  static auto Count(const Function& function, Opcode opcode) -> size_t {
+    size_t count = 0;
+    for (const auto& block : function.blocks) {
+      count += static_cast<size_t>(std::count_if(
+          block.instructions.begin(), block.instructions.end(),
+          [&](const auto& instruction) {
+            return instruction.opcode == opcode;
+          }));
+    }
+    return count;
+  }
+
+  Interpreter interpreter_;
+  std::vector<StmtPtr> statements_;
+};
+}  // namespace
+
+TEST_F(IrTest, BuildsValidSsaForControlFlow) {
+  std::optional<Function> function = Build(
+      "fun f(n) {"
+      "  var total = 0;"
+      "  for (var i = 0; i < n; i = i + 1) {"
+      "    if (i == 2 or i == 3) total = total + i; else total = total - 1;"
+      "  }"
+      "  return total;"
+      "}",
+      "f");
+  ASSERT_TRUE(function);
+  EXPECT_EQ(cclox::ir::Verify(function.value()), std::nullopt);
+  EXPECT_EQ(function->arity, 1);
+}
+
+TEST_F(IrTest, RejectsNestedFunctions) {
+  EXPECT_FALSE(Build("fun f() { fun g() {} return g; }", "f"));
+}
+
+TEST_F(IrTest, FoldsConstantsAndBranches) {
+  Function function = Optimize(
+      "fun f() {"
+      "  var x = 1 + 2;"
+      "  if (x > 2) return x * 2;"
+      "  return 0;"
+      "}",
+      "f");
+
+  std::ostringstream dump;
+  cclox::ir::Dump(function, dump);
+  EXPECT_EQ(dump.str(),
+            "function f/0\n"
+            "b0:\n"
+            "  v7 = const 6\n"
+            "  return v7\n");
+}
+
+TEST_F(IrTest, KeepsInstructionsThatCanThrow) {
+  Function function = Optimize(
+      "fun f(a) {"
+      "  var unused = a - 1;"
+      "  var also_unused = 2 * 3;"
+      "  var number = 2 - a;"
+      "  var dead = number * 2;"
+      "}",
+      "f");
+
+  // `a - 1` throws unless `a` is a number, and then `number * 2` cannot.
+  EXPECT_EQ(Count(function, Opcode::SUB), 2);
+  EXPECT_EQ(Count(function, Opcode::MUL), 0);
+}
+
+TEST_F(IrTest, EliminatesCommonSubexpressions) {
+  Function function =
+      Optimize("fun f(a, b) { return (a + b) * (a + b) + (b == a); }", "f");
+
+  EXPECT_EQ(Count(function, Opcode::ADD), 2);
+  EXPECT_EQ(Count(function, Opcode::EQ), 1);
+}
+
+TEST_F(IrTest, HoistsLoopInvariants) {
+  Function function = Optimize(
+      "fun f(n, k) {"
+      "  var i = 0;"
+      "  while (i < n * 2) {"
+      "    i = i + k * 3;"
+      "  }"
+      "  return i;"
+      "}",
+      "f");
+
+  // `n * 2` moves out of the loop header. `k * 3` stays in the body: if the
+  // loop never runs, it must not throw.
+  const auto& entry = function.blocks[0].instructions;
+  EXPECT_TRUE(std::any_of(entry.begin(), entry.end(), [](const auto& i) {
+    return i.opcode == Opcode::MUL && i.operands[0] == 0;
+  }));
+  EXPECT_FALSE(std::any_of(entry.begin(), entry.end(), [](const auto& i) {
+    return i.opcode == Opcode::MUL && i.operands[0] == 1;
+  }));
+}
+
+TEST_F(IrTest, InlinesSmallFunctionsBehindAGuard) {
+  std::optional<Function> square =
+      Build("fun square(x) { return x * x; }", "square");
+  ASSERT_TRUE(square);
+  PassManager::CreateDefault().Run(square.value());
+  std::optional<Function> function = Build(
+      "fun square(x) { return x * x; }"
+      "fun f(n) { return square(n + 1); }",
+      "f");
+  ASSERT_TRUE(function);
+
+  std::ostringstream report;
+  auto inlining = std::make_unique<cclox::ir::Inlining>(
+      [&](const std::string& name) -> std::optional<InlineCandidate> {
+        if (name != "square") {
+          return std::nullopt;
+        }
+        return InlineCandidate{cclox::Object{nullptr}, &square.value()};
+      });
+  inlining->SetReportStream(&report);
+  PassManager pipeline;
+  pipeline.Add(std::move(inlining)).AddDefaultPasses();
+  pipeline.SetVerify(true);
+  pipeline.Run(function.value());
+
+  EXPECT_EQ(report.str(), "[line 1] f: inlined square (3 instructions)\n");
+  EXPECT_EQ(Count(function.value(), Opcode::IS_CALLEE), 1);
+  EXPECT_EQ(Count(function.value(), Opcode::MUL), 1);
+  // The fallback still calls the function, and is not inlined again.
+  EXPECT_EQ(Count(function.value(), Opcode::CALL), 1);
+}
+
+TEST_F(IrTest, DoesNotInlineRecursiveFunctions) {
+  std::optional<Function> fib = Build(
+      "fun fib(n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); }",
+      "fib");
+  ASSERT_TRUE(fib);
+  Function caller = fib.value();
+  caller.name = "caller";
+
+  std::ostringstream report;
+  cclox::ir::Inlining inlining{
+      [&](const std::string&) -> std::optional<InlineCandidate> {
+        return InlineCandidate{cclox::Object{nullptr}, &fib.value()};
+      }};
+  inlining.SetReportStream(&report);
+  EXPECT_FALSE(inlining.Run(caller));
+  EXPECT_EQ(report.str(),
+            "[line 1] caller: not inlining fib: recursive\n"
+            "[line 1] caller: not inlining fib: recursive\n");
+}
+
+TEST_F(IrTest, InfersTypesThroughLoops) {
+  Function function = Optimize(
+      "fun f(n) {"
+      "  var total = 0.5;"
+      "  var name = \"a\";"
+      "  for (var i = 0; i < n; i = i + 1) {"
+      "    total = total + i;"
+      "    name = name + \"b\";"
+      "  }"
+      "  return total / 2;"
+      "}",
+      "f");
+  cclox::ir::TypeInference{}.Run(function);
+
+  std::ostringstream dump;
+  cclox::ir::Dump(function, dump);
+  // The counter may overflow into a double, the total never holds an integer.
+  EXPECT_NE(dump.str().find(":number = phi"), std::string::npos);
+  EXPECT_NE(dump.str().find(":double = phi"), std::string::npos);
+  EXPECT_NE(dump.str().find(":string = phi"), std::string::npos);
+  EXPECT_NE(dump.str().find(":bool = lt"), std::string::npos);
+  EXPECT_NE(dump.str().find(":double = div"), std::string::npos);
+  EXPECT_NE(dump.str().find(":any = param"), std::string::npos);
+}
+
+TEST_F(IrTest, PromotesLoopVariablesWithoutCalls) {
+  auto build_loop = [&](std::string source) {
+    Build(std::move(source), "");
+    for (const StmtPtr& statement : statements_) {
+      if (const auto* loop = std::get_if<WhileStmtPtr>(&statement)) {
+        return IrBuilder{interpreter_}.BuildLoop(**loop, true);
+      }
+    }
+    return std::optional<Function>{};
+  };
+
+  // Each defined global is loaded once on entry, and stored on every
+  // assignment.
+  interpreter_.GetGlobalEnvironment()->Define("a", cclox::Object{0});
+  interpreter_.GetGlobalEnvironment()->Define("b", cclox::Object{1});
+  std::optional<Function> loop =
+      build_loop("while (a < 10) { a = a + b; b = b + 1; }");
+  ASSERT_TRUE(loop);
+  EXPECT_EQ(cclox::ir::Verify(loop.value()), std::nullopt);
+  EXPECT_EQ(Count(loop.value(), Opcode::LOAD_GLOBAL), 2);
+  EXPECT_EQ(Count(loop.value(), Opcode::STORE_GLOBAL), 2);
+
+  loop = build_loop("while (a < 10) { a = a + f(b); }");
+  ASSERT_TRUE(loop);
+  EXPECT_EQ(Count(loop.value(), Opcode::LOAD_GLOBAL), 4);
+
+  EXPECT_FALSE(build_loop("while (true) { fun g() {} }"));
+}
+
+TEST_F(IrTest, GuardsSpeculatedLoopVariables) {
+  interpreter_.GetGlobalEnvironment()->Define("a", cclox::Object{0});
+  interpreter_.GetGlobalEnvironment()->Define("n", cclox::Object{10});
+  Build("while (a < n) { a = a + 1; }", "");
+  const auto& loop = std::get<WhileStmtPtr>(statements_.back());
+  std::optional<Function> function = IrBuilder{interpreter_}.BuildLoop(
+      *loop, false, [](const cclox::Token&, std::optional<uint64_t>) {
+        return cclox::ir::Type::NUMBER;
+      });
+  ASSERT_TRUE(function);
+  EXPECT_EQ(cclox::ir::Verify(function.value()), std::nullopt);
+
+  // `n` is checked once on entry and `a` on every iteration. Only the exit
+  // and the deoptimization of the iteration store `a`, which is its frame
+  // state.
+  EXPECT_EQ(Count(function.value(), Opcode::IS_TYPE), 2);
+  EXPECT_EQ(Count(function.value(), Opcode::DEOPT), 2);
+  EXPECT_EQ(Count(function.value(), Opcode::STORE_GLOBAL), 2);
+
+  cclox::ir::PassManager::CreateDefault().Run(function.value());
+  cclox::ir::TypeInference{}.Run(function.value());
+  EXPECT_EQ(cclox::ir::Verify(function.value()), std::nullopt);
+  std::ostringstream dump;
+  cclox::ir::Dump(function.value(), dump);
+  EXPECT_NE(dump.str().find(":number = add"), std::string::npos);
+}
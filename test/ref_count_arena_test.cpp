@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "ref_count_arena.h"
+
+using cclox::RefCountAllocator, cclox::RefCountArena;
+
+// Blocks are aligned for any control block, don't overlap, and can be written
+// to in full.
+TEST(RefCountArenaTest, HandsOutAlignedSeparateBlocks) {
+  std::vector<char*> blocks;
+  for (size_t size = 1; size <= 128; size += 7) {
+    auto* block = static_cast<char*>(RefCountArena::Allocate(size));
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(block) % 16, 0U) << size;
+    std::memset(block, static_cast<int>(size), size);
+    blocks.push_back(block);
+  }
+  size_t size = 1;
+  for (char* block : blocks) {
+    EXPECT_EQ(block[size - 1], static_cast<char>(size));
+    RefCountArena::Deallocate(block, size);
+    size += 7;
+  }
+}
+
+// A freed block is handed out again for the next block of its size class, on
+// any thread.
+TEST(RefCountArenaTest, ReusesFreedBlocksOfTheSameSize) {
+  void* first = RefCountArena::Allocate(40);
+  void* second = RefCountArena::Allocate(40);
+  EXPECT_NE(first, second);
+  RefCountArena::Deallocate(first, 40);
+  EXPECT_EQ(RefCountArena::Allocate(48), first);
+  RefCountArena::Deallocate(first, 48);
+  RefCountArena::Deallocate(second, 40);
+
+  void* other = nullptr;
+  std::thread{[&other] { other = RefCountArena::Allocate(40); }}.join();
+  EXPECT_EQ(other, second);
+  RefCountArena::Deallocate(other, 40);
+}
+
+// Chunks go back to the heap once none of their blocks is in use, and not
+// before.
+TEST(RefCountArenaTest, ReleasesEmptyChunks) {
+  RefCountArena::ReleaseEmptyChunks();
+  ASSERT_EQ(RefCountArena::GetChunkCount(), 0U);
+  // More than a chunk's worth of blocks.
+  std::vector<void*> blocks;
+  for (size_t i = 0; i < 5000; i++) {
+    blocks.push_back(RefCountArena::Allocate(32));
+  }
+  ASSERT_GT(RefCountArena::GetChunkCount(), 1U);
+
+  void* kept = blocks.back();
+  blocks.pop_back();
+  for (void* block : blocks) {
+    RefCountArena::Deallocate(block, 32);
+  }
+  RefCountArena::ReleaseEmptyChunks();
+  EXPECT_EQ(RefCountArena::GetChunkCount(), 1U);
+  RefCountArena::Deallocate(kept, 32);
+  RefCountArena::ReleaseEmptyChunks();
+  EXPECT_EQ(RefCountArena::GetChunkCount(), 0U);
+}
+
+// Blocks too large to pool come from the global heap.
+TEST(RefCountArenaTest, AllocatesLargeBlocksFromTheHeap) {
+  auto* block = static_cast<char*>(RefCountArena::Allocate(4096));
+  std::memset(block, 1, 4096);
+  RefCountArena::Deallocate(block, 4096);
+}
+
+// Shared pointers built with the allocator count references and destroy
+// their object as usual, with the control block in the arena.
+TEST(RefCountArenaTest, HoldsControlBlocksOfSharedPointers) {
+  bool destroyed = false;
+  {
+    std::shared_ptr<int> value{new int{42},
+                               [&destroyed](int* value) {
+                                 destroyed = true;
+                                 delete value;
+                               },
+                               RefCountAllocator<int>{}};
+    std::shared_ptr<int> copy = value;
+    EXPECT_EQ(value.use_count(), 2);
+    EXPECT_EQ(*copy, 42);
+  }
+  EXPECT_TRUE(destroyed);
+}
@@ -0,0 +1,140 @@
+#include <gtest/gtest.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <format>
+#include <functional>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "lox.h"
+#include "server.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+// Echoes each request between angle brackets, with a newline that the server
+// must not let end the response early. "fail" fails with a runtime error, and
+// "crash" overflows the worker's stack, which kills it.
+constexpr const char* kHandler =
+    "fun crash(n) { return crash(n + 1); }\n"
+    "fun handle(request) {\n"
+    "  if (request == \"fail\") return missing;\n"
+    "  if (request == \"crash\") return crash(0);\n"
+    "  return \"<\" + request + \">\n!\";\n"
+    "}\n";
+
+constexpr size_t kWorkerCount = 2;
+
+// Returns the ids of the processes `pid` forked that are still alive.
+auto ChildrenOf(pid_t pid) -> std::vector<pid_t> {
+  std::ifstream file{std::format("/proc/{}/task/{}/children", pid, pid)};
+  std::vector<pid_t> children;
+  for (pid_t child = 0; file >> child;) {
+    children.push_back(child);
+  }
+  return children;
+}
+
+// Tells whether `pid` exited, and is only waiting to be reaped.
+auto IsZombie(pid_t pid) -> bool {
+  std::ifstream file{std::format("/proc/{}/stat", pid)};
+  std::string line;
+  std::getline(file, line);
+  size_t end = line.rfind(')');
+  return end != std::string::npos && end + 2 < line.size() &&
+         line[end + 2] == 'Z';
+}
+
+// Forks a server for `kHandler` reading `requests` from its standard input,
+// and returns what it wrote to its standard output. `started` runs once all
+// the workers are up, before the requests are sent.
+auto Serve(const std::string& requests,
+           const std::function<void(pid_t)>& started = {}) -> std::string {
+  fs::path script = fs::temp_directory_path() / "cclox_server.lox";
+  std::ofstream{script} << kHandler;
+
+  int input[2];
+  int output[2];
+  EXPECT_EQ(pipe(input), 0);
+  EXPECT_EQ(pipe(output), 0);
+  pid_t server = fork();
+  if (server == 0) {
+    dup2(input[0], STDIN_FILENO);
+    dup2(output[1], STDOUT_FILENO);
+    for (int fd : {input[0], input[1], output[0], output[1]}) {
+      close(fd);
+    }
+    cclox::Lox lox;
+    if (!lox.Load(script.string())) {
+      _exit(1);
+    }
+    cclox::Server serve{lox, lox.GetGlobal("handle").value(), kWorkerCount};
+    _exit(serve.ServeStdin());
+  }
+  close(input[0]);
+  close(output[1]);
+
+  while (ChildrenOf(server).size() < kWorkerCount) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+  }
+  if (started) {
+    started(server);
+  }
+  EXPECT_EQ(write(input[1], requests.data(), requests.size()),
+            static_cast<ssize_t>(requests.size()));
+  close(input[1]);
+
+  std::string responses;
+  char buffer[4096];
+  for (ssize_t count; (count = read(output[0], buffer, sizeof(buffer))) > 0;) {
+    responses.append(buffer, static_cast<size_t>(count));
+  }
+  close(output[0]);
+  int status = 0;
+  waitpid(server, &status, 0);
+  EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  fs::remove(script);
+  return responses;
+}
+}  // namespace
+
+// Each request gets one line in order, even one whose response has a newline
+// or that failed, and a last request without a newline still counts.
+TEST(ServerTest, AnswersEachRequestOnOneLine) {
+  EXPECT_EQ(Serve("a\nfail\nb\nc"),
+            "<a> !\n"
+            "Runtime Error: Undefined variable 'missing'. [line 3]\n"
+            "<b> !\n"
+            "<c> !\n");
+}
+
+// A worker that dies serving a request answers it with an error, and another
+// takes its place for the requests after it.
+TEST(ServerTest, ReplacesWorkerThatDiesServingRequest) {
+  EXPECT_EQ(Serve("a\ncrash\nb\nc\nd\n"),
+            "<a> !\n"
+            "Error: The worker serving the request died.\n"
+            "<b> !\n"
+            "<c> !\n"
+            "<d> !\n");
+}
+
+// A worker that dies between requests is replaced without answering anything,
+// so the responses still line up with the requests.
+TEST(ServerTest, ReplacesWorkerThatDiesBetweenRequests) {
+  std::string responses = Serve("a\nb\nc\n", [](pid_t server) {
+    pid_t worker = ChildrenOf(server).front();
+    kill(worker, SIGKILL);
+    while (!IsZombie(worker)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+  });
+  EXPECT_EQ(responses, "<a> !\n<b> !\n<c> !\n");
+}